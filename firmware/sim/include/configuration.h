@@ -0,0 +1,103 @@
+/**
+ * @file configuration.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Configuration for the host build in firmware/sim.
+ *
+ * Stands in for src/config/e54_xpro/configuration.h: the same WINC driver
+ * options, and only those system settings the host build's services need.
+ */
+
+#ifndef CONFIGURATION_H
+#define CONFIGURATION_H
+
+// *****************************************************************************
+// Includes
+
+#include "user.h"
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// System services
+#define SYS_DEBUG_ENABLE
+#define SYS_DEBUG_GLOBAL_ERROR_LEVEL SYS_ERROR_INFO
+#define SYS_DEBUG_USE_CONSOLE
+
+#define SYS_TIME_INDEX_0 (0)
+#define SYS_TIME_MAX_TIMERS (5)
+#define SYS_TIME_HW_COUNTER_WIDTH (32)
+#define SYS_TIME_TICK_FREQ_IN_HZ (1000)
+
+#define SYS_FS_MAX_FILES 1
+#define SYS_FS_AUTOMOUNT_ENABLE false
+#define SYS_FS_FILE_NAME_LEN 255
+#define SYS_FS_CWD_STRING_LEN 1024
+#define SYS_FS_MEDIA_MAX_BLOCK_SIZE 512
+#define SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS 32
+
+#define SYS_CONSOLE_DEVICE_MAX_INSTANCES 1
+#define SYS_CONSOLE_PRINT_BUFFER_SIZE 200
+#define SYS_CONSOLE_INDEX_0 0
+
+// WINC driver: as configured for the SAME54 XPRO
+#define WDRV_WINC_EIC_SOURCE
+#define WDRV_WINC_NETWORK_MODE_SOCKET
+#define WDRV_WINC_DEVICE_WINC1500
+#define WDRV_WINC_DEVICE_SPLIT_INIT
+#define WDRV_WINC_DEVICE_ENTERPRISE_CONNECT
+#define WDRV_WINC_DEVICE_EXT_CONNECT_PARAMS
+#define WDRV_WINC_DEVICE_BSS_ROAMING
+#define WDRV_WINC_DEVICE_FLEXIBLE_FLASH_MAP
+#define WDRV_WINC_DEVICE_DYNAMIC_BYPASS_MODE
+#define WDRV_WINC_DEVICE_WPA_SOFT_AP
+#define WDRV_WINC_DEVICE_CONF_NTP_SERVER
+#define WDRV_WINC_DEVICE_HOST_FILE_DOWNLOAD
+#define WDRV_WINC_DEVICE_SOFT_AP_EXT
+#define WDRV_WINC_DEVICE_MULTI_GAIN_TABLE
+#define WDRV_WINC_DEVICE_URL_TYPE unsigned char
+#define WDRV_WINC_DEVICE_SCAN_STOP_ON_FIRST
+#define WDRV_WINC_DEVICE_DEPRECATE_WEP
+#define WDRV_WINC_DEVICE_OTA_SSL_OPTIONS
+#define WDRV_WINC_DEVICE_OTA_STATUS_EXTENDED
+#define WDRV_WINC_DEVICE_SCAN_SSID_LIST
+#define WDRV_WINC_DEVICE_USE_SYS_DEBUG
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef CONFIGURATION_H */
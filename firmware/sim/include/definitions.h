@@ -0,0 +1,78 @@
+/**
+ * @file definitions.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief System definitions for the host build in firmware/sim.
+ *
+ * Stands in for the Harmony-generated definitions.h: the real headers of the
+ * services the cloner uses, whose functions sys_sim.c and sys_fs_posix.c
+ * provide on the host, and none of the peripheral libraries.
+ */
+
+#ifndef DEFINITIONS_H
+#define DEFINITIONS_H
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "configuration.h"
+#include "device.h"
+#include "osal/osal.h"
+#include "peripheral/nvic/plib_nvic.h"
+#include "peripheral/sercom/usart/plib_sercom2_usart.h"
+#include "system/console/sys_console.h"
+#include "system/debug/sys_debug.h"
+#include "system/fs/sys_fs.h"
+#include "system/fs/sys_fs_media_manager.h"
+#include "system/int/sys_int.h"
+#include "system/ports/sys_ports.h"
+#include "system/time/sys_time.h"
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define CPU_CLOCK_FREQUENCY 120000000
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef DEFINITIONS_H */
@@ -0,0 +1,61 @@
+/**
+ * @file device.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for the SAME54 device header: just the compiler
+ * abstractions that the headers shared with the target use, and the cycle
+ * counter that prof.h reads.
+ */
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <stdint.h>
+
+#define __STATIC_INLINE static inline
+#define __NOP() ((void)0)
+
+// DWT->CYCCNT follows the simulated clock at CPU_CLOCK_FREQUENCY, so it counts
+// the modeled bus and flash delays but none of the host's own CPU time.
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+#define DWT (sim_dwt())
+#define CoreDebug (&g_sim_core_debug)
+
+DWT_Type *sim_dwt(void);
+extern CoreDebug_Type g_sim_core_debug;
+
+#endif /* #ifndef DEVICE_H */
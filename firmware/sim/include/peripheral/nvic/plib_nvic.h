@@ -0,0 +1,45 @@
+/**
+ * @file plib_nvic.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for the NVIC peripheral library.  The host build has
+ * no interrupts, so there is nothing to disable.
+ */
+
+#ifndef PLIB_NVIC_H
+#define PLIB_NVIC_H
+
+#include <stdbool.h>
+
+static inline bool NVIC_INT_Disable(void) {
+  return true;
+}
+
+static inline void NVIC_INT_Restore(bool state) {
+  (void)state;
+}
+
+#endif /* #ifndef PLIB_NVIC_H */
@@ -0,0 +1,96 @@
+/**
+ * @file sys_debug.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Host stand-in for the SYS_DEBUG interface, with the same macros as
+ * Harmony's.  Messages go to stdout through sys_sim.c.
+ */
+
+#ifndef SYS_DEBUG_H
+#define SYS_DEBUG_H
+
+// *****************************************************************************
+// Includes
+
+#include "system/system.h"
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+typedef enum {
+  SYS_ERROR_FATAL = 0,
+  SYS_ERROR_ERROR = 1,
+  SYS_ERROR_WARNING = 2,
+  SYS_ERROR_INFO = 3,
+  SYS_ERROR_DEBUG = 4,
+} SYS_ERROR_LEVEL;
+
+#define SYS_DEBUG_PRINT(level, fmt, ...)                                       \
+  do {                                                                         \
+    if ((level) <= SYS_DEBUG_ErrorLevelGet()) {                                \
+      SYS_DEBUG_Print(fmt, ##__VA_ARGS__);                                     \
+    }                                                                          \
+  } while (0)
+
+#define SYS_DEBUG_MESSAGE(level, message)                                      \
+  do {                                                                         \
+    if ((level) <= SYS_DEBUG_ErrorLevelGet()) {                                \
+      SYS_DEBUG_Message(message);                                              \
+    }                                                                          \
+  } while (0)
+
+#define _SYS_DEBUG_PRINT(level, fmt, ...)                                      \
+  SYS_DEBUG_PRINT(level, fmt, ##__VA_ARGS__)
+#define _SYS_DEBUG_MESSAGE(level, message) SYS_DEBUG_MESSAGE(level, message)
+
+#define SYS_ERROR_PRINT SYS_DEBUG_PRINT
+
+// *****************************************************************************
+// Public declarations
+
+void SYS_DEBUG_ErrorLevelSet(SYS_ERROR_LEVEL level);
+
+SYS_ERROR_LEVEL SYS_DEBUG_ErrorLevelGet(void);
+
+void SYS_DEBUG_Print(const char *format, ...);
+
+void SYS_DEBUG_Message(const char *message);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef SYS_DEBUG_H */
@@ -0,0 +1,94 @@
+/**
+ * @file sim_clock.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "sim_clock.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static uint64_t monotonic_ns(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static sim_clock_source_t s_source = SIM_CLOCK_VIRTUAL;
+
+static uint64_t s_charged; // total of sim_clock_advance() and skipped waits
+
+static uint64_t s_host_start; // CLOCK_MONOTONIC at sim_clock_set_source()
+
+// *****************************************************************************
+// Public code
+
+void sim_clock_set_source(sim_clock_source_t source) {
+  s_charged = sim_clock_now();
+  s_source = source;
+  s_host_start = monotonic_ns();
+}
+
+uint64_t sim_clock_now(void) {
+  if (s_source == SIM_CLOCK_MONOTONIC) {
+    return s_charged + (monotonic_ns() - s_host_start);
+  }
+  return s_charged;
+}
+
+void sim_clock_advance(uint64_t ns) {
+  s_charged += ns;
+}
+
+bool sim_clock_wait_until(uint64_t t) {
+  uint64_t now = sim_clock_now();
+
+  if (now >= t) {
+    return true;
+  } else if (s_source == SIM_CLOCK_VIRTUAL) {
+    s_charged += t - now;
+    return true;
+  }
+  return false;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint64_t monotonic_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * SIM_CLOCK_NS_PER_S + ts.tv_nsec;
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,102 @@
+/**
+ * @file sim_clock.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief sim_clock is the time base of the host build.
+ *
+ * Simulated time advances only when a model charges for work (bytes on the
+ * WINC's SPI bus, a flash erase) or when the firmware waits (nm_sleep(), a
+ * SYS_TIME delay), which skips straight to the end of the wait.  A run is
+ * therefore repeatable to the nanosecond and takes a fraction of the time it
+ * would on the bench, while SYS_TIME readings still reflect the modelled cost.
+ *
+ * The full application waits on a person or a host program at the console, so
+ * it runs the clock from CLOCK_MONOTONIC instead; the models' charges are then
+ * added on top of real time rather than slept.
+ */
+
+#ifndef _SIM_CLOCK_H_
+#define _SIM_CLOCK_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define SIM_CLOCK_NS_PER_US 1000ull
+#define SIM_CLOCK_NS_PER_MS 1000000ull
+#define SIM_CLOCK_NS_PER_S 1000000000ull
+
+typedef enum {
+  SIM_CLOCK_VIRTUAL,  // time moves only when the models charge for it
+  SIM_CLOCK_MONOTONIC // time also follows the host's CLOCK_MONOTONIC
+} sim_clock_source_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Select how time passes.  The default, SIM_CLOCK_VIRTUAL, makes runs
+ * exactly repeatable; SIM_CLOCK_MONOTONIC lets timeouts that wait on a host
+ * (such as a console that is read by another program) expire in real time.
+ */
+void sim_clock_set_source(sim_clock_source_t source);
+
+/**
+ * @brief Return the simulated time in nanoseconds since startup.
+ */
+uint64_t sim_clock_now(void);
+
+/**
+ * @brief Advance simulated time by ns nanoseconds.
+ */
+void sim_clock_advance(uint64_t ns);
+
+/**
+ * @brief Return true if time t has come.  On the virtual clock nothing else can
+ * happen in the meantime, so time skips ahead to t and this always returns true.
+ */
+bool sim_clock_wait_until(uint64_t t);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SIM_CLOCK_H_ */
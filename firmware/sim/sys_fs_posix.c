@@ -0,0 +1,569 @@
+/**
+ * @file sys_fs_posix.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "sys_fs_posix.h"
+
+#include "definitions.h"
+#include "prof.h"
+#include "sim_clock.h"
+#include "stats.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <time.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_OPEN_FILES 4
+#define MAX_OPEN_DIRS 2
+#define DIR_HANDLE_BASE 0x100 // directory handles are distinct from files
+
+// An SD card on a 15 MHz SPI bus, less command and CRC overhead.
+#define DEFAULT_CALL_US 300
+#define DEFAULT_BYTES_PER_S 1500000
+
+// Card blocks a transfer of n_bytes touches, for the stats counters.
+#define SD_BLOCK_SZ 512
+#define N_BLOCKS(_n_bytes) (((_n_bytes) + SD_BLOCK_SZ - 1) / SD_BLOCK_SZ)
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Return the open file for handle, or NULL (setting the error) if there
+ * is none.
+ */
+static FILE *file_for(SYS_FS_HANDLE handle);
+
+/**
+ * @brief Return the open directory for handle, or NULL (setting the error) if
+ * there is none.
+ */
+static DIR *dir_for(SYS_FS_HANDLE handle);
+
+/**
+ * @brief Map a path the firmware passes to SYS_FS into path on the host.
+ */
+static void host_path(char *path, size_t size, const char *fs_path);
+
+/**
+ * @brief Fill the FatFs-style date, time and attributes of stat from st.
+ */
+static void fstat_from_stat(SYS_FS_FSTAT *stat, const struct stat *st);
+
+/**
+ * @brief Translate errno into s_error.
+ */
+static void set_error_from_errno(void);
+
+/**
+ * @brief Charge sim_clock for a transfer of n_bytes to or from the card.
+ */
+static void charge_sd(size_t n_bytes);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const char *s_root = ".";
+
+static FILE *s_files[MAX_OPEN_FILES];
+
+static DIR *s_dirs[MAX_OPEN_DIRS];
+
+static char s_dir_paths[MAX_OPEN_DIRS][PATH_MAX];
+
+static char s_mount_name[SYS_FS_FILE_NAME_LEN + 1];
+
+static SYS_FS_ERROR s_error;
+
+static sys_fs_posix_timing_t s_timing = {DEFAULT_CALL_US, DEFAULT_BYTES_PER_S};
+
+static sys_fs_posix_stats_t s_stats;
+
+static bool s_fragmented;
+
+static const char *const s_modes[] = {
+    [SYS_FS_FILE_OPEN_READ] = "rb",
+    [SYS_FS_FILE_OPEN_WRITE] = "wb",
+    [SYS_FS_FILE_OPEN_APPEND] = "ab",
+    [SYS_FS_FILE_OPEN_READ_PLUS] = "r+b",
+    [SYS_FS_FILE_OPEN_WRITE_PLUS] = "w+b",
+    [SYS_FS_FILE_OPEN_APPEND_PLUS] = "a+b",
+};
+
+// *****************************************************************************
+// Public code
+
+void sys_fs_posix_set_root(const char *dir) {
+  s_root = dir;
+}
+
+sys_fs_posix_timing_t sys_fs_posix_timing_default(void) {
+  sys_fs_posix_timing_t timing = {
+      .call_us = DEFAULT_CALL_US,
+      .bytes_per_s = DEFAULT_BYTES_PER_S,
+  };
+  return timing;
+}
+
+void sys_fs_posix_set_timing(const sys_fs_posix_timing_t *timing) {
+  s_timing = *timing;
+}
+
+void sys_fs_posix_set_fragmented(bool fragmented) {
+  s_fragmented = fragmented;
+}
+
+sys_fs_posix_stats_t sys_fs_posix_stats_get(void) {
+  return s_stats;
+}
+
+void sys_fs_posix_stats_reset(void) {
+  memset(&s_stats, 0, sizeof(s_stats));
+}
+
+SYS_FS_HANDLE SYS_FS_FileOpen(const char *fname,
+                              SYS_FS_FILE_OPEN_ATTRIBUTES attributes) {
+  char path[PATH_MAX];
+
+  if ((unsigned)attributes >= sizeof(s_modes) / sizeof(s_modes[0])) {
+    s_error = SYS_FS_ERROR_INVALID_PARAMETER;
+    return SYS_FS_HANDLE_INVALID;
+  }
+  host_path(path, sizeof(path), fname);
+  for (SYS_FS_HANDLE handle = 0; handle < MAX_OPEN_FILES; handle++) {
+    if (s_files[handle] == NULL) {
+      s_files[handle] = fopen(path, s_modes[attributes]);
+      if (s_files[handle] == NULL) {
+        set_error_from_errno();
+        return SYS_FS_HANDLE_INVALID;
+      }
+      return handle;
+    }
+  }
+  s_error = SYS_FS_ERROR_TOO_MANY_OPEN_FILES;
+  return SYS_FS_HANDLE_INVALID;
+}
+
+SYS_FS_RESULT SYS_FS_FileClose(SYS_FS_HANDLE handle) {
+  FILE *file = file_for(handle);
+  int err;
+
+  if (file == NULL) {
+    return SYS_FS_RES_FAILURE;
+  }
+  s_files[handle] = NULL;
+  err = fclose(file);
+  if (err != 0) {
+    set_error_from_errno();
+    return SYS_FS_RES_FAILURE;
+  }
+  return SYS_FS_RES_SUCCESS;
+}
+
+size_t SYS_FS_FileRead(SYS_FS_HANDLE handle, void *buf, size_t nbyte) {
+  FILE *file = file_for(handle);
+  size_t n;
+
+  if (file == NULL) {
+    return (size_t)-1;
+  }
+  PROF_BEGIN(PROF_ZONE_FS_READ);
+  n = fread(buf, 1, nbyte, file);
+  s_stats.reads++;
+  s_stats.bytes_read += n;
+  STATS_ADD(STATS_SD_BLOCKS_READ, N_BLOCKS(n));
+  charge_sd(n);
+  PROF_END(PROF_ZONE_FS_READ);
+  if (n < nbyte && ferror(file)) {
+    set_error_from_errno();
+    return (size_t)-1;
+  }
+  return n;
+}
+
+size_t SYS_FS_FileWrite(SYS_FS_HANDLE handle, const void *buf, size_t nbyte) {
+  FILE *file = file_for(handle);
+  size_t n;
+
+  if (file == NULL) {
+    return (size_t)-1;
+  }
+  PROF_BEGIN(PROF_ZONE_FS_WRITE);
+  n = fwrite(buf, 1, nbyte, file);
+  s_stats.writes++;
+  s_stats.bytes_written += n;
+  STATS_ADD(STATS_SD_BLOCKS_WRITTEN, N_BLOCKS(n));
+  charge_sd(n);
+  PROF_END(PROF_ZONE_FS_WRITE);
+  if (n < nbyte) {
+    set_error_from_errno();
+    return (size_t)-1;
+  }
+  return n;
+}
+
+int32_t SYS_FS_FileSeek(SYS_FS_HANDLE handle,
+                        int32_t offset,
+                        SYS_FS_FILE_SEEK_CONTROL whence) {
+  static const int whences[] = {
+      [SYS_FS_SEEK_SET] = SEEK_SET,
+      [SYS_FS_SEEK_CUR] = SEEK_CUR,
+      [SYS_FS_SEEK_END] = SEEK_END,
+  };
+  FILE *file = file_for(handle);
+
+  if (file == NULL) {
+    return -1;
+  }
+  s_stats.seeks++;
+  if (fseek(file, offset, whences[whence]) != 0) {
+    set_error_from_errno();
+    return -1;
+  }
+  return (int32_t)ftell(file);
+}
+
+int32_t SYS_FS_FileTell(SYS_FS_HANDLE handle) {
+  FILE *file = file_for(handle);
+  return (file != NULL) ? (int32_t)ftell(file) : -1;
+}
+
+int32_t SYS_FS_FileSize(SYS_FS_HANDLE handle) {
+  FILE *file = file_for(handle);
+  long here;
+  long size;
+
+  if (file == NULL) {
+    return -1;
+  }
+  here = ftell(file);
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, here, SEEK_SET);
+  return (int32_t)size;
+}
+
+SYS_FS_RESULT SYS_FS_FileExpand(SYS_FS_HANDLE handle, uint32_t size) {
+  FILE *file = file_for(handle);
+
+  // Like f_expand(): the file gets its size, the file pointer stays put.
+  if (file == NULL) {
+    return SYS_FS_RES_FAILURE;
+  }
+  if (s_fragmented) {
+    s_error = SYS_FS_ERROR_DENIED;
+    return SYS_FS_RES_FAILURE;
+  }
+  if (fflush(file) != 0 || ftruncate(fileno(file), size) != 0) {
+    set_error_from_errno();
+    return SYS_FS_RES_FAILURE;
+  }
+  return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_RESULT SYS_FS_FileFastSeekEnable(SYS_FS_HANDLE handle,
+                                        uint32_t *linkMap,
+                                        uint32_t linkMapLength) {
+  (void)linkMap;
+  (void)linkMapLength;
+  return (file_for(handle) != NULL) ? SYS_FS_RES_SUCCESS : SYS_FS_RES_FAILURE;
+}
+
+SYS_FS_RESULT SYS_FS_FileWriteBehindEnable(SYS_FS_HANDLE handle, bool enable) {
+  (void)enable;
+  return (file_for(handle) != NULL) ? SYS_FS_RES_SUCCESS : SYS_FS_RES_FAILURE;
+}
+
+SYS_FS_RESULT SYS_FS_FileWriteBehindTasks(SYS_FS_HANDLE handle) {
+  return (file_for(handle) != NULL) ? SYS_FS_RES_SUCCESS : SYS_FS_RES_FAILURE;
+}
+
+SYS_FS_RESULT SYS_FS_Mount(const char *devName,
+                           const char *mountName,
+                           SYS_FS_FILE_SYSTEM_TYPE filesystemtype,
+                           unsigned long mountflags,
+                           const void *data) {
+  struct stat st;
+
+  (void)devName;
+  (void)filesystemtype;
+  (void)mountflags;
+  (void)data;
+  if (stat(s_root, &st) != 0 || !S_ISDIR(st.st_mode)) {
+    s_error = SYS_FS_ERROR_NOT_READY;
+    return SYS_FS_RES_FAILURE;
+  }
+  snprintf(s_mount_name, sizeof(s_mount_name), "%s", mountName);
+  return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_RESULT SYS_FS_Unmount(const char *mountName) {
+  if (strcmp(mountName, s_mount_name) != 0) {
+    s_error = SYS_FS_ERROR_INVALID_NAME;
+    return SYS_FS_RES_FAILURE;
+  }
+  s_mount_name[0] = '\0';
+  return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_RESULT SYS_FS_CurrentDriveSet(const char *path) {
+  // There is only the one drive, and relative paths are already taken from it.
+  if (s_mount_name[0] == '\0' || strcmp(path, s_mount_name) != 0) {
+    s_error = SYS_FS_ERROR_INVALID_DRIVE;
+    return SYS_FS_RES_FAILURE;
+  }
+  return SYS_FS_RES_SUCCESS;
+}
+
+bool SYS_FS_MEDIA_MANAGER_MediaStatusGet(const char *devName) {
+  struct stat st;
+
+  // The card is "inserted" while its directory exists.
+  (void)devName;
+  return stat(s_root, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+SYS_FS_RESULT SYS_FS_DriveLabelGet(const char *drive,
+                                   char *buff,
+                                   uint32_t *sn) {
+  struct stat st;
+  const char *name = strrchr(s_root, '/');
+
+  (void)drive;
+  if (stat(s_root, &st) != 0) {
+    set_error_from_errno();
+    return SYS_FS_RES_FAILURE;
+  }
+  // A FAT label is at most 11 characters: use the start of the directory name.
+  snprintf(buff, 12, "%s", name ? name + 1 : s_root);
+  *sn = (uint32_t)(st.st_dev ^ st.st_ino);
+  return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_RESULT SYS_FS_DriveSectorGet(const char *path,
+                                    uint32_t *totalSectors,
+                                    uint32_t *freeSectors) {
+  struct statvfs vfs;
+  uint64_t sectors_per_block;
+
+  (void)path;
+  if (statvfs(s_root, &vfs) != 0) {
+    set_error_from_errno();
+    return SYS_FS_RES_FAILURE;
+  }
+  // In 512 byte sectors, as FatFs counts them.
+  sectors_per_block = vfs.f_frsize / 512;
+  *totalSectors = (uint32_t)(vfs.f_blocks * sectors_per_block);
+  *freeSectors = (uint32_t)(vfs.f_bfree * sectors_per_block);
+  return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_HANDLE SYS_FS_DirOpen(const char *path) {
+  for (int i = 0; i < MAX_OPEN_DIRS; i++) {
+    if (s_dirs[i] == NULL) {
+      host_path(s_dir_paths[i], sizeof(s_dir_paths[i]), path);
+      s_dirs[i] = opendir(s_dir_paths[i]);
+      if (s_dirs[i] == NULL) {
+        set_error_from_errno();
+        return SYS_FS_HANDLE_INVALID;
+      }
+      return DIR_HANDLE_BASE + i;
+    }
+  }
+  s_error = SYS_FS_ERROR_TOO_MANY_OPEN_FILES;
+  return SYS_FS_HANDLE_INVALID;
+}
+
+SYS_FS_RESULT SYS_FS_DirClose(SYS_FS_HANDLE handle) {
+  DIR *dir = dir_for(handle);
+
+  if (dir == NULL) {
+    return SYS_FS_RES_FAILURE;
+  }
+  s_dirs[handle - DIR_HANDLE_BASE] = NULL;
+  closedir(dir);
+  return SYS_FS_RES_SUCCESS;
+}
+
+SYS_FS_RESULT SYS_FS_DirRead(SYS_FS_HANDLE handle, SYS_FS_FSTAT *stat) {
+  DIR *dir = dir_for(handle);
+  struct dirent *entry;
+  char path[PATH_MAX];
+  struct stat st;
+
+  if (dir == NULL) {
+    return SYS_FS_RES_FAILURE;
+  }
+  if (stat->lfname != NULL && stat->lfsize > 0) {
+    stat->lfname[0] = '\0'; // long names are returned in fname
+  }
+  for (;;) {
+    errno = 0;
+    entry = readdir(dir);
+    if (entry == NULL) {
+      if (errno != 0) {
+        set_error_from_errno();
+        return SYS_FS_RES_FAILURE;
+      }
+      // Like f_readdir(): the end of the directory is an empty name.
+      stat->fname[0] = '\0';
+      return SYS_FS_RES_SUCCESS;
+    }
+    snprintf(path,
+             sizeof(path),
+             "%s/%s",
+             s_dir_paths[handle - DIR_HANDLE_BASE],
+             entry->d_name);
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+        strlen(entry->d_name) > SYS_FS_FILE_NAME_LEN || lstat(path, &st) != 0 ||
+        !(S_ISREG(st.st_mode) || S_ISDIR(st.st_mode))) {
+      continue; // nothing FAT could hold
+    }
+    snprintf(stat->fname, sizeof(stat->fname), "%s", entry->d_name);
+    snprintf(stat->altname, sizeof(stat->altname), "%.12s", entry->d_name);
+    stat->fsize = S_ISREG(st.st_mode) ? (uint32_t)st.st_size : 0;
+    fstat_from_stat(stat, &st);
+    return SYS_FS_RES_SUCCESS;
+  }
+}
+
+SYS_FS_ERROR SYS_FS_Error(void) {
+  return s_error;
+}
+
+SYS_FS_ERROR SYS_FS_FileError(SYS_FS_HANDLE handle) {
+  (void)handle;
+  return s_error;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static FILE *file_for(SYS_FS_HANDLE handle) {
+  if (handle >= MAX_OPEN_FILES || s_files[handle] == NULL) {
+    s_error = SYS_FS_ERROR_INVALID_OBJECT;
+    return NULL;
+  }
+  return s_files[handle];
+}
+
+static DIR *dir_for(SYS_FS_HANDLE handle) {
+  if (handle < DIR_HANDLE_BASE || handle >= DIR_HANDLE_BASE + MAX_OPEN_DIRS ||
+      s_dirs[handle - DIR_HANDLE_BASE] == NULL) {
+    s_error = SYS_FS_ERROR_INVALID_OBJECT;
+    return NULL;
+  }
+  return s_dirs[handle - DIR_HANDLE_BASE];
+}
+
+static void host_path(char *path, size_t size, const char *fs_path) {
+  size_t mount_len = strlen(s_mount_name);
+
+  // "/mnt/mydrive/a/b", "a/b" (relative to the current drive) and "/a/b" all
+  // name a/b under the root.
+  if (mount_len > 0 && strncmp(fs_path, s_mount_name, mount_len) == 0 &&
+      (fs_path[mount_len] == '/' || fs_path[mount_len] == '\0')) {
+    fs_path += mount_len;
+  }
+  while (*fs_path == '/') {
+    fs_path++;
+  }
+  snprintf(path, size, "%s/%s", s_root, fs_path);
+}
+
+static void fstat_from_stat(SYS_FS_FSTAT *stat, const struct stat *st) {
+  struct tm tm;
+
+  localtime_r(&st->st_mtime, &tm);
+  if (tm.tm_year < 80) {
+    memset(&tm, 0, sizeof(tm)); // before 1980: FAT's earliest date
+    tm.tm_year = 80;
+    tm.tm_mday = 1;
+  }
+  stat->fdate = (uint16_t)(((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) |
+                           tm.tm_mday);
+  stat->ftime =
+      (uint16_t)((tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2));
+  stat->fattrib = S_ISDIR(st->st_mode) ? SYS_FS_ATTR_DIR : SYS_FS_ATTR_ARC;
+  if (!(st->st_mode & S_IWUSR)) {
+    stat->fattrib |= SYS_FS_ATTR_RDO;
+  }
+}
+
+static void set_error_from_errno(void) {
+  switch (errno) {
+  case ENOENT:
+    s_error = SYS_FS_ERROR_NO_FILE;
+    break;
+  case ENOTDIR:
+    s_error = SYS_FS_ERROR_NO_PATH;
+    break;
+  case EACCES:
+  case EPERM:
+  case EISDIR:
+    s_error = SYS_FS_ERROR_DENIED;
+    break;
+  case EEXIST:
+    s_error = SYS_FS_ERROR_EXIST;
+    break;
+  case EMFILE:
+  case ENFILE:
+    s_error = SYS_FS_ERROR_TOO_MANY_OPEN_FILES;
+    break;
+  case ENOSPC:
+    s_error = SYS_FS_ERROR_NOT_ENOUGH_FREE_VOLUME;
+    break;
+  default:
+    s_error = SYS_FS_ERROR_DISK_ERR;
+    break;
+  }
+}
+
+static void charge_sd(size_t n_bytes) {
+  uint64_t ns = s_timing.call_us * SIM_CLOCK_NS_PER_US;
+
+  if (s_timing.bytes_per_s > 0) {
+    ns += (n_bytes * SIM_CLOCK_NS_PER_S) / s_timing.bytes_per_s;
+  }
+  sim_clock_advance(ns);
+}
+
+// *****************************************************************************
+// End of file
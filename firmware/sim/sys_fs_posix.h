@@ -0,0 +1,119 @@
+/**
+ * @file sys_fs_posix.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief SYS_FS for the host build, over a host directory.
+ *
+ * The directory given to sys_fs_posix_set_root() stands in for the SD card.
+ * SYS_FS_Mount() succeeds while it exists, and paths under the mount name
+ * (such as "/mnt/mydrive/sub/a.img") or relative to the current drive ("sub/
+ * a.img") name files and directories under it.  Directory reads return what
+ * FatFs would: names, sizes, attributes and FAT dates, with an empty name at
+ * the end.  The drive's serial number and sector counts come from the host
+ * file system, so the firmware's change detection sees a new card when the
+ * directory is replaced or files come and go.  Fast seek and write-behind
+ * are accepted and do nothing: the host's own file cache does their job.
+ *
+ * Each read and write charges sim_clock for the time an SD card would take,
+ * per sys_fs_posix_timing_t, and is counted in sys_fs_posix_stats_t.  The
+ * model is deliberately simple: a fixed cost per call plus a transfer rate,
+ * with no overlap between the card and the WINC.
+ */
+
+#ifndef _SYS_FS_POSIX_H_
+#define _SYS_FS_POSIX_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+typedef struct {
+  uint32_t call_us;      // fixed cost of each read or write
+  uint32_t bytes_per_s;  // transfer rate, 0 for instantaneous
+} sys_fs_posix_timing_t;
+
+typedef struct {
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t seeks;
+  uint64_t bytes_read;
+  uint64_t bytes_written;
+} sys_fs_posix_stats_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Set the directory that stands in for the SD card.  Defaults to ".".
+ */
+void sys_fs_posix_set_root(const char *dir);
+
+/**
+ * @brief Return timings typical of an SD card on the SAME54 XPRO's SPI bus.
+ */
+sys_fs_posix_timing_t sys_fs_posix_timing_default(void);
+
+/**
+ * @brief Set the costs charged for file reads and writes.
+ */
+void sys_fs_posix_set_timing(const sys_fs_posix_timing_t *timing);
+
+/**
+ * @brief If fragmented is true, SYS_FS_FileExpand() fails with
+ * SYS_FS_ERROR_DENIED, as on a card with no contiguous free run that long.
+ */
+void sys_fs_posix_set_fragmented(bool fragmented);
+
+/**
+ * @brief Return the counts of file operations since the last reset.
+ */
+sys_fs_posix_stats_t sys_fs_posix_stats_get(void);
+
+/**
+ * @brief Zero the counts returned by sys_fs_posix_stats_get().
+ */
+void sys_fs_posix_stats_reset(void);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SYS_FS_POSIX_H_ */
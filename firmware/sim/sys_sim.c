@@ -0,0 +1,375 @@
+/**
+ * @file sys_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Harmony system services for the host build.
+ *
+ * SYS_DEBUG and SYS_CONSOLE write to stdout, or to a pseudo-terminal that
+ * stands in for the board's serial port; SYS_CONSOLE reads from the same place
+ * without waiting, as the UART console does.  SYS_TIME counts at the target's
+ * 60 MHz on sim_clock.c.  On its virtual clock a delay completes by moving the
+ * clock to its deadline, so waiting costs no real time.
+ */
+
+// *****************************************************************************
+// Includes
+
+#define _GNU_SOURCE // posix_openpt() and friends
+
+#include "sys_sim.h"
+
+#include "definitions.h"
+#include "sim_clock.h"
+#include "target_printf.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define SYS_TIME_HZ 60000000 // TC0 counter rate on the target
+#define CONSOLE_BUFFER_SIZE 4096
+#define MAX_DELAYS 8
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static void console_vprint(const char *format, va_list ap);
+
+static void console_write(const void *buf, size_t count);
+
+/**
+ * @brief Return the file descriptor that console input comes from, or -1.
+ */
+static int console_input_fd(void);
+
+// *****************************************************************************
+// Private (static) storage
+
+static bool s_console_muted;
+
+static int s_pty_master = -1; // console on a pty, else on stdout
+
+static int s_pty_slave = -1; // held open so the pty outlives its clients
+
+static bool s_stdin_input; // console input from stdin
+
+static bool s_stdin_termios_saved;
+
+static struct termios s_stdin_termios;
+
+static uint32_t s_console_drops; // bytes the pty had no room for
+
+static SYS_ERROR_LEVEL s_error_level = SYS_DEBUG_GLOBAL_ERROR_LEVEL;
+
+static uint64_t s_delay_deadlines[MAX_DELAYS];
+
+static DWT_Type s_dwt; // CYCCNT is refreshed on every read through DWT
+
+// *****************************************************************************
+// Public code
+
+void sys_sim_console_mute(bool mute) {
+  s_console_muted = mute;
+}
+
+bool sys_sim_console_open_pty(char *name, size_t size) {
+  struct termios tio;
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ||
+      ptsname_r(master, name, size) != 0) {
+    goto fail;
+  }
+  s_pty_slave = open(name, O_RDWR | O_NOCTTY);
+  if (s_pty_slave < 0 || tcgetattr(s_pty_slave, &tio) != 0) {
+    goto fail;
+  }
+  // Bytes pass through untouched, as on the UART.
+  cfmakeraw(&tio);
+  if (tcsetattr(s_pty_slave, TCSANOW, &tio) != 0 ||
+      fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK) != 0) {
+    goto fail;
+  }
+  s_pty_master = master;
+  return true;
+
+fail:
+  if (s_pty_slave >= 0) {
+    close(s_pty_slave);
+    s_pty_slave = -1;
+  }
+  if (master >= 0) {
+    close(master);
+  }
+  return false;
+}
+
+void sys_sim_console_open_stdio(void) {
+  struct termios tio;
+
+  s_stdin_input = true;
+  if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &s_stdin_termios) == 0) {
+    // Pass each key to the firmware as it is typed; the firmware echoes.
+    s_stdin_termios_saved = true;
+    tio = s_stdin_termios;
+    tio.c_lflag &= ~(ICANON | ECHO);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+  }
+}
+
+void sys_sim_console_close(void) {
+  if (s_pty_master >= 0) {
+    close(s_pty_master);
+    close(s_pty_slave);
+    s_pty_master = s_pty_slave = -1;
+  }
+  if (s_stdin_termios_saved) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &s_stdin_termios);
+    s_stdin_termios_saved = false;
+  }
+  s_stdin_input = false;
+  fflush(stdout);
+}
+
+bool sys_sim_console_wait(uint32_t ms) {
+  struct pollfd pfd = {.fd = console_input_fd(), .events = POLLIN};
+
+  if (pfd.fd < 0) {
+    usleep(ms * 1000);
+    return false;
+  }
+  return poll(&pfd, 1, (int)ms) > 0;
+}
+
+// SYS_DEBUG
+
+void SYS_DEBUG_ErrorLevelSet(SYS_ERROR_LEVEL level) {
+  s_error_level = level;
+}
+
+SYS_ERROR_LEVEL SYS_DEBUG_ErrorLevelGet(void) {
+  return s_error_level;
+}
+
+void SYS_DEBUG_Print(const char *format, ...) {
+  va_list ap;
+
+  va_start(ap, format);
+  console_vprint(format, ap);
+  va_end(ap);
+}
+
+void SYS_DEBUG_Message(const char *message) {
+  console_write(message, strlen(message));
+}
+
+// SYS_CONSOLE
+
+ssize_t SYS_CONSOLE_Write(const SYS_CONSOLE_HANDLE handle,
+                          const void *buf,
+                          size_t count) {
+  (void)handle;
+  console_write(buf, count);
+  return count;
+}
+
+ssize_t SYS_CONSOLE_Read(const SYS_CONSOLE_HANDLE handle,
+                         void *buf,
+                         size_t count) {
+  int fd = console_input_fd();
+  ssize_t n_read;
+
+  (void)handle;
+  if (fd < 0 || !sys_sim_console_wait(0)) {
+    return 0;
+  }
+  n_read = read(fd, buf, count);
+  if (n_read == 0 && fd == STDIN_FILENO) {
+    s_stdin_input = false; // end of input: nothing more will come
+  }
+  return (n_read > 0) ? n_read : 0;
+}
+
+ssize_t SYS_CONSOLE_WriteFreeBufferCountGet(const SYS_CONSOLE_HANDLE handle) {
+  (void)handle;
+  return CONSOLE_BUFFER_SIZE; // never waits: a full pty drops, like the UART
+}
+
+void SYS_CONSOLE_Print(const SYS_CONSOLE_HANDLE handle,
+                       const char *format,
+                       ...) {
+  va_list ap;
+
+  (void)handle;
+  va_start(ap, format);
+  console_vprint(format, ap);
+  va_end(ap);
+}
+
+void SYS_CONSOLE_Message(const SYS_CONSOLE_HANDLE handle,
+                         const char *message) {
+  (void)handle;
+  console_write(message, strlen(message));
+}
+
+uint32_t SERCOM2_USART_WriteDropCountGet(void) {
+  return s_console_drops;
+}
+
+// DWT, for prof.h
+
+CoreDebug_Type g_sim_core_debug;
+
+DWT_Type *sim_dwt(void) {
+  uint64_t ns = sim_clock_now();
+
+  s_dwt.CYCCNT = (uint32_t)((ns * (CPU_CLOCK_FREQUENCY / 1000000)) /
+                            (SIM_CLOCK_NS_PER_S / 1000000));
+  return &s_dwt;
+}
+
+// SYS_TIME
+
+uint32_t SYS_TIME_FrequencyGet(void) {
+  return SYS_TIME_HZ;
+}
+
+uint32_t SYS_TIME_CounterGet(void) {
+  return (uint32_t)((sim_clock_now() * (SYS_TIME_HZ / 1000000)) /
+                    (SIM_CLOCK_NS_PER_S / 1000000));
+}
+
+uint64_t SYS_TIME_Counter64Get(void) {
+  return (sim_clock_now() * (SYS_TIME_HZ / 1000000)) /
+         (SIM_CLOCK_NS_PER_S / 1000000);
+}
+
+uint32_t SYS_TIME_CountToUS(uint32_t count) {
+  return count / (SYS_TIME_HZ / 1000000);
+}
+
+uint32_t SYS_TIME_CountToMS(uint32_t count) {
+  return count / (SYS_TIME_HZ / 1000);
+}
+
+uint32_t SYS_TIME_USToCount(uint32_t us) {
+  return us * (SYS_TIME_HZ / 1000000);
+}
+
+uint32_t SYS_TIME_MSToCount(uint32_t ms) {
+  return ms * (SYS_TIME_HZ / 1000);
+}
+
+SYS_TIME_RESULT SYS_TIME_DelayUS(uint32_t us, SYS_TIME_HANDLE *handle) {
+  for (int i = 0; i < MAX_DELAYS; i++) {
+    if (s_delay_deadlines[i] == 0) {
+      s_delay_deadlines[i] =
+          sim_clock_now() + (uint64_t)us * SIM_CLOCK_NS_PER_US + 1;
+      *handle = (SYS_TIME_HANDLE)i;
+      return SYS_TIME_SUCCESS;
+    }
+  }
+  *handle = SYS_TIME_HANDLE_INVALID;
+  return SYS_TIME_ERROR;
+}
+
+SYS_TIME_RESULT SYS_TIME_DelayMS(uint32_t ms, SYS_TIME_HANDLE *handle) {
+  return SYS_TIME_DelayUS(ms * 1000, handle);
+}
+
+bool SYS_TIME_DelayIsComplete(SYS_TIME_HANDLE handle) {
+  if (handle >= MAX_DELAYS || s_delay_deadlines[handle] == 0) {
+    return true;
+  }
+  if (!sim_clock_wait_until(s_delay_deadlines[handle] - 1)) {
+    return false;
+  }
+  s_delay_deadlines[handle] = 0;
+  return true;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void console_vprint(const char *format, va_list ap) {
+  char buf[SYS_CONSOLE_PRINT_BUFFER_SIZE];
+  int len = target_vsnprintf(buf, sizeof(buf), format, ap);
+
+  if (len >= (int)sizeof(buf)) {
+    len = sizeof(buf) - 1; // truncated, as on the target
+  }
+  if (len > 0) {
+    console_write(buf, len);
+  }
+}
+
+static void console_write(const void *buf, size_t count) {
+  ssize_t n_written;
+
+  if (s_console_muted) {
+    return;
+  } else if (s_pty_master < 0) {
+    fwrite(buf, 1, count, stdout);
+    if (s_stdin_input) {
+      fflush(stdout); // someone is typing: show prompts as they come
+    }
+    return;
+  }
+  while (count > 0) {
+    n_written = write(s_pty_master, buf, count);
+    if (n_written < 0 && errno == EINTR) {
+      continue;
+    } else if (n_written <= 0) {
+      s_console_drops += count; // nobody is reading and the pty is full
+      return;
+    }
+    buf = (const char *)buf + n_written;
+    count -= n_written;
+  }
+}
+
+static int console_input_fd(void) {
+  if (s_pty_master >= 0) {
+    return s_pty_master;
+  }
+  return s_stdin_input ? STDIN_FILENO : -1;
+}
+
+// *****************************************************************************
+// End of file
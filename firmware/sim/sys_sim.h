@@ -0,0 +1,89 @@
+/**
+ * @file sys_sim.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Controls for the host versions of the Harmony system services in
+ * sys_sim.c.
+ */
+
+#ifndef _SYS_SIM_H_
+#define _SYS_SIM_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Discard (mute true) or print (mute false, the default) everything
+ * the firmware writes through SYS_CONSOLE and SYS_DEBUG.
+ */
+void sys_sim_console_mute(bool mute);
+
+/**
+ * @brief Move the console to a new pseudo-terminal, for a terminal emulator or
+ * host/winc_cloner_client.py to open as they would the board's serial port.
+ * Copies the name of its terminal device into name.  Returns false on failure.
+ */
+bool sys_sim_console_open_pty(char *name, size_t size);
+
+/**
+ * @brief Read console input from stdin, a key at a time if it is a terminal.
+ * (Without this or a pty, the console has no input.)
+ */
+void sys_sim_console_open_stdio(void);
+
+/**
+ * @brief Close the console's pty or restore stdin's terminal settings.
+ */
+void sys_sim_console_close(void);
+
+/**
+ * @brief Wait up to ms milliseconds for console input.  Returns true if there
+ * is some.
+ */
+bool sys_sim_console_wait(uint32_t ms);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SYS_SIM_H_ */
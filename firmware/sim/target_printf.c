@@ -0,0 +1,119 @@
+/**
+ * @file target_printf.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "target_printf.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// target_printf.h renames the functions it replaces: call the real ones here.
+#undef printf
+#undef sprintf
+#undef snprintf
+#undef vsnprintf
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_FORMAT_LENGTH 256
+#define MAX_OUTPUT_LENGTH 1024
+
+// *****************************************************************************
+// Public code
+
+int target_printf(const char *fmt, ...) {
+  char buf[MAX_OUTPUT_LENGTH];
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  len = target_vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  fputs(buf, stdout);
+  return len;
+}
+
+int target_sprintf(char *buf, const char *fmt, ...) {
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  len = target_vsnprintf(buf, MAX_OUTPUT_LENGTH, fmt, ap);
+  va_end(ap);
+  return len;
+}
+
+int target_snprintf(char *buf, size_t size, const char *fmt, ...) {
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  len = target_vsnprintf(buf, size, fmt, ap);
+  va_end(ap);
+  return len;
+}
+
+int target_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap) {
+  char format[MAX_FORMAT_LENGTH];
+
+  return vsnprintf(buf, size, target_format(format, sizeof(format), fmt), ap);
+}
+
+const char *target_format(char *buf, size_t size, const char *fmt) {
+  size_t len = 0;
+
+  while (*fmt != '\0' && len < size - 1) {
+    char c = *fmt++;
+    buf[len++] = c;
+    if (c != '%') {
+      continue;
+    }
+    // flags, width and precision pass through unchanged...
+    while (*fmt != '\0' && strchr("-+ #0123456789.*", *fmt) != NULL &&
+           len < size - 1) {
+      buf[len++] = *fmt++;
+    }
+    // ...but a single 'l' before an integer conversion is dropped.
+    if (fmt[0] == 'l' && fmt[1] != '\0' && strchr("diouxX", fmt[1]) != NULL) {
+      fmt++;
+    } else if (fmt[0] == 'l' && fmt[1] == 'l' && len < size - 2) {
+      buf[len++] = *fmt++;
+      buf[len++] = *fmt++;
+    }
+  }
+  buf[len] = '\0';
+  return buf;
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,87 @@
+/**
+ * @file target_printf.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief printf() as the target does it, for code compiled from src/.
+ *
+ * The firmware passes uint32_t values for %ld, %lu and %lx, which is right
+ * where long is 32 bits wide but not on a 64-bit host.  The Makefile forces
+ * this header into every source file shared with the target, so their calls
+ * to the printf() family go to versions in target_printf.c that drop the
+ * 'l' from integer conversions before formatting.  %lld and the like keep
+ * their meaning.
+ */
+
+#ifndef _TARGET_PRINTF_H_
+#define _TARGET_PRINTF_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define printf target_printf
+#define sprintf target_sprintf
+#define snprintf target_snprintf
+#define vsnprintf target_vsnprintf
+
+// *****************************************************************************
+// Public declarations
+
+int target_printf(const char *fmt, ...);
+
+int target_sprintf(char *buf, const char *fmt, ...);
+
+int target_snprintf(char *buf, size_t size, const char *fmt, ...);
+
+int target_vsnprintf(char *buf, size_t size, const char *fmt, va_list ap);
+
+/**
+ * @brief Copy fmt into buf (of size bytes) without the 'l' of %ld, %lu, %lx
+ * and so on, and return buf.  A format too long for buf is truncated.
+ */
+const char *target_format(char *buf, size_t size, const char *fmt);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _TARGET_PRINTF_H_ */
@@ -0,0 +1,230 @@
+/**
+ * @file winc_cloner_app.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Run the whole winc-cloner application on the host.
+ *
+ *     winc_cloner_app [option]... FLASH_FILE
+ *
+ * This is the firmware's super-loop, APP_Initialize() then APP_Tasks() over
+ * and over, with the console on a pseudo-terminal (or with --stdio, on stdin
+ * and stdout), the --dir directory as the SD card and FLASH_FILE as the
+ * simulated WINC's flash.  Open the terminal named at startup with a terminal
+ * emulator, or drive it with host/winc_cloner_client.py, as the board's serial
+ * port.  Time follows the host's clock, so timeouts behave as on the target,
+ * plus the modelled cost of each WINC and SD operation.
+ *
+ * SIGINT or SIGTERM stop the loop and close the flash file.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "app.h"
+#include "definitions.h"
+#include "sim_clock.h"
+#include "sys_fs_posix.h"
+#include "sys_sim.h"
+#include "winc_sim.h"
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// How long each pass of the super-loop may wait for console input.
+#define IDLE_WAIT_MS 1
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static void on_signal(int signum);
+
+static void usage(const char *program);
+
+// *****************************************************************************
+// Private (static) storage
+
+static volatile sig_atomic_t s_stop;
+
+static const struct option s_options[] = {
+    {"dir", required_argument, NULL, 'd'},
+    {"stdio", no_argument, NULL, 'i'},
+    {"pty-link", required_argument, NULL, 'k'},
+    {"debug", no_argument, NULL, 'g'},
+    {"spi-hz", required_argument, NULL, 's'},
+    {"spi-call-ns", required_argument, NULL, 'c'},
+    {"flash-spi-hz", required_argument, NULL, 'f'},
+    {"erase-us", required_argument, NULL, 'e'},
+    {"program-us", required_argument, NULL, 'p'},
+    {"sd-call-us", required_argument, NULL, 'l'},
+    {"sd-bytes-per-s", required_argument, NULL, 'b'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+};
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+  winc_sim_timing_t timing = winc_sim_timing_default();
+  sys_fs_posix_timing_t sd_timing = sys_fs_posix_timing_default();
+  const char *pty_link = NULL;
+  bool use_stdio = false;
+  char pty_name[PATH_MAX];
+  struct sigaction action = {.sa_handler = on_signal};
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "d:gh", s_options, NULL)) != -1) {
+    switch (opt) {
+    case 'd':
+      sys_fs_posix_set_root(optarg);
+      break;
+    case 'i':
+      use_stdio = true;
+      break;
+    case 'k':
+      pty_link = optarg;
+      break;
+    case 'g':
+      SYS_DEBUG_ErrorLevelSet(SYS_ERROR_DEBUG);
+      break;
+    case 's':
+      timing.spi_hz = strtoul(optarg, NULL, 0);
+      break;
+    case 'c':
+      timing.spi_call_ns = strtoul(optarg, NULL, 0);
+      break;
+    case 'f':
+      timing.flash_spi_hz = strtoul(optarg, NULL, 0);
+      break;
+    case 'e':
+      timing.sector_erase_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      timing.page_program_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      sd_timing.call_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'b':
+      sd_timing.bytes_per_s = strtoul(optarg, NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind + 1 != argc || (use_stdio && pty_link != NULL) ||
+      timing.spi_hz == 0 || timing.flash_spi_hz == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (use_stdio) {
+    sys_sim_console_open_stdio();
+  } else if (!sys_sim_console_open_pty(pty_name, sizeof(pty_name))) {
+    perror("pseudo-terminal");
+    return 1;
+  } else if (pty_link != NULL &&
+             ((unlink(pty_link) != 0 && errno != ENOENT) ||
+              symlink(pty_name, pty_link) != 0)) {
+    perror(pty_link);
+    sys_sim_console_close();
+    return 1;
+  } else {
+    fprintf(stderr, "console on %s\n", pty_link ? pty_link : pty_name);
+  }
+
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  sim_clock_set_source(SIM_CLOCK_MONOTONIC);
+  sys_fs_posix_set_timing(&sd_timing);
+  if (!winc_sim_open(argv[optind], &timing)) {
+    sys_sim_console_close();
+    return 1;
+  }
+
+  APP_Initialize();
+  while (!s_stop) {
+    APP_Tasks();
+    sys_sim_console_wait(IDLE_WAIT_MS);
+  }
+
+  winc_sim_close();
+  sys_sim_console_close();
+  if (pty_link != NULL) {
+    unlink(pty_link);
+  }
+  return 0;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void on_signal(int signum) {
+  (void)signum;
+  s_stop = 1;
+}
+
+static void usage(const char *program) {
+  winc_sim_timing_t timing = winc_sim_timing_default();
+  sys_fs_posix_timing_t sd_timing = sys_fs_posix_timing_default();
+
+  fprintf(stderr,
+          "usage: %s [option]... FLASH_FILE\n"
+          "options:\n"
+          "  --dir DIR           directory standing in for the SD card "
+          "(default .)\n"
+          "  --stdio             console on stdin and stdout, not a pty\n"
+          "  --pty-link PATH     make PATH a symbolic link to the pty\n"
+          "  --debug             log at SYS_ERROR_DEBUG, including binlog\n"
+          "  --spi-hz N          WINC SPI clock (default %u)\n"
+          "  --spi-call-ns N     overhead of each SPI transfer (default %u)\n"
+          "  --flash-spi-hz N    WINC to flash SPI clock (default %u)\n"
+          "  --erase-us N        sector erase time (default %u)\n"
+          "  --program-us N      page program time (default %u)\n"
+          "  --sd-call-us N      overhead of each SD read or write (default %u)\n"
+          "  --sd-bytes-per-s N  SD transfer rate (default %u)\n",
+          program,
+          timing.spi_hz,
+          timing.spi_call_ns,
+          timing.flash_spi_hz,
+          timing.sector_erase_us,
+          timing.page_program_us,
+          sd_timing.call_us,
+          sd_timing.bytes_per_s);
+}
+
+// *****************************************************************************
+// End of file
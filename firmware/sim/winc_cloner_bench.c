@@ -0,0 +1,398 @@
+/**
+ * @file winc_cloner_bench.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Throughput benchmark for the cloner, run against the simulated WINC.
+ *
+ *     winc_cloner_bench [option]...
+ *
+ * Each scenario loads the simulated flash with a starting image, then times
+ * three phases against the newer image in images/: compare, update and
+ * extract.  The scenarios are
+ *
+ *     identical   the flash already holds the new image
+ *     delta       the flash holds the previous release (a typical update)
+ *     different   the flash holds the new image with every bit inverted
+ *
+ * For each phase the benchmark reports the simulated time, sectors per
+ * second, sectors found different or programmed, the traffic on the WINC SPI
+ * bus (transfers, nmspi commands, kilobytes), the flash erases and page
+ * programs, and the kilobytes read from and written to the SD card.  All of
+ * it comes from the models, so a run is exactly repeatable: compare the
+ * numbers before and after a change to winc_cloner.c, spi_flash.c or nmspi.c.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "definitions.h"
+#include "progress.h"
+#include "sim_clock.h"
+#include "sys_fs_posix.h"
+#include "sys_sim.h"
+#include "winc_cloner.h"
+#include "winc_sim.h"
+#include <getopt.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define OLD_IMAGE "m2m_aio_3a0_v19_5_4.img"
+#define NEW_IMAGE "m2m_aio_3a0_v19_7_7.img"
+#define EXTRACT_IMAGE "bench_extract.img"
+#define FLASH_FILE "bench_flash.bin"
+
+typedef struct {
+  const char *name;
+  const char *start_image; // loaded into the flash before the first phase
+  bool invert;             // ...with every bit inverted
+} scenario_t;
+
+typedef enum {
+  PHASE_COMPARE,
+  PHASE_UPDATE,
+  PHASE_EXTRACT,
+  N_PHASES,
+} phase_t;
+
+typedef struct {
+  bool ok;
+  uint32_t n_sectors;
+  uint32_t n_changed; // sectors that differ (compare) or were programmed
+  uint64_t ns;
+  winc_sim_stats_t winc;
+  sys_fs_posix_stats_t sd;
+} phase_result_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static bool load_flash(const scenario_t *scenario);
+
+static bool run_phase(phase_t phase, phase_result_t *result);
+
+static void observe_progress(uint32_t n_done,
+                             uint32_t n_sectors,
+                             uint32_t n_changed);
+
+static void print_header(void);
+
+static void print_result(const char *scenario,
+                         phase_t phase,
+                         const phase_result_t *result);
+
+static void usage(const char *program);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const scenario_t s_scenarios[] = {
+    {"identical", NEW_IMAGE, false},
+    {"delta", OLD_IMAGE, false},
+    {"different", NEW_IMAGE, true},
+};
+
+static const char *const s_phase_names[N_PHASES] = {
+    [PHASE_COMPARE] = "compare",
+    [PHASE_UPDATE] = "update",
+    [PHASE_EXTRACT] = "extract",
+};
+
+static const struct option s_options[] = {
+    {"images", required_argument, NULL, 'i'},
+    {"work", required_argument, NULL, 'w'},
+    {"csv", no_argument, NULL, 'v'},
+    {"spi-hz", required_argument, NULL, 's'},
+    {"spi-call-ns", required_argument, NULL, 'c'},
+    {"flash-spi-hz", required_argument, NULL, 'f'},
+    {"erase-us", required_argument, NULL, 'e'},
+    {"program-us", required_argument, NULL, 'p'},
+    {"sd-call-us", required_argument, NULL, 'l'},
+    {"sd-bytes-per-s", required_argument, NULL, 'b'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+};
+
+static const char *s_images_dir = "../../images";
+static const char *s_work_dir = "build";
+static bool s_csv;
+static winc_sim_timing_t s_winc_timing;
+static uint32_t s_n_sectors;
+static uint32_t s_n_changed;
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+  sys_fs_posix_timing_t sd_timing = sys_fs_posix_timing_default();
+  bool ok = true;
+  int opt;
+
+  s_winc_timing = winc_sim_timing_default();
+  while ((opt = getopt_long(argc, argv, "h", s_options, NULL)) != -1) {
+    switch (opt) {
+    case 'i':
+      s_images_dir = optarg;
+      break;
+    case 'w':
+      s_work_dir = optarg;
+      break;
+    case 'v':
+      s_csv = true;
+      break;
+    case 's':
+      s_winc_timing.spi_hz = strtoul(optarg, NULL, 0);
+      break;
+    case 'c':
+      s_winc_timing.spi_call_ns = strtoul(optarg, NULL, 0);
+      break;
+    case 'f':
+      s_winc_timing.flash_spi_hz = strtoul(optarg, NULL, 0);
+      break;
+    case 'e':
+      s_winc_timing.sector_erase_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      s_winc_timing.page_program_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      sd_timing.call_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'b':
+      sd_timing.bytes_per_s = strtoul(optarg, NULL, 0);
+      break;
+    default:
+      usage(argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind != argc || s_winc_timing.spi_hz == 0 ||
+      s_winc_timing.flash_spi_hz == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  sys_fs_posix_set_timing(&sd_timing);
+  sys_sim_console_mute(true);
+  progress_set_observer(observe_progress);
+  print_header();
+
+  for (size_t i = 0; ok && i < sizeof(s_scenarios) / sizeof(s_scenarios[0]);
+       i++) {
+    if (!load_flash(&s_scenarios[i])) {
+      ok = false;
+      break;
+    }
+    winc_cloner_init();
+    for (phase_t phase = 0; ok && phase < N_PHASES; phase++) {
+      phase_result_t result;
+      ok = run_phase(phase, &result);
+      print_result(s_scenarios[i].name, phase, &result);
+    }
+    winc_sim_close();
+  }
+
+  if (!ok) {
+    fprintf(stderr, "benchmark failed\n");
+  }
+  return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool load_flash(const scenario_t *scenario) {
+  static uint8_t image[16 * 1024 * 1024];
+  char path[PATH_MAX];
+  size_t size;
+  FILE *f;
+
+  snprintf(path, sizeof(path), "%s/%s", s_images_dir, scenario->start_image);
+  if ((f = fopen(path, "rb")) == NULL) {
+    perror(path);
+    return false;
+  }
+  size = fread(image, 1, sizeof(image), f);
+  fclose(f);
+  if (scenario->invert) {
+    for (size_t i = 0; i < size; i++) {
+      image[i] = ~image[i];
+    }
+  }
+
+  snprintf(path, sizeof(path), "%s/%s", s_work_dir, FLASH_FILE);
+  if ((f = fopen(path, "wb")) == NULL || fwrite(image, 1, size, f) != size) {
+    perror(path);
+    if (f != NULL) {
+      fclose(f);
+    }
+    return false;
+  }
+  fclose(f);
+  return winc_sim_open(path, &s_winc_timing);
+}
+
+static bool run_phase(phase_t phase, phase_result_t *result) {
+  uint64_t start = sim_clock_now();
+
+  winc_sim_stats_reset();
+  sys_fs_posix_stats_reset();
+  s_n_sectors = 0;
+  s_n_changed = 0;
+
+  switch (phase) {
+  case PHASE_COMPARE:
+    sys_fs_posix_set_root(s_images_dir);
+    result->ok = winc_cloner_compare(NEW_IMAGE);
+    break;
+  case PHASE_UPDATE:
+    sys_fs_posix_set_root(s_images_dir);
+    result->ok = winc_cloner_update(NEW_IMAGE);
+    break;
+  default:
+    sys_fs_posix_set_root(s_work_dir);
+    result->ok = winc_cloner_extract(EXTRACT_IMAGE);
+    break;
+  }
+
+  result->ns = sim_clock_now() - start;
+  result->n_sectors = s_n_sectors;
+  result->n_changed = s_n_changed;
+  result->winc = winc_sim_stats_get();
+  result->sd = sys_fs_posix_stats_get();
+  return result->ok;
+}
+
+static void observe_progress(uint32_t n_done,
+                             uint32_t n_sectors,
+                             uint32_t n_changed) {
+  (void)n_sectors;
+  s_n_sectors = n_done;
+  s_n_changed = n_changed;
+}
+
+static void print_header(void) {
+  if (s_csv) {
+    printf("scenario,phase,ok,sectors,changed,seconds,sectors_per_s,"
+           "spi_transfers,spi_commands,spi_bytes,erases,page_programs,"
+           "sd_bytes_read,sd_bytes_written\n");
+    return;
+  }
+  printf("%-10s %-8s %7s %7s %8s %9s %9s %8s %8s %6s %6s %8s %8s\n",
+         "scenario",
+         "phase",
+         "sectors",
+         "changed",
+         "seconds",
+         "sectors/s",
+         "spi_xfers",
+         "spi_cmds",
+         "spi_KB",
+         "erases",
+         "pages",
+         "sd_rd_KB",
+         "sd_wr_KB");
+}
+
+static void print_result(const char *scenario,
+                         phase_t phase,
+                         const phase_result_t *result) {
+  double seconds = (double)result->ns / SIM_CLOCK_NS_PER_S;
+  double rate = (seconds > 0) ? result->n_sectors / seconds : 0;
+
+  if (s_csv) {
+    printf("%s,%s,%d,%u,%u,%.6f,%.1f,%u,%u,%llu,%u,%u,%llu,%llu\n",
+           scenario,
+           s_phase_names[phase],
+           result->ok,
+           result->n_sectors,
+           result->n_changed,
+           seconds,
+           rate,
+           result->winc.spi_transfers,
+           result->winc.spi_commands,
+           (unsigned long long)result->winc.spi_bytes,
+           result->winc.sector_erases,
+           result->winc.page_programs,
+           (unsigned long long)result->sd.bytes_read,
+           (unsigned long long)result->sd.bytes_written);
+    return;
+  }
+  printf("%-10s %-8s %7u %7u %8.3f %9.1f %9u %8u %8llu %6u %6u %8llu %8llu%s\n",
+         scenario,
+         s_phase_names[phase],
+         result->n_sectors,
+         result->n_changed,
+         seconds,
+         rate,
+         result->winc.spi_transfers,
+         result->winc.spi_commands,
+         (unsigned long long)result->winc.spi_bytes / 1024,
+         result->winc.sector_erases,
+         result->winc.page_programs,
+         (unsigned long long)result->sd.bytes_read / 1024,
+         (unsigned long long)result->sd.bytes_written / 1024,
+         result->ok ? "" : "  FAILED");
+}
+
+static void usage(const char *program) {
+  winc_sim_timing_t winc = winc_sim_timing_default();
+  sys_fs_posix_timing_t sd = sys_fs_posix_timing_default();
+
+  fprintf(stderr,
+          "usage: %s [option]...\n"
+          "options:\n"
+          "  --images DIR        directory holding %s and %s\n"
+          "                      (default ../../images)\n"
+          "  --work DIR          directory for scratch files (default build)\n"
+          "  --csv               print comma separated values\n"
+          "  --spi-hz N          WINC SPI clock (default %u)\n"
+          "  --spi-call-ns N     overhead of each SPI transfer (default %u)\n"
+          "  --flash-spi-hz N    WINC to flash SPI clock (default %u)\n"
+          "  --erase-us N        sector erase time (default %u)\n"
+          "  --program-us N      page program time (default %u)\n"
+          "  --sd-call-us N      overhead of each SD read or write (default %u)\n"
+          "  --sd-bytes-per-s N  SD transfer rate (default %u)\n",
+          program,
+          OLD_IMAGE,
+          NEW_IMAGE,
+          winc.spi_hz,
+          winc.spi_call_ns,
+          winc.flash_spi_hz,
+          winc.sector_erase_us,
+          winc.page_program_us,
+          sd.call_us,
+          sd.bytes_per_s);
+}
+
+// *****************************************************************************
+// End of file
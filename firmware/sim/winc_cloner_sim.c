@@ -0,0 +1,336 @@
+/**
+ * @file winc_cloner_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Run the cloner's operations on the host, against a simulated WINC.
+ *
+ *     winc_cloner_sim [option]... FLASH_FILE COMMAND...
+ *
+ * FLASH_FILE holds the simulated WINC's flash memory (it is created, erased,
+ * if it doesn't exist).  Each COMMAND is one of
+ *
+ *     extract IMAGE    compare IMAGE    update IMAGE    rebuild-pll
+ *     catalog          identify
+ *
+ * with IMAGE a file in the --dir directory, which stands in for the SD card.
+ * catalog lists the .wimg images in that directory the way the application
+ * does, interrupting the background scan as key presses would, and fails
+ * unless every image ends up scanned.  Later catalog commands refresh the
+ * same catalog, as the application does each time it prints its prompt.
+ * identify lists the directory the same way, without waiting for the scan,
+ * and finds the image that matches the WINC best.
+ * Commands run in order; the program stops at the first that fails, and exits
+ * with status 1 if one did.  After each command it reports the time the
+ * operation would have taken on the target, as simulated.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "app.h"
+#include "binlog.h"
+#include "definitions.h"
+#include "dir_reader.h"
+#include "m2m_types.h"
+#include "sim_clock.h"
+#include "sys_fs_posix.h"
+#include "winc_cloner.h"
+#include "winc_sim.h"
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+typedef struct {
+  const char *name;
+  bool takes_image;
+  bool (*fn)(const char *image);
+} command_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static bool rebuild_pll(const char *image);
+
+static bool catalog(const char *image);
+
+static bool identify(const char *image);
+
+/**
+ * @brief Mount the --dir directory once, then list it into the catalog.
+ */
+static bool list_directory(void);
+
+static const command_t *find_command(const char *name);
+
+static void usage(const char *program);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const command_t s_commands[] = {
+    {"extract", true, winc_cloner_extract},
+    {"compare", true, winc_cloner_compare},
+    {"update", true, winc_cloner_update},
+    {"rebuild-pll", false, rebuild_pll},
+    {"catalog", false, catalog},
+    {"identify", false, identify},
+};
+
+// catalog pauses the scan after these calls to dir_reader_step(), as the
+// console does on each key press.  The first lands just after the first
+// image's control sector has been read.
+static const uint32_t s_catalog_pauses[] = {2, 3, 40, 300, 301};
+
+static bool s_catalog_is_mounted;
+
+static const struct option s_options[] = {
+    {"dir", required_argument, NULL, 'd'},
+    {"debug", no_argument, NULL, 'g'},
+    {"spi-hz", required_argument, NULL, 's'},
+    {"spi-call-ns", required_argument, NULL, 'c'},
+    {"flash-spi-hz", required_argument, NULL, 'f'},
+    {"erase-us", required_argument, NULL, 'e'},
+    {"program-us", required_argument, NULL, 'p'},
+    {"sd-call-us", required_argument, NULL, 'l'},
+    {"sd-bytes-per-s", required_argument, NULL, 'b'},
+    {"fragmented", no_argument, NULL, 'r'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+};
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+  winc_sim_timing_t timing = winc_sim_timing_default();
+  sys_fs_posix_timing_t sd_timing = sys_fs_posix_timing_default();
+  bool ok = true;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "d:gh", s_options, NULL)) != -1) {
+    switch (opt) {
+    case 'd':
+      sys_fs_posix_set_root(optarg);
+      break;
+    case 'g':
+      SYS_DEBUG_ErrorLevelSet(SYS_ERROR_DEBUG);
+      break;
+    case 's':
+      timing.spi_hz = strtoul(optarg, NULL, 0);
+      break;
+    case 'c':
+      timing.spi_call_ns = strtoul(optarg, NULL, 0);
+      break;
+    case 'f':
+      timing.flash_spi_hz = strtoul(optarg, NULL, 0);
+      break;
+    case 'e':
+      timing.sector_erase_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      timing.page_program_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'l':
+      sd_timing.call_us = strtoul(optarg, NULL, 0);
+      break;
+    case 'b':
+      sd_timing.bytes_per_s = strtoul(optarg, NULL, 0);
+      break;
+    case 'r':
+      sys_fs_posix_set_fragmented(true);
+      break;
+    default:
+      usage(argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind + 2 > argc || timing.spi_hz == 0 || timing.flash_spi_hz == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+  // Check the whole command line before touching the flash.
+  for (int i = optind + 1; i < argc; i++) {
+    const command_t *command = find_command(argv[i]);
+    if (command == NULL || (command->takes_image && ++i >= argc)) {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  sys_fs_posix_set_timing(&sd_timing);
+  if (!winc_sim_open(argv[optind], &timing)) {
+    return 1;
+  }
+  winc_cloner_init();
+
+  for (int i = optind + 1; ok && i < argc; i++) {
+    const command_t *command = find_command(argv[i]);
+    const char *image = command->takes_image ? argv[++i] : NULL;
+    uint64_t start = sim_clock_now();
+
+    ok = command->fn(image);
+    binlog_flush();
+    printf("\n%s%s%s: %s in %.3f s (simulated)\n",
+           command->name,
+           image ? " " : "",
+           image ? image : "",
+           ok ? "succeeded" : "FAILED",
+           (double)(sim_clock_now() - start) / SIM_CLOCK_NS_PER_S);
+  }
+
+  winc_sim_close();
+  return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool rebuild_pll(const char *image) {
+  (void)image;
+  return winc_cloner_rebuild_pll();
+}
+
+static bool catalog(const char *image) {
+  uint32_t n_steps = 0;
+  size_t n_pauses = 0;
+  bool ok = true;
+
+  (void)image;
+  if (!list_directory()) {
+    return false;
+  }
+  while (!dir_reader_scan_is_complete()) {
+    dir_reader_step();
+    n_steps += 1;
+    if ((n_pauses < sizeof(s_catalog_pauses) / sizeof(s_catalog_pauses[0])) &&
+        (n_steps == s_catalog_pauses[n_pauses])) {
+      dir_reader_pause();
+      n_pauses += 1;
+    }
+  }
+
+  for (uint16_t idx = 0; idx < dir_reader_filename_count(); idx++) {
+    const dir_reader_image_t *entry = dir_reader_image_ref(idx);
+    uint16_t n_sectors = 0;
+
+    printf("\n%-32s %8u", dir_reader_filename_ref(idx), entry->size);
+    if (entry->flags & DIR_READER_IMAGE_HAS_VERSION) {
+      printf("  v%d.%d.%d",
+             M2M_GET_MAJOR(entry->fw_version),
+             M2M_GET_MINOR(entry->fw_version),
+             M2M_GET_PATCH(entry->fw_version));
+    }
+    if (entry->flags & DIR_READER_IMAGE_SCANNED) {
+      printf("  crc32 %08x", entry->digest);
+      if (dir_reader_manifest_ref(idx, &n_sectors) != NULL) {
+        printf("  %u sector manifest", n_sectors);
+      }
+    } else {
+      printf("  NOT SCANNED");
+      ok = false;
+    }
+  }
+  if (dir_reader_dropped_count() > 0) {
+    printf("\n(%d more images not cataloged)", dir_reader_dropped_count());
+  }
+  return ok;
+}
+
+static bool identify(const char *image) {
+  (void)image;
+  return list_directory() && winc_cloner_identify();
+}
+
+static bool list_directory(void) {
+  if (!s_catalog_is_mounted) {
+    if (SYS_FS_Mount(SD_DEVICE_NAME, SD_MOUNT_NAME, FAT, 0, NULL) !=
+        SYS_FS_RES_SUCCESS) {
+      return false;
+    }
+    dir_reader_init();
+    s_catalog_is_mounted = true;
+  }
+  dir_reader_read_directory();
+  while (!dir_reader_is_complete()) {
+    if (dir_reader_has_error()) {
+      return false;
+    }
+    dir_reader_step();
+  }
+  return true;
+}
+
+static const command_t *find_command(const char *name) {
+  for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++) {
+    if (strcmp(name, s_commands[i].name) == 0) {
+      return &s_commands[i];
+    }
+  }
+  return NULL;
+}
+
+static void usage(const char *program) {
+  winc_sim_timing_t timing = winc_sim_timing_default();
+  sys_fs_posix_timing_t sd_timing = sys_fs_posix_timing_default();
+
+  fprintf(stderr,
+          "usage: %s [option]... FLASH_FILE COMMAND...\n"
+          "commands:\n"
+          "  extract IMAGE   copy the WINC flash into IMAGE\n"
+          "  compare IMAGE   compare the WINC flash against IMAGE\n"
+          "  update IMAGE    program the WINC flash from IMAGE\n"
+          "  rebuild-pll     recompute the PLL tables from the efuses\n"
+          "  catalog         list and scan the .wimg images in --dir\n"
+          "  identify        find the .wimg image that matches the WINC\n"
+          "options:\n"
+          "  --dir DIR           directory holding the images (default .)\n"
+          "  --debug             log at SYS_ERROR_DEBUG, including binlog\n"
+          "  --spi-hz N          WINC SPI clock (default %u)\n"
+          "  --spi-call-ns N     overhead of each SPI transfer (default %u)\n"
+          "  --flash-spi-hz N    WINC to flash SPI clock (default %u)\n"
+          "  --erase-us N        sector erase time (default %u)\n"
+          "  --program-us N      page program time (default %u)\n"
+          "  --sd-call-us N      overhead of each SD read or write (default %u)\n"
+          "  --sd-bytes-per-s N  SD transfer rate (default %u)\n"
+          "  --fragmented        no contiguous free space for extract\n",
+          program,
+          timing.spi_hz,
+          timing.spi_call_ns,
+          timing.flash_spi_hz,
+          timing.sector_erase_us,
+          timing.page_program_us,
+          sd_timing.call_us,
+          sd_timing.bytes_per_s);
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,574 @@
+/**
+ * @file winc_image_tool.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief Analyze WINC flash images (.img files) on the host.
+ *
+ *     winc_image_tool [option]... COMMAND IMAGE...
+ *
+ * with COMMAND one of
+ *
+ *     info      size, CRC-32 and firmware version of each image, the state of
+ *               its control sectors, and for each region of the flash map its
+ *               CRC-32 and how much of it is erased (0xff)
+ *     sectors   the CRC-32 of every sector, and whether it is erased
+ *     diff      for every pair of images, the number of sectors an update
+ *               from one to the other would program
+ *
+ * The regions are those of spi_flash_map.h, the map the firmware and the WINC
+ * driver are built with.  The CRC-32s are the ones the target computes: the
+ * image's matches the digest that the firmware lists for it, and a sector's
+ * matches what the host protocol reports for the same sector on the WINC.
+ * diff counts sectors whose CRC-32s differ, as stream does when deciding what
+ * to send, and leaves out the PLL / gain sector, which update never writes.
+ *
+ * Images are read and digested in parallel, one per thread (--jobs).
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "crc32.h"
+#include "m2m_types.h"
+#include "spi_flash_map.h"
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_JOBS 64
+#define MAX_SECTORS (FLASH_8M_TOTAL_SZ / FLASH_SECTOR_SZ)
+
+typedef struct {
+  const char *name;
+  uint32_t offset;
+  uint32_t size;
+} region_t;
+
+typedef struct {
+  uint32_t n_bytes; // of the region present in the image
+  uint32_t n_erased;
+  uint32_t crc;
+} region_info_t;
+
+typedef struct {
+  const char *path;
+  bool ok;
+  int err; // errno if !ok
+  uint32_t size;
+  uint32_t crc;
+  uint32_t n_sectors;
+  uint32_t sector_crcs[MAX_SECTORS];
+  bool sector_erased[MAX_SECTORS];
+  tstrOtaControlSec control[2]; // primary, backup
+  bool control_erased[2];
+  region_info_t regions[16];
+} image_info_t;
+
+typedef enum { COMMAND_INFO, COMMAND_SECTORS, COMMAND_DIFF } command_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Worker thread: analyze images until there are none left.
+ */
+static void *analyze_images(void *arg);
+
+static void analyze_image(image_info_t *info);
+
+static uint32_t count_erased(const uint8_t *buf, size_t n_bytes);
+
+static const char *region_name(uint32_t addr);
+
+static void print_info(const image_info_t *info);
+
+static void print_control(const char *label,
+                          const tstrOtaControlSec *control,
+                          bool erased);
+
+static void print_sectors(const image_info_t *info);
+
+static void print_diff(void);
+
+static uint32_t sectors_to_program(const image_info_t *from,
+                                   const image_info_t *to);
+
+static void usage(const char *program);
+
+// *****************************************************************************
+// Private (static) storage
+
+static const region_t s_regions[] = {
+    {"boot", M2M_BOOT_FIRMWARE_STARTING_ADDR, M2M_BOOT_FIRMWARE_FLASH_SZ},
+    {"control", M2M_CONTROL_FLASH_OFFSET, M2M_CONTROL_FLASH_SEC_SZ},
+    {"control-backup", M2M_CONTROL_FLASH_BKP_OFFSET, M2M_CONTROL_FLASH_SEC_SZ},
+    {"pll", M2M_PLL_FLASH_OFFSET, M2M_PLL_FLASH_SZ},
+    {"gain", M2M_GAIN_FLASH_OFFSET, M2M_GAIN_FLASH_SZ},
+    {"tls-root-cert", M2M_TLS_ROOTCER_FLASH_OFFSET, M2M_TLS_ROOTCER_FLASH_SIZE},
+    {"tls-server", M2M_TLS_SERVER_FLASH_OFFSET, M2M_TLS_SERVER_FLASH_SIZE},
+    {"http", M2M_HTTP_MEM_FLASH_OFFSET, M2M_HTTP_MEM_FLASH_SZ},
+    {"cached-conns", M2M_CACHED_CONNS_FLASH_OFFSET, M2M_CACHED_CONNS_FLASH_SZ},
+    {"ota-image-1", M2M_OTA_IMAGE1_OFFSET, OTA_IMAGE_SIZE},
+    {"ota-image-2", M2M_OTA_IMAGE2_OFFSET, OTA_IMAGE_SIZE},
+    {"app", M2M_APP_8M_MEM_FLASH_OFFSET, M2M_APP_8M_MEM_FLASH_SZ},
+    {"unused",
+     M2M_APP_OTA_MEM_FLASH_OFFSET,
+     FLASH_8M_TOTAL_SZ - M2M_APP_OTA_MEM_FLASH_OFFSET},
+};
+
+#define N_REGIONS (sizeof(s_regions) / sizeof(s_regions[0]))
+
+static image_info_t *s_images;
+
+static size_t s_n_images;
+
+static size_t s_next_image; // next for a worker to take, under s_lock
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool s_csv;
+
+static const struct option s_options[] = {
+    {"jobs", required_argument, NULL, 'j'},
+    {"csv", no_argument, NULL, 'c'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+};
+
+// *****************************************************************************
+// Public code
+
+int main(int argc, char *argv[]) {
+  long n_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  pthread_t threads[MAX_JOBS];
+  command_t command;
+  bool ok = true;
+  int opt;
+
+  _Static_assert(N_REGIONS <= sizeof(s_images->regions) /
+                                  sizeof(s_images->regions[0]),
+                 "image_info_t.regions is too small");
+
+  while ((opt = getopt_long(argc, argv, "j:h", s_options, NULL)) != -1) {
+    switch (opt) {
+    case 'j':
+      n_jobs = strtol(optarg, NULL, 0);
+      break;
+    case 'c':
+      s_csv = true;
+      break;
+    default:
+      usage(argv[0]);
+      return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if (optind + 2 > argc) {
+    usage(argv[0]);
+    return 2;
+  } else if (strcmp(argv[optind], "info") == 0) {
+    command = COMMAND_INFO;
+  } else if (strcmp(argv[optind], "sectors") == 0) {
+    command = COMMAND_SECTORS;
+  } else if (strcmp(argv[optind], "diff") == 0) {
+    command = COMMAND_DIFF;
+  } else {
+    usage(argv[0]);
+    return 2;
+  }
+
+  s_n_images = argc - optind - 1;
+  s_images = calloc(s_n_images, sizeof(image_info_t));
+  if (s_images == NULL) {
+    perror("calloc");
+    return 1;
+  }
+  for (size_t i = 0; i < s_n_images; i++) {
+    s_images[i].path = argv[optind + 1 + i];
+  }
+
+  if (n_jobs < 1) {
+    n_jobs = 1;
+  } else if (n_jobs > MAX_JOBS) {
+    n_jobs = MAX_JOBS;
+  }
+  if ((size_t)n_jobs > s_n_images) {
+    n_jobs = s_n_images;
+  }
+  for (long i = 0; i < n_jobs; i++) {
+    if (pthread_create(&threads[i], NULL, analyze_images, NULL) != 0) {
+      n_jobs = i; // carry on with the threads there are
+      break;
+    }
+  }
+  if (n_jobs == 0) {
+    analyze_images(NULL);
+  }
+  for (long i = 0; i < n_jobs; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (size_t i = 0; i < s_n_images; i++) {
+    if (!s_images[i].ok) {
+      fprintf(stderr, "%s: %s\n", s_images[i].path, strerror(s_images[i].err));
+      ok = false;
+    }
+  }
+  if (command == COMMAND_DIFF) {
+    print_diff();
+  } else {
+    if (s_csv && command == COMMAND_INFO) {
+      printf("image,region,offset,size,bytes,erased,crc32\n");
+    } else if (s_csv) {
+      printf("image,offset,region,crc32,erased\n");
+    }
+    for (size_t i = 0; i < s_n_images; i++) {
+      if (!s_images[i].ok) {
+        continue;
+      } else if (command == COMMAND_INFO) {
+        print_info(&s_images[i]);
+      } else {
+        print_sectors(&s_images[i]);
+      }
+    }
+  }
+
+  free(s_images);
+  return ok ? 0 : 1;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void *analyze_images(void *arg) {
+  (void)arg;
+  for (;;) {
+    size_t i;
+
+    pthread_mutex_lock(&s_lock);
+    i = s_next_image++;
+    pthread_mutex_unlock(&s_lock);
+    if (i >= s_n_images) {
+      return NULL;
+    }
+    analyze_image(&s_images[i]);
+  }
+}
+
+static void analyze_image(image_info_t *info) {
+  static const uint32_t control_offsets[] = {M2M_CONTROL_FLASH_OFFSET,
+                                             M2M_CONTROL_FLASH_BKP_OFFSET};
+  FILE *file = fopen(info->path, "rb");
+  uint8_t *buf = malloc(FLASH_8M_TOTAL_SZ);
+  size_t size;
+
+  if (file == NULL || buf == NULL) {
+    info->err = errno;
+    goto done;
+  }
+  size = fread(buf, 1, FLASH_8M_TOTAL_SZ, file);
+  if (ferror(file)) {
+    info->err = errno;
+    goto done;
+  } else if (size == 0 || fgetc(file) != EOF) {
+    info->err = EFBIG; // no WINC flash is larger
+    goto done;
+  }
+
+  info->size = size;
+  info->crc = crc32_update(0, buf, size);
+  info->n_sectors = (size + FLASH_SECTOR_SZ - 1) / FLASH_SECTOR_SZ;
+  for (uint32_t i = 0; i < info->n_sectors; i++) {
+    uint32_t offset = i * FLASH_SECTOR_SZ;
+    uint32_t n_bytes = (size - offset < FLASH_SECTOR_SZ) ? size - offset
+                                                         : FLASH_SECTOR_SZ;
+    info->sector_crcs[i] = crc32_update(0, &buf[offset], n_bytes);
+    info->sector_erased[i] = count_erased(&buf[offset], n_bytes) == n_bytes;
+  }
+  for (size_t r = 0; r < N_REGIONS; r++) {
+    const region_t *region = &s_regions[r];
+    region_info_t *region_info = &info->regions[r];
+
+    if (region->offset < size) {
+      region_info->n_bytes = (size - region->offset < region->size)
+                                 ? size - region->offset
+                                 : region->size;
+      region_info->n_erased =
+          count_erased(&buf[region->offset], region_info->n_bytes);
+      region_info->crc =
+          crc32_update(0, &buf[region->offset], region_info->n_bytes);
+    }
+  }
+  for (int c = 0; c < 2; c++) {
+    if (control_offsets[c] + sizeof(info->control[c]) <= size) {
+      memcpy(&info->control[c],
+             &buf[control_offsets[c]],
+             sizeof(info->control[c]));
+      info->control_erased[c] =
+          count_erased(&buf[control_offsets[c]], M2M_CONTROL_FLASH_SEC_SZ) ==
+          M2M_CONTROL_FLASH_SEC_SZ;
+    }
+  }
+  info->ok = true;
+
+done:
+  if (file != NULL) {
+    fclose(file);
+  }
+  free(buf);
+}
+
+static uint32_t count_erased(const uint8_t *buf, size_t n_bytes) {
+  uint32_t n_erased = 0;
+
+  for (size_t i = 0; i < n_bytes; i++) {
+    n_erased += (buf[i] == 0xff);
+  }
+  return n_erased;
+}
+
+static const char *region_name(uint32_t addr) {
+  for (size_t r = 0; r < N_REGIONS; r++) {
+    if (addr >= s_regions[r].offset &&
+        addr < s_regions[r].offset + s_regions[r].size) {
+      return s_regions[r].name;
+    }
+  }
+  return "?";
+}
+
+static void print_info(const image_info_t *info) {
+  const tstrOtaControlSec *control = &info->control[0];
+
+  if (s_csv) {
+    for (size_t r = 0; r < N_REGIONS; r++) {
+      printf("%s,%s,%u,%u,%u,%u,%08x\n",
+             info->path,
+             s_regions[r].name,
+             s_regions[r].offset,
+             s_regions[r].size,
+             info->regions[r].n_bytes,
+             info->regions[r].n_erased,
+             info->regions[r].crc);
+    }
+    return;
+  }
+
+  printf("%s\n  size %u, crc32 %08x", info->path, info->size, info->crc);
+  if (control->u32OtaMagicValue == OTA_MAGIC_VALUE) {
+    printf(", firmware %u.%u.%u",
+           M2M_GET_FW_MAJOR(control->u32OtaCurrentworkingImagFirmwareVer),
+           M2M_GET_FW_MINOR(control->u32OtaCurrentworkingImagFirmwareVer),
+           M2M_GET_FW_PATCH(control->u32OtaCurrentworkingImagFirmwareVer));
+  } else {
+    printf(", no firmware version");
+  }
+  if (info->size % FLASH_SECTOR_SZ != 0) {
+    printf(" (not a whole number of sectors)");
+  }
+  printf("\n");
+  print_control("control", &info->control[0], info->control_erased[0]);
+  print_control("backup", &info->control[1], info->control_erased[1]);
+  if (memcmp(&info->control[0], &info->control[1], sizeof(info->control[0])) ==
+      0) {
+    printf("  backup control sector matches\n");
+  }
+  printf("  %-15s %8s %8s %6s %8s\n",
+         "region",
+         "offset",
+         "size",
+         "erased",
+         "crc32");
+  for (size_t r = 0; r < N_REGIONS; r++) {
+    const region_info_t *region_info = &info->regions[r];
+
+    if (region_info->n_bytes == 0) {
+      printf("  %-15s %08x %8u %6s %8s\n",
+             s_regions[r].name,
+             s_regions[r].offset,
+             s_regions[r].size,
+             "-",
+             "absent");
+      continue;
+    }
+    printf("  %-15s %08x %8u %5.1f%% %08x\n",
+           s_regions[r].name,
+           s_regions[r].offset,
+           region_info->n_bytes,
+           100.0 * region_info->n_erased / region_info->n_bytes,
+           region_info->crc);
+  }
+}
+
+static void print_control(const char *label,
+                          const tstrOtaControlSec *control,
+                          bool erased) {
+  const char *rollback;
+
+  if (erased) {
+    printf("  %s: erased\n", label);
+    return;
+  } else if (control->u32OtaMagicValue != OTA_MAGIC_VALUE) {
+    printf("  %s: bad magic %08x\n", label, control->u32OtaMagicValue);
+    return;
+  }
+  switch (control->u32OtaRollbackImageValidStatus) {
+  case OTA_STATUS_VALID:
+    rollback = "valid";
+    break;
+  case OTA_STATUS_INVALID:
+    rollback = "invalid";
+    break;
+  default:
+    rollback = "unknown";
+    break;
+  }
+  printf("  %s: format %u, sequence %u, running %u.%u.%u at %06x, rollback "
+         "%u.%u.%u at %06x (%s), crc %08x\n",
+         label,
+         control->u32OtaFormatVersion,
+         control->u32OtaSequenceNumber,
+         M2M_GET_FW_MAJOR(control->u32OtaCurrentworkingImagFirmwareVer),
+         M2M_GET_FW_MINOR(control->u32OtaCurrentworkingImagFirmwareVer),
+         M2M_GET_FW_PATCH(control->u32OtaCurrentworkingImagFirmwareVer),
+         control->u32OtaCurrentWorkingImagOffset,
+         M2M_GET_FW_MAJOR(control->u32OtaRollbackImagFirmwareVer),
+         M2M_GET_FW_MINOR(control->u32OtaRollbackImagFirmwareVer),
+         M2M_GET_FW_PATCH(control->u32OtaRollbackImagFirmwareVer),
+         control->u32OtaRollbackImageOffset,
+         rollback,
+         control->u32OtaControlSecCrc);
+}
+
+static void print_sectors(const image_info_t *info) {
+  uint32_t n_erased = 0;
+
+  if (!s_csv) {
+    printf("%s\n", info->path);
+  }
+  for (uint32_t i = 0; i < info->n_sectors; i++) {
+    uint32_t offset = i * FLASH_SECTOR_SZ;
+
+    n_erased += info->sector_erased[i];
+    if (s_csv) {
+      printf("%s,%u,%s,%08x,%d\n",
+             info->path,
+             offset,
+             region_name(offset),
+             info->sector_crcs[i],
+             info->sector_erased[i]);
+    } else {
+      printf("  %06x %-15s %08x%s\n",
+             offset,
+             region_name(offset),
+             info->sector_crcs[i],
+             info->sector_erased[i] ? " erased" : "");
+    }
+  }
+  if (!s_csv) {
+    printf("  %u of %u sectors erased\n", n_erased, info->n_sectors);
+  }
+}
+
+static void print_diff(void) {
+  // rows are the image on the WINC, columns the image to update it to.
+  if (s_csv) {
+    printf("from,to,sectors\n");
+    for (size_t i = 0; i < s_n_images; i++) {
+      for (size_t j = 0; j < s_n_images; j++) {
+        if (i != j && s_images[i].ok && s_images[j].ok) {
+          printf("%s,%s,%u\n",
+                 s_images[i].path,
+                 s_images[j].path,
+                 sectors_to_program(&s_images[i], &s_images[j]));
+        }
+      }
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < s_n_images; i++) {
+    printf("%3zu %s\n", i, s_images[i].path);
+  }
+  printf("\nsectors to program, from row to column\n    ");
+  for (size_t j = 0; j < s_n_images; j++) {
+    printf(" %4zu", j);
+  }
+  printf("\n");
+  for (size_t i = 0; i < s_n_images; i++) {
+    printf("%3zu ", i);
+    for (size_t j = 0; j < s_n_images; j++) {
+      if (i == j || !s_images[i].ok || !s_images[j].ok) {
+        printf(" %4s", "-");
+      } else {
+        printf(" %4u", sectors_to_program(&s_images[i], &s_images[j]));
+      }
+    }
+    printf("\n");
+  }
+}
+
+static uint32_t sectors_to_program(const image_info_t *from,
+                                   const image_info_t *to) {
+  uint32_t n_sectors = 0;
+
+  for (uint32_t i = 0; i < to->n_sectors; i++) {
+    uint32_t offset = i * FLASH_SECTOR_SZ;
+
+    if (offset >= M2M_PLL_FLASH_OFFSET &&
+        offset < M2M_PLL_FLASH_OFFSET + M2M_CONFIG_SECT_TOTAL_SZ) {
+      continue; // update leaves the PLL and gain tables alone
+    }
+    n_sectors += (i >= from->n_sectors) ||
+                 (from->sector_crcs[i] != to->sector_crcs[i]);
+  }
+  return n_sectors;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [option]... COMMAND IMAGE...\n"
+          "commands:\n"
+          "  info      version, control sectors and regions of each image\n"
+          "  sectors   CRC-32 of each sector, and whether it is erased\n"
+          "  diff      sectors to program between each pair of images\n"
+          "options:\n"
+          "  --jobs N  analyze N images at a time (default: one per CPU)\n"
+          "  --csv     print comma-separated values\n",
+          program);
+}
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,854 @@
+/**
+ * @file winc_sim.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "winc_sim.h"
+
+#include "definitions.h"
+#include "sim_clock.h"
+#include "stats.h"
+#include "wdrv_winc_gpio.h"
+#include "wdrv_winc_spi.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// SPI slave commands, as framed by nmspi.c.
+#define CMD_INTERNAL_WRITE 0xc3
+#define CMD_INTERNAL_READ 0xc4
+#define CMD_DMA_EXT_WRITE 0xc7
+#define CMD_DMA_EXT_READ 0xc8
+#define CMD_SINGLE_WRITE 0xc9
+#define CMD_SINGLE_READ 0xca
+#define CMD_RESET 0xcf
+
+#define CMD_MAX_LEN 9
+#define CMD_CLOCKLESS 0x80 // in the address byte of internal reads and writes
+#define CRC7_SEED 0x7f
+
+#define DATA_PKT_SZ (8 * 1024) // packet size once nm_spi_init() has run
+#define DATA_TOKEN_MASK 0xf0   // data packets start with 0xf1, 0xf2 or 0xf3
+#define DATA_TOKEN_FIRST 0xf1
+#define DATA_TOKEN_MIDDLE 0xf2
+#define DATA_TOKEN_LAST 0xf3
+#define DATA_ACK 0xc3 // spi_write_block() expects this, then 0x00
+#define IDLE_BYTE 0xff // what the host reads when the WINC has nothing to say
+
+// Longest response: a 64 KB block read in packets, with headers and CRCs.
+#define RSP_BUF_SZ (64 * 1024 + 64)
+
+// Registers
+#define REG_CHIP_ID 0x1000
+#define REG_RF_REV_ID 0x13f4
+#define REG_SPI_PROTOCOL_CONFIG 0xe824
+#define PROTOCOL_CONFIG_CRC 0x0c   // command and data CRC enables
+#define PROTOCOL_CONFIG_RESET 0x2c // CRC on, 2 KB packets
+
+#define SHARE_MEM_BASE 0xd0000 // HOST_SHARE_MEM_BASE in spi_flash.c
+#define SHARE_MEM_SZ (64 * 1024)
+
+#define SPI_FLASH_BASE 0x10200
+#define SPI_FLASH_CMD_CNT (SPI_FLASH_BASE + 0x04)
+#define SPI_FLASH_DATA_CNT (SPI_FLASH_BASE + 0x08)
+#define SPI_FLASH_BUF1 (SPI_FLASH_BASE + 0x0c)
+#define SPI_FLASH_BUF2 (SPI_FLASH_BASE + 0x10)
+#define SPI_FLASH_TR_DONE (SPI_FLASH_BASE + 0x18)
+#define SPI_FLASH_DMA_ADDR (SPI_FLASH_BASE + 0x1c)
+#define CMD_CNT_START (1 << 7)
+#define CMD_CNT_LEN(cmd_cnt) ((cmd_cnt)&0x7f)
+#define CMD_CNT_WRITE_LEN(cmd_cnt) (((cmd_cnt) >> 8) & 0xfffff)
+
+// Efuse banks 0 and 1 have their control registers and data apart from those
+// of banks 2 to 5 (see efuse.c).
+#define EFUSE_0_CONTROL 0x1014
+#define EFUSE_2_CONTROL 0x1320
+#define EFUSE_0_DATA 0x102c
+#define EFUSE_0_DATA_STRIDE 32
+#define EFUSE_2_DATA 0x1380
+#define EFUSE_2_DATA_STRIDE 16
+#define EFUSE_LOAD 0x007c082d
+#define EFUSE_LOADED (1ul << 31)
+
+// Serial flash commands and status bits
+#define FLASH_PAGE_PROGRAM 0x02
+#define FLASH_WRITE_DISABLE 0x04
+#define FLASH_READ_STATUS 0x05
+#define FLASH_WRITE_ENABLE 0x06
+#define FLASH_FAST_READ 0x0b
+#define FLASH_SECTOR_ERASE 0x20
+#define FLASH_READ_ID 0x9f
+#define FLASH_RELEASE_POWER_DOWN 0xab
+#define FLASH_DEEP_POWER_DOWN 0xb9
+
+#define FLASH_STATUS_WIP 0x01
+#define FLASH_STATUS_WEL 0x02
+
+#define FLASH_MANUFACTURER_ID 0xc2 // Macronix, as fitted to WINC1500 modules
+#define FLASH_MEMORY_TYPE 0x20
+#define FLASH_SECTOR_SZ 4096
+#define FLASH_PAGE_SZ 256
+#define FLASH_MIN_SIZE (256 * 1024)
+#define FLASH_MAX_SIZE (16 * 1024 * 1024)
+#define FLASH_ERASED 0xff
+
+#define N_REGS 512 // registers without a model of their own
+
+typedef enum {
+  WIRE_COMMAND,    // collecting command bytes
+  WIRE_DATA_TOKEN, // DMA write: waiting for a packet's start token
+  WIRE_DATA,       // DMA write: packet data
+  WIRE_DATA_CRC,   // DMA write: packet CRC
+} wire_state_t;
+
+typedef struct {
+  uint32_t addr;
+  uint32_t value;
+  bool used;
+} reg_t;
+
+typedef struct {
+  winc_sim_timing_t timing;
+  winc_sim_stats_t stats;
+  bool chip_enabled;
+  bool in_reset;
+
+  // SPI slave
+  bool crc_on;
+  wire_state_t wire_state;
+  uint8_t cmd[CMD_MAX_LEN];
+  size_t cmd_len;
+  uint32_t dma_addr;      // DMA write: next address
+  uint32_t dma_remaining; // DMA write: bytes to come in all packets
+  uint32_t pkt_remaining; // DMA write: bytes to come in this packet
+  uint8_t crc_remaining;  // DMA write: CRC bytes to come
+  uint8_t rsp[RSP_BUF_SZ];
+  size_t rsp_head;
+  size_t rsp_len;
+
+  // Registers and memory
+  reg_t regs[N_REGS];
+  uint8_t share_mem[SHARE_MEM_SZ];
+  bool efuse_loaded[WINC_SIM_N_EFUSE_BANKS];
+  uint32_t efuse[WINC_SIM_N_EFUSE_BANKS][4];
+
+  // Flash controller and flash
+  uint64_t tr_done_at; // time the controller's transaction ends
+  int fd;
+  uint8_t *flash;
+  size_t flash_size;
+  uint8_t flash_capacity_id;
+  bool flash_wel;
+  bool flash_deep_power_down;
+  uint64_t flash_busy_until;
+} winc_sim_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+static bool is_powered(void);
+static void power_on_reset(void);
+static void charge_spi(size_t n_bytes);
+
+static void mosi_byte(uint8_t b);
+static size_t command_length(uint8_t cmd);
+static void command_execute(void);
+static void data_packet_done(void);
+static uint8_t crc7(uint8_t crc, const uint8_t *buf, size_t len);
+
+static void rsp_clear(void);
+static void rsp_push(uint8_t b);
+static void rsp_push_word(uint32_t word);
+static uint8_t rsp_pop(void);
+
+static void bus_read(uint32_t addr, uint8_t *dst, size_t n);
+static void bus_write(uint32_t addr, const uint8_t *src, size_t n);
+static uint32_t reg_read(uint32_t addr);
+static void reg_write(uint32_t addr, uint32_t value);
+static reg_t *reg_find(uint32_t addr, bool create);
+static uint32_t reg_get(uint32_t addr);
+static void reg_set(uint32_t addr, uint32_t value);
+static int efuse_control_bank(uint32_t addr);
+static bool efuse_data_word(uint32_t addr, uint32_t *word);
+
+static void flash_transaction(uint32_t cmd_cnt);
+static void flash_command(uint8_t op,
+                          uint32_t addr,
+                          uint32_t dma_addr,
+                          uint32_t n_read,
+                          uint32_t n_write,
+                          uint64_t done_at);
+static void flash_page_program(uint32_t addr, uint32_t dma_addr, uint32_t n);
+
+// *****************************************************************************
+// Private (static) storage
+
+static winc_sim_t s_winc;
+
+// A MAC address and crystal frequency offset in bank 0, as on most modules.
+static const uint32_t s_default_efuse_bank_0[4] = {
+    0x81f8f005, 0xe45f1500, 0xff6a0000, 0x00000000};
+
+static uint8_t s_flash_buf[SHARE_MEM_SZ]; // flash data in transit
+
+// *****************************************************************************
+// Public code
+
+winc_sim_timing_t winc_sim_timing_default(void) {
+  winc_sim_timing_t timing = {
+      .spi_hz = 30000000,
+      .spi_call_ns = 2000,
+      .flash_spi_hz = 40000000,
+      .sector_erase_us = 40000,
+      .page_program_us = 700,
+  };
+  return timing;
+}
+
+bool winc_sim_open(const char *path, const winc_sim_timing_t *timing) {
+  struct stat st;
+  size_t size;
+  bool is_new;
+
+  memset(&s_winc, 0, sizeof(s_winc));
+  s_winc.timing = (timing != NULL) ? *timing : winc_sim_timing_default();
+  s_winc.fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (s_winc.fd < 0 || fstat(s_winc.fd, &st) != 0) {
+    perror(path);
+    return false;
+  }
+  is_new = (st.st_size == 0);
+  if (is_new && ftruncate(s_winc.fd, WINC_SIM_FLASH_SIZE) != 0) {
+    perror(path);
+    close(s_winc.fd);
+    return false;
+  }
+  size = is_new ? WINC_SIM_FLASH_SIZE : (size_t)st.st_size;
+  if (size < FLASH_MIN_SIZE || size > FLASH_MAX_SIZE ||
+      (size & (size - 1)) != 0) {
+    fprintf(stderr,
+            "%s: flash size %zu is not a power of two from %d to %d\n",
+            path,
+            size,
+            FLASH_MIN_SIZE,
+            FLASH_MAX_SIZE);
+    close(s_winc.fd);
+    return false;
+  }
+  s_winc.flash =
+      mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, s_winc.fd, 0);
+  if (s_winc.flash == MAP_FAILED) {
+    perror(path);
+    close(s_winc.fd);
+    return false;
+  }
+  s_winc.flash_size = size;
+  if (is_new) {
+    memset(s_winc.flash, FLASH_ERASED, size);
+  }
+
+  // RDID reports the size as 0x11 + log2(megabits): see spi_flash_get_size().
+  s_winc.flash_capacity_id = 0x11;
+  for (size_t megabits = size >> 17; megabits > 1; megabits >>= 1) {
+    s_winc.flash_capacity_id++;
+  }
+
+  memcpy(s_winc.efuse[0], s_default_efuse_bank_0, sizeof(s_winc.efuse[0]));
+  power_on_reset();
+  return true;
+}
+
+void winc_sim_close(void) {
+  if (s_winc.flash != NULL) {
+    msync(s_winc.flash, s_winc.flash_size, MS_SYNC);
+    munmap(s_winc.flash, s_winc.flash_size);
+    close(s_winc.fd);
+    s_winc.flash = NULL;
+  }
+}
+
+winc_sim_stats_t winc_sim_stats_get(void) {
+  return s_winc.stats;
+}
+
+void winc_sim_stats_reset(void) {
+  memset(&s_winc.stats, 0, sizeof(s_winc.stats));
+}
+
+void winc_sim_set_efuse_bank(uint8_t bank, const uint32_t words[4]) {
+  if (bank < WINC_SIM_N_EFUSE_BANKS) {
+    memcpy(s_winc.efuse[bank], words, sizeof(s_winc.efuse[bank]));
+  }
+}
+
+// The WINC driver's SPI and GPIO interface (wdrv_winc_spi.h, wdrv_winc_gpio.h)
+
+bool WDRV_WINC_SPISend(void *pTransmitData, size_t txSize) {
+  const uint8_t *p = pTransmitData;
+
+  STATS_INC(STATS_SPI_DMA_TRANSFERS);
+  STATS_ADD(STATS_SPI_BYTES_OUT, txSize);
+  charge_spi(txSize);
+  if (is_powered()) {
+    for (size_t i = 0; i < txSize; i++) {
+      mosi_byte(p[i]);
+    }
+  }
+  return true;
+}
+
+bool WDRV_WINC_SPIReceive(void *pReceiveData, size_t rxSize) {
+  uint8_t *p = pReceiveData;
+
+  STATS_INC(STATS_SPI_DMA_TRANSFERS);
+  STATS_ADD(STATS_SPI_BYTES_IN, rxSize);
+  charge_spi(rxSize);
+  for (size_t i = 0; i < rxSize; i++) {
+    p[i] = is_powered() ? rsp_pop() : IDLE_BYTE;
+  }
+  return true;
+}
+
+void WDRV_WINC_GPIOChipEnableAssert(void) {
+  s_winc.chip_enabled = true;
+}
+
+void WDRV_WINC_GPIOChipEnableDeassert(void) {
+  s_winc.chip_enabled = false;
+  power_on_reset();
+}
+
+void WDRV_WINC_GPIOResetAssert(void) {
+  s_winc.in_reset = true;
+  power_on_reset();
+}
+
+void WDRV_WINC_GPIOResetDeassert(void) {
+  s_winc.in_reset = false;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool is_powered(void) {
+  return s_winc.chip_enabled && !s_winc.in_reset && s_winc.flash != NULL;
+}
+
+static void power_on_reset(void) {
+  s_winc.crc_on = true;
+  s_winc.wire_state = WIRE_COMMAND;
+  s_winc.cmd_len = 0;
+  rsp_clear();
+  memset(s_winc.regs, 0, sizeof(s_winc.regs));
+  reg_set(REG_SPI_PROTOCOL_CONFIG, PROTOCOL_CONFIG_RESET);
+  // The boot ROM loads bank 0 (wait_for_bootrom() polls for it).
+  memset(s_winc.efuse_loaded, 0, sizeof(s_winc.efuse_loaded));
+  s_winc.efuse_loaded[0] = true;
+  s_winc.tr_done_at = 0;
+  s_winc.flash_wel = false;
+  s_winc.flash_deep_power_down = false;
+  s_winc.flash_busy_until = 0;
+}
+
+static void charge_spi(size_t n_bytes) {
+  s_winc.stats.spi_transfers++;
+  s_winc.stats.spi_bytes += n_bytes;
+  sim_clock_advance(s_winc.timing.spi_call_ns +
+                    (n_bytes * 8 * SIM_CLOCK_NS_PER_S) / s_winc.timing.spi_hz);
+}
+
+// SPI slave
+
+static void mosi_byte(uint8_t b) {
+  switch (s_winc.wire_state) {
+  case WIRE_COMMAND:
+    if (s_winc.cmd_len == 0) {
+      if (command_length(b) == 0) {
+        return; // not a command: the bus is idle.
+      }
+      // A new command discards any response the host didn't read, such as
+      // the one to a write of rNMI_GLB_RESET.
+      rsp_clear();
+    }
+    s_winc.cmd[s_winc.cmd_len++] = b;
+    if (s_winc.cmd_len == command_length(s_winc.cmd[0])) {
+      command_execute();
+      s_winc.cmd_len = 0;
+    }
+    break;
+
+  case WIRE_DATA_TOKEN:
+    if ((b & DATA_TOKEN_MASK) == DATA_TOKEN_MASK) {
+      s_winc.pkt_remaining = (s_winc.dma_remaining < DATA_PKT_SZ)
+                                 ? s_winc.dma_remaining
+                                 : DATA_PKT_SZ;
+      s_winc.wire_state = WIRE_DATA;
+    }
+    break;
+
+  case WIRE_DATA:
+    bus_write(s_winc.dma_addr++, &b, 1);
+    s_winc.dma_remaining--;
+    if (--s_winc.pkt_remaining == 0) {
+      if (s_winc.crc_on) {
+        s_winc.crc_remaining = 2;
+        s_winc.wire_state = WIRE_DATA_CRC;
+      } else {
+        data_packet_done();
+      }
+    }
+    break;
+
+  case WIRE_DATA_CRC:
+    if (--s_winc.crc_remaining == 0) {
+      data_packet_done();
+    }
+    break;
+  }
+}
+
+static size_t command_length(uint8_t cmd) {
+  size_t len;
+
+  switch (cmd) {
+  case CMD_SINGLE_READ:
+  case CMD_INTERNAL_READ:
+  case CMD_RESET:
+    len = 5;
+    break;
+  case CMD_DMA_EXT_WRITE:
+  case CMD_DMA_EXT_READ:
+  case CMD_INTERNAL_WRITE:
+    len = 8;
+    break;
+  case CMD_SINGLE_WRITE:
+    len = 9;
+    break;
+  default:
+    return 0;
+  }
+  return s_winc.crc_on ? len : len - 1; // the last byte is the CRC
+}
+
+static void command_execute(void) {
+  const uint8_t *cmd = s_winc.cmd;
+  size_t len = s_winc.cmd_len;
+  uint32_t addr24 = ((uint32_t)cmd[1] << 16) | ((uint32_t)cmd[2] << 8) | cmd[3];
+  uint32_t addr16 = ((uint32_t)(cmd[1] & ~CMD_CLOCKLESS) << 8) | cmd[2];
+  bool clockless = (cmd[1] & CMD_CLOCKLESS) != 0;
+  uint32_t size;
+
+  if (s_winc.crc_on && (uint8_t)(crc7(CRC7_SEED, cmd, len - 1) << 1) !=
+                           cmd[len - 1]) {
+    s_winc.stats.crc_errors++;
+    return; // no response: the host resets the protocol and retries.
+  }
+  s_winc.stats.spi_commands++;
+
+  if (cmd[0] == CMD_RESET) {
+    rsp_push(IDLE_BYTE); // spi_cmd_rsp() skips a byte after a reset
+  }
+  rsp_push(cmd[0]);
+  rsp_push(0x00); // state: ok
+
+  switch (cmd[0]) {
+  case CMD_SINGLE_READ:
+  case CMD_INTERNAL_READ:
+    rsp_push(DATA_TOKEN_LAST);
+    rsp_push_word(reg_read(cmd[0] == CMD_SINGLE_READ ? addr24 : addr16));
+    if (s_winc.crc_on && (cmd[0] == CMD_SINGLE_READ || !clockless)) {
+      rsp_push(0x00);
+      rsp_push(0x00);
+    }
+    break;
+
+  case CMD_SINGLE_WRITE:
+    reg_write(addr24,
+              ((uint32_t)cmd[4] << 24) | ((uint32_t)cmd[5] << 16) |
+                  ((uint32_t)cmd[6] << 8) | cmd[7]);
+    break;
+
+  case CMD_INTERNAL_WRITE:
+    reg_write(addr16,
+              ((uint32_t)cmd[3] << 24) | ((uint32_t)cmd[4] << 16) |
+                  ((uint32_t)cmd[5] << 8) | cmd[6]);
+    break;
+
+  case CMD_DMA_EXT_READ:
+    size = ((uint32_t)cmd[4] << 16) | ((uint32_t)cmd[5] << 8) | cmd[6];
+    for (uint32_t done = 0; done < size;) {
+      uint32_t n = (size - done < DATA_PKT_SZ) ? size - done : DATA_PKT_SZ;
+      if (s_winc.rsp_len + n + 3 > RSP_BUF_SZ) {
+        fprintf(stderr, "winc_sim: %ld byte read too long\n", (long)size);
+        break;
+      }
+      rsp_push((done + n == size) ? DATA_TOKEN_LAST
+               : (done == 0)      ? DATA_TOKEN_FIRST
+                                  : DATA_TOKEN_MIDDLE);
+      bus_read(addr24 + done, &s_winc.rsp[s_winc.rsp_len], n);
+      s_winc.rsp_len += n;
+      if (s_winc.crc_on) {
+        rsp_push(0x00);
+        rsp_push(0x00);
+      }
+      done += n;
+    }
+    break;
+
+  case CMD_DMA_EXT_WRITE:
+    size = ((uint32_t)cmd[4] << 16) | ((uint32_t)cmd[5] << 8) | cmd[6];
+    s_winc.dma_addr = addr24;
+    s_winc.dma_remaining = size;
+    s_winc.wire_state = (size > 0) ? WIRE_DATA_TOKEN : WIRE_COMMAND;
+    break;
+
+  case CMD_RESET:
+    s_winc.wire_state = WIRE_COMMAND;
+    break;
+  }
+}
+
+static void data_packet_done(void) {
+  if (s_winc.dma_remaining > 0) {
+    s_winc.wire_state = WIRE_DATA_TOKEN;
+    return;
+  }
+  // spi_write_block() reads two bytes, or three without CRC, and checks the
+  // last two.
+  if (!s_winc.crc_on) {
+    rsp_push(IDLE_BYTE);
+  }
+  rsp_push(DATA_ACK);
+  rsp_push(0x00);
+  s_winc.wire_state = WIRE_COMMAND;
+}
+
+static uint8_t crc7(uint8_t crc, const uint8_t *buf, size_t len) {
+  while (len--) {
+    uint8_t b = *buf++;
+    for (int i = 0; i < 8; i++) {
+      bool feedback = ((crc >> 6) ^ (b >> 7)) & 1;
+      crc = (crc << 1) & 0x7f;
+      if (feedback) {
+        crc ^= 0x09;
+      }
+      b <<= 1;
+    }
+  }
+  return crc;
+}
+
+static void rsp_clear(void) {
+  s_winc.rsp_head = 0;
+  s_winc.rsp_len = 0;
+}
+
+static void rsp_push(uint8_t b) {
+  if (s_winc.rsp_len < RSP_BUF_SZ) {
+    s_winc.rsp[s_winc.rsp_len++] = b;
+  }
+}
+
+static void rsp_push_word(uint32_t word) {
+  for (int i = 0; i < 4; i++) {
+    rsp_push((uint8_t)(word >> (8 * i))); // registers go out LSB first
+  }
+}
+
+static uint8_t rsp_pop(void) {
+  if (s_winc.rsp_head < s_winc.rsp_len) {
+    return s_winc.rsp[s_winc.rsp_head++];
+  }
+  return IDLE_BYTE;
+}
+
+// Registers and memory
+
+static void bus_read(uint32_t addr, uint8_t *dst, size_t n) {
+  if (addr >= SHARE_MEM_BASE && addr + n <= SHARE_MEM_BASE + SHARE_MEM_SZ) {
+    memcpy(dst, &s_winc.share_mem[addr - SHARE_MEM_BASE], n);
+    return;
+  }
+  for (size_t i = 0; i < n; i++, addr++) {
+    dst[i] = (uint8_t)(reg_read(addr & ~3u) >> (8 * (addr & 3)));
+  }
+}
+
+static void bus_write(uint32_t addr, const uint8_t *src, size_t n) {
+  if (addr >= SHARE_MEM_BASE && addr + n <= SHARE_MEM_BASE + SHARE_MEM_SZ) {
+    memcpy(&s_winc.share_mem[addr - SHARE_MEM_BASE], src, n);
+    return;
+  }
+  for (size_t i = 0; i < n; i++, addr++) {
+    uint32_t shift = 8 * (addr & 3);
+    uint32_t word = reg_read(addr & ~3u) & ~(0xfful << shift);
+    reg_write(addr & ~3u, word | ((uint32_t)src[i] << shift));
+  }
+}
+
+static uint32_t reg_read(uint32_t addr) {
+  uint32_t word;
+  int bank;
+
+  if (addr >= SHARE_MEM_BASE && addr < SHARE_MEM_BASE + SHARE_MEM_SZ) {
+    bus_read(addr, (uint8_t *)&word, sizeof(word)); // little endian host
+    return word;
+  }
+  if (efuse_data_word(addr, &word)) {
+    return word;
+  }
+  if ((bank = efuse_control_bank(addr)) >= 0) {
+    return reg_get(addr) | (s_winc.efuse_loaded[bank] ? EFUSE_LOADED : 0);
+  }
+  switch (addr) {
+  case REG_CHIP_ID:
+    return WINC_SIM_CHIP_ID;
+  case REG_RF_REV_ID:
+    return 0;
+  case SPI_FLASH_TR_DONE:
+    return (sim_clock_now() >= s_winc.tr_done_at) ? 1 : 0;
+  default:
+    return reg_get(addr);
+  }
+}
+
+static void reg_write(uint32_t addr, uint32_t value) {
+  int bank;
+
+  if (addr >= SHARE_MEM_BASE && addr < SHARE_MEM_BASE + SHARE_MEM_SZ) {
+    bus_write(addr, (const uint8_t *)&value, sizeof(value));
+    return;
+  }
+  reg_set(addr, value);
+  if ((bank = efuse_control_bank(addr)) >= 0) {
+    // Burning efuses is not modelled: only the load command does anything.
+    if (value == EFUSE_LOAD) {
+      s_winc.efuse_loaded[bank] = true;
+    }
+  } else if (addr == REG_SPI_PROTOCOL_CONFIG) {
+    s_winc.crc_on = (value & PROTOCOL_CONFIG_CRC) != 0;
+  } else if (addr == SPI_FLASH_CMD_CNT && (value & CMD_CNT_START)) {
+    flash_transaction(value);
+  }
+}
+
+static reg_t *reg_find(uint32_t addr, bool create) {
+  size_t i = (addr * 2654435761u) % N_REGS;
+
+  for (size_t probes = 0; probes < N_REGS; probes++, i = (i + 1) % N_REGS) {
+    if (s_winc.regs[i].used && s_winc.regs[i].addr == addr) {
+      return &s_winc.regs[i];
+    }
+    if (!s_winc.regs[i].used) {
+      if (!create) {
+        return NULL;
+      }
+      s_winc.regs[i].used = true;
+      s_winc.regs[i].addr = addr;
+      s_winc.regs[i].value = 0;
+      return &s_winc.regs[i];
+    }
+  }
+  fprintf(stderr, "winc_sim: no room for register 0x%lx\n", (long)addr);
+  return NULL;
+}
+
+static uint32_t reg_get(uint32_t addr) {
+  reg_t *reg = reg_find(addr, false);
+  return (reg != NULL) ? reg->value : 0;
+}
+
+static void reg_set(uint32_t addr, uint32_t value) {
+  reg_t *reg = reg_find(addr, true);
+  if (reg != NULL) {
+    reg->value = value;
+  }
+}
+
+static int efuse_control_bank(uint32_t addr) {
+  if (addr == EFUSE_0_CONTROL || addr == EFUSE_0_CONTROL + 4) {
+    return (addr - EFUSE_0_CONTROL) / 4;
+  }
+  if (addr >= EFUSE_2_CONTROL &&
+      addr < EFUSE_2_CONTROL + 4 * (WINC_SIM_N_EFUSE_BANKS - 2)) {
+    return 2 + (addr - EFUSE_2_CONTROL) / 4;
+  }
+  return -1;
+}
+
+static bool efuse_data_word(uint32_t addr, uint32_t *word) {
+  for (int bank = 0; bank < WINC_SIM_N_EFUSE_BANKS; bank++) {
+    uint32_t base = (bank < 2) ? EFUSE_0_DATA + bank * EFUSE_0_DATA_STRIDE
+                               : EFUSE_2_DATA + (bank - 2) * EFUSE_2_DATA_STRIDE;
+    if (addr >= base && addr < base + sizeof(s_winc.efuse[bank])) {
+      *word = s_winc.efuse_loaded[bank] ? s_winc.efuse[bank][(addr - base) / 4]
+                                        : 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Flash controller and flash
+
+static void flash_transaction(uint32_t cmd_cnt) {
+  uint32_t buf1 = reg_get(SPI_FLASH_BUF1);
+  uint8_t op = (uint8_t)buf1;
+  uint32_t addr = ((buf1 >> 8) & 0xff) << 16 | ((buf1 >> 16) & 0xff) << 8 |
+                  ((buf1 >> 24) & 0xff);
+  uint32_t n_read = reg_get(SPI_FLASH_DATA_CNT);
+  uint32_t n_write = CMD_CNT_WRITE_LEN(cmd_cnt);
+  uint64_t n_bytes = CMD_CNT_LEN(cmd_cnt) + n_read + n_write;
+
+  s_winc.stats.flash_commands++;
+
+  // The controller clocks the command, then the data, to or from the flash.
+  s_winc.tr_done_at =
+      sim_clock_now() +
+      (n_bytes * 8 * SIM_CLOCK_NS_PER_S) / s_winc.timing.flash_spi_hz;
+  flash_command(op,
+                addr,
+                reg_get(SPI_FLASH_DMA_ADDR),
+                n_read,
+                n_write,
+                s_winc.tr_done_at);
+}
+
+static void flash_command(uint8_t op,
+                          uint32_t addr,
+                          uint32_t dma_addr,
+                          uint32_t n_read,
+                          uint32_t n_write,
+                          uint64_t done_at) {
+  bool busy = sim_clock_now() < s_winc.flash_busy_until;
+  uint8_t id[3] = {FLASH_MANUFACTURER_ID,
+                   FLASH_MEMORY_TYPE,
+                   s_winc.flash_capacity_id};
+
+  if (n_read > sizeof(s_flash_buf)) {
+    n_read = sizeof(s_flash_buf);
+  }
+  // Data out of a flash that isn't listening reads as all ones.
+  memset(s_flash_buf, FLASH_ERASED, n_read);
+
+  if (s_winc.flash_deep_power_down && op != FLASH_RELEASE_POWER_DOWN) {
+    op = 0; // ignored
+  } else if (busy && op != FLASH_READ_STATUS) {
+    op = 0; // ignored
+  }
+
+  switch (op) {
+  case FLASH_READ_STATUS:
+    memset(s_flash_buf,
+           (busy ? FLASH_STATUS_WIP : 0) |
+               (s_winc.flash_wel ? FLASH_STATUS_WEL : 0),
+           n_read);
+    break;
+  case FLASH_READ_ID:
+    for (uint32_t i = 0; i < n_read; i++) {
+      s_flash_buf[i] = id[i % sizeof(id)]; // the ID repeats while clocked
+    }
+    break;
+  case FLASH_FAST_READ:
+    s_winc.stats.flash_bytes_read += n_read;
+    for (uint32_t i = 0; i < n_read; i++) {
+      s_flash_buf[i] = s_winc.flash[(addr + i) & (s_winc.flash_size - 1)];
+    }
+    break;
+  case FLASH_WRITE_ENABLE:
+    s_winc.flash_wel = true;
+    break;
+  case FLASH_WRITE_DISABLE:
+    s_winc.flash_wel = false;
+    break;
+  case FLASH_SECTOR_ERASE:
+    if (s_winc.flash_wel) {
+      addr &= (s_winc.flash_size - 1) & ~(FLASH_SECTOR_SZ - 1);
+      memset(&s_winc.flash[addr], FLASH_ERASED, FLASH_SECTOR_SZ);
+      s_winc.stats.sector_erases++;
+      s_winc.flash_busy_until =
+          done_at + s_winc.timing.sector_erase_us * SIM_CLOCK_NS_PER_US;
+      s_winc.flash_wel = false;
+    }
+    break;
+  case FLASH_PAGE_PROGRAM:
+    if (s_winc.flash_wel) {
+      flash_page_program(addr, dma_addr, n_write);
+      s_winc.stats.page_programs++;
+      s_winc.stats.flash_bytes_programmed += n_write;
+      s_winc.flash_busy_until =
+          done_at + s_winc.timing.page_program_us * SIM_CLOCK_NS_PER_US;
+      s_winc.flash_wel = false;
+    }
+    break;
+  case FLASH_DEEP_POWER_DOWN:
+    s_winc.flash_deep_power_down = true;
+    break;
+  case FLASH_RELEASE_POWER_DOWN:
+    s_winc.flash_deep_power_down = false;
+    break;
+  default:
+    break;
+  }
+
+  if (n_read > 0) {
+    bus_write(dma_addr, s_flash_buf, n_read);
+  }
+}
+
+static void flash_page_program(uint32_t addr, uint32_t dma_addr, uint32_t n) {
+  uint8_t latch[FLASH_PAGE_SZ];
+  uint32_t page = addr & (s_winc.flash_size - 1) & ~(FLASH_PAGE_SZ - 1);
+  uint32_t offset = addr & (FLASH_PAGE_SZ - 1);
+
+  // Like the real part: data wraps within the page, only the last page's
+  // worth is kept, and programming can only clear bits.
+  memset(latch, FLASH_ERASED, sizeof(latch));
+  if (n > sizeof(s_flash_buf)) {
+    n = sizeof(s_flash_buf);
+  }
+  bus_read(dma_addr, s_flash_buf, n);
+  for (uint32_t i = 0; i < n; i++) {
+    latch[(offset + i) % FLASH_PAGE_SZ] = s_flash_buf[i];
+  }
+  for (uint32_t i = 0; i < FLASH_PAGE_SZ; i++) {
+    s_winc.flash[page + i] &= latch[i];
+  }
+}
+
+// *****************************************************************************
+// End of file
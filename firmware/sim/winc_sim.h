@@ -0,0 +1,150 @@
+/**
+ * @file winc_sim.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief winc_sim models a WINC1500 module at the SPI bus, for host builds.
+ *
+ * winc_sim stands in for the WINC driver's lowest layer (WDRV_WINC_SPISend(),
+ * WDRV_WINC_SPIReceive() and the chip enable and reset pins), so the driver
+ * above it runs unmodified: nmspi.c's command, data and CRC framing, nmbus.c,
+ * nmasic.c and nmdrv.c, then spi_flash.c and efuse.c.  Behind the SPI slave,
+ * the model provides:
+ *
+ * - the chip ID and RF revision registers (a 3A0 WINC1500);
+ * - the SPI flash controller register window (SPI_FLASH_* in spi_flash.c), and
+ *   the shared packet memory at HOST_SHARE_MEM_BASE that it moves data through;
+ * - a serial flash that answers RDID, RDSR, WREN/WRDI, fast read, 4 KB sector
+ *   erase, page program and deep power-down as the real part does, including
+ *   ignoring commands while busy and NOR semantics (programming only clears
+ *   bits);
+ * - the efuse banks and their load sequence.
+ *
+ * The flash contents live in a file, mapped into memory, so an image can be
+ * inspected or compared with host tools after a run.  Transfers and flash
+ * operations charge sim_clock for the time they take, per winc_sim_timing_t,
+ * and are counted in winc_sim_stats_t.
+ */
+
+#ifndef _WINC_SIM_H_
+#define _WINC_SIM_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define WINC_SIM_CHIP_ID 0x1503a0
+#define WINC_SIM_FLASH_SIZE (1024 * 1024) // size of a newly created flash file
+#define WINC_SIM_N_EFUSE_BANKS 6
+
+/**
+ * @brief Costs charged to sim_clock.  Defaults from winc_sim_timing_default().
+ */
+typedef struct {
+  uint32_t spi_hz;          // host SPI clock (see initialization.c)
+  uint32_t spi_call_ns;     // fixed cost of each WDRV_WINC_SPISend/Receive()
+  uint32_t flash_spi_hz;    // clock between the WINC and its serial flash
+  uint32_t sector_erase_us; // busy time of a 4 KB sector erase
+  uint32_t page_program_us; // busy time of a 256 byte page program
+} winc_sim_timing_t;
+
+/**
+ * @brief Work done since winc_sim_open() or winc_sim_stats_reset().
+ */
+typedef struct {
+  uint32_t spi_transfers;   // calls to WDRV_WINC_SPISend/Receive()
+  uint32_t spi_commands;    // nmspi commands executed (register or block)
+  uint32_t crc_errors;      // commands rejected for a bad CRC
+  uint64_t spi_bytes;       // bytes on the WINC SPI bus, both directions
+  uint32_t flash_commands;  // serial flash transactions
+  uint64_t flash_bytes_read;
+  uint32_t sector_erases;
+  uint32_t page_programs;
+  uint64_t flash_bytes_programmed;
+} winc_sim_stats_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Return timings typical of a WINC1500 and its MX25-class flash.
+ */
+winc_sim_timing_t winc_sim_timing_default(void);
+
+/**
+ * @brief Power up the model with the flash contents in the file at path.
+ *
+ * A missing file is created, WINC_SIM_FLASH_SIZE bytes and erased (0xff).  The
+ * file size must be a power of two from 256 KB to 16 MB.  The efuse banks
+ * start out as on a typical module: bank 0 holds a MAC address and a crystal
+ * frequency offset.
+ *
+ * @return true on success, false (after printing why) if the file could not
+ *         be used.
+ */
+bool winc_sim_open(const char *path, const winc_sim_timing_t *timing);
+
+/**
+ * @brief Flush the flash contents to the file and release it.
+ */
+void winc_sim_close(void);
+
+/**
+ * @brief Return the counts of work done since the last reset.
+ */
+winc_sim_stats_t winc_sim_stats_get(void);
+
+/**
+ * @brief Zero the counts returned by winc_sim_stats_get().
+ */
+void winc_sim_stats_reset(void);
+
+/**
+ * @brief Replace the contents of an efuse bank (four 32-bit words, laid out as
+ * efuse.c reads them).
+ */
+void winc_sim_set_efuse_bank(uint8_t bank, const uint32_t words[4]);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _WINC_SIM_H_ */
@@ -31,8 +31,11 @@
 #include "app.h"
 
 #include "definitions.h"
+#include "binlog.h"
 #include "cmd_task.h"
 #include "dir_reader.h"
+#include "host_proto.h"
+#include "prof.h"
 #include "winc_cloner.h"
 #include <stdbool.h>
 
@@ -49,9 +52,13 @@
 #define EXPAND_STATE_IDS(_name) _name,
 typedef enum { APP_STATES(EXPAND_STATE_IDS) } app_state_t;
 
+// Warn if the SD card has not mounted within this many ms of boot.
+#define APP_MOUNT_TIMEOUT_MS 10000
+
 typedef struct {
   app_state_t state;
-  uint32_t mount_retries;
+  uint32_t boot_count; // SYS_TIME counter at APP_Initialize()
+  bool mount_is_late;  // the APP_MOUNT_TIMEOUT_MS warning has been printed
 } app_ctx_t;
 
 // *****************************************************************************
@@ -67,6 +74,21 @@ static void set_state(app_state_t state);
  */
 static const char *state_name(app_state_t state);
 
+/**
+ * @brief Return the number of milliseconds since APP_Initialize().
+ */
+static uint32_t ms_since_boot(void);
+
+/**
+ * @brief Return true once the SD volume is ready to be used.
+ *
+ * The volume is mounted as soon as the media manager reports the card as
+ * attached, rather than retrying SYS_FS_Mount() on every pass.  A media
+ * manager generated with automount (klatu_bb2_x) mounts the volume itself,
+ * which shows here as a drive that can already be selected.
+ */
+static bool mount_when_ready(void);
+
 // *****************************************************************************
 // Private (static) storage
 
@@ -82,14 +104,22 @@ static app_ctx_t s_app_ctx;
 
 void APP_Initialize(void) {
   s_app_ctx.state = APP_STATE_IDLE;
-  s_app_ctx.mount_retries = 0;
+  s_app_ctx.boot_count = SYS_TIME_CounterGet();
+  s_app_ctx.mount_is_late = false;
+#if PROF_ENABLED
+  prof_init();
+#endif
   APP_PrintBanner();
   cmd_task_init();
   dir_reader_init();
+  host_proto_init();
   winc_cloner_init();
 }
 
 void APP_Tasks(void) {
+  // debug messages recorded since the last pass go out now, off the hot path.
+  binlog_flush();
+
   switch (s_app_ctx.state) {
   case APP_STATE_IDLE: {
     // here on idle state.
@@ -98,13 +128,10 @@ void APP_Tasks(void) {
   } break;
 
   case APP_STATE_AWAIT_FILESYSTEM: {
-    // Waiting for file system to complete mounting.
-    s_app_ctx.mount_retries += 1;
-    if (SYS_FS_Mount(SD_DEVICE_NAME, SD_MOUNT_NAME, FAT, 0, NULL) ==
-        SYS_FS_RES_SUCCESS) {
+    // Waiting for the SD card to attach and the file system to mount.
+    if (mount_when_ready()) {
       // file system mounted.
-      SYS_CONSOLE_PRINT("mounted after %ld attempts",
-                        s_app_ctx.mount_retries);
+      SYS_CONSOLE_PRINT("mounted after %ld ms", ms_since_boot());
       // Set current drive so that we do not have to use absolute path.
       if (SYS_FS_CurrentDriveSet(SD_MOUNT_NAME) == SYS_FS_RES_FAILURE) {
         SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
@@ -113,11 +140,16 @@ void APP_Tasks(void) {
         set_state(APP_STATE_ERROR);
       } else {
         set_state(APP_STATE_PROCESSING_COMMANDS);
+        SYS_CONSOLE_PRINT("\nReady after %ld ms", ms_since_boot());
       }
 
-    } else if (s_app_ctx.mount_retries % 10000 == 0) {
-      // waiting for file system to mount...
-      SYS_CONSOLE_MESSAGE(".");
+    } else if (!s_app_ctx.mount_is_late &&
+               ms_since_boot() > APP_MOUNT_TIMEOUT_MS) {
+      // A card inserted late (or reseated) still mounts: keep waiting.
+      SYS_DEBUG_PRINT(SYS_ERROR_WARNING,
+                      "\nNo SD file system after %d ms, check the card",
+                      APP_MOUNT_TIMEOUT_MS);
+      s_app_ctx.mount_is_late = true;
     }
   } break;
 
@@ -167,5 +199,23 @@ static const char *state_name(app_state_t state) {
   return s_state_names[state];
 }
 
+static uint32_t ms_since_boot(void) {
+  return SYS_TIME_CountToMS(SYS_TIME_CounterGet() - s_app_ctx.boot_count);
+}
+
+static bool mount_when_ready(void) {
+  if (!SYS_FS_MEDIA_MANAGER_MediaStatusGet(SD_DEVICE_NAME)) {
+    // card not attached (yet): nothing to mount.
+    return false;
+  }
+  if (SYS_FS_CurrentDriveSet(SD_MOUNT_NAME) == SYS_FS_RES_SUCCESS) {
+    // already mounted by the file system's automount.
+    return true;
+  }
+  // Attached: a failed mount is retried on the next pass.
+  return SYS_FS_Mount(SD_DEVICE_NAME, SD_MOUNT_NAME, FAT, 0, NULL) ==
+         SYS_FS_RES_SUCCESS;
+}
+
 // *****************************************************************************
 // End of file
@@ -0,0 +1,146 @@
+/**
+ * @file binlog.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "binlog.h"
+
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define HEADER_WORDS 3 // argument count, format address, timestamp
+#define LINE_PREFIX "\n#BL"
+#define MAX_LINE_LENGTH                                                        \
+  (sizeof(LINE_PREFIX) + 9 * (HEADER_WORDS - 1 + BINLOG_MAX_ARGS))
+#define WORD_INDEX(_i) ((_i) & (BINLOG_BUFFER_WORDS - 1))
+
+typedef struct {
+  uint32_t head;       // where binlog_write() stores the next word
+  uint32_t tail;       // first word not yet flushed
+  uint32_t n_dropped;  // records dropped since startup
+  uint32_t n_reported; // value of n_dropped at the last drop notice
+} binlog_ctx_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Format the record starting at s_words[index] into s_line and return
+ * its length.  Set *n_words to the number of words it occupies.
+ */
+static size_t format_record(uint32_t index, uint32_t *n_words);
+
+// *****************************************************************************
+// Private (static) storage
+
+static binlog_ctx_t s_binlog_ctx;
+
+static uint32_t s_words[BINLOG_BUFFER_WORDS];
+
+static char s_line[MAX_LINE_LENGTH];
+
+// *****************************************************************************
+// Public code
+
+void binlog_write(const char *fmt, size_t n_args, const uint32_t *args) {
+  uint32_t head;
+  uint32_t n_free;
+  bool interrupt_state;
+
+  if (SYS_ERROR_DEBUG > SYS_DEBUG_ErrorLevelGet()) {
+    return; // not logging at debug level.
+  }
+
+  interrupt_state = NVIC_INT_Disable();
+  head = s_binlog_ctx.head;
+  n_free = BINLOG_BUFFER_WORDS - 1 - WORD_INDEX(head - s_binlog_ctx.tail);
+  if (HEADER_WORDS + n_args > n_free) {
+    // drop the whole record: never overwrite ones not yet flushed.
+    s_binlog_ctx.n_dropped += 1;
+  } else {
+    s_words[WORD_INDEX(head++)] = n_args;
+    s_words[WORD_INDEX(head++)] = (uint32_t)(uintptr_t)fmt;
+    s_words[WORD_INDEX(head++)] = SYS_TIME_CounterGet();
+    for (size_t i = 0; i < n_args; i++) {
+      s_words[WORD_INDEX(head++)] = args[i];
+    }
+    s_binlog_ctx.head = WORD_INDEX(head);
+  }
+  NVIC_INT_Restore(interrupt_state);
+}
+
+void binlog_flush(void) {
+  uint32_t n_dropped = s_binlog_ctx.n_dropped;
+
+  while (s_binlog_ctx.tail != s_binlog_ctx.head) {
+    uint32_t n_words;
+    size_t len = format_record(s_binlog_ctx.tail, &n_words);
+
+    if (SYS_CONSOLE_WriteFreeBufferCountGet(SYS_CONSOLE_DEFAULT_INSTANCE) <
+        (ssize_t)len) {
+      return; // the console is busy: flush the rest next time.
+    }
+    SYS_CONSOLE_Write(SYS_CONSOLE_DEFAULT_INSTANCE, s_line, len);
+    s_binlog_ctx.tail = WORD_INDEX(s_binlog_ctx.tail + n_words);
+  }
+
+  if (n_dropped != s_binlog_ctx.n_reported) {
+    SYS_CONSOLE_PRINT("\n[binlog: %ld records dropped]",
+                      n_dropped - s_binlog_ctx.n_reported);
+    s_binlog_ctx.n_reported = n_dropped;
+  }
+}
+
+uint32_t binlog_dropped_count(void) { return s_binlog_ctx.n_dropped; }
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t format_record(uint32_t index, uint32_t *n_words) {
+  static const char hex[] = "0123456789abcdef";
+  size_t len = sizeof(LINE_PREFIX) - 1;
+
+  *n_words = HEADER_WORDS + s_words[index];
+  memcpy(s_line, LINE_PREFIX, len);
+  // the argument count is implied by the number of words on the line.
+  for (uint32_t i = 1; i < *n_words; i++) {
+    uint32_t word = s_words[WORD_INDEX(index + i)];
+    s_line[len++] = ' ';
+    for (int shift = 28; shift >= 0; shift -= 4) {
+      s_line[len++] = hex[(word >> shift) & 0xf];
+    }
+  }
+  return len;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file binlog.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief binlog records debug messages without formatting them.
+ *
+ * BINLOG(fmt, ...) stores the address of its format string, a SYS_TIME
+ * timestamp and its raw arguments in a RAM ring buffer: a few stores instead
+ * of a vsnprintf().  binlog_flush() later writes the pending records to the
+ * console as lines of hex words:
+ *
+ *     #BL <format address> <timestamp> <argument>...
+ *
+ * and host/binlog_decode.py turns them back into text, looking the format
+ * strings up in the firmware's ELF file (they live in section .binlog_fmt).
+ *
+ * Like SYS_DEBUG_PRINT(SYS_ERROR_DEBUG, ...), BINLOG() records nothing unless
+ * the SYS_DEBUG error level is SYS_ERROR_DEBUG.
+ *
+ * Arguments are limited to BINLOG_MAX_ARGS integers or pointers of at most 32
+ * bits.  A %s argument is recorded as a pointer, so the decoder can only print
+ * strings that are in flash, such as string literals.
+ */
+
+#ifndef _BINLOG_H_
+#define _BINLOG_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define BINLOG_BUFFER_WORDS 4096 // ring buffer size, must be a power of two
+#define BINLOG_MAX_ARGS 6
+
+/**
+ * @brief Record a debug message for deferred formatting.  Takes a string
+ * literal format and up to BINLOG_MAX_ARGS arguments, as printf() does.
+ */
+#define BINLOG(...)                                                            \
+  BINLOG_SELECT_(__VA_ARGS__, BINLOG_6_, BINLOG_5_, BINLOG_4_, BINLOG_3_,      \
+                 BINLOG_2_, BINLOG_1_, BINLOG_0_)(__VA_ARGS__)
+
+// Implementation of BINLOG(): pick the variant for the argument count...
+#define BINLOG_SELECT_(_fmt, _1, _2, _3, _4, _5, _6, _variant, ...) _variant
+
+#define BINLOG_0_(_fmt) BINLOG_RECORD_(_fmt, 0, (_fmt), 0)
+#define BINLOG_1_(_fmt, _a)                                                    \
+  BINLOG_RECORD_(_fmt, 1, (_fmt, _a), BINLOG_ARG_(_a))
+#define BINLOG_2_(_fmt, _a, _b)                                                \
+  BINLOG_RECORD_(_fmt, 2, (_fmt, _a, _b), BINLOG_ARG_(_a), BINLOG_ARG_(_b))
+#define BINLOG_3_(_fmt, _a, _b, _c)                                            \
+  BINLOG_RECORD_(_fmt,                                                         \
+                 3,                                                            \
+                 (_fmt, _a, _b, _c),                                           \
+                 BINLOG_ARG_(_a),                                              \
+                 BINLOG_ARG_(_b),                                              \
+                 BINLOG_ARG_(_c))
+#define BINLOG_4_(_fmt, _a, _b, _c, _d)                                        \
+  BINLOG_RECORD_(_fmt,                                                         \
+                 4,                                                            \
+                 (_fmt, _a, _b, _c, _d),                                       \
+                 BINLOG_ARG_(_a),                                              \
+                 BINLOG_ARG_(_b),                                              \
+                 BINLOG_ARG_(_c),                                              \
+                 BINLOG_ARG_(_d))
+#define BINLOG_5_(_fmt, _a, _b, _c, _d, _e)                                    \
+  BINLOG_RECORD_(_fmt,                                                         \
+                 5,                                                            \
+                 (_fmt, _a, _b, _c, _d, _e),                                   \
+                 BINLOG_ARG_(_a),                                              \
+                 BINLOG_ARG_(_b),                                              \
+                 BINLOG_ARG_(_c),                                              \
+                 BINLOG_ARG_(_d),                                              \
+                 BINLOG_ARG_(_e))
+#define BINLOG_6_(_fmt, _a, _b, _c, _d, _e, _f)                                \
+  BINLOG_RECORD_(_fmt,                                                         \
+                 6,                                                            \
+                 (_fmt, _a, _b, _c, _d, _e, _f),                               \
+                 BINLOG_ARG_(_a),                                              \
+                 BINLOG_ARG_(_b),                                              \
+                 BINLOG_ARG_(_c),                                              \
+                 BINLOG_ARG_(_d),                                              \
+                 BINLOG_ARG_(_e),                                              \
+                 BINLOG_ARG_(_f))
+
+#define BINLOG_ARG_(_x) ((uint32_t)(uintptr_t)(_x))
+
+// ...place the format string where the decoder will find it, let the compiler
+// check the arguments against it (printf is never called) and record them.
+#define BINLOG_RECORD_(_fmt, _n_args, _printf_args, ...)                       \
+  do {                                                                         \
+    static const char binlog_fmt_[]                                            \
+        __attribute__((section(".binlog_fmt"), used)) = _fmt;                  \
+    const uint32_t binlog_args_[] = {__VA_ARGS__};                             \
+    (void)(0 && printf _printf_args);                                          \
+    binlog_write(binlog_fmt_, (_n_args), binlog_args_);                        \
+  } while (0)
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Append a record to the ring buffer, or count it as dropped if the
+ * buffer is full.  Called through BINLOG(); safe to call from interrupts.
+ */
+void binlog_write(const char *fmt, size_t n_args, const uint32_t *args);
+
+/**
+ * @brief Write pending records to the console, as many as fit in its transmit
+ * buffer without waiting.  Call regularly from the super-loop.
+ */
+void binlog_flush(void);
+
+/**
+ * @brief Return the number of records dropped since startup because the ring
+ * buffer was full.
+ */
+uint32_t binlog_dropped_count(void);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _BINLOG_H_ */
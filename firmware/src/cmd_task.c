@@ -33,7 +33,13 @@
 #include "app.h"
 #include "definitions.h"
 #include "dir_reader.h"
+#include "host_proto.h"
 #include "line_reader.h"
+#include "m2m_types.h"
+#include "prof.h"
+#include "session_log.h"
+#include "spi_trace.h"
+#include "stats.h"
 #include "winc_cloner.h"
 #include <stdbool.h>
 #include <stddef.h>
@@ -52,6 +58,9 @@
   M(CMD_TASK_STATE_START_UPDATING)                                             \
   M(CMD_TASK_STATE_START_COMPARING)                                            \
   M(CMD_TASK_STATE_START_REBUILDING)                                           \
+  M(CMD_TASK_STATE_START_IDENTIFYING)                                          \
+  M(CMD_TASK_STATE_START_PROBING)                                              \
+  M(CMD_TASK_STATE_HOST_PROTOCOL)                                              \
   M(CMD_TASK_STATE_ERROR)
 
 #define EXPAND_STATE_IDS(_name) _name,
@@ -59,8 +68,15 @@ typedef enum { STATES(EXPAND_STATE_IDS) } cmd_task_state_t;
 
 typedef struct {
   cmd_task_state_t state;
+  uint16_t page; // page of the catalog being listed
 } cmd_task_ctx_t;
 
+// Indices typed at a filename prompt select a cataloged image.
+#define MAX_CATALOG_INDEX UINT16_MAX
+
+// Number of catalog entries listed per page.
+#define CATALOG_PAGE_SIZE 16
+
 // *****************************************************************************
 // Private (static, forward) declarations
 
@@ -76,6 +92,17 @@ static const char *state_name(cmd_task_state_t state);
 
 static void flush_serial_input(void);
 
+/**
+ * @brief Print one line of the image catalog.
+ */
+static void print_catalog_entry(uint16_t idx);
+
+/**
+ * @brief If line is the index of a cataloged image, return that image's
+ * filename, otherwise return line.
+ */
+static const char *resolve_filename(const char *line);
+
 static uint8_t downcase(uint8_t ch);
 
 // *****************************************************************************
@@ -91,7 +118,10 @@ static cmd_task_ctx_t s_cmd_task_ctx;
 // *****************************************************************************
 // Public code
 
-void cmd_task_init(void) { s_cmd_task_ctx.state = CMD_TASK_STATE_INIT; }
+void cmd_task_init(void) {
+  s_cmd_task_ctx.state = CMD_TASK_STATE_INIT;
+  s_cmd_task_ctx.page = 0;
+}
 
 /**
  * @brief Step the demo task internal state.  Called frequently.
@@ -122,18 +152,48 @@ void cmd_task_step(void) {
 
   case CMD_TASK_STATE_LISTING_DIRECTORY: {
     // Here when dir_reader has completed successfully
-    uint8_t count = dir_reader_filename_count();
-    SYS_CONSOLE_PRINT("\nFound %d file%s", count, count == 1 ? "" : "s");
-    for (uint8_t idx = 0; idx < count; idx++) {
-      SYS_CONSOLE_PRINT("\n   %s", dir_reader_filename_ref(idx));
+    uint16_t count = dir_reader_filename_count();
+    uint16_t n_pages = (count + CATALOG_PAGE_SIZE - 1) / CATALOG_PAGE_SIZE;
+    if (s_cmd_task_ctx.page >= n_pages) {
+      s_cmd_task_ctx.page = (n_pages > 0) ? n_pages - 1 : 0;
+    }
+    uint16_t first = s_cmd_task_ctx.page * CATALOG_PAGE_SIZE;
+    uint16_t last = first + CATALOG_PAGE_SIZE;
+    if (last > count) {
+      last = count;
+    }
+
+    SYS_CONSOLE_PRINT("\nFound %d image%s", count, count == 1 ? "" : "s");
+    if (dir_reader_dropped_count() > 0) {
+      SYS_CONSOLE_PRINT(" (%d more not cataloged)", dir_reader_dropped_count());
+    }
+    for (uint16_t idx = first; idx < last; idx++) {
+      print_catalog_entry(idx);
+    }
+    if (n_pages > 1) {
+      SYS_CONSOLE_PRINT(
+          "\n  (page %d of %d)", s_cmd_task_ctx.page + 1, n_pages);
     }
     SYS_CONSOLE_MESSAGE("\nCommands:"
                         "\nh: print this help"
+                        "\nn, p: list next / previous page of images"
+                        "\ns: sort images by name / by version"
                         "\ne: extract WINC firmware to a file"
-                        "\nu: update WINC firmware from a file"
-                        "\nc: compare WINC firmware against a file"
+                        "\nu: update WINC firmware from a file (name or #)"
+                        "\nc: compare WINC firmware against a file (name or #)"
                         "\nr: recompute / rebuild WINC PLL tables"
-                        "\n> ");
+                        "\ni: identify WINC firmware among the images"
+                        "\nv: print WINC firmware versions (fast)");
+#if SPI_TRACE_ENABLED
+    SYS_CONSOLE_MESSAGE("\nt: write the WINC SPI trace to " SPI_TRACE_FILENAME);
+#endif
+#if STATS_ENABLED
+    SYS_CONSOLE_MESSAGE("\nk: print and reset bus, flash and SD counters");
+#endif
+#if PROF_ENABLED
+    SYS_CONSOLE_MESSAGE("\nz: print and reset profiling zones");
+#endif
+    SYS_CONSOLE_MESSAGE("\n> ");
     flush_serial_input();
     set_state(CMD_TASK_STATE_AWAIT_COMMAND);
   } break;
@@ -148,11 +208,30 @@ void cmd_task_step(void) {
     if (n_read < 0) {
       SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "\nError while reading from console");
       set_state(CMD_TASK_STATE_ERROR);
+    } else if ((n_read > 0) && (buf[0] == HOST_PROTO_SOF0)) {
+      // start of a binary frame: a host program is taking over.
+      host_proto_start(buf[0]);
+      set_state(CMD_TASK_STATE_HOST_PROTOCOL);
     } else if (n_read > 0) {
       switch (downcase(buf[0])) {
       case 'h':
         set_state(CMD_TASK_STATE_PRINTING_HELP);
         break;
+      case 'n':
+        s_cmd_task_ctx.page += 1;
+        set_state(CMD_TASK_STATE_LISTING_DIRECTORY);
+        break;
+      case 'p':
+        if (s_cmd_task_ctx.page > 0) {
+          s_cmd_task_ctx.page -= 1;
+        }
+        set_state(CMD_TASK_STATE_LISTING_DIRECTORY);
+        break;
+      case 's':
+        dir_reader_sort((dir_reader_get_sort() + 1) % DIR_READER_SORT_COUNT);
+        s_cmd_task_ctx.page = 0;
+        set_state(CMD_TASK_STATE_LISTING_DIRECTORY);
+        break;
       case 'e':
         line_reader_start();
         SYS_CONSOLE_MESSAGE("extract WINC firmware into filename: ");
@@ -172,12 +251,42 @@ void cmd_task_step(void) {
         SYS_CONSOLE_MESSAGE("recompute / rebuild WINC PLL tables");
         set_state(CMD_TASK_STATE_START_REBUILDING);
         break;
+      case 'i':
+        SYS_CONSOLE_MESSAGE("identify WINC firmware among the images");
+        set_state(CMD_TASK_STATE_START_IDENTIFYING);
+        break;
+      case 'v':
+        SYS_CONSOLE_MESSAGE("print WINC firmware versions");
+        set_state(CMD_TASK_STATE_START_PROBING);
+        break;
+#if SPI_TRACE_ENABLED
+      case 't':
+        dir_reader_pause();
+        spi_trace_dump(SPI_TRACE_FILENAME);
+        SYS_CONSOLE_MESSAGE("\n> ");
+        break;
+#endif
+#if STATS_ENABLED
+      case 'k':
+        stats_print();
+        stats_reset();
+        SYS_CONSOLE_MESSAGE("\n> ");
+        break;
+#endif
+#if PROF_ENABLED
+      case 'z':
+        prof_print();
+        prof_reset();
+        SYS_CONSOLE_MESSAGE("\n> ");
+        break;
+#endif
       default:
         SYS_CONSOLE_PRINT("\nUnrecognized command '%c'", buf[0]);
         set_state(CMD_TASK_STATE_PRINTING_HELP);
       }
     } else {
-      // no bytes read -- remain in this state.
+      // no bytes read -- remain in this state, scanning images meanwhile.
+      dir_reader_step();
     }
   } break;
 
@@ -191,7 +300,10 @@ void cmd_task_step(void) {
     } else if (line_reader_succeeded()) {
       const char *filename = line_reader_get_line();
       SYS_CONSOLE_PRINT("\nExtracting WINC firmware into %s", filename);
+      dir_reader_pause();
       winc_cloner_extract(filename);
+      session_log_flush();
+      dir_reader_invalidate(filename);
       set_state(CMD_TASK_STATE_PRINTING_HELP);
 
     } else {
@@ -207,9 +319,11 @@ void cmd_task_step(void) {
       set_state(CMD_TASK_STATE_PRINTING_HELP);  // restart...
 
     } else if (line_reader_succeeded()) {
-      const char *filename = line_reader_get_line();
+      const char *filename = resolve_filename(line_reader_get_line());
       SYS_CONSOLE_PRINT("\nUpdating WINC firmware from %s", filename);
+      dir_reader_pause();
       winc_cloner_update(filename);
+      session_log_flush();
       set_state(CMD_TASK_STATE_PRINTING_HELP);
 
     } else {
@@ -225,9 +339,11 @@ void cmd_task_step(void) {
       set_state(CMD_TASK_STATE_PRINTING_HELP);  // restart...
 
     } else if (line_reader_succeeded()) {
-      const char *filename = line_reader_get_line();
+      const char *filename = resolve_filename(line_reader_get_line());
       SYS_CONSOLE_PRINT("\nComparing WINC firmware against %s", filename);
+      dir_reader_pause();
       winc_cloner_compare(filename);
+      session_log_flush();
       set_state(CMD_TASK_STATE_PRINTING_HELP);
 
     } else {
@@ -237,10 +353,38 @@ void cmd_task_step(void) {
 
   case CMD_TASK_STATE_START_REBUILDING: {
     // Arrive here to rebuild / repair the PLL tables based on the gain tables.
+    dir_reader_pause();
     winc_cloner_rebuild_pll();
     set_state(CMD_TASK_STATE_PRINTING_HELP);
   } break;
 
+  case CMD_TASK_STATE_START_IDENTIFYING: {
+    // identify needs the listing; it reads images not yet scanned itself.
+    if (!dir_reader_is_complete() && !dir_reader_has_error()) {
+      dir_reader_step();
+    } else {
+      // the scan's file stays closed while identify reads images.
+      dir_reader_pause();
+      winc_cloner_identify();
+      set_state(CMD_TASK_STATE_PRINTING_HELP);
+    }
+  } break;
+
+  case CMD_TASK_STATE_START_PROBING: {
+    // read the version records from the WINC's flash headers.
+    dir_reader_pause();
+    winc_cloner_probe();
+    set_state(CMD_TASK_STATE_PRINTING_HELP);
+  } break;
+
+  case CMD_TASK_STATE_HOST_PROTOCOL: {
+    // remain in this state until the host exits the binary protocol.
+    host_proto_step();
+    if (!host_proto_is_active()) {
+      set_state(CMD_TASK_STATE_PRINTING_HELP);
+    }
+  } break;
+
   case CMD_TASK_STATE_ERROR: {
     // here on error state
   } break;
@@ -277,6 +421,44 @@ static void flush_serial_input(void) {
   }
 }
 
+static void print_catalog_entry(uint16_t idx) {
+  const dir_reader_image_t *image = dir_reader_image_ref(idx);
+
+  SYS_CONSOLE_PRINT(
+      "\n  %2d: %-24s %7ld", idx, dir_reader_filename_ref(idx), image->size);
+  if (image->flags & DIR_READER_IMAGE_HAS_VERSION) {
+    SYS_CONSOLE_PRINT("  v%d.%d.%d",
+                      M2M_GET_MAJOR(image->fw_version),
+                      M2M_GET_MINOR(image->fw_version),
+                      M2M_GET_PATCH(image->fw_version));
+  }
+  if (image->flags & DIR_READER_IMAGE_SCANNED) {
+    SYS_CONSOLE_PRINT("  crc32 %08lx", image->digest);
+  } else if (image->flags == 0) {
+    SYS_CONSOLE_MESSAGE("  (scanning)");
+  }
+}
+
+static const char *resolve_filename(const char *line) {
+  const char *p = line;
+  uint32_t idx = 0;
+
+  if (*p == '\0') {
+    return line;
+  }
+  while (*p != '\0') {
+    if ((*p < '0') || (*p > '9') || (idx > MAX_CATALOG_INDEX)) {
+      return line; // not an index: treat it as a filename.
+    }
+    idx = idx * 10 + (*p++ - '0');
+  }
+  if (idx < dir_reader_filename_count()) {
+    return dir_reader_filename_ref(idx);
+  } else {
+    return line;
+  }
+}
+
 static uint8_t downcase(uint8_t ch) {
   if ((ch >= 'A') && (ch <= 'Z')) {
     ch += 'a' - 'A';
@@ -103,6 +103,9 @@ extern "C" {
 #define SYS_FS_MAX_FILE_SYSTEM_TYPE       1
 #define SYS_FS_MEDIA_MAX_BLOCK_SIZE       512
 #define SYS_FS_MEDIA_MANAGER_BUFFER_SIZE  2048
+/* Sectors per media that may be buffered for a writer that has enabled
+ * write-behind (see SYS_FS_FileWriteBehindEnable).  Multiple of 4. */
+#define SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS  32
 #define SYS_FS_USE_LFN                    1
 #define SYS_FS_FILE_NAME_LEN              255
 #define SYS_FS_CWD_STRING_LEN             1024
@@ -141,6 +144,12 @@ extern "C" {
 #define DRV_SDSPI_QUEUE_SIZE_IDX0               4
 #define DRV_SDSPI_CHIP_SELECT_PIN_IDX0          SYS_PORT_PIN_PC06
 #define DRV_SDSPI_SPEED_HZ_IDX0                 5000000
+/* SERCOM6 is clocked at 60 MHz, so SPI rates are 60 MHz / 2n: 15 MHz is the
+   fastest one that stays within the 25 MHz SPI-mode limit of SD cards. */
+#define DRV_SDSPI_MAX_SPEED_HZ_IDX0             15000000
+#define DRV_SDSPI_DMA_MODE
+#define DRV_SDSPI_XMIT_DMA_CH_IDX0              SYS_DMA_CHANNEL_2
+#define DRV_SDSPI_RCV_DMA_CH_IDX0               SYS_DMA_CHANNEL_3
 #define DRV_SDSPI_POLLING_INTERVAL_MS_IDX0      1000
 
 
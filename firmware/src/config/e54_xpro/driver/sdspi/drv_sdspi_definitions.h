@@ -50,6 +50,7 @@
 // *****************************************************************************
 
 #include "system/ports/sys_ports.h"
+#include "system/dma/sys_dma.h"
 
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
@@ -233,6 +234,24 @@ typedef struct
     /* Speed at which SD card communication should happen */
     uint32_t                        sdcardSpeedHz;
 
+    /* Upper limit for the speed negotiated from the card's CSD once the card
+       has been initialized at sdcardSpeedHz */
+    uint32_t                        sdcardMaxSpeedHz;
+
+#if defined(DRV_SDSPI_DMA_MODE)
+    /* Transmit DMA Channel */
+    SYS_DMA_CHANNEL                 txDMAChannel;
+
+    /* Receive DMA Channel */
+    SYS_DMA_CHANNEL                 rxDMAChannel;
+
+    /* SPI transmit register address used for DMA operation. */
+    void*                           txAddress;
+
+    /* SPI receive register address used for DMA operation. */
+    void*                           rxAddress;
+#endif
+
     uint32_t                        pollingIntervalMs;
 
     /* Size of buffer objects queue */
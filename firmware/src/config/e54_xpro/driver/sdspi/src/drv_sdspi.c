@@ -49,6 +49,7 @@
 #include "drv_sdspi_plib_interface.h"
 
 #include "drv_sdspi_local.h"
+#include "stats.h"
 
 
 // *****************************************************************************
@@ -61,6 +62,7 @@ static CACHE_ALIGN uint8_t gDrvSDSPIClkPulseData [DRV_SDSPI_INSTANCES_NUMBER][CA
 static CACHE_ALIGN uint8_t gDrvSDSPICsdData [DRV_SDSPI_INSTANCES_NUMBER][CACHE_ALIGNED_SIZE_GET(20)];
 static CACHE_ALIGN uint8_t gDrvSDSPICidData [DRV_SDSPI_INSTANCES_NUMBER][CACHE_ALIGNED_SIZE_GET(20)];
 static CACHE_ALIGN uint8_t gDrvSDSPITempCidData [DRV_SDSPI_INSTANCES_NUMBER][CACHE_ALIGNED_SIZE_GET(20)];
+static CACHE_ALIGN uint8_t gDrvSDSPITempCsdData [DRV_SDSPI_INSTANCES_NUMBER][CACHE_ALIGNED_SIZE_GET(20)];
 
 
 static DRV_SDSPI_OBJ gDrvSDSPIObj[DRV_SDSPI_INSTANCES_NUMBER];
@@ -106,6 +108,57 @@ const DRV_SDSPI_CMD_OBJ gDrvSDSPICmdTable[] =
     {CMD_VALUE_SET_WR_BLK_ERASE_COUNT,     0xFF,   RESPONSE_R1,         1 }
 };
 
+// *****************************************************************************
+/* CRC16 lookup table
+
+  Summary:
+    Lookup table for the CRC16 of SD card data blocks.
+
+  Description:
+    Data blocks are protected by a CRC16-CCITT (polynomial x^16 + x^12 + x^5 + 1,
+    initial value 0). The table holds the CRC of each possible leading byte so
+    that a 512 byte block costs one lookup per byte.
+
+  Remarks:
+    None.
+*/
+
+static const uint16_t gDrvSDSPICrc16Table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: File Scope Functions
@@ -459,6 +512,102 @@ static uint32_t _DRV_SDSPI_ProcessCSD(uint8_t* csdPtr)
     return discCapacity;
 }
 
+static uint8_t* _DRV_SDSPI_CSDDataGet(uint8_t* csdPtr)
+{
+    if (csdPtr[0] == DRV_SDSPI_DATA_START_TOKEN)
+    {
+        /* Some cards issue the data start token before the CSD data */
+        csdPtr = csdPtr + 1;
+    }
+
+    return csdPtr;
+}
+
+static uint32_t _DRV_SDSPI_CSDSpeedGet(uint8_t* csdPtr)
+{
+    /* TRAN_SPEED (CSD byte 3): bits 2:0 select the rate unit, bits 6:3 the
+       multiplier (in tenths). For example 0x32 = 25 MHz and 0x5A = 50 MHz. */
+    static const uint32_t rateUnit[4] = {100000, 1000000, 10000000, 100000000};
+    static const uint8_t timeValue[16] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+    uint8_t tranSpeed = _DRV_SDSPI_CSDDataGet(csdPtr)[3];
+
+    if ((tranSpeed & 0x07) > 3)
+    {
+        /* Reserved rate unit */
+        return 0;
+    }
+
+    return (rateUnit[tranSpeed & 0x07] / 10) * timeValue[(tranSpeed >> 3) & 0x0F];
+}
+
+static uint8_t _DRV_SDSPI_CRC7Get(const uint8_t* data, uint32_t length)
+{
+    uint8_t crc = 0;
+    uint8_t i;
+
+    /* Polynomial x^7 + x^3 + 1, computed in the upper 7 bits so that the
+       result can be sent as is with the end bit set. */
+    while (length--)
+    {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? ((crc << 1) ^ 0x12) : (crc << 1);
+        }
+    }
+
+    return (crc | 0x01);
+}
+
+static uint16_t _DRV_SDSPI_CRC16Get(const uint8_t* data, uint32_t length)
+{
+    uint16_t crc = 0;
+
+    while (length--)
+    {
+        crc = (crc << 8) ^ gDrvSDSPICrc16Table[(uint8_t)(crc >> 8) ^ *data++];
+    }
+
+    return crc;
+}
+
+static bool _DRV_SDSPI_CSDIsValid(uint8_t* csdPtr)
+{
+    uint8_t* csdData = _DRV_SDSPI_CSDDataGet(csdPtr);
+
+    /* 16 bytes of CSD followed by the CRC16 of the data block */
+    return (_DRV_SDSPI_CRC16Get(csdData, 16) == (((uint16_t)csdData[16] << 8) | csdData[17]));
+}
+
+static void _DRV_SDSPI_SpeedSet(DRV_SDSPI_OBJ* dObj, uint32_t speedHz)
+{
+    if (speedHz != dObj->sdcardSpeedHz)
+    {
+        dObj->sdcardSpeedHz = speedHz;
+        _DRV_SDSPI_SPISpeedSetup(dObj, speedHz);
+    }
+}
+
+static void _DRV_SDSPI_DataCRCErrorHandle(DRV_SDSPI_OBJ* dObj)
+{
+    uint32_t speedHz = dObj->sdcardSpeedHz / 2;
+
+    dObj->crcErrorCount++;
+
+    /* Halve the clock, but never go below the speed the card was
+       initialized at. */
+    if (speedHz < dObj->sdcardSafeSpeedHz)
+    {
+        speedHz = dObj->sdcardSafeSpeedHz;
+    }
+    _DRV_SDSPI_SpeedSet(dObj, speedHz);
+
+    /* Let the current transfer run to completion so that the card returns
+       to the idle state, then re-issue the request. */
+    dObj->crcRetries++;
+    dObj->crcRetryPending = true;
+}
+
 static void _DRV_SDSPI_CommandSend
 (
     SYS_MODULE_OBJ object,
@@ -484,7 +633,10 @@ static void _DRV_SDSPI_CommandSend
             dObj->pCmdResp[2] = endianArray[2];
             dObj->pCmdResp[3] = endianArray[1];
             dObj->pCmdResp[4] = endianArray[0];
-            dObj->pCmdResp[5] = gDrvSDSPICmdTable[command].crc;
+            /* The CRC in the command table is only valid for the argument
+               used during initialization. Once CRC checking is turned on,
+               every command needs the CRC of its actual argument. */
+            dObj->pCmdResp[5] = _DRV_SDSPI_CRC7Get(dObj->pCmdResp, 5);
             /* Dummy data. Only used in case of DRV_SDCARD_STOP_TRANSMISSION */
             dObj->pCmdResp[6] = 0xFF;
 
@@ -1003,6 +1155,7 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
 {
     /* Get the driver object */
     DRV_SDSPI_OBJ *dObj = ( DRV_SDSPI_OBJ* )&gDrvSDSPIObj[object];
+    uint32_t highSpeedHz;
 
     /* Check what state we are in, to decide what to do */
     switch (dObj->mediaInitState)
@@ -1011,6 +1164,7 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
 
             dObj->discCapacity = 0;
             dObj->sdCardType = DRV_SDSPI_MODE_NORMAL;
+            dObj->crcEnabled = false;
 
             /* Keep the chip select high(not selected) to send clock pulses  */
             SYS_PORT_PinSet(dObj->chipSelectPin);
@@ -1257,6 +1411,10 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
                20Mbps SPI speeds. SD cards would typically operate at up to 25Mbps
                or higher SPI speeds.
              */
+            /* Start at the configured speed. The speed advertised in the CSD
+               is only tried once CRC checking is on, see
+               DRV_SDSPI_INIT_SET_HIGH_SPEED. */
+            dObj->sdcardSpeedHz = dObj->sdcardSafeSpeedHz;
             _DRV_SDSPI_SPISpeedSetup(dObj, dObj->sdcardSpeedHz);
 
             /* Do a dummy read to ensure that the receiver buffer is cleared */
@@ -1325,6 +1483,7 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
             if (dObj->spiTransferStatus == DRV_SDSPI_SPI_TRANSFER_STATUS_COMPLETE)
             {
                 dObj->discCapacity = _DRV_SDSPI_ProcessCSD(dObj->pCsdData);
+                dObj->sdcardCsdSpeedHz = _DRV_SDSPI_CSDSpeedGet(dObj->pCsdData);
                 dObj->mediaInitState = DRV_SDSPI_INIT_READ_CID;
             }
             else if (dObj->spiTransferStatus == DRV_SDSPI_SPI_TRANSFER_STATUS_ERROR)
@@ -1379,7 +1538,7 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
 
             if (dObj->spiTransferStatus == DRV_SDSPI_SPI_TRANSFER_STATUS_COMPLETE)
             {
-                dObj->mediaInitState = DRV_SDSPI_INIT_TURN_OFF_CRC;
+                dObj->mediaInitState = DRV_SDSPI_INIT_TURN_ON_CRC;
             }
             else if (dObj->spiTransferStatus == DRV_SDSPI_SPI_TRANSFER_STATUS_ERROR)
             {
@@ -1388,18 +1547,19 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
 
             break;
 
-        case DRV_SDSPI_INIT_TURN_OFF_CRC:
+        case DRV_SDSPI_INIT_TURN_ON_CRC:
 
-            /* Turn off CRC7 if we can, might be an invalid cmd on some
-               cards (CMD59). */
-            /* Note: POR default for the media is normally with CRC checking
-               off in SPI mode anyway, so this is typically redundant.
+            /* Turn on CRC checking (CMD59), so that bit errors at the higher
+               clock speed are caught on commands, data reads and data
+               writes. This might be an invalid cmd on some cards, in which
+               case the card stays at the initial speed.
              */
-            _DRV_SDSPI_CommandSend (object, DRV_SDSPI_CRC_ON_OFF, 0x00);
+            _DRV_SDSPI_CommandSend (object, DRV_SDSPI_CRC_ON_OFF, 0x01);
 
             /* Change from this state only on completion of command execution */
             if (dObj->cmdState == DRV_SDSPI_CMD_EXEC_IS_COMPLETE)
             {
+                dObj->crcEnabled = (dObj->cmdResponse.response1.byte == 0x00);
                 dObj->mediaInitState = DRV_SDSPI_INIT_SET_BLOCKLEN;
             }
             else if (dObj->cmdState == DRV_SDSPI_CMD_EXEC_ERROR)
@@ -1417,10 +1577,97 @@ static void _DRV_SDSPI_MediaInitialize ( SYS_MODULE_OBJ object )
 
             /* Change from this state only on completion of command execution */
             if (dObj->cmdState == DRV_SDSPI_CMD_EXEC_IS_COMPLETE)
+            {
+                dObj->mediaInitState = DRV_SDSPI_INIT_SET_HIGH_SPEED;
+            }
+            else if (dObj->cmdState == DRV_SDSPI_CMD_EXEC_ERROR)
+            {
+                dObj->mediaInitState = DRV_SDSPI_INIT_ERROR;
+            }
+
+            break;
+
+        case DRV_SDSPI_INIT_SET_HIGH_SPEED:
+
+            /* Switch to the maximum speed advertised by the card, limited by
+               what the host is configured for. Without CRC checking there is
+               no way to tell whether the faster clock works, so stay at the
+               initial speed in that case.
+             */
+            highSpeedHz = dObj->sdcardCsdSpeedHz;
+            if (highSpeedHz > dObj->sdcardMaxSpeedHz)
+            {
+                highSpeedHz = dObj->sdcardMaxSpeedHz;
+            }
+
+            if ((dObj->crcEnabled == true) && (highSpeedHz > dObj->sdcardSpeedHz))
+            {
+                _DRV_SDSPI_SpeedSet(dObj, highSpeedHz);
+                dObj->mediaInitState = DRV_SDSPI_INIT_VERIFY_CSD;
+            }
+            else
             {
                 dObj->mediaInitState = DRV_SDSPI_INIT_SD_INIT_DONE;
             }
+
+            break;
+
+        case DRV_SDSPI_INIT_VERIFY_CSD:
+
+            /* CMD9: Read the CSD again, this time at the new speed */
+            _DRV_SDSPI_CommandSend (object, DRV_SDSPI_SEND_CSD, 0x00);
+
+            /* Change from this state only on completion of command execution */
+            if (dObj->cmdState == DRV_SDSPI_CMD_EXEC_IS_COMPLETE)
+            {
+                if (dObj->cmdResponse.response1.byte == 0x00)
+                {
+                    dObj->mediaInitState = DRV_SDSPI_INIT_VERIFY_CSD_DATA;
+                }
+                else
+                {
+                    /* Command CRC error or garbled response: fall back */
+                    _DRV_SDSPI_SpeedSet(dObj, dObj->sdcardSafeSpeedHz);
+                    dObj->mediaInitState = DRV_SDSPI_INIT_SD_INIT_DONE;
+                }
+            }
             else if (dObj->cmdState == DRV_SDSPI_CMD_EXEC_ERROR)
+            {
+                _DRV_SDSPI_SpeedSet(dObj, dObj->sdcardSafeSpeedHz);
+                dObj->mediaInitState = DRV_SDSPI_INIT_SD_INIT_DONE;
+            }
+
+            break;
+
+        case DRV_SDSPI_INIT_VERIFY_CSD_DATA:
+
+            if (_DRV_SDSPI_SPIRead(dObj, dObj->pTempCsdData, _DRV_SDSPI_CSD_READ_SIZE) == true)
+            {
+                dObj->mediaInitState = DRV_SDSPI_INIT_VERIFY_CSD_STATUS;
+            }
+            else
+            {
+                dObj->mediaInitState = DRV_SDSPI_INIT_ERROR;
+            }
+
+            break;
+
+        case DRV_SDSPI_INIT_VERIFY_CSD_STATUS:
+
+            if (dObj->spiTransferStatus == DRV_SDSPI_SPI_TRANSFER_STATUS_COMPLETE)
+            {
+                /* The new speed is kept only if the CSD arrives intact and
+                   matches the copy read at the initial speed. */
+                if ((_DRV_SDSPI_CSDIsValid(dObj->pTempCsdData) == false) ||
+                    (memcmp(_DRV_SDSPI_CSDDataGet(dObj->pTempCsdData),
+                            _DRV_SDSPI_CSDDataGet(dObj->pCsdData), 16) != 0))
+                {
+                    dObj->crcErrorCount++;
+                    _DRV_SDSPI_SpeedSet(dObj, dObj->sdcardSafeSpeedHz);
+                }
+                dObj->mediaInitState = DRV_SDSPI_INIT_SD_INIT_DONE;
+            }
+            else if (dObj->spiTransferStatus == DRV_SDSPI_SPI_TRANSFER_STATUS_ERROR)
             {
                 dObj->mediaInitState = DRV_SDSPI_INIT_ERROR;
             }
@@ -1547,6 +1794,7 @@ static void _DRV_SDSPI_BufferIOTasks
     DRV_SDSPI_CLIENT_OBJ*       clientObj;
     DRV_SDSPI_BUFFER_OBJ*       currentBufObj;
     DRV_SDSPI_EVENT             evtStatus = DRV_SDSPI_EVENT_COMMAND_COMPLETE;
+    uint16_t                    crc16;
 
     /* Get the driver object */
     dObj = (DRV_SDSPI_OBJ*)&gDrvSDSPIObj[object];
@@ -1592,6 +1840,13 @@ static void _DRV_SDSPI_BufferIOTasks
 
             currentBufObj->status = DRV_SDSPI_COMMAND_IN_PROGRESS;
 
+            /* Remember where the request started in case it has to be
+               re-issued after a CRC error */
+            dObj->retryBuffer = currentBufObj->buffer;
+            dObj->retryNBlocks = currentBufObj->nBlocks;
+            dObj->crcRetries = 0;
+            dObj->crcRetryPending = false;
+
             if (dObj->sdCardType == DRV_SDSPI_MODE_NORMAL)
             {
                 currentBufObj->blockStart <<= 9;
@@ -1735,8 +1990,8 @@ static void _DRV_SDSPI_BufferIOTasks
 
         case DRV_SDSPI_TASK_READ_CRC_BYTES:
 
-            /* Read 2 bytes of CRC data. In SPI mode of operation the CRC
-             * data is ignored. */
+            /* Read 2 bytes of CRC data. The CRC is checked only if CRC
+             * checking has been turned on in the card. */
             if (_DRV_SDSPI_SPIRead(dObj, dObj->pCmdResp, 2) == true)
             {
                 dObj->nextTaskState = DRV_SDSPI_TASK_READ_COMPLETE_CHECK;
@@ -1750,6 +2005,25 @@ static void _DRV_SDSPI_BufferIOTasks
 
         case DRV_SDSPI_TASK_READ_COMPLETE_CHECK:
 
+            if ((dObj->crcEnabled == true) &&
+                (_DRV_SDSPI_CRC16Get(currentBufObj->buffer, _DRV_SDSPI_MEDIA_BLOCK_SIZE) !=
+                    (((uint16_t)dObj->pCmdResp[0] << 8) | dObj->pCmdResp[1])))
+            {
+                /* The block was corrupted on the bus. End the transfer and
+                   retry the request at a lower speed. */
+                _DRV_SDSPI_DataCRCErrorHandle(dObj);
+
+                if (currentBufObj->command == DRV_SDSPI_READ_MULTI_BLOCK)
+                {
+                    dObj->taskBufferIOState = DRV_SDSPI_TASK_READ_STOP_TRANSMISSION;
+                }
+                else
+                {
+                    dObj->taskBufferIOState = DRV_SDSPI_TASK_SEND_DUMMY_CLOCK_PULSES;
+                }
+                break;
+            }
+
             if (currentBufObj->command == DRV_SDSPI_READ_MULTI_BLOCK)
             {
                 currentBufObj->nBlocks--;
@@ -1857,8 +2131,13 @@ static void _DRV_SDSPI_BufferIOTasks
 
         case DRV_SDSPI_TASK_WRITE_CRC_BYTES:
 
-            /* Send 16-bit dummy CRC for the data block that was just sent. */
-            if (_DRV_SDSPI_SPIWrite(dObj, dObj->pClkPulseData, 2) == true)
+            /* Send 16-bit CRC for the data block that was just sent. The card
+             * ignores it unless CRC checking has been turned on. */
+            crc16 = _DRV_SDSPI_CRC16Get(currentBufObj->buffer, _DRV_SDSPI_MEDIA_BLOCK_SIZE);
+            dObj->pCmdResp[0] = (uint8_t)(crc16 >> 8);
+            dObj->pCmdResp[1] = (uint8_t)crc16;
+
+            if (_DRV_SDSPI_SPIWrite(dObj, dObj->pCmdResp, 2) == true)
             {
                 dObj->nextTaskState = DRV_SDSPI_TASK_WRITE_READ_RESP_TOKEN;
                 dObj->taskBufferIOState = DRV_SDSPI_TASK_SPI_STATUS;
@@ -1886,16 +2165,26 @@ static void _DRV_SDSPI_BufferIOTasks
 
             /* Read response token byte from media, mask out top three
              * don't care bits, and check if there was an error */
-            if ((dObj->pCmdResp[0] & DRV_SDSPI_WRITE_RESPONSE_TOKEN_MASK) != DRV_SDSPI_DATA_ACCEPTED)
+            if ((dObj->pCmdResp[0] & DRV_SDSPI_WRITE_RESPONSE_TOKEN_MASK) == DRV_SDSPI_DATA_ACCEPTED)
             {
-                /* Something went wrong. */
-                dObj->taskBufferIOState = DRV_SDSPI_TASK_READ_WRITE_ABORT;
+                dObj->taskBufferIOState = DRV_SDSPI_TASK_WRITE_CHECK_BUSY;
+                dObj->timerFlag = false;
             }
-            else
+            else if ((dObj->crcEnabled == true) &&
+                ((dObj->pCmdResp[0] & DRV_SDSPI_WRITE_RESPONSE_TOKEN_MASK) == DRV_SDSPI_DATA_CRC_ERROR))
             {
+                /* The block was corrupted on the bus and rejected. Wait for
+                 * the card to become idle, end the transfer and retry the
+                 * request at a lower speed. */
+                _DRV_SDSPI_DataCRCErrorHandle(dObj);
                 dObj->taskBufferIOState = DRV_SDSPI_TASK_WRITE_CHECK_BUSY;
                 dObj->timerFlag = false;
             }
+            else
+            {
+                /* Something went wrong. */
+                dObj->taskBufferIOState = DRV_SDSPI_TASK_READ_WRITE_ABORT;
+            }
             break;
 
         case DRV_SDSPI_TASK_WRITE_CHECK_BUSY:
@@ -1959,7 +2248,19 @@ static void _DRV_SDSPI_BufferIOTasks
                either send the next packet of data to the media, or the stop
                token if we are finished.
                */
-            if (currentBufObj->command == DRV_SDSPI_WRITE_MULTI_BLOCK)
+            if (dObj->crcRetryPending == true)
+            {
+                /* The last block was rejected, end the transfer */
+                if (currentBufObj->command == DRV_SDSPI_WRITE_MULTI_BLOCK)
+                {
+                    dObj->taskBufferIOState = DRV_SDSPI_TASK_WRITE_STOP_TRAN_TOKEN;
+                }
+                else
+                {
+                    dObj->taskBufferIOState = DRV_SDSPI_TASK_SEND_DUMMY_CLOCK_PULSES;
+                }
+            }
+            else if (currentBufObj->command == DRV_SDSPI_WRITE_MULTI_BLOCK)
             {
                 currentBufObj->nBlocks --;
                 if (currentBufObj->nBlocks == 0)
@@ -2065,6 +2366,33 @@ static void _DRV_SDSPI_BufferIOTasks
             /* Reset any of the error flags. */
         case DRV_SDSPI_TASK_PROCESS_NEXT:
 
+            if (dObj->crcRetryPending == true)
+            {
+                dObj->crcRetryPending = false;
+
+                if ((dObj->taskBufferIOState == DRV_SDSPI_TASK_PROCESS_NEXT) &&
+                    (dObj->crcRetries <= _DRV_SDSPI_CRC_ERROR_RETRIES))
+                {
+                    /* The card is idle again. Re-issue the request from the
+                       start, at the reduced speed. */
+                    currentBufObj->buffer = dObj->retryBuffer;
+                    currentBufObj->nBlocks = dObj->retryNBlocks;
+
+                    if (currentBufObj->opType == DRV_SDSPI_OPERATION_TYPE_READ)
+                    {
+                        dObj->taskBufferIOState = DRV_SDSPI_TASK_PROCESS_READ;
+                    }
+                    else
+                    {
+                        dObj->taskBufferIOState = DRV_SDSPI_TASK_PROCESS_WRITE;
+                    }
+                    break;
+                }
+
+                /* Out of retries, fail the request */
+                dObj->taskBufferIOState = DRV_SDSPI_TASK_READ_WRITE_ABORT;
+            }
+
             if (dObj->taskBufferIOState == DRV_SDSPI_TASK_PROCESS_NEXT)
             {
                 currentBufObj->status = DRV_SDSPI_COMMAND_COMPLETED;
@@ -2172,6 +2500,11 @@ SYS_MODULE_OBJ DRV_SDSPI_Initialize
     dObj->writeProtectPin       = sdSPIInit->writeProtectPin;
     dObj->chipSelectPin         = sdSPIInit->chipSelectPin;
     dObj->sdcardSpeedHz         = sdSPIInit->sdcardSpeedHz;
+    dObj->sdcardSafeSpeedHz     = sdSPIInit->sdcardSpeedHz;
+    dObj->sdcardMaxSpeedHz      = sdSPIInit->sdcardMaxSpeedHz;
+    dObj->crcEnabled            = false;
+    dObj->crcRetryPending       = false;
+    dObj->crcErrorCount         = 0;
     dObj->pollingIntervalMs     = sdSPIInit->pollingIntervalMs;
     dObj->sdspiTokenCount       = 1;
 
@@ -2190,6 +2523,7 @@ SYS_MODULE_OBJ DRV_SDSPI_Initialize
     dObj->pCmdResp              = &gDrvSDSPICmdResponseBuffer[drvIndex][0];
     dObj->pCsdData              = &gDrvSDSPICsdData[drvIndex][0];
     dObj->pCidData              = &gDrvSDSPICidData[drvIndex][0];
+    dObj->pTempCsdData          = &gDrvSDSPITempCsdData[drvIndex][0];
     dObj->pClkPulseData         = &gDrvSDSPIClkPulseData[drvIndex][0];
 
     for (i = 0; i < MEDIA_INIT_ARRAY_SIZE; i++)
@@ -2203,8 +2537,22 @@ SYS_MODULE_OBJ DRV_SDSPI_Initialize
 
 
 
+#if defined(DRV_SDSPI_DMA_MODE)
+    dObj->txDMAChannel          = sdSPIInit->txDMAChannel;
+    dObj->rxDMAChannel          = sdSPIInit->rxDMAChannel;
+    dObj->txAddress             = sdSPIInit->txAddress;
+    dObj->rxAddress             = sdSPIInit->rxAddress;
+
+    SYS_DMA_DataWidthSetup(dObj->txDMAChannel, SYS_DMA_WIDTH_8_BIT);
+    SYS_DMA_DataWidthSetup(dObj->rxDMAChannel, SYS_DMA_WIDTH_8_BIT);
+
+    /* Transfers complete when the receive channel is done. No call-back is
+     * needed for the transmit channel. */
+    SYS_DMA_ChannelCallbackRegister(dObj->rxDMAChannel, _DRV_SDSPI_RX_DMA_CallbackHandler, (uintptr_t)dObj);
+#else
     /* Register call-back with the SPI PLIB */
     dObj->spiPlib->callbackRegister(_DRV_SDSPI_SPIPlibCallbackHandler, (uintptr_t)dObj);
+#endif
 
     /* Register with file system*/
     if (sdSPIInit->isFsEnabled == true)
@@ -2459,6 +2807,7 @@ void DRV_SDSPI_AsyncRead
     uint32_t nBlocks
 )
 {
+    STATS_ADD(STATS_SD_BLOCKS_READ, nBlocks);
     DRV_SDSPI_SetupXfer(
         handle,
         commandHandle,
@@ -2478,6 +2827,7 @@ void DRV_SDSPI_AsyncWrite
     uint32_t nBlocks
 )
 {
+    STATS_ADD(STATS_SD_BLOCKS_WRITTEN, nBlocks);
     DRV_SDSPI_SetupXfer(
         handle,
         commandHandle,
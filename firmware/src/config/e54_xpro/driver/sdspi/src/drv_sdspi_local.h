@@ -97,6 +97,8 @@
 
 #define _DRV_SDSPI_COMMAND_RESPONSE_TRIES           (10)
 
+#define _DRV_SDSPI_CRC_ERROR_RETRIES               (3)
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: SD Card constants
@@ -337,6 +339,24 @@
 #define DRV_SDSPI_DATA_ACCEPTED                        0x05
 
 
+// *****************************************************************************
+/* SD card data rejected due to CRC error token
+
+  Summary:
+    This macro represents an SD card data rejected due to CRC error token.
+
+  Description:
+    This macro represents the data response token sent by the card when the
+    CRC of a written data block does not match. Only sent when CRC checking
+    has been turned on with CMD59.
+
+  Remarks:
+    None.
+*/
+
+#define DRV_SDSPI_DATA_CRC_ERROR                       0x0B
+
+
 // *****************************************************************************
 /* SD card R1 response end bit
 
@@ -856,12 +876,24 @@ typedef enum
     /* Process the CID register data */
     DRV_SDSPI_INIT_PROCESS_CID,
 
-    /* Issue command to turn off the CRC */
-    DRV_SDSPI_INIT_TURN_OFF_CRC,
+    /* Issue command to turn on the CRC */
+    DRV_SDSPI_INIT_TURN_ON_CRC,
 
     /* Set the block length of the card */
     DRV_SDSPI_INIT_SET_BLOCKLEN,
 
+    /* Switch to the speed advertised in the CSD */
+    DRV_SDSPI_INIT_SET_HIGH_SPEED,
+
+    /* Issue command to read the CSD again at the new speed */
+    DRV_SDSPI_INIT_VERIFY_CSD,
+
+    /* Read the CSD data at the new speed */
+    DRV_SDSPI_INIT_VERIFY_CSD_DATA,
+
+    /* Check the CRC and contents of the CSD read at the new speed */
+    DRV_SDSPI_INIT_VERIFY_CSD_STATUS,
+
     /* SD Card Init is done */
     DRV_SDSPI_INIT_SD_INIT_DONE,
 
@@ -1436,9 +1468,56 @@ typedef struct
     /* Pointer to the CID data of the SD Card */
     uint8_t*                                        pCidData;
 
-    /* Speed at which SD card communication should happen */
+    /* Pointer to the CSD data read back after switching to the high speed */
+    uint8_t*                                        pTempCsdData;
+
+    /* Speed at which SD card communication currently happens */
     uint32_t                                        sdcardSpeedHz;
 
+    /* Speed used for card initialization and as the fallback on CRC errors */
+    uint32_t                                        sdcardSafeSpeedHz;
+
+    /* Upper limit for the speed negotiated from the CSD */
+    uint32_t                                        sdcardMaxSpeedHz;
+
+    /* Maximum transfer rate advertised in the CSD (TRAN_SPEED) */
+    uint32_t                                        sdcardCsdSpeedHz;
+
+    /* Flag to indicate that the card accepted CMD59 and checks/sends CRCs */
+    bool                                            crcEnabled;
+
+    /* Flag to indicate that the current request must be re-issued once the
+    card is idle, due to a data CRC error */
+    bool                                            crcRetryPending;
+
+    /* Number of times the current request has been re-issued */
+    uint8_t                                         crcRetries;
+
+    /* Buffer and block count of the current request, restored on a retry */
+    uint8_t*                                        retryBuffer;
+
+    uint32_t                                        retryNBlocks;
+
+    /* Number of data CRC errors seen since the driver was initialized */
+    uint32_t                                        crcErrorCount;
+
+#if defined(DRV_SDSPI_DMA_MODE)
+    /* Transmit DMA Channel */
+    SYS_DMA_CHANNEL                                 txDMAChannel;
+
+    /* Receive DMA Channel */
+    SYS_DMA_CHANNEL                                 rxDMAChannel;
+
+    /* This is the SPI transmit register address. Used for DMA operation. */
+    void*                                           txAddress;
+
+    /* This is the SPI receive register address. Used for DMA operation. */
+    void*                                           rxAddress;
+
+    /* Dummy data is read into this variable by RX DMA */
+    uint32_t                                        rxDummyData;
+#endif
+
     uint32_t                                        pollingIntervalMs;
 
     /* Number of sectors in the SD card */
@@ -93,6 +93,95 @@ void _DRV_SDSPI_SPIPlibCallbackHandler( uintptr_t context )
     SYS_PORT_PinSet(dObj->chipSelectPin);
 }
 
+#if defined(DRV_SDSPI_DMA_MODE)
+// *****************************************************************************
+/* SDSPI RX DMA Event Handler
+
+  Summary:
+    Event handler registered by the SD card driver with the DMA System Service
+
+  Description:
+    Every transfer clocks the same number of bytes in both directions, so the
+    request is complete once the receive channel is done.
+
+  Remarks:
+
+*/
+
+void _DRV_SDSPI_RX_DMA_CallbackHandler( SYS_DMA_TRANSFER_EVENT event, uintptr_t context )
+{
+    DRV_SDSPI_OBJ* dObj = (DRV_SDSPI_OBJ *)context;
+
+    if (event == SYS_DMA_TRANSFER_COMPLETE)
+    {
+        dObj->spiTransferStatus = DRV_SDSPI_SPI_TRANSFER_STATUS_COMPLETE;
+    }
+    else
+    {
+        dObj->spiTransferStatus = DRV_SDSPI_SPI_TRANSFER_STATUS_ERROR;
+    }
+
+    SYS_PORT_PinSet(dObj->chipSelectPin);
+}
+
+// *****************************************************************************
+/* SD Card SPI DMA Transfer
+
+  Summary:
+    Starts a DMA transfer of nBytes in both directions.
+
+  Description:
+    Data to the card comes from pWriteBuffer, or is a run of 0xFF clock bytes
+    when pWriteBuffer is NULL. Data from the card goes to pReadBuffer, or is
+    discarded when pReadBuffer is NULL. The receive channel is armed first so
+    that no byte is missed once the transmit channel starts the clock.
+
+  Remarks:
+    This is a non-blocking implementation.
+*/
+
+static bool _DRV_SDSPI_DMATransfer(
+    DRV_SDSPI_OBJ* dObj,
+    void* pWriteBuffer,
+    void* pReadBuffer,
+    uint32_t nBytes
+)
+{
+    if (pReadBuffer == NULL)
+    {
+        SYS_DMA_AddressingModeSetup(dObj->rxDMAChannel, SYS_DMA_SOURCE_ADDRESSING_MODE_FIXED, SYS_DMA_DESTINATION_ADDRESSING_MODE_FIXED);
+        pReadBuffer = &dObj->rxDummyData;
+    }
+    else
+    {
+        SYS_DMA_AddressingModeSetup(dObj->rxDMAChannel, SYS_DMA_SOURCE_ADDRESSING_MODE_FIXED, SYS_DMA_DESTINATION_ADDRESSING_MODE_INCREMENTED);
+    }
+
+    if (pWriteBuffer == NULL)
+    {
+        SYS_DMA_AddressingModeSetup(dObj->txDMAChannel, SYS_DMA_SOURCE_ADDRESSING_MODE_FIXED, SYS_DMA_DESTINATION_ADDRESSING_MODE_FIXED);
+        pWriteBuffer = dObj->pClkPulseData;
+    }
+    else
+    {
+        SYS_DMA_AddressingModeSetup(dObj->txDMAChannel, SYS_DMA_SOURCE_ADDRESSING_MODE_INCREMENTED, SYS_DMA_DESTINATION_ADDRESSING_MODE_FIXED);
+    }
+
+    if (SYS_DMA_ChannelTransfer(dObj->rxDMAChannel, (const void*)dObj->rxAddress, (const void*)pReadBuffer, nBytes) == false)
+    {
+        return false;
+    }
+
+    if (SYS_DMA_ChannelTransfer(dObj->txDMAChannel, (const void*)pWriteBuffer, (const void*)dObj->txAddress, nBytes) == false)
+    {
+        SYS_DMA_ChannelDisable(dObj->rxDMAChannel);
+        return false;
+    }
+
+    return true;
+}
+#endif
+
 // *****************************************************************************
 /* SD Card SPI Write
 
@@ -117,7 +206,11 @@ bool _DRV_SDSPI_SPIWrite(
 
     dObj->spiTransferStatus = DRV_SDSPI_SPI_TRANSFER_STATUS_IN_PROGRESS;
 
+#if defined(DRV_SDSPI_DMA_MODE)
+    if (_DRV_SDSPI_DMATransfer(dObj, pWriteBuffer, NULL, nBytes) == false)
+#else
     if (dObj->spiPlib->write (pWriteBuffer, nBytes) == false)
+#endif
     {
         SYS_PORT_PinSet(dObj->chipSelectPin);
     }
@@ -153,7 +246,12 @@ bool _DRV_SDSPI_SPIRead(
 
     dObj->spiTransferStatus = DRV_SDSPI_SPI_TRANSFER_STATUS_IN_PROGRESS;
 
+#if defined(DRV_SDSPI_DMA_MODE)
+    /* The card is clocked with 0xFF from pClkPulseData */
+    if (_DRV_SDSPI_DMATransfer(dObj, NULL, pReadBuffer, nBytes) == false)
+#else
     if (dObj->spiPlib->read (pReadBuffer, nBytes) == false)
+#endif
     {
         SYS_PORT_PinSet(dObj->chipSelectPin);
     }
@@ -177,7 +275,11 @@ bool _DRV_SDSPI_SPIWriteWithChipSelectDisabled(
 
     dObj->spiTransferStatus = DRV_SDSPI_SPI_TRANSFER_STATUS_IN_PROGRESS;
 
+#if defined(DRV_SDSPI_DMA_MODE)
+    if (_DRV_SDSPI_DMATransfer(dObj, pWriteBuffer, NULL, nBytes) == true)
+#else
     if (dObj->spiPlib->write (pWriteBuffer, nBytes) == true)
+#endif
     {
         isSuccess = true;
     }
@@ -73,6 +73,25 @@
 
 void _DRV_SDSPI_SPIPlibCallbackHandler( uintptr_t context );
 
+#if defined(DRV_SDSPI_DMA_MODE)
+// *****************************************************************************
+/* SDSPI RX DMA Event Handler
+
+  Summary:
+    Event handler registered by the SD card driver with the DMA System Service
+
+  Description:
+    This event handler is called when the receive DMA channel has moved the
+    last byte of a request, which also means the transmit side is done.
+
+  Remarks:
+    Used in place of _DRV_SDSPI_SPIPlibCallbackHandler when DRV_SDSPI_DMA_MODE
+    is defined.
+*/
+
+void _DRV_SDSPI_RX_DMA_CallbackHandler( SYS_DMA_TRANSFER_EVENT event, uintptr_t context );
+#endif
+
 
 // *****************************************************************************
 /* SD Card SPI Write
@@ -36,6 +36,8 @@
 *******************************************************************************/
 
 #include "spi_flash.h"
+#include "prof.h"
+#include "stats.h"
 #define DUMMY_REGISTER  (0x1084)
 
 #define TIMEOUT (-1) /*MS*/
@@ -65,6 +67,9 @@ SPI Flash DMA
 #define SPI_FLASH_MSB_CTL       (SPI_FLASH_BASE + 0x20)
 #define SPI_FLASH_TX_CTL        (SPI_FLASH_BASE + 0x24)
 
+/* RDID of the flash, read once by spi_flash_get_size */
+static uint32_t gu32InternalFlashId = 0;
+
 /*********************************************/
 /* STATIC FUNCTIONS                          */
 /*********************************************/
@@ -85,6 +90,7 @@ static int8_t spi_flash_read_status_reg(uint8_t * val)
     uint8_t cmd[1];
     uint32_t reg;
 
+    STATS_INC(STATS_FLASH_STATUS_POLLS);
     cmd[0] = 0x05;
 
     ret += nm_write_reg(SPI_FLASH_DATA_CNT, 4);
@@ -162,6 +168,7 @@ static int8_t spi_flash_sector_erase(uint32_t u32FlashAdr)
     uint32_t    val = 0;
     int8_t  ret = M2M_SUCCESS;
 
+    STATS_INC(STATS_FLASH_ERASES);
     cmd[0] = 0x20;
     cmd[1] = (uint8_t)(u32FlashAdr >> 16);
     cmd[2] = (uint8_t)(u32FlashAdr >> 8);
@@ -261,6 +268,7 @@ static int8_t spi_flash_page_program(uint32_t u32MemAdr, uint32_t u32FlashAdr, u
     uint32_t    val = 0;
     int8_t  ret = M2M_SUCCESS;
 
+    STATS_INC(STATS_FLASH_PAGE_PROGRAMS);
     cmd[0] = 0x02;
     cmd[1] = (uint8_t)(u32FlashAdr >> 16);
     cmd[2] = (uint8_t)(u32FlashAdr >> 8);
@@ -322,17 +330,21 @@ static int8_t spi_flash_pp(uint32_t u32Offset, uint8_t *pu8Buf, uint16_t u16Sz)
 {
     int8_t ret = M2M_SUCCESS;
     uint8_t tmp;
+    PROF_BEGIN(PROF_ZONE_FLASH_PP);
     spi_flash_write_enable();
     /* use shared packet memory as temp mem */
     ret += nm_write_block(HOST_SHARE_MEM_BASE, pu8Buf, u16Sz);
     ret += spi_flash_page_program(HOST_SHARE_MEM_BASE, u32Offset, u16Sz);
+    PROF_BEGIN(PROF_ZONE_FLASH_PP_BUSY);
     ret += spi_flash_read_status_reg(&tmp);
     do
     {
         if(ret != M2M_SUCCESS) goto ERR;
         ret += spi_flash_read_status_reg(&tmp);
     }while(tmp & 0x01);
+    PROF_END(PROF_ZONE_FLASH_PP_BUSY);
     ret += spi_flash_write_disable();
+    PROF_END(PROF_ZONE_FLASH_PP);
 ERR:
     return ret;
 }
@@ -461,6 +473,7 @@ ERR1:
 int8_t spi_flash_read(uint8_t *pu8Buf, uint32_t u32offset, uint32_t u32Sz)
 {
     int8_t ret = M2M_SUCCESS;
+    PROF_BEGIN(PROF_ZONE_FLASH_READ);
     if(u32Sz > FLASH_BLOCK_SIZE)
     {
         do
@@ -474,6 +487,7 @@ int8_t spi_flash_read(uint8_t *pu8Buf, uint32_t u32offset, uint32_t u32Sz)
     }
 
     ret = spi_flash_read_internal(pu8Buf, u32offset, u32Sz);
+    PROF_END(PROF_ZONE_FLASH_READ);
 
 ERR:
     return ret;
@@ -498,6 +512,7 @@ int8_t spi_flash_write(uint8_t* pu8Buf, uint32_t u32Offset, uint32_t u32Sz)
     uint32_t u32wsz;
     uint32_t u32off;
     uint32_t u32Blksz;
+    PROF_BEGIN(PROF_ZONE_FLASH_WRITE);
     u32Blksz = FLASH_PAGE_SZ;
     u32off = u32Offset % u32Blksz;
     if(u32Sz<=0)
@@ -535,6 +550,7 @@ int8_t spi_flash_write(uint8_t* pu8Buf, uint32_t u32Offset, uint32_t u32Sz)
         u32Sz -= u32wsz;
     }
 EXIT:
+    PROF_END(PROF_ZONE_FLASH_WRITE);
 ERR:
     return ret;
 }
@@ -556,6 +572,7 @@ int8_t spi_flash_erase(uint32_t u32Offset, uint32_t u32Sz)
     uint32_t i = 0;
     int8_t ret = M2M_SUCCESS;
     uint8_t  tmp = 0;
+    PROF_BEGIN(PROF_ZONE_FLASH_ERASE);
     M2M_PRINT("\r\n>Start erasing...\r\n");
     for(i = u32Offset; i < (u32Sz +u32Offset); i += (16*FLASH_PAGE_SZ))
     {
@@ -571,6 +588,7 @@ int8_t spi_flash_erase(uint32_t u32Offset, uint32_t u32Sz)
 
     }
     M2M_PRINT("Done\r\n");
+    PROF_END(PROF_ZONE_FLASH_ERASE);
 ERR:
     return ret;
 }
@@ -584,16 +602,16 @@ ERR:
 */
 uint32_t spi_flash_get_size(void)
 {
-    uint32_t u32FlashId = 0, u32FlashPwr = 0;
+    uint32_t u32FlashPwr = 0;
     static uint32_t gu32InternalFlashSize= 0;
 
     if(!gu32InternalFlashSize)
     {
-        u32FlashId = spi_flash_rdid();
-        if((u32FlashId != 0xffffffff) && (u32FlashId !=0))
+        gu32InternalFlashId = spi_flash_rdid();
+        if((gu32InternalFlashId != 0xffffffff) && (gu32InternalFlashId !=0))
         {
             /*flash size is the third byte from the FLASH RDID*/
-            u32FlashPwr = ((u32FlashId>>16)&0xff) - 0x11; /*2MBIT is the min*/
+            u32FlashPwr = ((gu32InternalFlashId>>16)&0xff) - 0x11; /*2MBIT is the min*/
             /*That number power 2 to get the flash size*/
             gu32InternalFlashSize = 1<<u32FlashPwr;
             M2M_INFO("Flash Size %lu Mb\r\n",gu32InternalFlashSize);
@@ -605,4 +623,18 @@ uint32_t spi_flash_get_size(void)
     }
 
     return gu32InternalFlashSize;
-}
\ No newline at end of file
+}
+
+/**
+*   @fn         spi_flash_get_id
+*   @brief      Get the JEDEC ID of the SPI Flash, as read by spi_flash_get_size
+*   @return     Flash ID
+*/
+uint32_t spi_flash_get_id(void)
+{
+    if(!spi_flash_get_size())
+    {
+        return 0;
+    }
+    return gu32InternalFlashId;
+}
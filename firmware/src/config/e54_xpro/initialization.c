@@ -140,6 +140,20 @@ const DRV_SDSPI_INIT drvSDSPI0InitData =
 
     .sdcardSpeedHz          = DRV_SDSPI_SPEED_HZ_IDX0,
 
+    .sdcardMaxSpeedHz       = DRV_SDSPI_MAX_SPEED_HZ_IDX0,
+
+    /* DMA Channel for Transmit */
+    .txDMAChannel           = DRV_SDSPI_XMIT_DMA_CH_IDX0,
+
+    /* DMA Channel for Receive */
+    .rxDMAChannel           = DRV_SDSPI_RCV_DMA_CH_IDX0,
+
+    /* SPI Transmit Register */
+    .txAddress              = (void *)&(SERCOM6_REGS->SPIM.SERCOM_DATA),
+
+    /* SPI Receive Register */
+    .rxAddress              = (void *)&(SERCOM6_REGS->SPIM.SERCOM_DATA),
+
     .pollingIntervalMs      = DRV_SDSPI_POLLING_INTERVAL_MS_IDX0,
 
     .writeProtectPin        = SYS_PORT_PIN_NONE,
@@ -304,7 +318,9 @@ const SYS_FS_FUNCTIONS FatFsFunctions =
     .testerror         = FATFS_error,
     .formatDisk        = (FORMAT_DISK)FATFS_mkfs,
     .partitionDisk     = FATFS_fdisk,
-    .getCluster        = FATFS_getclusters
+    .getCluster        = FATFS_getclusters,
+    .expand            = FATFS_expand,
+    .fastSeek          = FATFS_fastseek
 };
 
 
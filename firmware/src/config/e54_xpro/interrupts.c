@@ -114,7 +114,6 @@ extern void EIC_EXTINT_15_Handler      ( void ) __attribute__((weak, alias("Dumm
 extern void FREQM_Handler              ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void NVMCTRL_0_Handler          ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void NVMCTRL_1_Handler          ( void ) __attribute__((weak, alias("Dummy_Handler")));
-extern void DMAC_OTHER_Handler         ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void EVSYS_0_Handler            ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void EVSYS_1_Handler            ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void EVSYS_2_Handler            ( void ) __attribute__((weak, alias("Dummy_Handler")));
@@ -259,7 +258,7 @@ const H3DeviceVectors exception_table=
     .pfnDMAC_1_Handler             = DMAC_1_InterruptHandler,
     .pfnDMAC_2_Handler             = DMAC_2_InterruptHandler,
     .pfnDMAC_3_Handler             = DMAC_3_InterruptHandler,
-    .pfnDMAC_OTHER_Handler         = DMAC_OTHER_Handler,
+    .pfnDMAC_OTHER_Handler         = DMAC_OTHER_InterruptHandler,
     .pfnEVSYS_0_Handler            = EVSYS_0_Handler,
     .pfnEVSYS_1_Handler            = EVSYS_1_Handler,
     .pfnEVSYS_2_Handler            = EVSYS_2_Handler,
@@ -93,6 +93,8 @@ typedef uint8_t DMAC_CRC_BEAT_SIZE;
 #define  DMAC_CHANNEL_2   (2U)
     /* DMAC Channel 3 */
 #define  DMAC_CHANNEL_3   (3U)
+    /* DMAC Channel 4 */
+#define  DMAC_CHANNEL_4   (4U)
 typedef uint32_t DMAC_CHANNEL;
 
 typedef enum
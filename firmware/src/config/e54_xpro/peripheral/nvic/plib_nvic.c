@@ -69,6 +69,8 @@ void NVIC_Initialize( void )
     NVIC_EnableIRQ(DMAC_2_IRQn);
     NVIC_SetPriority(DMAC_3_IRQn, 7);
     NVIC_EnableIRQ(DMAC_3_IRQn);
+    NVIC_SetPriority(DMAC_OTHER_IRQn, 7);
+    NVIC_EnableIRQ(DMAC_OTHER_IRQn);
     NVIC_SetPriority(SERCOM2_0_IRQn, 7);
     NVIC_EnableIRQ(SERCOM2_0_IRQn);
     NVIC_SetPriority(SERCOM2_1_IRQn, 7);
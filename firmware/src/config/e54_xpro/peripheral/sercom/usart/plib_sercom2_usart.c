@@ -50,6 +50,8 @@
 
 #include "interrupts.h"
 #include "plib_sercom2_usart.h"
+#include "peripheral/dmac/plib_dmac.h"
+#include "peripheral/nvic/plib_nvic.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -58,8 +60,12 @@
 // *****************************************************************************
 
 
-/* SERCOM2 USART baud value for 115200 Hz baud rate */
-#define SERCOM2_USART_INT_BAUD_VALUE            (63522UL)
+/* SERCOM2 USART baud value for 921600 Hz baud rate */
+#define SERCOM2_USART_INT_BAUD_VALUE            (49430UL)
+
+/* Transmit from the ring buffer by DMA rather than the data register empty
+ * interrupt: one interrupt per contiguous run of bytes instead of per byte. */
+#define SERCOM2_USART_TX_DMA_CHANNEL            DMAC_CHANNEL_4
 
 static SERCOM_USART_RING_BUFFER_OBJECT sercom2USARTObj;
 
@@ -69,20 +75,29 @@ static SERCOM_USART_RING_BUFFER_OBJECT sercom2USARTObj;
 // *****************************************************************************
 // *****************************************************************************
 
-#define SERCOM2_USART_READ_BUFFER_SIZE      128U
-#define SERCOM2_USART_READ_BUFFER_9BIT_SIZE     (128U >> 1U)
+#define SERCOM2_USART_READ_BUFFER_SIZE      512U
+#define SERCOM2_USART_READ_BUFFER_9BIT_SIZE     (512U >> 1U)
 #define SERCOM2_USART_RX_INT_DISABLE()      SERCOM2_REGS->USART_INT.SERCOM_INTENCLR = SERCOM_USART_INT_INTENCLR_RXC_Msk
 #define SERCOM2_USART_RX_INT_ENABLE()       SERCOM2_REGS->USART_INT.SERCOM_INTENSET = SERCOM_USART_INT_INTENSET_RXC_Msk
 
 static uint8_t SERCOM2_USART_ReadBuffer[SERCOM2_USART_READ_BUFFER_SIZE];
 
-#define SERCOM2_USART_WRITE_BUFFER_SIZE     2048U
-#define SERCOM2_USART_WRITE_BUFFER_9BIT_SIZE  (2048U >> 1U)
+#define SERCOM2_USART_WRITE_BUFFER_SIZE     8192U
+#define SERCOM2_USART_WRITE_BUFFER_9BIT_SIZE  (8192U >> 1U)
 #define SERCOM2_USART_TX_INT_DISABLE()      SERCOM2_REGS->USART_INT.SERCOM_INTENCLR = SERCOM_USART_INT_INTENCLR_DRE_Msk
 #define SERCOM2_USART_TX_INT_ENABLE()       SERCOM2_REGS->USART_INT.SERCOM_INTENSET = SERCOM_USART_INT_INTENSET_DRE_Msk
 
 static uint8_t SERCOM2_USART_WriteBuffer[SERCOM2_USART_WRITE_BUFFER_SIZE];
 
+/* Bytes discarded by SERCOM2_USART_Write() because the ring buffer was full */
+static volatile uint32_t sercom2USARTWriteDropCount = 0U;
+
+/* Bytes handed to the DMA transfer in progress, or 0 when it is idle */
+static volatile uint32_t sercom2USARTTxDmaCount = 0U;
+
+static void SERCOM2_USART_TxDmaStart( void );
+static void SERCOM2_USART_TxDmaCallback( DMAC_TRANSFER_EVENT event, uintptr_t context );
+
 void SERCOM2_USART_Initialize( void )
 {
     /*
@@ -633,6 +648,14 @@ size_t SERCOM2_USART_Write(uint8_t* pWrBuffer, const size_t size )
 {
     size_t nBytesWritten  = 0U;
 
+    /* Never wait for the UART: when the message does not fit, drop all of it
+     * (a missing line reads better than a truncated one) and count the loss. */
+    if (size > SERCOM2_USART_WriteFreeBufferCountGet())
+    {
+        sercom2USARTWriteDropCount += size;
+        return 0U;
+    }
+
     while (nBytesWritten < size)
     {
         if (((SERCOM2_REGS->USART_INT.SERCOM_CTRLB & SERCOM_USART_INT_CTRLB_CHSIZE_Msk) >> SERCOM_USART_INT_CTRLB_CHSIZE_Pos) != 0x01U)
@@ -664,12 +687,8 @@ size_t SERCOM2_USART_Write(uint8_t* pWrBuffer, const size_t size )
         }
     }
 
-    /* Check if any data is pending for transmission */
-    if (SERCOM2_USART_WritePendingBytesGet() > 0U)
-    {
-        /* Enable TX interrupt as data is pending for transmission */
-        SERCOM2_USART_TX_INT_ENABLE();
-    }
+    /* Start a DMA transfer if one isn't already running */
+    SERCOM2_USART_TxDmaStart();
 
     return nBytesWritten;
 }
@@ -684,6 +703,11 @@ size_t SERCOM2_USART_WriteBufferSizeGet(void)
     return (sercom2USARTObj.wrBufferSize - 1U);
 }
 
+uint32_t SERCOM2_USART_WriteDropCountGet(void)
+{
+    return sercom2USARTWriteDropCount;
+}
+
 bool SERCOM2_USART_WriteNotificationEnable(bool isEnabled, bool isPersistent)
 {
     bool previousStatus = sercom2USARTObj.isWrNotificationEnabled;
@@ -710,6 +734,55 @@ void SERCOM2_USART_WriteCallbackRegister( SERCOM_USART_RING_BUFFER_CALLBACK call
     sercom2USARTObj.wrContext = context;
 }
 
+/* Called from Write() and from the DMA callback: send the oldest contiguous
+ * run of pending bytes, unless a transfer is already in progress. */
+static void SERCOM2_USART_TxDmaStart( void )
+{
+    bool interruptState = NVIC_INT_Disable();
+    uint32_t wrOutIndex = sercom2USARTObj.wrOutIndex;
+    uint32_t wrInIndex = sercom2USARTObj.wrInIndex;
+    uint32_t nBytes;
+
+    if ((sercom2USARTTxDmaCount == 0U) && (wrInIndex != wrOutIndex))
+    {
+        /* When the pending bytes wrap around, send up to the end of the
+         * buffer now and the rest from the completion callback. */
+        if (wrInIndex > wrOutIndex)
+        {
+            nBytes = wrInIndex - wrOutIndex;
+        }
+        else
+        {
+            nBytes = sercom2USARTObj.wrBufferSize - wrOutIndex;
+        }
+        sercom2USARTTxDmaCount = nBytes;
+
+        /* DMAC_Initialize() runs after this PLIB is initialized and clears
+         * channel callbacks, so register here rather than at startup. */
+        DMAC_ChannelCallbackRegister(SERCOM2_USART_TX_DMA_CHANNEL, SERCOM2_USART_TxDmaCallback, 0U);
+        (void)DMAC_ChannelTransfer(SERCOM2_USART_TX_DMA_CHANNEL, &SERCOM2_USART_WriteBuffer[wrOutIndex], (const void *)&SERCOM2_REGS->USART_INT.SERCOM_DATA, nBytes);
+    }
+
+    NVIC_INT_Restore(interruptState);
+}
+
+/* DMA transfer complete (or failed): release its bytes and send the next run */
+static void SERCOM2_USART_TxDmaCallback( DMAC_TRANSFER_EVENT event, uintptr_t context )
+{
+    uint32_t wrOutIndex = sercom2USARTObj.wrOutIndex + sercom2USARTTxDmaCount;
+
+    if (wrOutIndex >= sercom2USARTObj.wrBufferSize)
+    {
+        wrOutIndex = 0U;
+    }
+    sercom2USARTObj.wrOutIndex = wrOutIndex;
+    sercom2USARTTxDmaCount = 0U;
+
+    SERCOM2_USART_SendWriteNotification();
+
+    SERCOM2_USART_TxDmaStart();
+}
+
 
 
 void static SERCOM2_USART_ISR_ERR_Handler( void )
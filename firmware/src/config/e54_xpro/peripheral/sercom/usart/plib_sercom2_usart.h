@@ -86,6 +86,8 @@ size_t SERCOM2_USART_WriteFreeBufferCountGet(void);
 
 size_t SERCOM2_USART_WriteBufferSizeGet(void);
 
+uint32_t SERCOM2_USART_WriteDropCountGet(void);
+
 bool SERCOM2_USART_WriteNotificationEnable(bool isEnabled, bool isPersistent);
 
 void SERCOM2_USART_WriteThresholdSet(uint32_t nBytesThreshold);
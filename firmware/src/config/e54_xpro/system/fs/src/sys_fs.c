@@ -44,6 +44,7 @@
 
 #include "system/fs/src/sys_fs_local.h"
 #include "system/fs/sys_fs_media_manager.h"
+#include "prof.h"
 
 // *****************************************************************************
 /* Registration table for each native file system
@@ -811,6 +812,7 @@ SYS_FS_HANDLE SYS_FS_FileOpen
         {
             fileObj->inUse = true;
             fileObj->mountPoint = disk;
+            fileObj->writeBehind = false;
             break;
         }
     }
@@ -901,6 +903,7 @@ SYS_FS_RESULT SYS_FS_FileClose
 )
 {
     int fileStatus = -1;
+    bool writeBehindStatus = true;
     SYS_FS_OBJ *fileObj = (SYS_FS_OBJ *)handle;
     OSAL_RESULT osalResult = OSAL_RESULT_FALSE;
 
@@ -936,9 +939,26 @@ SYS_FS_RESULT SYS_FS_FileClose
 
     fileStatus = fileObj->mountPoint->fsFunctions->close(fileObj->nativeFSFileObj);
 
+    if (fileObj->writeBehind == true)
+    {
+        /* Closing the file has queued its last writes. Wait for all of them
+         * and collect any error from the ones that already drained. */
+        writeBehindStatus = SYS_FS_MEDIA_MANAGER_WriteBehindFlush(fileObj->mountPoint->diskNumber);
+        SYS_FS_MEDIA_MANAGER_WriteBehindEnable(fileObj->mountPoint->diskNumber, false);
+        fileObj->writeBehind = false;
+    }
+
     /* Release the acquired mutex. */
     OSAL_MUTEX_Unlock(&(fileObj->mountPoint->mutexDiskVolume));
 
+    if ((fileStatus == 0) && (writeBehindStatus == false))
+    {
+        /* The file is closed, but data written to it was lost. */
+        fileObj->inUse = false;
+        errorValue = SYS_FS_ERROR_DISK_ERR;
+        return SYS_FS_RES_FAILURE;
+    }
+
     if (fileStatus == 0)
     {
         /* Mark the file object as free. */
@@ -1069,6 +1089,7 @@ size_t SYS_FS_FileRead
     }
     else
     {
+        PROF_BEGIN(PROF_ZONE_FS_READ);
         fileStatus = fileObj->mountPoint->fsFunctions->read(
                 fileObj->nativeFSFileObj,
                 buffer,
@@ -1077,6 +1098,7 @@ size_t SYS_FS_FileRead
 
         /* Release the acquired mutex. */
         OSAL_MUTEX_Unlock(&(fileObj->mountPoint->mutexDiskVolume));
+        PROF_END(PROF_ZONE_FS_READ);
 
         if (fileStatus != 0)
         {
@@ -2406,6 +2428,7 @@ size_t SYS_FS_FileWrite
     }
     else
     {
+        PROF_BEGIN(PROF_ZONE_FS_WRITE);
         fileStatus = fileObj->mountPoint->fsFunctions->write(
                 fileObj->nativeFSFileObj,
                 buffer,
@@ -2414,6 +2437,7 @@ size_t SYS_FS_FileWrite
 
         /* Release the acquired mutex. */
         OSAL_MUTEX_Unlock(&(fileObj->mountPoint->mutexDiskVolume));
+        PROF_END(PROF_ZONE_FS_WRITE);
 
         if (fileStatus != 0)
         {
@@ -2561,6 +2585,270 @@ SYS_FS_RESULT SYS_FS_FileTruncate
     }
 }
 
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileExpand
+    (
+        SYS_FS_HANDLE handle,
+        uint32_t size
+    );
+
+  Summary:
+    Allocates a contiguous block of clusters to a file.
+
+  Description:
+    This function allocates a contiguous run of clusters of the given size to
+    an empty file. The file read/write pointer is left at the top of the file.
+
+  Remarks:
+    See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileExpand
+(
+    SYS_FS_HANDLE handle,
+    uint32_t size
+)
+{
+    int fileStatus = -1;
+    SYS_FS_OBJ *obj = (SYS_FS_OBJ *)handle;
+
+    if(handle == SYS_FS_HANDLE_INVALID)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->inUse == false)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->mountPoint->fsFunctions->expand == NULL)
+    {
+        obj->errorValue = SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(OSAL_MUTEX_Lock(&(obj->mountPoint->mutexDiskVolume), OSAL_WAIT_FOREVER)
+                                                        == OSAL_RESULT_TRUE)
+    {
+        fileStatus = obj->mountPoint->fsFunctions->expand(obj->nativeFSFileObj, size);
+
+        OSAL_MUTEX_Unlock(&(obj->mountPoint->mutexDiskVolume));
+    }
+
+    if(fileStatus == 0)
+    {
+        return SYS_FS_RES_SUCCESS;
+    }
+    else
+    {
+        obj->errorValue = (SYS_FS_ERROR)fileStatus;
+        return SYS_FS_RES_FAILURE;
+    }
+}
+
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileFastSeekEnable
+    (
+        SYS_FS_HANDLE handle,
+        uint32_t *linkMap,
+        uint32_t linkMapLength
+    );
+
+  Summary:
+    Enables fast seek mode on an open file.
+
+  Description:
+    This function builds the cluster link map of the file in the caller
+    supplied table, after which seeks and reads locate clusters through the
+    map instead of walking the allocation table.
+
+  Remarks:
+    See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileFastSeekEnable
+(
+    SYS_FS_HANDLE handle,
+    uint32_t *linkMap,
+    uint32_t linkMapLength
+)
+{
+    int fileStatus = -1;
+    SYS_FS_OBJ *obj = (SYS_FS_OBJ *)handle;
+
+    if(handle == SYS_FS_HANDLE_INVALID)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->inUse == false)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if((linkMap == NULL) || (linkMapLength < 4))
+    {
+        obj->errorValue = SYS_FS_ERROR_INVALID_PARAMETER;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->mountPoint->fsFunctions->fastSeek == NULL)
+    {
+        obj->errorValue = SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(OSAL_MUTEX_Lock(&(obj->mountPoint->mutexDiskVolume), OSAL_WAIT_FOREVER)
+                                                        == OSAL_RESULT_TRUE)
+    {
+        fileStatus = obj->mountPoint->fsFunctions->fastSeek(obj->nativeFSFileObj,
+                linkMap, linkMapLength);
+
+        OSAL_MUTEX_Unlock(&(obj->mountPoint->mutexDiskVolume));
+    }
+
+    if(fileStatus == 0)
+    {
+        return SYS_FS_RES_SUCCESS;
+    }
+    else
+    {
+        obj->errorValue = (SYS_FS_ERROR)fileStatus;
+        return SYS_FS_RES_FAILURE;
+    }
+}
+
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileWriteBehindEnable
+    (
+        SYS_FS_HANDLE handle,
+        bool enable
+    );
+
+  Summary:
+    Enables or disables write-behind for an open file.
+
+  Description:
+    This function switches the write-behind mode of the media holding the
+    file. Write-behind is flushed and switched off when the file is closed.
+
+  Remarks:
+    See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileWriteBehindEnable
+(
+    SYS_FS_HANDLE handle,
+    bool enable
+)
+{
+    bool status = false;
+    SYS_FS_OBJ *obj = (SYS_FS_OBJ *)handle;
+
+    if(handle == SYS_FS_HANDLE_INVALID)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->inUse == false)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(OSAL_MUTEX_Lock(&(obj->mountPoint->mutexDiskVolume), OSAL_WAIT_FOREVER)
+                                                        == OSAL_RESULT_TRUE)
+    {
+        if((enable == false) && (obj->writeBehind == true))
+        {
+            status = SYS_FS_MEDIA_MANAGER_WriteBehindFlush(obj->mountPoint->diskNumber);
+            SYS_FS_MEDIA_MANAGER_WriteBehindEnable(obj->mountPoint->diskNumber, false);
+            obj->writeBehind = false;
+
+            OSAL_MUTEX_Unlock(&(obj->mountPoint->mutexDiskVolume));
+
+            if(status == false)
+            {
+                obj->errorValue = SYS_FS_ERROR_DISK_ERR;
+                return SYS_FS_RES_FAILURE;
+            }
+
+            return SYS_FS_RES_SUCCESS;
+        }
+
+        status = SYS_FS_MEDIA_MANAGER_WriteBehindEnable(obj->mountPoint->diskNumber, enable);
+
+        OSAL_MUTEX_Unlock(&(obj->mountPoint->mutexDiskVolume));
+    }
+
+    if(status == true)
+    {
+        obj->writeBehind = enable;
+        return SYS_FS_RES_SUCCESS;
+    }
+    else
+    {
+        obj->errorValue = SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS;
+        return SYS_FS_RES_FAILURE;
+    }
+}
+
+//******************************************************************************
+/*Function:
+    SYS_FS_RESULT SYS_FS_FileWriteBehindTasks
+    (
+        SYS_FS_HANDLE handle
+    );
+
+  Summary:
+    Lets the buffered writes of a file make progress.
+
+  Description:
+    This function runs the media driver of the file once if it has buffered
+    writes, and reports whether any of them has failed.
+
+  Remarks:
+    See sys_fs.h for usage information.
+***************************************************************************/
+SYS_FS_RESULT SYS_FS_FileWriteBehindTasks
+(
+    SYS_FS_HANDLE handle
+)
+{
+    SYS_FS_OBJ *obj = (SYS_FS_OBJ *)handle;
+
+    if(handle == SYS_FS_HANDLE_INVALID)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->inUse == false)
+    {
+        errorValue = SYS_FS_ERROR_INVALID_OBJECT;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    if(obj->writeBehind == false)
+    {
+        return SYS_FS_RES_SUCCESS;
+    }
+
+    if(SYS_FS_MEDIA_MANAGER_WriteBehindTasks(obj->mountPoint->diskNumber) == false)
+    {
+        obj->errorValue = SYS_FS_ERROR_DISK_ERR;
+        return SYS_FS_RES_FAILURE;
+    }
+
+    return SYS_FS_RES_SUCCESS;
+}
+
 //******************************************************************************
 /*Function:
     SYS_FS_RESULT SYS_FS_FileCharacterPut
@@ -530,6 +530,46 @@ int FATFS_truncate (
     return ((int)res);
 }
 
+int FATFS_expand (
+    uintptr_t handle,   /* Pointer to the file object */
+    uint32_t fsz        /* File size to be expanded to */
+)
+{
+    FRESULT res;
+
+    FATFS_FILE_OBJECT *ptr = (FATFS_FILE_OBJECT *)handle;
+    FIL *fp = &ptr->fileObj;
+
+    /* opt = 1: allocate the contiguous area now rather than on first write */
+    res = f_expand(fp, (FSIZE_t)fsz, 1);
+
+    return ((int)res);
+}
+
+int FATFS_fastseek (
+    uintptr_t handle,   /* Pointer to the file object */
+    uint32_t *tbl,      /* Pointer to the cluster link map table */
+    uint32_t len        /* Number of items in the table */
+)
+{
+    FRESULT res;
+
+    FATFS_FILE_OBJECT *ptr = (FATFS_FILE_OBJECT *)handle;
+    FIL *fp = &ptr->fileObj;
+
+    tbl[0] = len;
+    fp->cltbl = (DWORD *)tbl;
+
+    res = f_lseek(fp, CREATE_LINKMAP);
+    if (res != FR_OK)
+    {
+        /* Incomplete map: fall back to following the FAT chain */
+        fp->cltbl = NULL;
+    }
+
+    return ((int)res);
+}
+
 int FATFS_chmod (
     const char* path,  /* Pointer to the file path */
     uint8_t attr,       /* Attribute bits */
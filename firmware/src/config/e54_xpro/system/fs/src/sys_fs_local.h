@@ -113,6 +113,9 @@ typedef struct
     /* File specific error value */
     SYS_FS_ERROR errorValue;
     
+    /* Set while the file has write-behind enabled on its media */
+    bool writeBehind;
+    
     /* Name of file is stored in a buffer for future use */
     uint8_t fileName[SYS_FS_FILE_NAME_LEN + 1] CACHE_ALIGN;
 
@@ -49,6 +49,97 @@
     (token) = ((token) == SYS_FS_MEDIA_NUMBER) ? 0: (token); \
 }
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+
+/* Number of write-behind slots per media */
+#define SYS_FS_MEDIA_WRITE_BEHIND_SLOTS     (4)
+
+/* Largest sector write, in sectors, that fits in one write-behind slot */
+#define SYS_FS_MEDIA_WRITE_BEHIND_SLOT_SECTORS \
+    (SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS / SYS_FS_MEDIA_WRITE_BEHIND_SLOTS)
+
+// *****************************************************************************
+/* Write-behind slot state
+
+  Summary:
+    Identifies the state of a write-behind slot.
+
+  Remarks:
+    None.
+*/
+typedef enum
+{
+    /* Slot holds no data */
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT_FREE = 0,
+
+    /* Slot holds data not yet handed to the media driver */
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT_DIRTY,
+
+    /* Slot data is being written by the media driver */
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT_IN_PROGRESS
+
+} SYS_FS_MEDIA_WRITE_BEHIND_SLOT_STATE;
+
+// *****************************************************************************
+/* Write-behind slot
+
+  Summary:
+    Defines one sector write buffered by the media manager.
+
+  Remarks:
+    None.
+*/
+typedef struct
+{
+    /* State of the slot */
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT_STATE state;
+
+    /* First sector to be written */
+    uint32_t sector;
+
+    /* Number of sectors to be written */
+    uint32_t numSectors;
+
+    /* Handle of the media write of the slot */
+    SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE commandHandle;
+
+} SYS_FS_MEDIA_WRITE_BEHIND_SLOT;
+
+// *****************************************************************************
+/* Write-behind object
+
+  Summary:
+    Defines the write-behind state of a media.
+
+  Description:
+    While write-behind is enabled, sector writes are copied into the slots and
+    reported complete at once. The slots are written to the media in order,
+    one media command at a time, while the client goes on with other work.
+
+  Remarks:
+    None.
+*/
+typedef struct
+{
+    /* Set while a client has write-behind enabled on the media */
+    bool enabled;
+
+    /* Set when a buffered write has failed since the last flush */
+    bool error;
+
+    /* Index of the oldest slot in use */
+    uint8_t head;
+
+    /* Number of slots in use */
+    uint8_t count;
+
+    /* Write-behind slots, used as a ring */
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT slot[SYS_FS_MEDIA_WRITE_BEHIND_SLOTS];
+
+} SYS_FS_MEDIA_WRITE_BEHIND;
+
+#endif
+
 // *****************************************************************************
 /* Media object
 
@@ -117,6 +208,11 @@ typedef struct _SYS_FS_MEDIA
     /* Pointer to the media geometry */
     SYS_FS_MEDIA_GEOMETRY *mediaGeometry;
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    /* Write-behind state */
+    SYS_FS_MEDIA_WRITE_BEHIND writeBehind;
+#endif
+
 } SYS_FS_MEDIA;
 
 // *****************************************************************************
@@ -42,6 +42,9 @@
 #include "nmasic.h"
 #include "wdrv_winc_common.h"
 #include "wdrv_winc_spi.h"
+#include "prof.h"
+#include "spi_trace.h"
+#include "stats.h"
 
 #define NMI_PERIPH_REG_BASE 0x1000
 #define NMI_INTR_REG_BASE (NMI_PERIPH_REG_BASE+0xa00)
@@ -174,6 +177,9 @@ static int8_t spi_cmd(uint8_t cmd, uint32_t adr, uint32_t u32data, uint32_t sz,
     uint8_t bc[9];
     uint8_t len = 5;
 
+    SPI_TRACE_BEGIN(cmd, adr, sz, !gu8Crc_off);
+    STATS_SPI_COMMAND(cmd);
+
     bc[0] = cmd;
     switch (cmd)
     {
@@ -830,21 +836,27 @@ int8_t nm_spi_read_reg_with_ret(uint32_t u32Addr, uint32_t* pu32RetVal)
     if (OSAL_RESULT_TRUE != OSAL_MUTEX_Lock(&s_spiLock, OSAL_WAIT_FOREVER))
         return M2M_ERR_BUS_FAIL;
 
+    PROF_BEGIN(PROF_ZONE_NMSPI_READ_REG);
+
     while(retry--)
     {
         if (spi_read_reg(u32Addr, pu32RetVal) == N_OK)
         {
+            SPI_TRACE_END(true);
             OSAL_MUTEX_Unlock(&s_spiLock);
 
+            PROF_END(PROF_ZONE_NMSPI_READ_REG);
             return M2M_SUCCESS;
         }
 
+        SPI_TRACE_END(false);
         M2M_ERR("Reset and retry %d %" PRIx32 "\r\n", retry, u32Addr);
         spi_reset();
     }
 
     OSAL_MUTEX_Unlock(&s_spiLock);
 
+    PROF_END(PROF_ZONE_NMSPI_READ_REG);
     return M2M_ERR_BUS_FAIL;
 }
 
@@ -867,21 +879,27 @@ int8_t nm_spi_write_reg(uint32_t u32Addr, uint32_t u32Val)
     if (OSAL_RESULT_TRUE != OSAL_MUTEX_Lock(&s_spiLock, OSAL_WAIT_FOREVER))
         return M2M_ERR_BUS_FAIL;
 
+    PROF_BEGIN(PROF_ZONE_NMSPI_WRITE_REG);
+
     while(retry--)
     {
         if (spi_write_reg(u32Addr, u32Val) == N_OK)
         {
+            SPI_TRACE_END(true);
             OSAL_MUTEX_Unlock(&s_spiLock);
 
+            PROF_END(PROF_ZONE_NMSPI_WRITE_REG);
             return M2M_SUCCESS;
         }
 
+        SPI_TRACE_END(false);
         M2M_ERR("Reset and retry %d %" PRIx32 " %" PRIx32 "\r\n", retry, u32Addr, u32Val);
         spi_reset();
     }
 
     OSAL_MUTEX_Unlock(&s_spiLock);
 
+    PROF_END(PROF_ZONE_NMSPI_WRITE_REG);
     return M2M_ERR_BUS_FAIL;
 }
 
@@ -908,6 +926,8 @@ int8_t nm_spi_read_block(uint32_t u32Addr, uint8_t *puBuf, uint16_t u16Sz)
     if (OSAL_RESULT_TRUE != OSAL_MUTEX_Lock(&s_spiLock, OSAL_WAIT_FOREVER))
         return M2M_ERR_BUS_FAIL;
 
+    PROF_BEGIN(PROF_ZONE_NMSPI_READ_BLOCK);
+
     if (u16Sz == 1)
     {
         u16Sz = 2;
@@ -922,20 +942,24 @@ int8_t nm_spi_read_block(uint32_t u32Addr, uint8_t *puBuf, uint16_t u16Sz)
     {
         if (spi_read_block(u32Addr, puTmpBuf, u16Sz) == N_OK)
         {
+            SPI_TRACE_END(true);
             OSAL_MUTEX_Unlock(&s_spiLock);
 
             if (puTmpBuf == tmpBuf)
                 *puBuf = *tmpBuf;
 
+            PROF_END(PROF_ZONE_NMSPI_READ_BLOCK);
             return M2M_SUCCESS;
         }
 
+        SPI_TRACE_END(false);
         M2M_ERR("Reset and retry %d %" PRIx32 " %d\r\n", retry, u32Addr, u16Sz);
         spi_reset();
     }
 
     OSAL_MUTEX_Unlock(&s_spiLock);
 
+    PROF_END(PROF_ZONE_NMSPI_READ_BLOCK);
     return M2M_ERR_BUS_FAIL;
 }
 
@@ -960,6 +984,8 @@ int8_t nm_spi_write_block(uint32_t u32Addr, uint8_t *puBuf, uint16_t u16Sz)
     if (OSAL_RESULT_TRUE != OSAL_MUTEX_Lock(&s_spiLock, OSAL_WAIT_FOREVER))
         return M2M_ERR_BUS_FAIL;
 
+    PROF_BEGIN(PROF_ZONE_NMSPI_WRITE_BLOCK);
+
     //Workaround hardware problem with single byte transfers over SPI bus
     if (u16Sz == 1)
         u16Sz = 2;
@@ -968,17 +994,21 @@ int8_t nm_spi_write_block(uint32_t u32Addr, uint8_t *puBuf, uint16_t u16Sz)
     {
         if (spi_write_block(u32Addr, puBuf, u16Sz) == N_OK)
         {
+            SPI_TRACE_END(true);
             OSAL_MUTEX_Unlock(&s_spiLock);
 
+            PROF_END(PROF_ZONE_NMSPI_WRITE_BLOCK);
             return M2M_SUCCESS;
         }
 
+        SPI_TRACE_END(false);
         M2M_ERR("Reset and retry %d %" PRIx32 " %d\r\n", retry, u32Addr, u16Sz);
         spi_reset();
     }
 
     OSAL_MUTEX_Unlock(&s_spiLock);
 
+    PROF_END(PROF_ZONE_NMSPI_WRITE_BLOCK);
     return M2M_ERR_BUS_FAIL;
 }
 
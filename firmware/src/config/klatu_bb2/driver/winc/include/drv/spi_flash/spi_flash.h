@@ -133,6 +133,19 @@ int8_t spi_flash_enable(uint8_t enable);
  * @return      SPI flash size in case of success and a ZERO value in case of failure.
  */
 uint32_t spi_flash_get_size(void);
+ /**@}*/
+
+ /** @defgroup SPiFlashGetIdFn spi_flash_get_id
+ *  @ingroup SPIFLASHAPI
+ */
+  /**@{*/
+/*!
+ * @fn             uint32_t spi_flash_get_id(void);
+ * @brief         Returns with \ref uint32_t value which is the JEDEC ID of the flash\n
+ * @note         Manufacturer in the low byte, then memory type and capacity.
+ * @return      SPI flash ID in case of success and a ZERO value in case of failure.
+ */
+uint32_t spi_flash_get_id(void);
  /**@}*/
 
   /** @defgroup SPiFlashRead spi_flash_read
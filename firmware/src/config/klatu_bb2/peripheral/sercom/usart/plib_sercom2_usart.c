@@ -58,8 +58,8 @@
 // *****************************************************************************
 
 
-/* SERCOM2 USART baud value for 115200 Hz baud rate */
-#define SERCOM2_USART_INT_BAUD_VALUE            (63522UL)
+/* SERCOM2 USART baud value for 921600 Hz baud rate */
+#define SERCOM2_USART_INT_BAUD_VALUE            (49430UL)
 
 static SERCOM_USART_RING_BUFFER_OBJECT sercom2USARTObj;
 
@@ -69,20 +69,23 @@ static SERCOM_USART_RING_BUFFER_OBJECT sercom2USARTObj;
 // *****************************************************************************
 // *****************************************************************************
 
-#define SERCOM2_USART_READ_BUFFER_SIZE      128U
-#define SERCOM2_USART_READ_BUFFER_9BIT_SIZE     (128U >> 1U)
+#define SERCOM2_USART_READ_BUFFER_SIZE      512U
+#define SERCOM2_USART_READ_BUFFER_9BIT_SIZE     (512U >> 1U)
 #define SERCOM2_USART_RX_INT_DISABLE()      SERCOM2_REGS->USART_INT.SERCOM_INTENCLR = SERCOM_USART_INT_INTENCLR_RXC_Msk
 #define SERCOM2_USART_RX_INT_ENABLE()       SERCOM2_REGS->USART_INT.SERCOM_INTENSET = SERCOM_USART_INT_INTENSET_RXC_Msk
 
 static uint8_t SERCOM2_USART_ReadBuffer[SERCOM2_USART_READ_BUFFER_SIZE];
 
-#define SERCOM2_USART_WRITE_BUFFER_SIZE     2048U
-#define SERCOM2_USART_WRITE_BUFFER_9BIT_SIZE  (2048U >> 1U)
+#define SERCOM2_USART_WRITE_BUFFER_SIZE     8192U
+#define SERCOM2_USART_WRITE_BUFFER_9BIT_SIZE  (8192U >> 1U)
 #define SERCOM2_USART_TX_INT_DISABLE()      SERCOM2_REGS->USART_INT.SERCOM_INTENCLR = SERCOM_USART_INT_INTENCLR_DRE_Msk
 #define SERCOM2_USART_TX_INT_ENABLE()       SERCOM2_REGS->USART_INT.SERCOM_INTENSET = SERCOM_USART_INT_INTENSET_DRE_Msk
 
 static uint8_t SERCOM2_USART_WriteBuffer[SERCOM2_USART_WRITE_BUFFER_SIZE];
 
+/* Bytes discarded by SERCOM2_USART_Write() because the ring buffer was full */
+static volatile uint32_t sercom2USARTWriteDropCount = 0U;
+
 void SERCOM2_USART_Initialize( void )
 {
     /*
@@ -633,6 +636,14 @@ size_t SERCOM2_USART_Write(uint8_t* pWrBuffer, const size_t size )
 {
     size_t nBytesWritten  = 0U;
 
+    /* Never wait for the UART: when the message does not fit, drop all of it
+     * (a missing line reads better than a truncated one) and count the loss. */
+    if (size > SERCOM2_USART_WriteFreeBufferCountGet())
+    {
+        sercom2USARTWriteDropCount += size;
+        return 0U;
+    }
+
     while (nBytesWritten < size)
     {
         if (((SERCOM2_REGS->USART_INT.SERCOM_CTRLB & SERCOM_USART_INT_CTRLB_CHSIZE_Msk) >> SERCOM_USART_INT_CTRLB_CHSIZE_Pos) != 0x01U)
@@ -684,6 +695,11 @@ size_t SERCOM2_USART_WriteBufferSizeGet(void)
     return (sercom2USARTObj.wrBufferSize - 1U);
 }
 
+uint32_t SERCOM2_USART_WriteDropCountGet(void)
+{
+    return sercom2USARTWriteDropCount;
+}
+
 bool SERCOM2_USART_WriteNotificationEnable(bool isEnabled, bool isPersistent)
 {
     bool previousStatus = sercom2USARTObj.isWrNotificationEnabled;
@@ -944,6 +944,109 @@ void SYS_FS_MEDIA_MANAGER_Tasks
     void
 );
 
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_WriteBehindEnable
+    (
+        uint8_t volNumber,
+        bool enable
+    );
+
+  Summary:
+    Enables or disables write-behind on the media of a volume.
+
+  Description:
+    While write-behind is enabled, a sector write of up to
+    SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS / 4 sectors is copied into one of four
+    write-behind slots and reported complete before it reaches the media.
+    The slots are written to the media in order whenever the media driver
+    runs.  A write only waits when all slots are in use.  Sector reads and
+    larger writes first wait for every buffered write to finish.
+
+    Once a buffered write fails, further writes fail at once until the error
+    is collected by SYS_FS_MEDIA_MANAGER_WriteBehindFlush.
+
+  Precondition:
+    The volume must be attached.
+
+  Parameters:
+    volNumber - Volume number, as reported by
+                SYS_FS_MEDIA_MANAGER_VolumePropertyGet.
+
+    enable    - true to enable write-behind, false to disable it. Disabling
+                write-behind waits for the buffered writes, but keeps their
+                error for SYS_FS_MEDIA_MANAGER_WriteBehindFlush.
+
+  Returns:
+    true  - Write-behind mode was changed.
+    false - The volume is invalid, its media does not use 512 byte blocks or
+            SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS is not configured.
+*/
+bool SYS_FS_MEDIA_MANAGER_WriteBehindEnable
+(
+    uint8_t volNumber,
+    bool enable
+);
+
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_WriteBehindFlush
+    (
+        uint8_t volNumber
+    );
+
+  Summary:
+    Waits for the buffered writes of a volume's media to finish.
+
+  Description:
+    This function drives the media driver until every buffered write has
+    been written, then reports and clears the write-behind error.
+
+  Precondition:
+    None.
+
+  Parameters:
+    volNumber - Volume number.
+
+  Returns:
+    true  - Every write buffered since the last flush reached the media.
+    false - At least one buffered write failed.
+*/
+bool SYS_FS_MEDIA_MANAGER_WriteBehindFlush
+(
+    uint8_t volNumber
+);
+
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_WriteBehindTasks
+    (
+        uint8_t volNumber
+    );
+
+  Summary:
+    Lets the buffered writes of a volume's media make progress.
+
+  Description:
+    A client that blocks the main loop while write-behind is enabled calls
+    this function between its own steps. It runs the media driver task once
+    if writes are buffered.
+
+  Precondition:
+    None.
+
+  Parameters:
+    volNumber - Volume number.
+
+  Returns:
+    true  - No buffered write has failed so far.
+    false - A buffered write has failed.
+*/
+bool SYS_FS_MEDIA_MANAGER_WriteBehindTasks
+(
+    uint8_t volNumber
+);
+
 //DOM-IGNORE-BEGIN
 #ifdef __cplusplus
 }
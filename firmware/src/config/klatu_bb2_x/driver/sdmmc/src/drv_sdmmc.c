@@ -52,6 +52,7 @@
 #include "configuration.h"
 #include "driver/sdmmc/drv_sdmmc.h"
 #include "driver/sdmmc/src/drv_sdmmc_local.h"
+#include "stats.h"
 #include <string.h>
 
 static DRV_SDMMC_OBJ gDrvSDMMCObj[DRV_SDMMC_INSTANCES_NUMBER];
@@ -1248,7 +1249,8 @@ static void _DRV_SDMMC_MediaInitialize (
                         }
                         else
                         {
-                            dObj->initState = DRV_SDMMC_INIT_DONE;
+                            /* Switch refused, stay in default speed mode. */
+                            dObj->initState = DRV_SDMMC_INIT_SET_BLOCK_LENGTH;
                         }
                     }
                     else
@@ -1262,7 +1264,8 @@ static void _DRV_SDMMC_MediaInitialize (
                         }
                         else
                         {
-                            dObj->initState = DRV_SDMMC_INIT_DONE;
+                            /* No HS support, stay in default speed mode. */
+                            dObj->initState = DRV_SDMMC_INIT_SET_BLOCK_LENGTH;
                         }
                     }
                 }
@@ -1667,6 +1670,7 @@ void DRV_SDMMC_AsyncRead (
     uint32_t nBlocks
 )
 {
+    STATS_ADD(STATS_SD_BLOCKS_READ, nBlocks);
     DRV_SDMMC_SetupXfer(
         handle,
         commandHandle,
@@ -1686,6 +1690,7 @@ void DRV_SDMMC_AsyncWrite
     uint32_t nBlocks
 )
 {
+    STATS_ADD(STATS_SD_BLOCKS_WRITTEN, nBlocks);
     DRV_SDMMC_SetupXfer(
         handle,
         commandHandle,
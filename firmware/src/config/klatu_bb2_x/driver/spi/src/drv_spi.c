@@ -49,6 +49,7 @@
 #include "configuration.h"
 #include "driver/spi/drv_spi.h"
 #include "system/debug/sys_debug.h"
+#include "prof.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -1233,6 +1234,8 @@ void DRV_SPI_WriteReadTransferAdd (
         {
             transferObj->currentState = DRV_SPI_TRANSFER_OBJ_IS_PROCESSING;
 
+            PROF_BEGIN(PROF_ZONE_DRV_SPI_START);
+
              /* This is the first request in the queue, hence initiate a transfer */
             _DRV_SPI_UpdateTransferSetupAndAssertCS(transferObj);
 
@@ -1244,6 +1247,8 @@ void DRV_SPI_WriteReadTransferAdd (
             {
                 dObj->spiPlib->writeRead(transferObj->pTransmitData, transferObj->txSize, transferObj->pReceiveData, transferObj->rxSize);
             }
+
+            PROF_END(PROF_ZONE_DRV_SPI_START);
         }
 
         _DRV_SPI_ResourceUnlock(dObj);
@@ -41,6 +41,8 @@
 #include "driver/spi/drv_spi.h"
 #include "wdrv_winc_common.h"
 #include "wdrv_winc_spi.h"
+#include "prof.h"
+#include "stats.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -124,9 +126,19 @@ bool WDRV_WINC_SPISend(void* pTransmitData, size_t txSize)
         return false;
     }
 
-    while (OSAL_RESULT_FALSE == OSAL_SEM_Pend(&spiDcpt.txSyncSem, OSAL_WAIT_FOREVER))
+    STATS_INC(STATS_SPI_DMA_TRANSFERS);
+    STATS_ADD(STATS_SPI_BYTES_OUT, txSize);
+
+    PROF_BEGIN(PROF_ZONE_DRV_SPI_WAIT);
+    if (OSAL_RESULT_FALSE == OSAL_SEM_Pend(&spiDcpt.txSyncSem, OSAL_WAIT_FOREVER))
     {
+        /* The transfer is still running: wait for it to complete. */
+        STATS_INC(STATS_SPI_SEM_WAITS);
+        while (OSAL_RESULT_FALSE == OSAL_SEM_Pend(&spiDcpt.txSyncSem, OSAL_WAIT_FOREVER))
+        {
+        }
     }
+    PROF_END(PROF_ZONE_DRV_SPI_WAIT);
 
     return true;
 }
@@ -157,9 +169,19 @@ bool WDRV_WINC_SPIReceive(void* pReceiveData, size_t rxSize)
         return false;
     }
 
-    while (OSAL_RESULT_FALSE == OSAL_SEM_Pend(&spiDcpt.rxSyncSem, OSAL_WAIT_FOREVER))
+    STATS_INC(STATS_SPI_DMA_TRANSFERS);
+    STATS_ADD(STATS_SPI_BYTES_IN, rxSize);
+
+    PROF_BEGIN(PROF_ZONE_DRV_SPI_WAIT);
+    if (OSAL_RESULT_FALSE == OSAL_SEM_Pend(&spiDcpt.rxSyncSem, OSAL_WAIT_FOREVER))
     {
+        /* The transfer is still running: wait for it to complete. */
+        STATS_INC(STATS_SPI_SEM_WAITS);
+        while (OSAL_RESULT_FALSE == OSAL_SEM_Pend(&spiDcpt.rxSyncSem, OSAL_WAIT_FOREVER))
+        {
+        }
     }
+    PROF_END(PROF_ZONE_DRV_SPI_WAIT);
 
 
     return true;
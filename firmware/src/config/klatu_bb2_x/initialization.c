@@ -287,7 +287,9 @@ const SYS_FS_FUNCTIONS FatFsFunctions =
     .testerror         = FATFS_error,
     .formatDisk        = (FORMAT_DISK)FATFS_mkfs,
     .partitionDisk     = FATFS_fdisk,
-    .getCluster        = FATFS_getclusters
+    .getCluster        = FATFS_getclusters,
+    .expand            = FATFS_expand,
+    .fastSeek          = FATFS_fastseek
 };
 
 
@@ -50,10 +50,10 @@
 
 #include "plib_sdhc_common.h"
 
-#define SDHC1_DMA_NUM_DESCR_LINES        (1U)
+#define SDHC1_DMA_NUM_DESCR_LINES        (16U)
 #define SDHC1_BASE_CLOCK_FREQUENCY       (60000000U)
 #define SDHC1_MAX_BLOCK_SIZE             (0x200U)
-#define SDHC1_DMA_DESC_TABLE_SIZE	     (8U * 1)
+#define SDHC1_DMA_DESC_TABLE_SIZE	     (8U * 16)
 #define SDHC1_DMA_DESC_TABLE_SIZE_CACHE_ALIGN	 (SDHC1_DMA_DESC_TABLE_SIZE + ((SDHC1_DMA_DESC_TABLE_SIZE % CACHE_LINE_SIZE)? (CACHE_LINE_SIZE - (SDHC1_DMA_DESC_TABLE_SIZE % CACHE_LINE_SIZE)) : 0U))
 
 static CACHE_ALIGN SDHC_ADMA_DESCR sdhc1DmaDescrTable[(SDHC1_DMA_DESC_TABLE_SIZE_CACHE_ALIGN/8U)];
@@ -290,6 +290,10 @@ void SDHC1_DmaSetup (
     SDHC_DATA_TRANSFER_DIR direction
 )
 {
+    uint32_t i;
+    uint32_t pendingBytes = numBytes;
+    uint32_t nBytes = 0U;
+
     (void)direction;
 
     /* Each ADMA2 descriptor can transfer 65536 bytes (or 128 blocks) of data.
@@ -297,21 +301,38 @@ void SDHC1_DmaSetup (
      * limited to 65536 blocks. Hence, combined length of data that can be
      * transferred by all the descriptors is 512 bytes x 65536 blocks, assuming
      * a block size of 512 bytes.
+     * With SDHC1_DMA_NUM_DESCR_LINES lines, a single multi-block request can
+     * move up to SDHC1_DMA_NUM_DESCR_LINES x 64 KB without CPU involvement.
      */
 
-    if (numBytes <= 65536U)
+    for (i = 0U; (i < SDHC1_DMA_NUM_DESCR_LINES) && (pendingBytes > 0U); i++)
     {
-        sdhc1DmaDescrTable[0].address = (uint32_t)(buffer);
-        sdhc1DmaDescrTable[0].length = (uint16_t)numBytes;
-        sdhc1DmaDescrTable[0].attribute = \
-            (SDHC_DESC_TABLE_ATTR_XFER_DATA | SDHC_DESC_TABLE_ATTR_VALID | SDHC_DESC_TABLE_ATTR_INTR);
+        if (pendingBytes > 65536U)
+        {
+            nBytes = 65536U;
+        }
+        else
+        {
+            nBytes = pendingBytes;
+        }
+
+        /* A length field of 0 stands for 65536 bytes */
+        sdhc1DmaDescrTable[i].address = (uint32_t)(buffer);
+        sdhc1DmaDescrTable[i].length = (uint16_t)nBytes;
+        sdhc1DmaDescrTable[i].attribute = \
+            (SDHC_DESC_TABLE_ATTR_XFER_DATA | SDHC_DESC_TABLE_ATTR_VALID);
 
+        buffer += nBytes;
+        pendingBytes -= nBytes;
+    }
 
+    if (pendingBytes == 0U)
+    {
          /* The last descriptor line must indicate the end of the descriptor list */
-        sdhc1DmaDescrTable[0].attribute |= (uint16_t)(SDHC_DESC_TABLE_ATTR_END);
+        sdhc1DmaDescrTable[i - 1U].attribute |= (uint16_t)(SDHC_DESC_TABLE_ATTR_END | SDHC_DESC_TABLE_ATTR_INTR);
 
         /* Clean the cache associated with the modified descriptors */
-        DCACHE_CLEAN_BY_ADDR((uint32_t*)(sdhc1DmaDescrTable), (sizeof(SDHC_ADMA_DESCR)));
+        DCACHE_CLEAN_BY_ADDR((uint32_t*)(sdhc1DmaDescrTable), (i * sizeof(SDHC_ADMA_DESCR)));
 
         /* Set the starting address of the descriptor table */
         SDHC1_REGS->SDHC_ASAR[0] = (uint32_t)(&sdhc1DmaDescrTable[0]);
@@ -353,7 +374,9 @@ bool SDHC1_ClockSet ( uint32_t speed)
             F_SDCLK = (F_BASECLK x (CLKMULT + 1))/(DIV + 1)
             For a given F_SDCLK, DIV = [(F_BASECLK x (CLKMULT + 1))/F_SDCLK] - 1
         */
-        divider = (uint16_t)((baseclk_frq * (clkmul + 1U)) / speed);
+        /* Round the divisor up so that SDCLK never exceeds the requested
+           speed (e.g. 25 MHz from a 60 MHz clock gives 20 MHz, not 30 MHz). */
+        divider = (uint16_t)(((baseclk_frq * (clkmul + 1U)) + speed - 1U) / speed);
         if (divider > 0U)
         {
             divider = divider - 1U;
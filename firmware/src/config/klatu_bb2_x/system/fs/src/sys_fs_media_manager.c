@@ -123,6 +123,22 @@ static uint8_t gNumOfFSClients = 0;
 */
 uint8_t CACHE_ALIGN gSYSFSMediaBlockBuffer[SYS_FS_MEDIA_MANAGER_BUFFER_SIZE] = {0};
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+// *****************************************************************************
+/* Media Write-behind Buffer
+
+  Summary:
+    Defines the buffer holding the write-behind slots of each media.
+
+  Description:
+    Each media owns SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS sectors, split evenly
+    between its write-behind slots.
+  Remarks:
+    None
+*/
+static uint8_t CACHE_ALIGN gSYSFSMediaWriteBehindBuffer[SYS_FS_MEDIA_NUMBER][SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS << SYS_FS_MEDIA_SHIFT_SECTOR_VALUE];
+#endif
+
 // *****************************************************************************
 /* Media Mount Table
 
@@ -218,6 +234,258 @@ static void _SYS_FS_MEDIA_MANAGER_UpdateVolToPart
     VolToPart[volNumber].pt = pt;
 }
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+//*****************************************************************************
+/* Function:
+    static SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE _SYS_FS_MEDIA_MANAGER_LocalCommandComplete
+    (
+        SYS_FS_MEDIA *mediaObj
+    );
+
+  Summary:
+    Completes a command that the media manager served by itself.
+
+  Description:
+    Write-behind writes never reach the media driver. This function marks
+    such a command complete and notifies the disk io layer at once; the disk
+    io layer only polls the command status after the sector write call
+    returns.
+
+  Remarks:
+    The media object address serves as the command handle.
+*/
+static SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE _SYS_FS_MEDIA_MANAGER_LocalCommandComplete
+(
+    SYS_FS_MEDIA *mediaObj
+)
+{
+    mediaObj->commandHandle = (SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE)mediaObj;
+    mediaObj->commandStatus = SYS_FS_MEDIA_COMMAND_COMPLETED;
+
+    if ((gSYSFSMediaManagerObj.eventHandler != NULL) && (gSYSFSMediaManagerObj.muteEventNotification == false))
+    {
+        gSYSFSMediaManagerObj.eventHandler ((SYS_FS_EVENT)SYS_FS_MEDIA_EVENT_BLOCK_COMMAND_COMPLETE, (void *)mediaObj->commandHandle, mediaObj->mediaIndex);
+    }
+
+    return (mediaObj->commandHandle);
+}
+#endif
+
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+//*****************************************************************************
+/* Function:
+    static uint8_t *_SYS_FS_MEDIA_MANAGER_WriteBehindBuffer
+    (
+        SYS_FS_MEDIA *mediaObj,
+        uint8_t index
+    );
+
+  Summary:
+    Returns the buffer of a write-behind slot.
+
+  Remarks:
+    None
+*/
+static uint8_t *_SYS_FS_MEDIA_MANAGER_WriteBehindBuffer
+(
+    SYS_FS_MEDIA *mediaObj,
+    uint8_t index
+)
+{
+    uint32_t offset = (index * SYS_FS_MEDIA_WRITE_BEHIND_SLOT_SECTORS) << SYS_FS_MEDIA_SHIFT_SECTOR_VALUE;
+
+    return &gSYSFSMediaWriteBehindBuffer[mediaObj->mediaIndex][offset];
+}
+
+//*****************************************************************************
+/* Function:
+    static void _SYS_FS_MEDIA_MANAGER_WriteBehindIssue
+    (
+        SYS_FS_MEDIA *mediaObj
+    );
+
+  Summary:
+    Hands the oldest buffered write to the media driver.
+
+  Description:
+    The slots are written strictly in order and only one write-behind command
+    is queued with the media driver at a time. If the driver queue is full,
+    the slot stays dirty and is issued on a later call.
+
+  Remarks:
+    None
+*/
+static void _SYS_FS_MEDIA_MANAGER_WriteBehindIssue
+(
+    SYS_FS_MEDIA *mediaObj
+)
+{
+    SYS_FS_MEDIA_WRITE_BEHIND *writeBehind = &mediaObj->writeBehind;
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT *slot = &writeBehind->slot[writeBehind->head];
+
+    if ((writeBehind->count == 0) || (slot->state != SYS_FS_MEDIA_WRITE_BEHIND_SLOT_DIRTY))
+    {
+        return;
+    }
+
+    slot->state = SYS_FS_MEDIA_WRITE_BEHIND_SLOT_IN_PROGRESS;
+
+    mediaObj->driverFunctions->sectorWrite (mediaObj->driverHandle, &(slot->commandHandle), _SYS_FS_MEDIA_MANAGER_WriteBehindBuffer (mediaObj, writeBehind->head), slot->sector, slot->numSectors);
+
+    if (slot->commandHandle == SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID)
+    {
+        slot->state = SYS_FS_MEDIA_WRITE_BEHIND_SLOT_DIRTY;
+    }
+}
+
+//*****************************************************************************
+/* Function:
+    static bool _SYS_FS_MEDIA_MANAGER_WriteBehindEventHandle
+    (
+        SYS_FS_MEDIA *mediaObj,
+        SYS_FS_MEDIA_BLOCK_EVENT event,
+        SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE commandHandle
+    );
+
+  Summary:
+    Handles the completion of a write-behind command.
+
+  Description:
+    This function frees the slot written by the given command, records a
+    failure and issues the next buffered write. It returns false if the
+    command does not belong to a write-behind slot.
+
+  Remarks:
+    None
+*/
+static bool _SYS_FS_MEDIA_MANAGER_WriteBehindEventHandle
+(
+    SYS_FS_MEDIA *mediaObj,
+    SYS_FS_MEDIA_BLOCK_EVENT event,
+    SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE commandHandle
+)
+{
+    SYS_FS_MEDIA_WRITE_BEHIND *writeBehind = &mediaObj->writeBehind;
+    SYS_FS_MEDIA_WRITE_BEHIND_SLOT *slot = &writeBehind->slot[writeBehind->head];
+
+    if ((writeBehind->count == 0) ||
+        (slot->state != SYS_FS_MEDIA_WRITE_BEHIND_SLOT_IN_PROGRESS) ||
+        (slot->commandHandle != commandHandle))
+    {
+        return false;
+    }
+
+    if (event != SYS_FS_MEDIA_EVENT_BLOCK_COMMAND_COMPLETE)
+    {
+        writeBehind->error = true;
+    }
+
+    slot->state = SYS_FS_MEDIA_WRITE_BEHIND_SLOT_FREE;
+    writeBehind->head = (writeBehind->head + 1) % SYS_FS_MEDIA_WRITE_BEHIND_SLOTS;
+    writeBehind->count--;
+
+    _SYS_FS_MEDIA_MANAGER_WriteBehindIssue (mediaObj);
+
+    return true;
+}
+
+//*****************************************************************************
+/* Function:
+    static void _SYS_FS_MEDIA_MANAGER_WriteBehindWait
+    (
+        SYS_FS_MEDIA *mediaObj,
+        uint8_t maxSlotsInUse
+    );
+
+  Summary:
+    Drives the buffered writes until few enough slots are in use.
+
+  Remarks:
+    Passing zero for maxSlotsInUse drains every buffered write.
+*/
+static void _SYS_FS_MEDIA_MANAGER_WriteBehindWait
+(
+    SYS_FS_MEDIA *mediaObj,
+    uint8_t maxSlotsInUse
+)
+{
+    while (mediaObj->writeBehind.count > maxSlotsInUse)
+    {
+        _SYS_FS_MEDIA_MANAGER_WriteBehindIssue (mediaObj);
+
+        if(mediaObj->driverFunctions->tasks != NULL)
+        {
+            mediaObj->driverFunctions->tasks(mediaObj->driverObj);
+        }
+    }
+}
+
+//*****************************************************************************
+/* Function:
+    static void _SYS_FS_MEDIA_MANAGER_WriteBehindReset
+    (
+        SYS_FS_MEDIA *mediaObj
+    );
+
+  Summary:
+    Disables write-behind and frees every slot of a media.
+
+  Remarks:
+    Data still held in the slots is dropped.
+*/
+static void _SYS_FS_MEDIA_MANAGER_WriteBehindReset
+(
+    SYS_FS_MEDIA *mediaObj
+)
+{
+    uint8_t index = 0;
+
+    mediaObj->writeBehind.enabled = false;
+    mediaObj->writeBehind.head = 0;
+    mediaObj->writeBehind.count = 0;
+
+    for (index = 0; index < SYS_FS_MEDIA_WRITE_BEHIND_SLOTS; index++)
+    {
+        mediaObj->writeBehind.slot[index].state = SYS_FS_MEDIA_WRITE_BEHIND_SLOT_FREE;
+    }
+}
+
+//*****************************************************************************
+/* Function:
+    static SYS_FS_MEDIA *_SYS_FS_MEDIA_MANAGER_VolumeMediaGet
+    (
+        uint8_t volNumber
+    );
+
+  Summary:
+    Returns the media object of an attached volume, or NULL.
+
+  Remarks:
+    None
+*/
+static SYS_FS_MEDIA *_SYS_FS_MEDIA_MANAGER_VolumeMediaGet
+(
+    uint8_t volNumber
+)
+{
+    SYS_FS_VOLUME *volumeObj = NULL;
+
+    if (volNumber >= SYS_FS_VOLUME_NUMBER)
+    {
+        SYS_ASSERT(false, "Invalid Volume");
+        return NULL;
+    }
+
+    volumeObj = &gSYSFSMediaManagerObj.volumeObj[volNumber];
+    if ((volumeObj->inUse == false) || (volumeObj->obj->attachStatus != SYS_FS_MEDIA_ATTACHED))
+    {
+        return NULL;
+    }
+
+    return volumeObj->obj;
+}
+#endif
+
 //*****************************************************************************
 /* Function:
     static void _SYS_FS_MEDIA_MANAGER_HandleMediaDetach
@@ -244,6 +512,15 @@ static void _SYS_FS_MEDIA_MANAGER_HandleMediaDetach
     uint8_t volIndex = 0;
     SYS_FS_VOLUME *volumeObj = NULL;
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    /* Buffered writes can no longer reach the media. */
+    if (mediaObj->writeBehind.count > 0)
+    {
+        mediaObj->writeBehind.error = true;
+    }
+    _SYS_FS_MEDIA_MANAGER_WriteBehindReset (mediaObj);
+#endif
+
     for (volIndex = 0; volIndex < SYS_FS_VOLUME_NUMBER; volIndex++)
     {
         volumeObj = &gSYSFSMediaManagerObj.volumeObj[volIndex];
@@ -773,6 +1050,11 @@ SYS_FS_MEDIA_HANDLE SYS_FS_MEDIA_MANAGER_Register
             mediaObj->mediaId = mediaId;
             mediaObj->attachStatus = SYS_FS_MEDIA_DETACHED;
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+            mediaObj->writeBehind.error = false;
+            _SYS_FS_MEDIA_MANAGER_WriteBehindReset (mediaObj);
+#endif
+
             return (SYS_FS_MEDIA_HANDLE)mediaObj;
         }
 
@@ -860,6 +1142,11 @@ SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE SYS_FS_MEDIA_MANAGER_SectorRead
         return SYS_FS_MEDIA_HANDLE_INVALID;
     }
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    /* The sectors to be read may still be buffered. */
+    _SYS_FS_MEDIA_MANAGER_WriteBehindWait (mediaObj, 0);
+#endif
+
     mediaReadBlockSize = mediaObj->mediaGeometry->geometryTable[0].blockSize;
 
     if (mediaReadBlockSize < 512)
@@ -979,6 +1266,9 @@ SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE SYS_FS_MEDIA_MANAGER_SectorWrite
     uint32_t numSectorsToWrite = 0;
     uint32_t mediaWriteBlockSize = 0;
     uint32_t blocksPerSector = 0;
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    uint8_t slotIndex = 0;
+#endif
 
     if(diskNum >= SYS_FS_MEDIA_NUMBER)
     {
@@ -995,6 +1285,37 @@ SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE SYS_FS_MEDIA_MANAGER_SectorWrite
 
     mediaWriteBlockSize = mediaObj->mediaGeometry->geometryTable[1].blockSize;
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    if ((mediaObj->writeBehind.enabled == true) && (mediaWriteBlockSize == 512) &&
+        (numSectors <= SYS_FS_MEDIA_WRITE_BEHIND_SLOT_SECTORS))
+    {
+        if (mediaObj->writeBehind.error == true)
+        {
+            /* Do not let the file system carry on past a lost write. */
+            return SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE_INVALID;
+        }
+
+        /* Wait for a free slot. */
+        _SYS_FS_MEDIA_MANAGER_WriteBehindWait (mediaObj, SYS_FS_MEDIA_WRITE_BEHIND_SLOTS - 1);
+
+        slotIndex = (mediaObj->writeBehind.head + mediaObj->writeBehind.count) % SYS_FS_MEDIA_WRITE_BEHIND_SLOTS;
+
+        memcpy ((void *)_SYS_FS_MEDIA_MANAGER_WriteBehindBuffer (mediaObj, slotIndex), (const void *)dataBuffer, numSectors << SYS_FS_MEDIA_SHIFT_SECTOR_VALUE);
+
+        mediaObj->writeBehind.slot[slotIndex].sector = sector;
+        mediaObj->writeBehind.slot[slotIndex].numSectors = numSectors;
+        mediaObj->writeBehind.slot[slotIndex].state = SYS_FS_MEDIA_WRITE_BEHIND_SLOT_DIRTY;
+        mediaObj->writeBehind.count++;
+
+        _SYS_FS_MEDIA_MANAGER_WriteBehindIssue (mediaObj);
+
+        return _SYS_FS_MEDIA_MANAGER_LocalCommandComplete (mediaObj);
+    }
+
+    /* Keep the writes in order. */
+    _SYS_FS_MEDIA_MANAGER_WriteBehindWait (mediaObj, 0);
+#endif
+
     if (mediaWriteBlockSize > 512)
     {
         sectorsPerBlock = mediaWriteBlockSize / 512;
@@ -1192,6 +1513,14 @@ SYS_FS_MEDIA_COMMAND_STATUS SYS_FS_MEDIA_MANAGER_CommandStatusGet
         return SYS_FS_MEDIA_COMMAND_UNKNOWN;
     }
 
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    if (commandHandle == (SYS_FS_MEDIA_BLOCK_COMMAND_HANDLE)mediaObj)
+    {
+        /* Command served by the media manager itself */
+        return SYS_FS_MEDIA_COMMAND_COMPLETED;
+    }
+#endif
+
     return (mediaObj->driverFunctions->commandStatusGet(mediaObj->driverHandle, commandHandle));
 }
 
@@ -1382,6 +1711,15 @@ void SYS_FS_MEDIA_MANAGER_EventHandler
     uintptr_t context
 )
 {
+
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    if (_SYS_FS_MEDIA_MANAGER_WriteBehindEventHandle ((SYS_FS_MEDIA*)context, event, commandHandle) == true)
+    {
+        /* The file system saw this write complete when it was buffered. */
+        return;
+    }
+#endif
+
     switch(event)
     {
         case SYS_FS_MEDIA_EVENT_BLOCK_COMMAND_COMPLETE:
@@ -1578,6 +1916,11 @@ void SYS_FS_MEDIA_MANAGER_Tasks
 
                     /* Update the media status */
                     mediaObj->attachStatus = SYS_FS_MEDIA_ATTACHED;
+
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+                    /* Retry a buffered write the driver queue refused. */
+                    _SYS_FS_MEDIA_MANAGER_WriteBehindIssue (mediaObj);
+#endif
                 }
                 else
                 {
@@ -1719,6 +2062,157 @@ void SYS_FS_MEDIA_MANAGER_Tasks
     }
 }
 
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_WriteBehindEnable
+    (
+        uint8_t volNumber,
+        bool enable
+    );
+
+  Summary:
+    Enables or disables write-behind on the media of a volume.
+
+  Description:
+    Enabling write-behind clears any stale error. Disabling it first waits
+    for every buffered write.
+
+  Remarks:
+    See sys_fs_media_manager.h for usage information.
+***************************************************************************/
+bool SYS_FS_MEDIA_MANAGER_WriteBehindEnable
+(
+    uint8_t volNumber,
+    bool enable
+)
+{
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    SYS_FS_MEDIA *mediaObj = _SYS_FS_MEDIA_MANAGER_VolumeMediaGet (volNumber);
+
+    if ((mediaObj == NULL) || (mediaObj->mediaGeometry->geometryTable[1].blockSize != 512))
+    {
+        return false;
+    }
+
+    if (enable == true)
+    {
+        mediaObj->writeBehind.error = false;
+    }
+    else
+    {
+        _SYS_FS_MEDIA_MANAGER_WriteBehindWait (mediaObj, 0);
+    }
+
+    mediaObj->writeBehind.enabled = enable;
+
+    return true;
+#else
+    (void)volNumber;
+    (void)enable;
+
+    return false;
+#endif
+}
+
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_WriteBehindFlush
+    (
+        uint8_t volNumber
+    );
+
+  Summary:
+    Waits for the buffered writes of a volume's media to finish.
+
+  Description:
+    This function drains the write-behind slots, then reports and clears the
+    write-behind error.
+
+  Remarks:
+    See sys_fs_media_manager.h for usage information.
+***************************************************************************/
+bool SYS_FS_MEDIA_MANAGER_WriteBehindFlush
+(
+    uint8_t volNumber
+)
+{
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    SYS_FS_MEDIA *mediaObj = NULL;
+    bool error = false;
+
+    if (volNumber >= SYS_FS_VOLUME_NUMBER)
+    {
+        SYS_ASSERT(false, "Invalid Volume");
+        return false;
+    }
+
+    mediaObj = gSYSFSMediaManagerObj.volumeObj[volNumber].obj;
+    if (mediaObj == NULL)
+    {
+        return true;
+    }
+
+    /* A detached media has already dropped its slots and set the error. */
+    _SYS_FS_MEDIA_MANAGER_WriteBehindWait (mediaObj, 0);
+
+    error = mediaObj->writeBehind.error;
+    mediaObj->writeBehind.error = false;
+
+    return (error == false);
+#else
+    (void)volNumber;
+
+    return true;
+#endif
+}
+
+//*****************************************************************************
+/* Function:
+    bool SYS_FS_MEDIA_MANAGER_WriteBehindTasks
+    (
+        uint8_t volNumber
+    );
+
+  Summary:
+    Lets the buffered writes of a volume's media make progress.
+
+  Description:
+    This function runs the media driver task once if writes are buffered.
+
+  Remarks:
+    See sys_fs_media_manager.h for usage information.
+***************************************************************************/
+bool SYS_FS_MEDIA_MANAGER_WriteBehindTasks
+(
+    uint8_t volNumber
+)
+{
+#if defined(SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS)
+    SYS_FS_MEDIA *mediaObj = _SYS_FS_MEDIA_MANAGER_VolumeMediaGet (volNumber);
+
+    if (mediaObj == NULL)
+    {
+        return false;
+    }
+
+    if (mediaObj->writeBehind.count > 0)
+    {
+        _SYS_FS_MEDIA_MANAGER_WriteBehindIssue (mediaObj);
+
+        if(mediaObj->driverFunctions->tasks != NULL)
+        {
+            mediaObj->driverFunctions->tasks(mediaObj->driverObj);
+        }
+    }
+
+    return (mediaObj->writeBehind.error == false);
+#else
+    (void)volNumber;
+
+    return true;
+#endif
+}
+
 /*************************************************************************
 * END OF sys_fs_media_manager.c
 ***************************************************************************/
@@ -579,6 +579,12 @@ typedef struct
     /* Function pointer of native file system to get total sectors and free
      * sectors */
     int(*getCluster)(const char *path, uint32_t *tot_sec, uint32_t *free_sec);
+    /* Function pointer of native file system to allocate a contiguous block
+     * of clusters to a file */
+    int(*expand)(uintptr_t handle, uint32_t size);
+    /* Function pointer of native file system to build a cluster link map and
+     * enable fast seek on a file */
+    int(*fastSeek)(uintptr_t handle, uint32_t *linkMap, uint32_t length);
 } SYS_FS_FUNCTIONS;
 
 // *****************************************************************************
@@ -2853,6 +2859,273 @@ SYS_FS_RESULT SYS_FS_FileSync
     SYS_FS_HANDLE handle
 );
 
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileExpand
+    (
+        SYS_FS_HANDLE handle,
+        uint32_t size
+    );
+
+    Summary:
+      Allocates a contiguous block of clusters to a file.
+
+    Description:
+      This function allocates a contiguous run of clusters to an empty file,
+      sets the file size to the requested value and leaves the file read/write
+      pointer at the top of the file.  Subsequent writes that stay within the
+      allocated size overwrite the pre-allocated clusters in place, so the
+      native file system does not need to grow the cluster chain or update the
+      allocation table while the file is being written.
+
+    Precondition:
+      A valid file handle has to be passed as input to the function. The file
+      has to be opened in a mode where writes to file is possible and the file
+      has to be empty (such as write mode).
+
+    Parameters:
+      handle - A valid handle which was obtained while opening the file.
+
+      size   - Size, in bytes, to be allocated to the file.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - File expand operation was successful.
+      SYS_FS_RES_FAILURE - File expand operation was unsuccessful. The reason
+                           for the failure can be retrieved with SYS_FS_Error
+                           or SYS_FS_FileError.  SYS_FS_ERROR_DENIED indicates
+                           that no contiguous free area of the requested size
+                           exists on the volume.
+
+    Example:
+      <code>
+        SYS_FS_HANDLE fileHandle;
+        size_t nbytes;
+
+        fileHandle = SYS_FS_FileOpen("/mnt/myDrive/FILE.bin",
+                (SYS_FS_FILE_OPEN_WRITE));
+
+        if(fileHandle != SYS_FS_HANDLE_INVALID)
+        {
+            // File open is successful
+        }
+
+        if(SYS_FS_FileExpand(fileHandle, 0x100000) != SYS_FS_RES_SUCCESS)
+        {
+            // Not enough contiguous space on the volume.
+        }
+
+        // Write the file content
+        nbytes = SYS_FS_FileWrite(fileHandle, buf, sizeof(buf));
+
+        SYS_FS_FileClose(fileHandle);
+
+      </code>
+
+    Remarks:
+      The native file system must support contiguous allocation (for FAT FS,
+      FF_USE_EXPAND must be enabled), otherwise the function fails with
+      SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS.
+*/
+
+SYS_FS_RESULT SYS_FS_FileExpand
+(
+    SYS_FS_HANDLE handle,
+    uint32_t size
+);
+
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileFastSeekEnable
+    (
+        SYS_FS_HANDLE handle,
+        uint32_t *linkMap,
+        uint32_t linkMapLength
+    );
+
+    Summary:
+      Enables fast seek mode on an open file.
+
+    Description:
+      This function walks the cluster chain of the file once and records each
+      contiguous fragment in the cluster link map supplied by the caller.
+      Subsequent calls to SYS_FS_FileSeek and SYS_FS_FileRead locate clusters
+      through the link map rather than by following the allocation table from
+      the start of the file, so a seek to any offset costs no card reads other
+      than the one for the target sector itself.
+
+      The link map needs two entries per fragment plus two more.  If the
+      supplied map is too small, the function fails with
+      SYS_FS_ERROR_NOT_ENOUGH_CORE, linkMap[0] holds the required length and
+      the file continues to use normal (chain walking) seeks.
+
+    Precondition:
+      A valid file handle has to be passed as input to the function. The file
+      should not grow while fast seek mode is enabled (such as read mode).
+
+    Parameters:
+      handle        - A valid handle which was obtained while opening the file.
+
+      linkMap       - Storage for the cluster link map.  It must remain valid
+                      until the file is closed.
+
+      linkMapLength - Number of uint32_t entries in linkMap.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - Fast seek mode is enabled.
+      SYS_FS_RES_FAILURE - Fast seek mode could not be enabled. The reason
+                           for the failure can be retrieved with SYS_FS_Error
+                           or SYS_FS_FileError.
+
+    Example:
+      <code>
+        SYS_FS_HANDLE fileHandle;
+        uint32_t linkMap[32];
+
+        fileHandle = SYS_FS_FileOpen("/mnt/myDrive/FILE.bin",
+                (SYS_FS_FILE_OPEN_READ));
+
+        if(fileHandle != SYS_FS_HANDLE_INVALID)
+        {
+            // File open is successful
+        }
+
+        if(SYS_FS_FileFastSeekEnable(fileHandle, linkMap, 32) != SYS_FS_RES_SUCCESS)
+        {
+            // File is too fragmented for linkMap, seeks walk the chain.
+        }
+
+        SYS_FS_FileSeek(fileHandle, 0x9000, SYS_FS_SEEK_SET);
+
+        SYS_FS_FileClose(fileHandle);
+
+      </code>
+
+    Remarks:
+      The native file system must support fast seek (for FAT FS,
+      FF_USE_FASTSEEK must be enabled), otherwise the function fails with
+      SYS_FS_ERROR_NOT_SUPPORTED_IN_NATIVE_FS.
+*/
+
+SYS_FS_RESULT SYS_FS_FileFastSeekEnable
+(
+    SYS_FS_HANDLE handle,
+    uint32_t *linkMap,
+    uint32_t linkMapLength
+);
+
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileWriteBehindEnable
+    (
+        SYS_FS_HANDLE handle,
+        bool enable
+    );
+
+    Summary:
+      Enables or disables write-behind for an open file.
+
+    Description:
+      While write-behind is enabled, the sector writes that SYS_FS_FileWrite
+      makes on the media of the file are copied into RAM and return at once.
+      Up to SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS sectors are buffered; the media
+      manager writes them to the media in order while the application goes on
+      with its next step, and a write only waits when the buffer is full.
+
+      An error from a buffered write is returned by the next write to the
+      media and, in any case, by SYS_FS_FileClose, which waits for every
+      buffered write before it returns.
+
+    Precondition:
+      A valid file handle has to be passed as input to the function.
+
+    Parameters:
+      handle - A valid handle which was obtained while opening the file.
+
+      enable - true to enable write-behind. false waits for the buffered
+               writes and disables it.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - Write-behind mode was changed.
+      SYS_FS_RES_FAILURE - Write-behind is not available for the media (or
+                           SYS_FS_MEDIA_WRITE_BEHIND_BLOCKS is not
+                           configured), or a buffered write failed while
+                           disabling it. The reason for the failure can be
+                           retrieved with SYS_FS_FileError.
+
+    Example:
+      <code>
+        SYS_FS_HANDLE fileHandle;
+        uint8_t buffer[4096];
+
+        fileHandle = SYS_FS_FileOpen("/mnt/myDrive/FILE.bin",
+                (SYS_FS_FILE_OPEN_WRITE));
+
+        if(fileHandle != SYS_FS_HANDLE_INVALID)
+        {
+            // File open is successful
+        }
+
+        SYS_FS_FileWriteBehindEnable(fileHandle, true);
+
+        while(ProduceData(buffer, sizeof(buffer)))
+        {
+            SYS_FS_FileWrite(fileHandle, buffer, sizeof(buffer));
+        }
+
+        if(SYS_FS_FileClose(fileHandle) != SYS_FS_RES_SUCCESS)
+        {
+            // Some of the data did not reach the media.
+        }
+
+      </code>
+
+    Remarks:
+      The media driver only makes progress when it runs. An application that
+      holds the main loop while it produces data should call
+      SYS_FS_FileWriteBehindTasks between its own steps.
+*/
+
+SYS_FS_RESULT SYS_FS_FileWriteBehindEnable
+(
+    SYS_FS_HANDLE handle,
+    bool enable
+);
+
+//******************************************************************************
+/* Function:
+    SYS_FS_RESULT SYS_FS_FileWriteBehindTasks
+    (
+        SYS_FS_HANDLE handle
+    );
+
+    Summary:
+      Lets the buffered writes of a file make progress.
+
+    Description:
+      This function runs the media driver of the file once if the file has
+      writes buffered by write-behind.  It does not wait for them.
+
+    Precondition:
+      A valid file handle has to be passed as input to the function.
+
+    Parameters:
+      handle - A valid handle which was obtained while opening the file.
+
+    Returns:
+      SYS_FS_RES_SUCCESS - No buffered write has failed so far (or the file
+                           does not use write-behind).
+      SYS_FS_RES_FAILURE - A buffered write has failed. SYS_FS_FileError
+                           returns SYS_FS_ERROR_DISK_ERR.
+
+    Remarks:
+      None.
+*/
+
+SYS_FS_RESULT SYS_FS_FileWriteBehindTasks
+(
+    SYS_FS_HANDLE handle
+);
+
 //******************************************************************************
 /* Function:
     SYS_FS_RESULT SYS_FS_FileStringPut
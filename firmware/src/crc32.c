@@ -0,0 +1,72 @@
+/**
+ * @file crc32.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+
+// *****************************************************************************
+// Includes
+
+#include "crc32.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+// *****************************************************************************
+// Private (static) storage
+
+// nibble-wide table: 64 bytes of flash, fast enough to keep up with the SD.
+static const uint32_t s_crc32_nibble[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4,
+    0x4db26158, 0x5005713c, 0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+
+// *****************************************************************************
+// Public code
+
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t n_bytes) {
+  const uint8_t *p = (const uint8_t *)buf;
+
+  crc = ~crc;
+  while (n_bytes--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ s_crc32_nibble[crc & 0x0f];
+    crc = (crc >> 4) ^ s_crc32_nibble[crc & 0x0f];
+  }
+  return ~crc;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+// *****************************************************************************
+// End of file
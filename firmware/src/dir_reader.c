@@ -31,19 +31,55 @@
 #include "dir_reader.h"
 
 #include "app.h"
+#include "crc32.h"
 #include "definitions.h"
+#include "m2m_types.h"
+#include "spi_flash_map.h"
+#include "winc_image.h"
+#include <ctype.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 // *****************************************************************************
 // Private types and definitions
 
-#define MAX_FILENAME_LENGTH 80
-#define MAX_IMG_FILENAMES 20
+#define MAX_FILENAME_LENGTH 80 // longest path name, including the NUL
+
+// At 16 bytes per image plus its path name, the defaults hold 192 images with
+// path names such as "product/v19_7_7.wimg" (20 characters) in 7 KB: 3 KB of
+// entries and a 4 KB name pool.  The pool can't grow past 4 KB (see
+// dir_reader_image_t), so to catalog more images, shorten their names.
+#define MAX_IMAGES 192
+#define NAME_POOL_SIZE 4096
 
 #define IMAGE_EXTENSION ".wimg"
 
+// Files larger than the biggest WINC flash can't be images: don't scan them.
+#define MAX_IMAGE_SIZE (1024 * 1024UL)
+
+// Bytes read from an image per call to dir_reader_step() while scanning.
+// One sector, so that each chunk yields one fingerprint for the manifest.
+#define SCAN_CHUNK_SZ FLASH_SECTOR_SZ
+
+// Sector fingerprints kept for dir_reader_manifest_ref(), at 2 bytes per
+// sector: the default holds the manifests of 32 1 MB images in 16 KB.  Images
+// scanned once it is full have no manifest.
+#define MANIFEST_POOL_SIZE 8192
+
+// Manifests the pool can list: enough to fill it with images for a 4 Mb WINC
+// flash (512 KB).
+#define MAX_MANIFESTS 64
+
+// An image whose scan is over, one way or the other.
+#define IMAGE_SCAN_DONE (DIR_READER_IMAGE_SCANNED | DIR_READER_IMAGE_SKIPPED)
+
+// Set on entries found by the directory walk in progress.  Entries left
+// without it when the walk completes have been removed from the card.
+#define IMAGE_SEEN 0x08
+
 #define STATES(M)                                                              \
   M(DIR_READER_STATE_IDLE)                                                     \
   M(DIR_READER_STATE_OPENING_DIRECTORY)                                        \
@@ -55,12 +91,42 @@
 #define EXPAND_STATE_IDS(_name) _name,
 typedef enum { STATES(EXPAND_STATE_IDS) } dir_reader_state_t;
 
+/**
+ * @brief Where to find the manifest of the images with a given digest.
+ */
+typedef struct {
+  uint32_t digest;    // CRC-32 of the image file
+  uint16_t offset;    // first fingerprint in s_manifest_pool
+  uint16_t n_sectors; // number of fingerprints
+} manifest_t;
+
 typedef struct {
   dir_reader_state_t state;
   dir_reader_callback_fn callback_fn;
   uintptr_t callback_arg;
   SYS_FS_HANDLE dir_handle;
-  uint8_t file_count; // # of .img files found
+  uint16_t file_count;    // # of .wimg files in the catalog
+  uint16_t dropped_count; // # of .wimg files that didn't fit
+  uint16_t pool_used;     // image names fill the pool from the bottom...
+  uint16_t pool_top;      // ...and sub-directories to visit from the top.
+  const char *subdir;     // sub-directory being read, NULL for root
+  dir_reader_sort_t sort;
+  bool has_signature;      // true if the catalog matches the signature below
+  uint32_t signature;      // of the directory walk that built the catalog
+  uint32_t walk_signature; // of the directory walk in progress
+  SYS_FS_HANDLE scan_handle; // image being scanned in the background
+  uint16_t scan_idx;         // index of the image being scanned
+  uint32_t scan_offset;      // bytes of the image scanned so far
+  bool scan_is_paused;       // scan_idx was closed part way, at scan_offset
+  uint32_t scan_crc;         // running CRC-32 of the image
+  uint8_t scan_flags;        // DIR_READER_IMAGE_HAS_VERSION, once found
+  uint16_t scan_version;     // fw_version, valid with scan_flags
+  bool scan_has_control;     // a valid control sector has been read
+  uint32_t scan_rev_image;   // offset of the OTA image that runs
+  uint32_t scan_rev_window;  // offset of its version records, 0 if unknown
+  bool scan_manifest;        // fingerprints are going to s_manifest_pool
+  uint16_t manifest_count;   // # of entries in s_manifests
+  uint16_t manifest_used;    // # of fingerprints in s_manifest_pool
 } dir_reader_ctx_t;
 
 // *****************************************************************************
@@ -84,9 +150,100 @@ static void endgame(dir_reader_state_t final_state);
 /**
  * @brief Return true if the last chars of str equal suffix.
  */
-__attribute__((unused))
 static bool string_ends_with(const char *str, const char *suffix);
 
+/**
+ * @brief Start the signature of a directory walk with the volume's serial
+ * number, so that swapping cards changes it.
+ */
+static void signature_start(void);
+
+/**
+ * @brief Fold an image's path name, size and modification time into the
+ * signature of the directory walk in progress.
+ */
+static void signature_add(const char *path, const dir_reader_image_t *image);
+
+/**
+ * @brief Return true if path names the same file as the cataloged name, in
+ * any case and with or without the mount name in front.
+ */
+static bool paths_match(const char *path, const char *name);
+
+/**
+ * @brief Open the directory at the top of the sub-directory stack, or the
+ * root directory if subdir is NULL.
+ */
+static void open_directory(const char *subdir);
+
+/**
+ * @brief Push the name of a sub-directory to visit once the root is read.
+ */
+static void push_subdir(const char *name);
+
+/**
+ * @brief Add or refresh the catalog entry for an image found in the current
+ * directory, keeping the scan results if the file is unchanged.
+ */
+static void catalog_add(SYS_FS_FSTAT *stat);
+
+/**
+ * @brief Drop the entries not seen by the last directory walk, squeeze their
+ * names out of the pool and re-sort.
+ */
+static void catalog_compact(void);
+
+/**
+ * @brief qsort() comparison functions.
+ */
+static int compare_offsets(const void *a, const void *b);
+static int compare_names(const void *a, const void *b);
+static int compare_versions(const void *a, const void *b);
+
+/**
+ * @brief Scan one chunk of the next image that has not been scanned yet.
+ */
+static void scan_step(void);
+
+/**
+ * @brief Follow the control sector to the OTA image that runs, and note the
+ * firmware version in that image's version record, as winc_cloner_probe()
+ * reads it from the WINC.  The version goes into the image's entry when the
+ * scan completes.
+ *
+ * NOTE: offset must fall on a FLASH_SECTOR_SZ boundary.
+ */
+static void scan_versions(const uint8_t *buf, uint32_t offset, size_t n_bytes);
+
+/**
+ * @brief Start the scan of an image from its first byte.
+ */
+static void scan_start(const dir_reader_image_t *image);
+
+/**
+ * @brief Close the scanned image and record its final flags.  Until then, the
+ * entry's flags show its scan as not done, so that a scan interrupted by
+ * dir_reader_pause() picks up the same image again.
+ */
+static void scan_finish(uint8_t flags);
+
+/**
+ * @brief Return the manifest of the images whose digest is digest, or NULL.
+ */
+static const manifest_t *manifest_find(uint32_t digest);
+
+/**
+ * @brief Keep the fingerprints of the image just scanned, unless an identical
+ * image already has a manifest.
+ */
+static void manifest_add(uint32_t digest, uint16_t n_sectors);
+
+/**
+ * @brief Drop the manifests that no scanned image uses any longer and squeeze
+ * their fingerprints out of the pool.
+ */
+static void manifest_compact(void);
+
 // *****************************************************************************
 // Private (static) storage
 
@@ -95,10 +252,29 @@ static const char *s_state_names[] = {STATES(EXPAND_STATE_NAMES)};
 
 #define N_STATES (sizeof(s_state_names) / sizeof(s_state_names[0]))
 
-char s_filenames[MAX_IMG_FILENAMES * MAX_FILENAME_LENGTH];
+_Static_assert(NAME_POOL_SIZE <= 4096, "name_offset is 12 bits");
+
+_Static_assert(sizeof(dir_reader_image_t) == 16, "catalog entries grew");
+
+static char s_name_pool[NAME_POOL_SIZE];
+
+static dir_reader_image_t s_images[MAX_IMAGES];
 
 char s_filename[MAX_FILENAME_LENGTH]; // to hold stat's long file names
 
+static char s_dir_path[MAX_FILENAME_LENGTH]; // directory being read
+
+static char s_path[MAX_FILENAME_LENGTH]; // "subdir/filename"
+
+static uint8_t s_scan_buf[SCAN_CHUNK_SZ] __attribute__((aligned(32)));
+
+// The version records of the image being scanned, which may span two chunks.
+static uint8_t s_rev_window[WINC_IMAGE_REV_WINDOW_SZ];
+
+static uint16_t s_manifest_pool[MANIFEST_POOL_SIZE];
+
+static manifest_t s_manifests[MAX_MANIFESTS];
+
 static dir_reader_ctx_t s_dir_reader_ctx;
 
 // *****************************************************************************
@@ -107,6 +283,14 @@ static dir_reader_ctx_t s_dir_reader_ctx;
 void dir_reader_init(void) {
   s_dir_reader_ctx.state = DIR_READER_STATE_IDLE;
   s_dir_reader_ctx.dir_handle = SYS_FS_HANDLE_INVALID;
+  s_dir_reader_ctx.scan_handle = SYS_FS_HANDLE_INVALID;
+  s_dir_reader_ctx.scan_is_paused = false;
+  s_dir_reader_ctx.file_count = 0;
+  s_dir_reader_ctx.pool_used = 0;
+  s_dir_reader_ctx.manifest_count = 0;
+  s_dir_reader_ctx.manifest_used = 0;
+  s_dir_reader_ctx.sort = DIR_READER_SORT_BY_NAME;
+  s_dir_reader_ctx.has_signature = false;
 }
 
 /**
@@ -119,22 +303,19 @@ void dir_reader_step(void) {
   } break;
 
   case DIR_READER_STATE_OPENING_DIRECTORY: {
-    // here when dirlist_read_directory() has been called.
-    s_dir_reader_ctx.file_count = 0;
-    memset(s_filenames, 0, sizeof(s_filenames));
-
-    s_dir_reader_ctx.dir_handle = SYS_FS_DirOpen(SD_MOUNT_NAME "/");
-    if (s_dir_reader_ctx.dir_handle != SYS_FS_HANDLE_INVALID) {
-      set_state(DIR_READER_STATE_READING_DIRECTORY);
-    } else {
-      SYS_DEBUG_PRINT(
-          SYS_ERROR_ERROR, "\nUnable to open directory %s", SD_MOUNT_NAME "/");
-      endgame(DIR_READER_STATE_ERROR);
+    // here when dirlist_read_directory() has been called.  Existing entries
+    // stay put so that unchanged images keep their scan results.
+    for (uint16_t i = 0; i < s_dir_reader_ctx.file_count; i++) {
+      s_images[i].flags &= ~IMAGE_SEEN;
     }
+    signature_start();
+    s_dir_reader_ctx.dropped_count = 0;
+    s_dir_reader_ctx.pool_top = NAME_POOL_SIZE;
+    open_directory(NULL);
   } break;
 
   case DIR_READER_STATE_READING_DIRECTORY: {
-    // remain in this state until all directory entries are read and printed
+    // remain in this state until all directory entries are read
     SYS_FS_FSTAT stat;
     stat.lfname = s_filename;
     stat.lfsize = sizeof(s_filename);
@@ -142,35 +323,72 @@ void dir_reader_step(void) {
     if (SYS_FS_DirRead(s_dir_reader_ctx.dir_handle, &stat) ==
         SYS_FS_RES_FAILURE) {
       SYS_DEBUG_PRINT(
-          SYS_ERROR_ERROR, "\nUnable to read directory %s", SD_MOUNT_NAME "/");
+          SYS_ERROR_ERROR, "\nUnable to read directory %s", s_dir_path);
+      SYS_FS_DirClose(s_dir_reader_ctx.dir_handle);
+      s_dir_reader_ctx.dir_handle = SYS_FS_HANDLE_INVALID;
+      s_dir_reader_ctx.has_signature = false;
+      catalog_compact();
       endgame(DIR_READER_STATE_ERROR);
 
     } else if ((stat.lfname[0] == '\0') && (stat.fname[0] == '\0')) {
       set_state(DIR_READER_STATE_CLOSING_DIRECTORY);
 
-    } else if (s_dir_reader_ctx.file_count >= MAX_IMG_FILENAMES) {
-        SYS_DEBUG_PRINT(
-            SYS_ERROR_ERROR, "\ndirectory full, skipping %s", stat.fname);
+    } else if (stat.fattrib & SYS_FS_ATTR_DIR) {
+      // only the root's sub-directories are searched, and only one deep.
+      if ((s_dir_reader_ctx.subdir == NULL) && (stat.fname[0] != '.')) {
+        push_subdir(stat.fname);
+      }
+
+    } else if (string_ends_with(stat.fname, IMAGE_EXTENSION)) {
+      catalog_add(&stat);
+
     } else {
-      // read succeeded.  Record it.
-      strncpy((char *)dir_reader_filename_ref(s_dir_reader_ctx.file_count++),
-              (const char *)stat.fname,
-              MAX_FILENAME_LENGTH);
+      // not an image: skip it.
     }
     // remain in this state to read more filenames
   } break;
 
   case DIR_READER_STATE_CLOSING_DIRECTORY: {
-    if (SYS_FS_DirClose(s_dir_reader_ctx.dir_handle) != SYS_FS_RES_SUCCESS) {
+    if ((s_dir_reader_ctx.dir_handle != SYS_FS_HANDLE_INVALID) &&
+        (SYS_FS_DirClose(s_dir_reader_ctx.dir_handle) != SYS_FS_RES_SUCCESS)) {
       SYS_DEBUG_PRINT(
-          SYS_ERROR_ERROR, "\nClosing directory %s failed", SD_MOUNT_NAME "/");
+          SYS_ERROR_ERROR, "\nClosing directory %s failed", s_dir_path);
     }
     s_dir_reader_ctx.dir_handle = SYS_FS_HANDLE_INVALID;
-    endgame(DIR_READER_STATE_COMPLETE);
+
+    if (s_dir_reader_ctx.subdir != NULL) {
+      // done with this sub-directory: pop it.
+      s_dir_reader_ctx.pool_top += strlen(s_dir_reader_ctx.subdir) + 1;
+    }
+    if (s_dir_reader_ctx.pool_top < NAME_POOL_SIZE) {
+      open_directory(&s_name_pool[s_dir_reader_ctx.pool_top]);
+    } else if (s_dir_reader_ctx.has_signature &&
+               (s_dir_reader_ctx.walk_signature ==
+                s_dir_reader_ctx.signature)) {
+      // every image has the same name, size and time as before: the catalog
+      // is still good, and so is the order of its entries.
+      for (uint16_t i = 0; i < s_dir_reader_ctx.file_count; i++) {
+        s_images[i].flags &= ~IMAGE_SEEN;
+      }
+      endgame(DIR_READER_STATE_COMPLETE);
+    } else {
+      catalog_compact();
+      if (s_dir_reader_ctx.dropped_count > 0) {
+        SYS_DEBUG_PRINT(SYS_ERROR_WARNING,
+                        "\nCatalog full, %d images left out",
+                        s_dir_reader_ctx.dropped_count);
+      }
+      s_dir_reader_ctx.signature = s_dir_reader_ctx.walk_signature;
+      s_dir_reader_ctx.has_signature = true;
+      s_dir_reader_ctx.scan_idx = 0;
+      endgame(DIR_READER_STATE_COMPLETE);
+    }
   } break;
 
   case DIR_READER_STATE_COMPLETE: {
-    // here on error state
+    // listing is complete: fill in image versions and digests in the
+    // background.
+    scan_step();
   } break;
 
   case DIR_READER_STATE_ERROR: {
@@ -186,19 +404,108 @@ void dir_reader_set_callback(dir_reader_callback_fn callback_fn,
 }
 
 void dir_reader_read_directory(void) {
+  dir_reader_pause();
   set_state(DIR_READER_STATE_OPENING_DIRECTORY);
 }
 
-uint8_t dir_reader_filename_count(void) { return s_dir_reader_ctx.file_count; }
+void dir_reader_invalidate(const char *path) {
+  uint16_t idx;
+
+  if (dir_reader_find(path, &idx)) {
+    s_images[idx].flags = 0; // scan it again.
+    if (idx == s_dir_reader_ctx.scan_idx) {
+      dir_reader_pause();
+      s_dir_reader_ctx.scan_is_paused = false; // from the start.
+    }
+  }
+  s_dir_reader_ctx.has_signature = false;
+}
+
+void dir_reader_pause(void) {
+  if (s_dir_reader_ctx.scan_handle != SYS_FS_HANDLE_INVALID) {
+    SYS_FS_FileClose(s_dir_reader_ctx.scan_handle);
+    s_dir_reader_ctx.scan_handle = SYS_FS_HANDLE_INVALID;
+    s_dir_reader_ctx.scan_is_paused = true;
+  }
+}
+
+void dir_reader_sort(dir_reader_sort_t sort) {
+  SYS_ASSERT(sort < DIR_READER_SORT_COUNT, "dir_reader_sort_t out of bounds");
+  // entries are about to move: restart the scan from the first unscanned one.
+  dir_reader_pause();
+  s_dir_reader_ctx.scan_is_paused = false;
+  s_dir_reader_ctx.scan_idx = 0;
+  s_dir_reader_ctx.sort = sort;
+  qsort(s_images,
+        s_dir_reader_ctx.file_count,
+        sizeof(dir_reader_image_t),
+        (sort == DIR_READER_SORT_BY_VERSION) ? compare_versions
+                                             : compare_names);
+}
+
+dir_reader_sort_t dir_reader_get_sort(void) { return s_dir_reader_ctx.sort; }
+
+uint16_t dir_reader_filename_count(void) {
+  return s_dir_reader_ctx.file_count;
+}
+
+uint16_t dir_reader_dropped_count(void) {
+  return s_dir_reader_ctx.dropped_count;
+}
+
+const char *dir_reader_filename_ref(uint16_t idx) {
+  if (idx < s_dir_reader_ctx.file_count) {
+    return &s_name_pool[s_images[idx].name_offset];
+  } else {
+    return NULL;
+  }
+}
+
+bool dir_reader_find(const char *path, uint16_t *idx) {
+  for (uint16_t i = 0; i < s_dir_reader_ctx.file_count; i++) {
+    if (paths_match(path, &s_name_pool[s_images[i].name_offset])) {
+      *idx = i;
+      return true;
+    }
+  }
+  return false;
+}
 
-const char *dir_reader_filename_ref(uint8_t idx) {
+const dir_reader_image_t *dir_reader_image_ref(uint16_t idx) {
   if (idx < s_dir_reader_ctx.file_count) {
-    return &s_filenames[idx * MAX_FILENAME_LENGTH];
+    return &s_images[idx];
   } else {
     return NULL;
   }
 }
 
+const uint16_t *dir_reader_manifest_ref(uint16_t idx, uint16_t *n_sectors) {
+  const manifest_t *manifest;
+
+  if ((idx >= s_dir_reader_ctx.file_count) ||
+      !(s_images[idx].flags & DIR_READER_IMAGE_SCANNED)) {
+    return NULL;
+  }
+  manifest = manifest_find(s_images[idx].digest);
+  if (manifest == NULL) {
+    return NULL;
+  }
+  *n_sectors = manifest->n_sectors;
+  return &s_manifest_pool[manifest->offset];
+}
+
+bool dir_reader_scan_is_complete(void) {
+  if (!dir_reader_is_complete()) {
+    return false;
+  }
+  for (uint16_t i = 0; i < s_dir_reader_ctx.file_count; i++) {
+    if (!(s_images[i].flags & IMAGE_SCAN_DONE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool dir_reader_is_idle(void) {
   return s_dir_reader_ctx.state == DIR_READER_STATE_IDLE;
 }
@@ -236,7 +543,6 @@ static void endgame(dir_reader_state_t final_state) {
   }
 }
 
-__attribute__((unused))
 static bool string_ends_with(const char *str, const char *suffix) {
   if (str == NULL) {
     return false;
@@ -253,5 +559,368 @@ static bool string_ends_with(const char *str, const char *suffix) {
   }
 }
 
+static void signature_start(void) {
+  char label[12]; // FatFs writes up to 11 chars plus NUL
+  uint32_t serial_number = 0;
+
+  // The label entry sits at the head of the root directory, which the walk
+  // reads next anyway.
+  SYS_FS_DriveLabelGet(SD_MOUNT_NAME, label, &serial_number);
+  s_dir_reader_ctx.walk_signature =
+      crc32_update(0, &serial_number, sizeof(serial_number));
+}
+
+static void signature_add(const char *path, const dir_reader_image_t *image) {
+  uint32_t crc = s_dir_reader_ctx.walk_signature;
+
+  // Overwriting or renaming an image on a PC leaves the free space as it was
+  // (images for a given flash are all the same size), but not the names and
+  // times of the directory entries.
+  crc = crc32_update(crc, path, strlen(path) + 1);
+  crc = crc32_update(crc, &image->size, sizeof(image->size));
+  crc = crc32_update(crc, &image->stamp, sizeof(image->stamp));
+  s_dir_reader_ctx.walk_signature = crc;
+}
+
+static bool paths_match(const char *path, const char *name) {
+  size_t mount_len = strlen(SD_MOUNT_NAME);
+
+  if (strncmp(path, SD_MOUNT_NAME, mount_len) == 0) {
+    path += mount_len;
+  }
+  while (*path == '/') {
+    path++;
+  }
+  // FAT names are case-insensitive.
+  while ((*path != '\0') && (tolower((unsigned char)*path) ==
+                              tolower((unsigned char)*name))) {
+    path++;
+    name++;
+  }
+  return (*path == '\0') && (*name == '\0');
+}
+
+static void open_directory(const char *subdir) {
+  s_dir_reader_ctx.subdir = subdir;
+  if (subdir == NULL) {
+    snprintf(s_dir_path, sizeof(s_dir_path), "%s/", SD_MOUNT_NAME);
+  } else {
+    snprintf(s_dir_path, sizeof(s_dir_path), "%s/%s", SD_MOUNT_NAME, subdir);
+  }
+
+  s_dir_reader_ctx.dir_handle = SYS_FS_DirOpen(s_dir_path);
+  if (s_dir_reader_ctx.dir_handle != SYS_FS_HANDLE_INVALID) {
+    set_state(DIR_READER_STATE_READING_DIRECTORY);
+  } else if (subdir != NULL) {
+    // skip an unreadable sub-directory rather than the whole catalog.
+    SYS_DEBUG_PRINT(SYS_ERROR_WARNING, "\nUnable to open directory %s", s_dir_path);
+    set_state(DIR_READER_STATE_CLOSING_DIRECTORY);
+  } else {
+    SYS_DEBUG_PRINT(SYS_ERROR_ERROR, "\nUnable to open directory %s", s_dir_path);
+    s_dir_reader_ctx.has_signature = false;
+    endgame(DIR_READER_STATE_ERROR);
+  }
+}
+
+static void push_subdir(const char *name) {
+  size_t len = strlen(name) + 1;
+
+  if (s_dir_reader_ctx.pool_used + len > s_dir_reader_ctx.pool_top) {
+    SYS_DEBUG_PRINT(SYS_ERROR_WARNING, "\nCatalog full, skipping %s/", name);
+    return;
+  }
+  s_dir_reader_ctx.pool_top -= len;
+  memcpy(&s_name_pool[s_dir_reader_ctx.pool_top], name, len);
+}
+
+static void catalog_add(SYS_FS_FSTAT *stat) {
+  uint32_t stamp = ((uint32_t)stat->fdate << 16) | stat->ftime;
+  dir_reader_image_t *image;
+  int len;
+
+  if (s_dir_reader_ctx.subdir == NULL) {
+    len = snprintf(s_path, sizeof(s_path), "%s", stat->fname);
+  } else {
+    len = snprintf(
+        s_path, sizeof(s_path), "%s/%s", s_dir_reader_ctx.subdir, stat->fname);
+  }
+  if ((len < 0) || (len >= (int)sizeof(s_path))) {
+    SYS_DEBUG_PRINT(SYS_ERROR_WARNING, "\nPath too long, skipping %s", s_path);
+    s_dir_reader_ctx.dropped_count += 1;
+    return;
+  }
+
+  for (uint16_t i = 0; i < s_dir_reader_ctx.file_count; i++) {
+    image = &s_images[i];
+    if (strcmp(&s_name_pool[image->name_offset], s_path) == 0) {
+      if ((image->size != stat->fsize) || (image->stamp != stamp)) {
+        // same name, new contents: scan it again.
+        image->size = stat->fsize;
+        image->stamp = stamp;
+        image->flags = 0;
+      }
+      image->flags |= IMAGE_SEEN;
+      signature_add(s_path, image);
+      return;
+    }
+  }
+
+  if ((s_dir_reader_ctx.file_count >= MAX_IMAGES) ||
+      (s_dir_reader_ctx.pool_used + len + 1 > s_dir_reader_ctx.pool_top)) {
+    s_dir_reader_ctx.dropped_count += 1;
+    return;
+  }
+  image = &s_images[s_dir_reader_ctx.file_count++];
+  memset(image, 0, sizeof(dir_reader_image_t));
+  image->size = stat->fsize;
+  image->stamp = stamp;
+  image->name_offset = s_dir_reader_ctx.pool_used;
+  image->flags = IMAGE_SEEN;
+  signature_add(s_path, image);
+  memcpy(&s_name_pool[s_dir_reader_ctx.pool_used], s_path, len + 1);
+  s_dir_reader_ctx.pool_used += len + 1;
+}
+
+static void catalog_compact(void) {
+  uint16_t count = 0;
+  uint16_t pool_used = 0;
+
+  // Drop entries that weren't seen, then walk the survivors in pool order so
+  // that each name only ever moves down.
+  for (uint16_t i = 0; i < s_dir_reader_ctx.file_count; i++) {
+    if (s_images[i].flags & IMAGE_SEEN) {
+      s_images[count] = s_images[i];
+      s_images[count++].flags &= ~IMAGE_SEEN;
+    }
+  }
+  qsort(s_images, count, sizeof(dir_reader_image_t), compare_offsets);
+  for (uint16_t i = 0; i < count; i++) {
+    const char *name = &s_name_pool[s_images[i].name_offset];
+    size_t len = strlen(name) + 1;
+    memmove(&s_name_pool[pool_used], name, len);
+    s_images[i].name_offset = pool_used;
+    pool_used += len;
+  }
+  s_dir_reader_ctx.file_count = count;
+  s_dir_reader_ctx.pool_used = pool_used;
+  manifest_compact();
+  dir_reader_sort(s_dir_reader_ctx.sort);
+}
+
+static int compare_offsets(const void *a, const void *b) {
+  return (int)((const dir_reader_image_t *)a)->name_offset -
+         (int)((const dir_reader_image_t *)b)->name_offset;
+}
+
+static int compare_names(const void *a, const void *b) {
+  return strcmp(&s_name_pool[((const dir_reader_image_t *)a)->name_offset],
+                &s_name_pool[((const dir_reader_image_t *)b)->name_offset]);
+}
+
+static int compare_versions(const void *a, const void *b) {
+  const dir_reader_image_t *image_a = (const dir_reader_image_t *)a;
+  const dir_reader_image_t *image_b = (const dir_reader_image_t *)b;
+  // images without a known version sort last.
+  int version_a = (image_a->flags & DIR_READER_IMAGE_HAS_VERSION)
+                      ? image_a->fw_version
+                      : -1;
+  int version_b = (image_b->flags & DIR_READER_IMAGE_HAS_VERSION)
+                      ? image_b->fw_version
+                      : -1;
+
+  if (version_a != version_b) {
+    return version_b - version_a;
+  } else {
+    return compare_names(a, b);
+  }
+}
+
+static void scan_step(void) {
+  dir_reader_image_t *image;
+  size_t n_read;
+
+  if (s_dir_reader_ctx.scan_handle == SYS_FS_HANDLE_INVALID) {
+    // find the next image that has not been scanned.
+    while ((s_dir_reader_ctx.scan_idx < s_dir_reader_ctx.file_count) &&
+           (s_images[s_dir_reader_ctx.scan_idx].flags & IMAGE_SCAN_DONE)) {
+      s_dir_reader_ctx.scan_idx += 1;
+    }
+    if (s_dir_reader_ctx.scan_idx >= s_dir_reader_ctx.file_count) {
+      return; // all done.
+    }
+    image = &s_images[s_dir_reader_ctx.scan_idx];
+    if ((image->size == 0) || (image->size > MAX_IMAGE_SIZE)) {
+      image->flags = DIR_READER_IMAGE_SKIPPED;
+      return;
+    }
+    s_dir_reader_ctx.scan_handle =
+        SYS_FS_FileOpen(dir_reader_filename_ref(s_dir_reader_ctx.scan_idx),
+                        SYS_FS_FILE_OPEN_READ);
+    if (s_dir_reader_ctx.scan_handle == SYS_FS_HANDLE_INVALID) {
+      image->flags = DIR_READER_IMAGE_SKIPPED;
+      s_dir_reader_ctx.scan_is_paused = false;
+      return;
+    }
+    if (!s_dir_reader_ctx.scan_is_paused) {
+      scan_start(image);
+    } else if (SYS_FS_FileSeek(s_dir_reader_ctx.scan_handle,
+                               s_dir_reader_ctx.scan_offset,
+                               SYS_FS_SEEK_SET) !=
+               (int32_t)s_dir_reader_ctx.scan_offset) {
+      scan_finish(DIR_READER_IMAGE_SKIPPED);
+      return;
+    }
+    // else pick up where dir_reader_pause() left off.
+    s_dir_reader_ctx.scan_is_paused = false;
+  }
+
+  image = &s_images[s_dir_reader_ctx.scan_idx];
+  n_read = SYS_FS_FileRead(s_dir_reader_ctx.scan_handle,
+                           s_scan_buf,
+                           sizeof(s_scan_buf));
+  if (n_read == (size_t)-1) {
+    scan_finish(DIR_READER_IMAGE_SKIPPED);
+    return;
+  }
+  scan_versions(s_scan_buf, s_dir_reader_ctx.scan_offset, n_read);
+  s_dir_reader_ctx.scan_crc =
+      crc32_update(s_dir_reader_ctx.scan_crc, s_scan_buf, n_read);
+  if (s_dir_reader_ctx.scan_manifest && (n_read == FLASH_SECTOR_SZ)) {
+    s_manifest_pool[s_dir_reader_ctx.manifest_used +
+                    s_dir_reader_ctx.scan_offset / FLASH_SECTOR_SZ] =
+        DIR_READER_FINGERPRINT(crc32_update(0, s_scan_buf, n_read));
+  }
+  s_dir_reader_ctx.scan_offset += n_read;
+
+  if ((n_read < sizeof(s_scan_buf)) ||
+      (s_dir_reader_ctx.scan_offset >= image->size)) {
+    image->digest = s_dir_reader_ctx.scan_crc;
+    if (s_dir_reader_ctx.scan_manifest &&
+        (s_dir_reader_ctx.scan_offset == image->size)) {
+      manifest_add(image->digest, image->size / FLASH_SECTOR_SZ);
+    }
+    image->fw_version = s_dir_reader_ctx.scan_version;
+    scan_finish(s_dir_reader_ctx.scan_flags | DIR_READER_IMAGE_SCANNED);
+  }
+}
+
+static void scan_versions(const uint8_t *buf, uint32_t offset, size_t n_bytes) {
+  uint32_t window = s_dir_reader_ctx.scan_rev_window;
+  tstrOtaControlSec control;
+  winc_image_rev_t rev;
+  uint32_t from;
+  uint32_t to;
+
+  // the control sector, or else its backup, names the image that runs.
+  if (!s_dir_reader_ctx.scan_has_control &&
+      ((offset == M2M_CONTROL_FLASH_OFFSET) ||
+       (offset == M2M_CONTROL_FLASH_BKP_OFFSET)) &&
+      (n_bytes >= sizeof(control))) {
+    memcpy(&control, buf, sizeof(control));
+    if (control.u32OtaMagicValue == OTA_MAGIC_VALUE) {
+      s_dir_reader_ctx.scan_has_control = true;
+      s_dir_reader_ctx.scan_rev_image = control.u32OtaCurrentWorkingImagOffset;
+    }
+  }
+  // that image's boot section header locates its version records...
+  if ((offset == s_dir_reader_ctx.scan_rev_image) &&
+      (n_bytes >= WINC_IMAGE_BOOT_HEADER_SZ)) {
+    window = winc_image_rev_window(buf);
+    window = (window != 0) ? offset + window : 0;
+    s_dir_reader_ctx.scan_rev_window = window;
+  }
+  // ...which get copied as they go by.
+  if ((window == 0) || (offset + n_bytes <= window) ||
+      (offset >= window + WINC_IMAGE_REV_WINDOW_SZ)) {
+    return;
+  }
+  from = (offset > window) ? offset : window;
+  to = offset + n_bytes;
+  if (to > window + WINC_IMAGE_REV_WINDOW_SZ) {
+    to = window + WINC_IMAGE_REV_WINDOW_SZ;
+  }
+  memcpy(&s_rev_window[from - window], &buf[from - offset], to - from);
+  if ((to == window + WINC_IMAGE_REV_WINDOW_SZ) &&
+      winc_image_find_rev(s_rev_window, &rev)) {
+    s_dir_reader_ctx.scan_version = rev.fw_version;
+    s_dir_reader_ctx.scan_flags = DIR_READER_IMAGE_HAS_VERSION;
+  }
+}
+
+static void scan_start(const dir_reader_image_t *image) {
+  s_dir_reader_ctx.scan_offset = 0;
+  s_dir_reader_ctx.scan_crc = 0;
+  s_dir_reader_ctx.scan_flags = 0;
+  s_dir_reader_ctx.scan_has_control = false;
+  s_dir_reader_ctx.scan_rev_image = M2M_OTA_IMAGE1_OFFSET;
+  s_dir_reader_ctx.scan_rev_window = 0;
+  // fingerprint whole sectors only, and only while the pool has room.
+  s_dir_reader_ctx.scan_manifest =
+      ((image->size % FLASH_SECTOR_SZ) == 0) &&
+      (s_dir_reader_ctx.manifest_used + image->size / FLASH_SECTOR_SZ <=
+       MANIFEST_POOL_SIZE);
+}
+
+static void scan_finish(uint8_t flags) {
+  dir_reader_pause();
+  s_dir_reader_ctx.scan_is_paused = false;
+  s_images[s_dir_reader_ctx.scan_idx].flags = flags;
+  s_dir_reader_ctx.scan_idx += 1;
+}
+
+static const manifest_t *manifest_find(uint32_t digest) {
+  for (uint16_t i = 0; i < s_dir_reader_ctx.manifest_count; i++) {
+    if (s_manifests[i].digest == digest) {
+      return &s_manifests[i];
+    }
+  }
+  return NULL;
+}
+
+static void manifest_add(uint32_t digest, uint16_t n_sectors) {
+  manifest_t *manifest;
+
+  if ((manifest_find(digest) != NULL) ||
+      (s_dir_reader_ctx.manifest_count >= MAX_MANIFESTS)) {
+    return; // the fingerprints just written get overwritten by the next scan.
+  }
+  manifest = &s_manifests[s_dir_reader_ctx.manifest_count++];
+  manifest->digest = digest;
+  manifest->offset = s_dir_reader_ctx.manifest_used;
+  manifest->n_sectors = n_sectors;
+  s_dir_reader_ctx.manifest_used += n_sectors;
+}
+
+static void manifest_compact(void) {
+  uint16_t count = 0;
+  uint16_t used = 0;
+
+  // Manifests sit in the pool in the order they were added, so each one only
+  // ever moves down.
+  for (uint16_t i = 0; i < s_dir_reader_ctx.manifest_count; i++) {
+    manifest_t manifest = s_manifests[i];
+    bool in_use = false;
+
+    for (uint16_t j = 0; j < s_dir_reader_ctx.file_count; j++) {
+      if ((s_images[j].flags & DIR_READER_IMAGE_SCANNED) &&
+          (s_images[j].digest == manifest.digest)) {
+        in_use = true;
+        break;
+      }
+    }
+    if (!in_use) {
+      continue;
+    }
+    memmove(&s_manifest_pool[used],
+            &s_manifest_pool[manifest.offset],
+            manifest.n_sectors * sizeof(s_manifest_pool[0]));
+    manifest.offset = used;
+    s_manifests[count++] = manifest;
+    used += manifest.n_sectors;
+  }
+  s_dir_reader_ctx.manifest_count = count;
+  s_dir_reader_ctx.manifest_used = used;
+}
+
 // *****************************************************************************
 // End of file
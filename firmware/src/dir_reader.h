@@ -25,7 +25,23 @@
  */
 
 /**
- * @brief dir_reader lists the available .img files in the root directory.
+ * @brief dir_reader lists the available .wimg files in the root directory and
+ * in its immediate sub-directories (e.g. one per product).
+ *
+ * Image names are kept as paths relative to the root in a packed string pool,
+ * so the number of images the catalog can hold depends on the length of their
+ * names rather than on a fixed number of fixed-length slots.
+ *
+ * The listing is kept as a catalog.  Each dir_reader_read_directory() walks
+ * the directories again, but an image is only scanned again when its name,
+ * size or modification time changes, or after dir_reader_invalidate().  If
+ * none of them has changed, as summed up by a signature of the walk, the
+ * catalog keeps its order as well.  For each image, the catalog also holds
+ * the version of the firmware that runs (read from the active OTA image's
+ * version record, see winc_image.h), a CRC-32 of its contents and a manifest
+ * of 16-bit fingerprints, one per flash sector.  Those are filled in a chunk
+ * at a time by dir_reader_step() once the listing is complete, so the listing
+ * itself is never held up by them.  Identical images share a manifest.
  */
 
 #ifndef _DIR_READER_H_
@@ -53,6 +69,36 @@ extern "C" {
  */
 typedef void (*dir_reader_callback_fn)(uintptr_t arg);
 
+// dir_reader_image_t flags
+#define DIR_READER_IMAGE_SCANNED 0x01     // digest is valid
+#define DIR_READER_IMAGE_HAS_VERSION 0x02 // fw_version is valid
+#define DIR_READER_IMAGE_SKIPPED 0x04     // not a WINC image, or unreadable
+
+// The fingerprint of a FLASH_SECTOR_SZ sector, as dir_reader_manifest_ref()
+// lists them: the low 16 bits of the sector's CRC-32.
+#define DIR_READER_FINGERPRINT(_crc32) ((uint16_t)((_crc32)&0xffff))
+
+/**
+ * @brief Cached information about one image in the catalog (16 bytes).
+ */
+typedef struct {
+  uint32_t size;            // file size in bytes
+  uint32_t digest;          // CRC-32 of the file contents
+  uint32_t stamp;           // FAT modification date << 16 | time
+  uint16_t fw_version;      // see M2M_GET_MAJOR() et al
+  uint16_t name_offset : 12; // private: use dir_reader_filename_ref()
+  uint16_t flags : 4;        // DIR_READER_IMAGE_xxx
+} dir_reader_image_t;
+
+/**
+ * @brief Catalog sort orders.
+ */
+typedef enum {
+  DIR_READER_SORT_BY_NAME,    // path name, ascending
+  DIR_READER_SORT_BY_VERSION, // firmware version, newest first
+  DIR_READER_SORT_COUNT
+} dir_reader_sort_t;
+
 // *****************************************************************************
 // Public declarations
 
@@ -73,26 +119,90 @@ void dir_reader_set_callback(dir_reader_callback_fn callback_fn,
                              uintptr_t callback_arg);
 
 /**
- * @brief Read the rood directory to discover the .img files.
+ * @brief Read the root directory and its immediate sub-directories to
+ * catalog the .wimg files.
+ *
+ * Images whose directory entries are unchanged since the last call keep their
+ * cached version, digest and manifest.
  *
- * Note: this is asynchronous.  The results are avaiable after
+ * Note: this is asynchronous.  The results are available after
  * dir_reader_is_complete() returns true.
  */
 void dir_reader_read_directory(void);
 
 /**
- * @brief Return the number of .img files found in the root directory.
+ * @brief Forget the cached scan of the image at path, if it is cataloged.
+ *
+ * Call this after writing path.  Files written by the firmware all get the
+ * same modification time (there is no clock), so an image overwritten with
+ * one of the same size would otherwise look unchanged.
+ */
+void dir_reader_invalidate(const char *path);
+
+/**
+ * @brief Close the file held open by the background image scan, if any.
+ *
+ * Call this before opening another file.  The next call to dir_reader_step()
+ * opens the image again and picks up its scan where it left off.
+ */
+void dir_reader_pause(void);
+
+/**
+ * @brief Sort the catalog.  The order is kept when the catalog is rebuilt.
+ */
+void dir_reader_sort(dir_reader_sort_t sort);
+
+/**
+ * @brief Return the current sort order.
+ */
+dir_reader_sort_t dir_reader_get_sort(void);
+
+/**
+ * @brief Return the number of .wimg files in the catalog.
+ *
+ * Note: valid only after dir_reader_is_complete() returns true.
+ */
+uint16_t dir_reader_filename_count(void);
+
+/**
+ * @brief Return the number of images that were found but left out of the
+ * catalog because it was full.
+ */
+uint16_t dir_reader_dropped_count(void);
+
+/**
+ * @brief Return the idx'th image path name, or NULL if idx is out of bounds.
  *
  * Note: valid only after dir_reader_is_complete() returns true.
  */
-uint8_t dir_reader_filename_count(void);
+const char *dir_reader_filename_ref(uint16_t idx);
 
 /**
- * @brief Return the idx'th image filename, or NULL if idx is out of bounds.
+ * @brief Find the image at path, as typed at a prompt: in any case, and with
+ * or without the mount name in front.  Set *idx to its index and return true,
+ * or return false if it is not in the catalog.
  *
  * Note: valid only after dir_reader_is_complete() returns true.
  */
-const char *dir_reader_filename_ref(uint8_t idx);
+bool dir_reader_find(const char *path, uint16_t *idx);
+
+/**
+ * @brief Return the cached info for the idx'th image, or NULL if idx is out of
+ * bounds.
+ *
+ * Note: valid only after dir_reader_is_complete() returns true.
+ */
+const dir_reader_image_t *dir_reader_image_ref(uint16_t idx);
+
+/**
+ * @brief Return the manifest of the idx'th image: the fingerprint of each of
+ * its sectors, in address order.  Set *n_sectors to their number.  Return NULL
+ * if the image has not been scanned, is not a whole number of sectors, or
+ * found the manifest pool full.
+ *
+ * Note: valid only after dir_reader_is_complete() returns true.
+ */
+const uint16_t *dir_reader_manifest_ref(uint16_t idx, uint16_t *n_sectors);
 
 /**
  * @brief Return true if the dir_reader is idle.
@@ -104,6 +214,12 @@ bool dir_reader_is_idle(void);
  */
 bool dir_reader_is_complete(void);
 
+/**
+ * @brief Return true if the dir_reader completed and has scanned every image
+ * in the catalog.
+ */
+bool dir_reader_scan_is_complete(void);
+
 /**
  * @brief Return true if the dir_reader has encountered an error.
  */
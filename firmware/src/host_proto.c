@@ -0,0 +1,665 @@
+/**
+ * @file host_proto.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "host_proto.h"
+
+#include "app.h"
+#include "crc32.h"
+#include "definitions.h"
+#include "dir_reader.h"
+#include "progress.h"
+#include "session_log.h"
+#include "spi_flash_map.h"
+#include "winc_cloner.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define HEADER_SZ 6 // sof0, sof1, type, seq, len_lo, len_hi
+#define CRC_SZ 2
+#define MAX_FRAME_SZ (HEADER_SZ + HOST_PROTO_MAX_PAYLOAD + CRC_SZ)
+
+#define STATES(M)                                                              \
+  M(HOST_PROTO_STATE_INACTIVE)                                                 \
+  M(HOST_PROTO_STATE_RUNNING)
+
+#define EXPAND_STATE_IDS(_name) _name,
+typedef enum { STATES(EXPAND_STATE_IDS) } host_proto_state_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t seq;
+  uint32_t size;                      // image size argument, if any
+  char name[HOST_PROTO_MAX_NAME + 1]; // filename argument, if any
+} host_proto_request_t;
+
+typedef struct {
+  host_proto_state_t state;
+  uint8_t rx_buf[MAX_FRAME_SZ]; // frame being received
+  size_t rx_len;
+  host_proto_request_t queue[HOST_PROTO_QUEUE_LEN];
+  uint8_t queue_head; // next request to execute
+  uint8_t queue_count;
+  bool has_last;           // true once a request has been queued
+  uint8_t last_seq;        // seq and type of the last request queued, so a
+  uint8_t last_type;       // resent request (lost ACK) isn't queued twice
+  uint8_t running_seq;     // seq of the request being executed
+  uint32_t n_changed;      // as last reported by progress
+  uint32_t progress_count; // SYS_TIME counter at the last PROGRESS frame
+  uint8_t *stream_dst;      // sector being streamed in, NULL if none wanted
+  uint32_t stream_addr;     // WINC address of that sector
+  uint32_t stream_received; // bytes of it received so far
+  uint8_t stream_round;     // identifies the latest SECTOR frame
+  bool stream_skip;         // host reported the sector unchanged
+  bool stream_gap;          // stream data went missing: ask again
+} host_proto_ctx_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Set the internal state.
+ */
+static void set_state(host_proto_state_t state);
+
+/**
+ * @brief Return the name of the given state.
+ */
+static const char *state_name(host_proto_state_t state);
+
+/**
+ * @brief Feed any bytes waiting on the console into the frame parser.
+ */
+static void rx_poll(void);
+
+/**
+ * @brief Add one byte to the frame being received.
+ */
+static void rx_byte(uint8_t byte);
+
+/**
+ * @brief Validate a complete request frame, queue it and ACK it.
+ */
+static void rx_frame(uint8_t type,
+                     uint8_t seq,
+                     const uint8_t *payload,
+                     size_t len);
+
+/**
+ * @brief Take a stream frame answering the current SECTOR frame.
+ */
+static void rx_stream(uint8_t type,
+                      uint8_t round,
+                      const uint8_t *payload,
+                      size_t len);
+
+/**
+ * @brief Execute a queued request and send its RESULT.
+ */
+static void execute(host_proto_request_t *request);
+
+/**
+ * @brief Send the catalog as ENTRY frames.  Return the number sent.
+ */
+static uint32_t send_catalog(uint8_t seq);
+
+/**
+ * @brief Sector source for HOST_PROTO_CMD_STREAM_UPDATE: fetch one sector of
+ * the image from the host.
+ */
+static winc_cloner_source_result_t
+stream_source(uint32_t addr, const uint8_t *winc_data, uint8_t *dst);
+
+/**
+ * @brief Called by progress while a cloner operation runs.
+ */
+static void on_progress(uint32_t n_done,
+                        uint32_t n_sectors,
+                        uint32_t n_changed);
+
+/**
+ * @brief Frame and send a response.  If wait is false, the frame is dropped
+ * rather than waiting for room in the console's transmit buffer.
+ */
+static bool send_frame(uint8_t type,
+                       uint8_t seq,
+                       const uint8_t *payload,
+                       size_t len,
+                       bool wait);
+
+static void send_result(uint8_t seq,
+                        uint8_t status,
+                        uint32_t value,
+                        const char *text);
+
+static size_t put_u16(uint8_t *dst, uint16_t value);
+static size_t put_u32(uint8_t *dst, uint32_t value);
+static uint32_t get_u32(const uint8_t *src);
+
+/**
+ * @brief Update a running CRC-16/CCITT-FALSE with n_bytes of buf.
+ */
+static uint16_t crc16_update(uint16_t crc, const uint8_t *buf, size_t n_bytes);
+
+// *****************************************************************************
+// Private (static) storage
+
+#define EXPAND_STATE_NAMES(_name) #_name,
+static const char *s_state_names[] = {STATES(EXPAND_STATE_NAMES)};
+
+#define N_STATES (sizeof(s_state_names) / sizeof(s_state_names[0]))
+
+static host_proto_ctx_t s_host_proto_ctx;
+
+static uint8_t s_tx_buf[MAX_FRAME_SZ];
+
+// *****************************************************************************
+// Public code
+
+void host_proto_init(void) {
+  s_host_proto_ctx.state = HOST_PROTO_STATE_INACTIVE;
+  s_host_proto_ctx.rx_len = 0;
+  s_host_proto_ctx.queue_head = 0;
+  s_host_proto_ctx.queue_count = 0;
+  s_host_proto_ctx.stream_dst = NULL;
+}
+
+void host_proto_start(uint8_t first_byte) {
+  s_host_proto_ctx.rx_len = 0;
+  s_host_proto_ctx.queue_head = 0;
+  s_host_proto_ctx.queue_count = 0;
+  s_host_proto_ctx.has_last = false;
+  set_state(HOST_PROTO_STATE_RUNNING);
+  rx_byte(first_byte);
+}
+
+void host_proto_step(void) {
+  switch (s_host_proto_ctx.state) {
+  case HOST_PROTO_STATE_INACTIVE: {
+    // wait here for a call to host_proto_start()
+  } break;
+
+  case HOST_PROTO_STATE_RUNNING: {
+    rx_poll();
+    if (s_host_proto_ctx.queue_count > 0) {
+      host_proto_request_t *request =
+          &s_host_proto_ctx.queue[s_host_proto_ctx.queue_head];
+      // the request stays in the queue while it runs: it counts as pending.
+      execute(request);
+      s_host_proto_ctx.queue_head =
+          (s_host_proto_ctx.queue_head + 1) % HOST_PROTO_QUEUE_LEN;
+      s_host_proto_ctx.queue_count -= 1;
+      if (request->type == HOST_PROTO_CMD_EXIT) {
+        set_state(HOST_PROTO_STATE_INACTIVE);
+      }
+    } else {
+      // nothing to do: let the catalog finish scanning images meanwhile.
+      dir_reader_step();
+    }
+  } break;
+  } // switch
+}
+
+bool host_proto_is_active(void) {
+  return s_host_proto_ctx.state != HOST_PROTO_STATE_INACTIVE;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static void set_state(host_proto_state_t state) {
+  if (s_host_proto_ctx.state != state) {
+    SYS_DEBUG_PRINT(SYS_ERROR_DEBUG,
+                    "%s => %s",
+                    state_name(s_host_proto_ctx.state),
+                    state_name(state));
+    s_host_proto_ctx.state = state;
+  }
+}
+
+static const char *state_name(host_proto_state_t state) {
+  SYS_ASSERT(state < N_STATES, "host_proto_state_t out of bounds");
+  return s_state_names[state];
+}
+
+static void rx_poll(void) {
+  uint8_t buf[16];
+  ssize_t n_read;
+
+  while ((n_read = SYS_CONSOLE_Read(
+              SYS_CONSOLE_DEFAULT_INSTANCE, buf, sizeof(buf))) > 0) {
+    for (ssize_t i = 0; i < n_read; i++) {
+      rx_byte(buf[i]);
+    }
+  }
+}
+
+static void rx_byte(uint8_t byte) {
+  uint8_t *rx_buf = s_host_proto_ctx.rx_buf;
+  size_t rx_len = s_host_proto_ctx.rx_len;
+
+  // Hunt for the start of frame, then collect the header and the rest.
+  if (((rx_len == 0) && (byte != HOST_PROTO_SOF0)) ||
+      ((rx_len == 1) && (byte != HOST_PROTO_SOF1))) {
+    s_host_proto_ctx.rx_len = (byte == HOST_PROTO_SOF0) ? 1 : 0;
+    rx_buf[0] = byte;
+    return;
+  }
+  rx_buf[rx_len++] = byte;
+
+  if (rx_len < HEADER_SZ) {
+    s_host_proto_ctx.rx_len = rx_len;
+    return;
+  }
+  size_t payload_len = rx_buf[4] | (rx_buf[5] << 8);
+  if (payload_len > HOST_PROTO_MAX_PAYLOAD) {
+    // can't be a real frame: resynchronize.
+    s_host_proto_ctx.rx_len = 0;
+    return;
+  }
+  if (rx_len < HEADER_SZ + payload_len + CRC_SZ) {
+    s_host_proto_ctx.rx_len = rx_len;
+    return;
+  }
+
+  // complete frame.
+  s_host_proto_ctx.rx_len = 0;
+  uint16_t crc = crc16_update(0xffff, &rx_buf[2], HEADER_SZ - 2 + payload_len);
+  uint16_t rx_crc = rx_buf[HEADER_SZ + payload_len] |
+                    (rx_buf[HEADER_SZ + payload_len + 1] << 8);
+  if (crc != rx_crc) {
+    SYS_DEBUG_MESSAGE(SYS_ERROR_DEBUG, "\nhost_proto: CRC error");
+    return; // the host resends if it gets no ACK.
+  }
+  rx_frame(rx_buf[2], rx_buf[3], &rx_buf[HEADER_SZ], payload_len);
+}
+
+static void rx_frame(uint8_t type,
+                     uint8_t seq,
+                     const uint8_t *payload,
+                     size_t len) {
+  uint8_t ack[2];
+  bool takes_name = false;
+
+  if ((type == HOST_PROTO_CMD_STREAM_DATA) ||
+      (type == HOST_PROTO_CMD_STREAM_SKIP)) {
+    rx_stream(type, seq, payload, len);
+    return;
+  }
+
+  switch (type) {
+  case HOST_PROTO_CMD_PING:
+  case HOST_PROTO_CMD_LIST:
+  case HOST_PROTO_CMD_REBUILD_PLL:
+  case HOST_PROTO_CMD_EXIT:
+    ack[0] = (len == 0) ? HOST_PROTO_ACK_QUEUED : HOST_PROTO_ACK_INVALID;
+    break;
+  case HOST_PROTO_CMD_EXTRACT:
+  case HOST_PROTO_CMD_UPDATE:
+  case HOST_PROTO_CMD_COMPARE:
+    takes_name = true;
+    ack[0] = ((len > 0) && (len <= HOST_PROTO_MAX_NAME))
+                 ? HOST_PROTO_ACK_QUEUED
+                 : HOST_PROTO_ACK_INVALID;
+    break;
+  case HOST_PROTO_CMD_STREAM_UPDATE:
+    ack[0] = ((len == 4) && (get_u32(payload) > 0)) ? HOST_PROTO_ACK_QUEUED
+                                                     : HOST_PROTO_ACK_INVALID;
+    break;
+  default:
+    ack[0] = HOST_PROTO_ACK_UNKNOWN;
+    break;
+  }
+
+  if ((ack[0] == HOST_PROTO_ACK_QUEUED) && s_host_proto_ctx.has_last &&
+      (seq == s_host_proto_ctx.last_seq) &&
+      (type == s_host_proto_ctx.last_type)) {
+    // a resend of the last request: ACK it again, but don't queue it twice.
+    ack[1] = s_host_proto_ctx.queue_count;
+    send_frame(HOST_PROTO_RSP_ACK, seq, ack, sizeof(ack), true);
+    return;
+  }
+
+  if ((ack[0] == HOST_PROTO_ACK_QUEUED) &&
+      (s_host_proto_ctx.queue_count >= HOST_PROTO_QUEUE_LEN)) {
+    ack[0] = HOST_PROTO_ACK_BUSY;
+  }
+
+  if (ack[0] == HOST_PROTO_ACK_QUEUED) {
+    uint8_t tail = (s_host_proto_ctx.queue_head +
+                    s_host_proto_ctx.queue_count) % HOST_PROTO_QUEUE_LEN;
+    host_proto_request_t *request = &s_host_proto_ctx.queue[tail];
+    request->type = type;
+    request->seq = seq;
+    request->size = 0;
+    request->name[0] = '\0';
+    if (type == HOST_PROTO_CMD_STREAM_UPDATE) {
+      request->size = get_u32(payload);
+    } else if (takes_name) {
+      memcpy(request->name, payload, len);
+      request->name[len] = '\0';
+    }
+    s_host_proto_ctx.queue_count += 1;
+    s_host_proto_ctx.has_last = true;
+    s_host_proto_ctx.last_seq = seq;
+    s_host_proto_ctx.last_type = type;
+  }
+  ack[1] = s_host_proto_ctx.queue_count;
+  send_frame(HOST_PROTO_RSP_ACK, seq, ack, sizeof(ack), true);
+}
+
+static void rx_stream(uint8_t type,
+                      uint8_t round,
+                      const uint8_t *payload,
+                      size_t len) {
+  uint32_t addr;
+  uint32_t received = s_host_proto_ctx.stream_received;
+
+  if ((s_host_proto_ctx.stream_dst == NULL) ||
+      (round != s_host_proto_ctx.stream_round) || (len < 4)) {
+    // unwanted, or answering an earlier SECTOR frame: the host's data for a
+    // superseded query may still be arriving, so this is expected.
+    return;
+  }
+  addr = get_u32(payload);
+  if (type == HOST_PROTO_CMD_STREAM_SKIP) {
+    if (addr == s_host_proto_ctx.stream_addr) {
+      s_host_proto_ctx.stream_skip = true;
+    }
+    return;
+  }
+  payload += 4;
+  len -= 4;
+  if ((addr != s_host_proto_ctx.stream_addr + received) ||
+      (received + len > FLASH_SECTOR_SZ)) {
+    s_host_proto_ctx.stream_gap = true;
+    return;
+  }
+  memcpy(&s_host_proto_ctx.stream_dst[received], payload, len);
+  s_host_proto_ctx.stream_received = received + len;
+}
+
+static void execute(host_proto_request_t *request) {
+  bool ok = true;
+  uint32_t value = 0;
+
+  // free the file handle held by the catalog's image scan.
+  dir_reader_pause();
+  s_host_proto_ctx.running_seq = request->seq;
+  s_host_proto_ctx.n_changed = 0;
+  s_host_proto_ctx.progress_count = SYS_TIME_CounterGet();
+  progress_set_observer(on_progress);
+
+  switch (request->type) {
+  case HOST_PROTO_CMD_PING:
+    send_result(request->seq,
+                HOST_PROTO_RESULT_OK,
+                0,
+                "winc-cloner v" WINC_IMAGER_VERSION);
+    break;
+  case HOST_PROTO_CMD_LIST:
+    value = send_catalog(request->seq);
+    ok = !dir_reader_has_error();
+    break;
+  case HOST_PROTO_CMD_EXTRACT:
+    ok = winc_cloner_extract(request->name);
+    dir_reader_invalidate(request->name);
+    break;
+  case HOST_PROTO_CMD_UPDATE:
+    ok = winc_cloner_update(request->name);
+    value = s_host_proto_ctx.n_changed;
+    break;
+  case HOST_PROTO_CMD_COMPARE:
+    ok = winc_cloner_compare(request->name);
+    value = s_host_proto_ctx.n_changed;
+    break;
+  case HOST_PROTO_CMD_REBUILD_PLL:
+    ok = winc_cloner_rebuild_pll();
+    break;
+  case HOST_PROTO_CMD_STREAM_UPDATE:
+    ok = winc_cloner_update_from_source("host", request->size, stream_source);
+    value = s_host_proto_ctx.n_changed;
+    break;
+  case HOST_PROTO_CMD_EXIT:
+    break;
+  }
+
+  progress_set_observer(NULL);
+  if (request->type != HOST_PROTO_CMD_PING) {
+    send_result(request->seq,
+                ok ? HOST_PROTO_RESULT_OK : HOST_PROTO_RESULT_FAILED,
+                value,
+                NULL);
+  }
+  // the image file is closed: append the operation's record to the log.
+  session_log_flush();
+}
+
+static uint32_t send_catalog(uint8_t seq) {
+  uint8_t payload[HOST_PROTO_MAX_PAYLOAD];
+  uint16_t count;
+
+  dir_reader_read_directory();
+  while (!dir_reader_is_complete() && !dir_reader_has_error()) {
+    dir_reader_step();
+    rx_poll();
+  }
+  count = dir_reader_filename_count();
+  for (uint16_t idx = 0; idx < count; idx++) {
+    const dir_reader_image_t *image = dir_reader_image_ref(idx);
+    const char *name = dir_reader_filename_ref(idx);
+    size_t len = 0;
+    size_t name_len = strlen(name);
+
+    len += put_u16(&payload[len], idx);
+    len += put_u32(&payload[len], image->size);
+    len += put_u32(&payload[len], image->digest);
+    len += put_u16(&payload[len], image->fw_version);
+    payload[len++] = image->flags;
+    if (name_len > sizeof(payload) - len) {
+      name_len = sizeof(payload) - len;
+    }
+    memcpy(&payload[len], name, name_len);
+    len += name_len;
+    send_frame(HOST_PROTO_RSP_ENTRY, seq, payload, len, true);
+    rx_poll();
+  }
+  return count;
+}
+
+static winc_cloner_source_result_t
+stream_source(uint32_t addr, const uint8_t *winc_data, uint8_t *dst) {
+  uint8_t payload[13];
+  uint32_t winc_crc = crc32_update(0, winc_data, FLASH_SECTOR_SZ);
+  winc_cloner_source_result_t res = WINC_CLONER_SOURCE_ERROR;
+  int n_tries = 0;
+
+  s_host_proto_ctx.stream_dst = dst;
+  s_host_proto_ctx.stream_addr = addr;
+  s_host_proto_ctx.stream_received = 0;
+
+  while ((res == WINC_CLONER_SOURCE_ERROR) &&
+         (n_tries < HOST_PROTO_STREAM_TRIES)) {
+    uint32_t received = s_host_proto_ctx.stream_received;
+    uint32_t start = SYS_TIME_CounterGet();
+
+    // ask for the sector, or for what is still missing of it.
+    s_host_proto_ctx.stream_round += 1;
+    s_host_proto_ctx.stream_skip = false;
+    s_host_proto_ctx.stream_gap = false;
+    payload[0] = s_host_proto_ctx.stream_round;
+    put_u32(&payload[1], addr);
+    put_u32(&payload[5], received);
+    put_u32(&payload[9], winc_crc);
+    send_frame(HOST_PROTO_RSP_SECTOR,
+               s_host_proto_ctx.running_seq,
+               payload,
+               sizeof(payload),
+               true);
+    n_tries += 1;
+
+    // Receive without pause: the sector is in flight and the console's
+    // receive buffer holds only a fraction of it.
+    while (SYS_TIME_CountToMS(SYS_TIME_CounterGet() - start) <
+           HOST_PROTO_STREAM_TIMEOUT_MS) {
+      rx_poll();
+      if (s_host_proto_ctx.stream_skip) {
+        res = WINC_CLONER_SOURCE_SAME;
+        break;
+      }
+      if (s_host_proto_ctx.stream_received == FLASH_SECTOR_SZ) {
+        res = WINC_CLONER_SOURCE_DATA;
+        break;
+      }
+      if (s_host_proto_ctx.stream_gap) {
+        break;
+      }
+      if (s_host_proto_ctx.stream_received != received) {
+        // the host is keeping up: restart the timeout.
+        received = s_host_proto_ctx.stream_received;
+        start = SYS_TIME_CounterGet();
+        n_tries = 0;
+      }
+    }
+  }
+  s_host_proto_ctx.stream_dst = NULL;
+  return res;
+}
+
+static void on_progress(uint32_t n_done,
+                        uint32_t n_sectors,
+                        uint32_t n_changed) {
+  uint8_t payload[12];
+  uint32_t now = SYS_TIME_CounterGet();
+
+  // keep taking (and ACKing) pipelined requests while the cloner runs.
+  rx_poll();
+  s_host_proto_ctx.n_changed = n_changed;
+
+  if ((SYS_TIME_CountToMS(now - s_host_proto_ctx.progress_count) <
+       PROGRESS_INTERVAL_MS) &&
+      (n_done < n_sectors)) {
+    return;
+  }
+  put_u32(&payload[0], n_done);
+  put_u32(&payload[4], n_sectors);
+  put_u32(&payload[8], n_changed);
+  if (send_frame(HOST_PROTO_RSP_PROGRESS,
+                 s_host_proto_ctx.running_seq,
+                 payload,
+                 sizeof(payload),
+                 false)) {
+    s_host_proto_ctx.progress_count = now;
+  }
+}
+
+static bool send_frame(uint8_t type,
+                       uint8_t seq,
+                       const uint8_t *payload,
+                       size_t len,
+                       bool wait) {
+  size_t n = 0;
+  uint16_t crc;
+
+  s_tx_buf[n++] = HOST_PROTO_SOF0;
+  s_tx_buf[n++] = HOST_PROTO_SOF1;
+  s_tx_buf[n++] = type;
+  s_tx_buf[n++] = seq;
+  n += put_u16(&s_tx_buf[n], len);
+  memcpy(&s_tx_buf[n], payload, len);
+  n += len;
+  crc = crc16_update(0xffff, &s_tx_buf[2], n - 2);
+  n += put_u16(&s_tx_buf[n], crc);
+
+  while (SYS_CONSOLE_WriteFreeBufferCountGet(SYS_CONSOLE_DEFAULT_INSTANCE) <
+         (ssize_t)n) {
+    if (!wait) {
+      return false;
+    }
+    // the UART interrupt drains the transmit buffer.
+  }
+  SYS_CONSOLE_Write(SYS_CONSOLE_DEFAULT_INSTANCE, s_tx_buf, n);
+  return true;
+}
+
+static void send_result(uint8_t seq,
+                        uint8_t status,
+                        uint32_t value,
+                        const char *text) {
+  uint8_t payload[HOST_PROTO_MAX_PAYLOAD];
+  size_t len = 0;
+
+  payload[len++] = status;
+  len += put_u32(&payload[len], value);
+  if (text != NULL) {
+    size_t text_len = strlen(text);
+    if (text_len > sizeof(payload) - len) {
+      text_len = sizeof(payload) - len;
+    }
+    memcpy(&payload[len], text, text_len);
+    len += text_len;
+  }
+  send_frame(HOST_PROTO_RSP_RESULT, seq, payload, len, true);
+}
+
+static size_t put_u16(uint8_t *dst, uint16_t value) {
+  dst[0] = value & 0xff;
+  dst[1] = value >> 8;
+  return 2;
+}
+
+static size_t put_u32(uint8_t *dst, uint32_t value) {
+  put_u16(&dst[0], value & 0xffff);
+  put_u16(&dst[2], value >> 16);
+  return 4;
+}
+
+static uint32_t get_u32(const uint8_t *src) {
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+         ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static uint16_t crc16_update(uint16_t crc, const uint8_t *buf, size_t n_bytes) {
+  while (n_bytes--) {
+    crc ^= (uint16_t)(*buf++) << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// *****************************************************************************
+// End of file
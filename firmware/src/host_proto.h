@@ -0,0 +1,168 @@
+/**
+ * @file host_proto.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief host_proto implements a framed binary protocol on the console UART,
+ * for driving the cloner from a host program rather than by hand.
+ *
+ * The protocol is entered from the command menu by sending a frame: its first
+ * byte (HOST_PROTO_SOF0) can't be typed, so it is never confused with a menu
+ * command.  It runs until the host sends HOST_PROTO_CMD_EXIT.
+ *
+ * Every frame, in either direction, is:
+ *
+ *   0xa5 0x5a type seq len_lo len_hi payload[len] crc_lo crc_hi
+ *
+ * where crc is the CRC-16/CCITT-FALSE of type, seq, len and payload, and all
+ * multi-byte payload fields are little-endian.  Bytes outside of a valid frame
+ * (including any text the firmware prints) are to be ignored by the receiver.
+ *
+ * Each request is answered at once with an ACK carrying the request's seq.  A
+ * request that was queued is then executed in order, possibly emitting
+ * PROGRESS or ENTRY frames, and is finished by a RESULT with the same seq.
+ * Up to HOST_PROTO_QUEUE_LEN requests may be queued, so the host can send the
+ * next command while the current one is still running.  A host that gets no
+ * ACK resends the request unchanged: one with the same seq and type as the
+ * last request queued is ACKed again but not queued twice, so each new
+ * request must use a new seq.
+ *
+ * HOST_PROTO_CMD_STREAM_UPDATE updates the WINC from an image held by the host
+ * rather than from the SD card.  While it runs, the target asks for the image
+ * one sector at a time with a SECTOR frame carrying the CRC-32 of what the
+ * WINC already holds there.  The host answers with STREAM_SKIP if its sector
+ * has the same CRC, or else sends the sector from the requested offset as
+ * STREAM_DATA frames.  Stream frames are neither ACKed nor queued: the next
+ * SECTOR frame is the acknowledgement.  Their seq field echoes the SECTOR
+ * frame's round, so frames answering an earlier query are recognized and
+ * dropped.  A gap in the data, or silence for HOST_PROTO_STREAM_TIMEOUT_MS,
+ * prompts a new SECTOR frame that asks for the rest of the sector.
+ *
+ * The target asks for a sector only once the WINC is idle, and programs it
+ * only once all of it has arrived.  So no data is in flight while the WINC is
+ * busy, and the console's small receive buffer never overflows however long
+ * an erase takes.
+ *
+ * See host/ at the top of the repository for a reference client.
+ */
+
+#ifndef _HOST_PROTO_H_
+#define _HOST_PROTO_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define HOST_PROTO_SOF0 0xa5
+#define HOST_PROTO_SOF1 0x5a
+
+#define HOST_PROTO_MAX_PAYLOAD 128
+#define HOST_PROTO_MAX_NAME 80 // longest filename argument, excluding NUL
+#define HOST_PROTO_QUEUE_LEN 4
+#define HOST_PROTO_STREAM_TIMEOUT_MS 500 // wait for stream data, then ask again
+#define HOST_PROTO_STREAM_TRIES 8        // SECTOR frames sent without reply
+
+// Requests (host to target).  Payload in parentheses.
+#define HOST_PROTO_CMD_PING 0x01          // ()
+#define HOST_PROTO_CMD_LIST 0x02          // ()
+#define HOST_PROTO_CMD_EXTRACT 0x10       // (filename)
+#define HOST_PROTO_CMD_UPDATE 0x11        // (filename)
+#define HOST_PROTO_CMD_COMPARE 0x12       // (filename)
+#define HOST_PROTO_CMD_REBUILD_PLL 0x13   // ()
+#define HOST_PROTO_CMD_STREAM_UPDATE 0x14 // (u32 image size)
+#define HOST_PROTO_CMD_EXIT 0x1f          // ()
+
+// Stream frames (host to target), answering a SECTOR frame.  seq is its round.
+#define HOST_PROTO_CMD_STREAM_DATA 0x20 // (u32 address, data)
+#define HOST_PROTO_CMD_STREAM_SKIP 0x21 // (u32 address)
+
+// Responses (target to host).
+#define HOST_PROTO_RSP_ACK 0x80      // (u8 ack status, u8 requests queued)
+#define HOST_PROTO_RSP_PROGRESS 0x81 // (u32 done, u32 total, u32 changed)
+#define HOST_PROTO_RSP_ENTRY 0x82    // (u16 index, u32 size, u32 digest,
+                                     //  u16 fw_version, u8 flags, name)
+#define HOST_PROTO_RSP_RESULT 0x83   // (u8 result status, u32 value, text)
+#define HOST_PROTO_RSP_SECTOR 0x84   // (u8 round, u32 address, u32 offset,
+                                     //  u32 crc32 of the WINC sector)
+
+// ACK status
+#define HOST_PROTO_ACK_QUEUED 0x00
+#define HOST_PROTO_ACK_BUSY 0x01    // queue full: resend later
+#define HOST_PROTO_ACK_UNKNOWN 0x02 // unrecognized request type
+#define HOST_PROTO_ACK_INVALID 0x03 // bad payload for the request type
+
+// RESULT status.  The value is the number of sectors changed (UPDATE and
+// STREAM_UPDATE) or that differ (COMPARE), or the number of ENTRY frames sent
+// (LIST).  PING returns the firmware version as text.
+#define HOST_PROTO_RESULT_OK 0x00
+#define HOST_PROTO_RESULT_FAILED 0x01
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Initialize the host_proto.  Called once at startup.
+ */
+void host_proto_init(void);
+
+/**
+ * @brief Enter the protocol, given the first byte of a frame read by the menu.
+ */
+void host_proto_start(uint8_t first_byte);
+
+/**
+ * @brief Step the host_proto internal state.  Called frequently while active.
+ *
+ * Note: queued requests are executed from here and may block for as long as
+ * the cloner operation takes.
+ */
+void host_proto_step(void);
+
+/**
+ * @brief Return true until the host has sent HOST_PROTO_CMD_EXIT.
+ */
+bool host_proto_is_active(void);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _HOST_PROTO_H_ */
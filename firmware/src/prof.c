@@ -0,0 +1,113 @@
+/**
+ * @file prof.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "prof.h"
+
+#if PROF_ENABLED
+
+#include "definitions.h"
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define CYCLES_PER_MS (CPU_CLOCK_FREQUENCY / 1000)
+
+typedef struct {
+  uint32_t n_passes;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+} prof_entry_t;
+
+// *****************************************************************************
+// Private (static) storage
+
+#define PROF_EXPAND_ZONE_NAMES(_name) #_name,
+static const char *s_zone_names[] = {PROF_ZONES(PROF_EXPAND_ZONE_NAMES)};
+
+static prof_entry_t s_entries[PROF_ZONE_COUNT];
+
+// *****************************************************************************
+// Public code
+
+void prof_init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  prof_reset();
+}
+
+void prof_record(prof_zone_t zone, uint32_t n_cycles) {
+  prof_entry_t *entry = &s_entries[zone];
+
+  if (entry->n_passes == 0 || n_cycles < entry->min_cycles) {
+    entry->min_cycles = n_cycles;
+  }
+  if (n_cycles > entry->max_cycles) {
+    entry->max_cycles = n_cycles;
+  }
+  entry->n_passes += 1;
+  entry->total_cycles += n_cycles;
+}
+
+void prof_reset(void) {
+  memset(s_entries, 0, sizeof(s_entries));
+}
+
+void prof_print(void) {
+  SYS_CONSOLE_PRINT("\n%-24s %8s %10s %10s %10s %10s",
+                    "zone",
+                    "passes",
+                    "total ms",
+                    "min cyc",
+                    "mean cyc",
+                    "max cyc");
+  for (int i = 0; i < PROF_ZONE_COUNT; i++) {
+    const prof_entry_t *entry = &s_entries[i];
+
+    if (entry->n_passes == 0) {
+      continue;
+    }
+    // skip the "PROF_ZONE_" prefix
+    SYS_CONSOLE_PRINT("\n%-24s %8lu %10lu %10lu %10lu %10lu",
+                      s_zone_names[i] + sizeof("PROF_ZONE_") - 1,
+                      entry->n_passes,
+                      (uint32_t)(entry->total_cycles / CYCLES_PER_MS),
+                      entry->min_cycles,
+                      (uint32_t)(entry->total_cycles / entry->n_passes),
+                      entry->max_cycles);
+  }
+}
+
+#endif // #if PROF_ENABLED
+
+// *****************************************************************************
+// End of file
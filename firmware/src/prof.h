@@ -0,0 +1,148 @@
+/**
+ * @file prof.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief prof times named zones of code with the Cortex-M4 cycle counter.
+ *
+ * SYS_TIME ticks far too slowly to see inside a page program or an SPI block
+ * read, but DWT->CYCCNT counts every CPU cycle.  A zone is a stretch of code
+ * between PROF_BEGIN(zone) and PROF_END(zone) in the same block:
+ *
+ *     PROF_BEGIN(PROF_ZONE_FLASH_PP);
+ *     ...
+ *     PROF_END(PROF_ZONE_FLASH_PP);
+ *
+ * For each zone, prof keeps the number of passes and the minimum, maximum and
+ * total cycles they took.  Zones may nest or overlap, so the total of an outer
+ * zone includes the inner ones.  A pass that leaves the zone without reaching
+ * PROF_END() (say, an early return on an error) is not counted.  Zones must
+ * not be used in interrupt handlers.
+ *
+ * Unless PROF_ENABLED is defined as 1 (in the project's preprocessor macros,
+ * or with make PROF=1 in firmware/sim), PROF_BEGIN() and PROF_END() expand to
+ * nothing and prof adds no code or data at all.
+ */
+
+#ifndef _PROF_H_
+#define _PROF_H_
+
+// *****************************************************************************
+// Includes
+
+#include "definitions.h"
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#ifndef PROF_ENABLED
+#define PROF_ENABLED 0
+#endif
+
+// The zones, in the order prof_print() lists them.
+#define PROF_ZONES(M)                                                          \
+  M(PROF_ZONE_CLONER_EXTRACT_SECTOR)                                           \
+  M(PROF_ZONE_CLONER_UPDATE_SECTOR)                                            \
+  M(PROF_ZONE_CLONER_COMPARE_SECTOR)                                           \
+  M(PROF_ZONE_CLONER_PROGRAM_SECTOR)                                           \
+  M(PROF_ZONE_CLONER_BUFFER_COMPARE)                                           \
+  M(PROF_ZONE_FS_READ)                                                         \
+  M(PROF_ZONE_FS_WRITE)                                                        \
+  M(PROF_ZONE_FLASH_READ)                                                      \
+  M(PROF_ZONE_FLASH_WRITE)                                                     \
+  M(PROF_ZONE_FLASH_ERASE)                                                     \
+  M(PROF_ZONE_FLASH_PP)                                                        \
+  M(PROF_ZONE_FLASH_PP_BUSY)                                                   \
+  M(PROF_ZONE_NMSPI_READ_REG)                                                  \
+  M(PROF_ZONE_NMSPI_WRITE_REG)                                                 \
+  M(PROF_ZONE_NMSPI_READ_BLOCK)                                                \
+  M(PROF_ZONE_NMSPI_WRITE_BLOCK)                                               \
+  M(PROF_ZONE_DRV_SPI_START)                                                   \
+  M(PROF_ZONE_DRV_SPI_WAIT)
+
+#define PROF_EXPAND_ZONE_IDS(_name) _name,
+typedef enum { PROF_ZONES(PROF_EXPAND_ZONE_IDS) PROF_ZONE_COUNT } prof_zone_t;
+
+#if PROF_ENABLED
+
+#define PROF_BEGIN(_zone) const uint32_t prof_start_##_zone##_ = DWT->CYCCNT
+
+#define PROF_END(_zone)                                                        \
+  prof_record((_zone), DWT->CYCCNT - prof_start_##_zone##_)
+
+#else
+
+#define PROF_BEGIN(_zone) ((void)0)
+
+#define PROF_END(_zone) ((void)0)
+
+#endif
+
+// *****************************************************************************
+// Public declarations
+
+#if PROF_ENABLED
+
+/**
+ * @brief Start the cycle counter and clear the table.  Call once at startup.
+ */
+void prof_init(void);
+
+/**
+ * @brief Add a pass of n_cycles through zone to the table.  Called through
+ * PROF_END().
+ */
+void prof_record(prof_zone_t zone, uint32_t n_cycles);
+
+/**
+ * @brief Clear the table.
+ */
+void prof_reset(void);
+
+/**
+ * @brief Print the table on the console: for each zone that has been entered,
+ * the number of passes, their total time in milliseconds, and the minimum,
+ * mean and maximum cycles of a pass.
+ */
+void prof_print(void);
+
+#endif
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _PROF_H_ */
@@ -0,0 +1,212 @@
+/**
+ * @file progress.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+// *****************************************************************************
+// Includes
+
+#include "progress.h"
+
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_LINE_LENGTH 100
+
+typedef struct {
+  const char *label;
+  const char *changed_label;
+  uint32_t n_sectors;
+  uint32_t sector_size;
+  uint32_t n_done;
+  uint32_t n_changed;
+  uint32_t start_count; // SYS_TIME counter at progress_start()
+  uint32_t start_drops; // console bytes dropped before progress_start()
+  uint32_t last_ms;     // time of the last redraw, in ms since start
+} progress_ctx_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Format the status line into s_line and return its length.
+ */
+static size_t format_line(uint32_t elapsed_ms);
+
+/**
+ * @brief Return the length of s_line after snprintf() appended at len and
+ * reported n_written: never past the end of s_line, where a field cut short
+ * leaves the line.
+ */
+static size_t line_advance(size_t len, int n_written);
+
+// *****************************************************************************
+// Private (static) storage
+
+static progress_ctx_t s_progress_ctx;
+
+static progress_observer_fn s_observer_fn;
+
+static char s_line[MAX_LINE_LENGTH];
+
+// *****************************************************************************
+// Public code
+
+void progress_start(const char *label,
+                    const char *changed_label,
+                    uint32_t n_sectors,
+                    uint32_t sector_size) {
+  s_progress_ctx.label = label;
+  s_progress_ctx.changed_label = changed_label;
+  s_progress_ctx.n_sectors = n_sectors;
+  s_progress_ctx.sector_size = sector_size;
+  s_progress_ctx.n_done = 0;
+  s_progress_ctx.n_changed = 0;
+  s_progress_ctx.start_count = SYS_TIME_CounterGet();
+  s_progress_ctx.start_drops = SERCOM2_USART_WriteDropCountGet();
+  s_progress_ctx.last_ms = 0;
+}
+
+void progress_update(uint32_t n_done, uint32_t n_changed) {
+  uint32_t elapsed_ms;
+  size_t len;
+
+  s_progress_ctx.n_done = n_done;
+  s_progress_ctx.n_changed = n_changed;
+
+  if (s_observer_fn != NULL) {
+    s_observer_fn(n_done, s_progress_ctx.n_sectors, n_changed);
+    return;
+  }
+
+  elapsed_ms = SYS_TIME_CountToMS(SYS_TIME_CounterGet() -
+                                  s_progress_ctx.start_count);
+  if (elapsed_ms - s_progress_ctx.last_ms < PROGRESS_INTERVAL_MS) {
+    return; // too soon.
+  }
+
+  len = format_line(elapsed_ms);
+  if (SYS_CONSOLE_WriteFreeBufferCountGet(SYS_CONSOLE_DEFAULT_INSTANCE) <
+      (ssize_t)len) {
+    return; // UART is behind: try again on the next update.
+  }
+  SYS_CONSOLE_Write(SYS_CONSOLE_DEFAULT_INSTANCE, s_line, len);
+  s_progress_ctx.last_ms = elapsed_ms;
+}
+
+void progress_finish(bool success) {
+  uint32_t elapsed_ms;
+  uint32_t n_dropped;
+
+  if (s_observer_fn != NULL) {
+    s_observer_fn(s_progress_ctx.n_done,
+                  s_progress_ctx.n_sectors,
+                  s_progress_ctx.n_changed);
+    return;
+  }
+
+  elapsed_ms = SYS_TIME_CountToMS(SYS_TIME_CounterGet() -
+                                  s_progress_ctx.start_count);
+  format_line(elapsed_ms);
+  SYS_CONSOLE_PRINT("%s%s\n", s_line, success ? "" : " FAILED");
+
+  // The console drops output rather than stall the operation: say so when it
+  // did, so a gap in the log isn't mistaken for a quiet run.
+  n_dropped =
+      SERCOM2_USART_WriteDropCountGet() - s_progress_ctx.start_drops;
+  if (n_dropped > 0) {
+    SYS_CONSOLE_PRINT("(%ld console bytes dropped)\n", n_dropped);
+  }
+}
+
+void progress_set_observer(progress_observer_fn observer_fn) {
+  s_observer_fn = observer_fn;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static size_t format_line(uint32_t elapsed_ms) {
+  uint32_t n_done = s_progress_ctx.n_done;
+  uint32_t n_sectors = s_progress_ctx.n_sectors;
+  uint32_t percent = (n_sectors > 0) ? (n_done * 100) / n_sectors : 100;
+  uint32_t kb_per_s = 0;
+  uint32_t eta_s = 0;
+  size_t len;
+
+  if (elapsed_ms > 0) {
+    kb_per_s = (uint32_t)(((uint64_t)n_done * s_progress_ctx.sector_size) /
+                          elapsed_ms); // bytes per ms ~= KB per s
+  }
+  if ((n_done > 0) && (n_done < n_sectors)) {
+    eta_s = (uint32_t)(((uint64_t)elapsed_ms * (n_sectors - n_done)) /
+                       n_done / 1000);
+  }
+
+  // "\r" redraws in place; trailing blanks erase a longer previous line.
+  len = line_advance(0,
+                     snprintf(s_line,
+                              sizeof(s_line),
+                              "\r%s %3ld%% %ld/%ld",
+                              s_progress_ctx.label,
+                              percent,
+                              n_done,
+                              n_sectors));
+  if (s_progress_ctx.changed_label != NULL) {
+    len = line_advance(len,
+                       snprintf(&s_line[len],
+                                sizeof(s_line) - len,
+                                ", %ld %s",
+                                s_progress_ctx.n_changed,
+                                s_progress_ctx.changed_label));
+  }
+  len = line_advance(len,
+                     snprintf(&s_line[len],
+                              sizeof(s_line) - len,
+                              ", %ld.%02ld MB/s, ETA %ld:%02ld   ",
+                              kb_per_s / 1000,
+                              (kb_per_s % 1000) / 10,
+                              eta_s / 60,
+                              eta_s % 60));
+  return len;
+}
+
+static size_t line_advance(size_t len, int n_written) {
+  if (n_written < 0) {
+    return len; // encoding error: nothing appended.
+  }
+  len += n_written;
+  return (len < sizeof(s_line)) ? len : sizeof(s_line) - 1;
+}
+
+// *****************************************************************************
+// End of file
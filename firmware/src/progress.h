@@ -0,0 +1,110 @@
+/**
+ * @file progress.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief progress keeps a one-line status report up to date during long
+ * operations.
+ *
+ * The line is redrawn at most every PROGRESS_INTERVAL_MS, and only if the
+ * console's transmit buffer has room for all of it: when the UART falls
+ * behind, updates are skipped rather than waited for, so console throughput
+ * never holds up the operation being reported.
+ */
+
+#ifndef _PROGRESS_H_
+#define _PROGRESS_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define PROGRESS_INTERVAL_MS 250
+
+/**
+ * @brief Signature for a progress observer.
+ */
+typedef void (*progress_observer_fn)(uint32_t n_done,
+                                     uint32_t n_sectors,
+                                     uint32_t n_changed);
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Start reporting progress of an operation on n_sectors sectors.
+ *
+ * @param label Describes the operation, e.g. "Updating".
+ * @param changed_label Describes the sectors counted as changed, e.g.
+ *        "differ", or NULL to leave the count out.
+ * @param n_sectors Number of sectors the operation will process.
+ * @param sector_size Size of a sector in bytes, used to compute throughput.
+ */
+void progress_start(const char *label,
+                    const char *changed_label,
+                    uint32_t n_sectors,
+                    uint32_t sector_size);
+
+/**
+ * @brief Record that n_done sectors have been processed, n_changed of them
+ * counted as changed.  Cheap enough to call once per sector.
+ */
+void progress_update(uint32_t n_done, uint32_t n_changed);
+
+/**
+ * @brief Print the final status line followed by a newline.
+ */
+void progress_finish(bool success);
+
+/**
+ * @brief Send progress to observer_fn instead of the console status line, or
+ * back to the console if observer_fn is NULL.
+ *
+ * The observer is called on every progress_update() and on progress_finish(),
+ * without rate limiting.
+ */
+void progress_set_observer(progress_observer_fn observer_fn);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _PROGRESS_H_ */
@@ -0,0 +1,248 @@
+/**
+ * @file session_log.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "session_log.h"
+
+#include "app.h"
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define MAX_LINE_LENGTH 400
+#define MAX_FIELD_LENGTH 24
+#define CARD_SECTOR_SZ 512
+
+#define CSV_HEADER                                                             \
+  "seq,operation,result,image,image_crc32,mac,freq_offset,pa_gain_corr,"       \
+  "flash_id,flash_mbit,card_serial,card_mb,sectors,equal,changed,skipped,"     \
+  "erases,page_programs,sd_read_bytes,sd_write_bytes,winc_read_bytes,"         \
+  "winc_write_bytes,sd_read_ms,sd_write_ms,winc_read_ms,erase_ms,program_ms,"  \
+  "compare_ms,total_ms\r\n"
+
+typedef struct {
+  uint32_t n_sessions; // sessions since startup
+  uint32_t n_dropped;  // lines dropped since startup
+  size_t n_pending;    // bytes of s_pending waiting to be written
+} session_log_ctx_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Convert SYS_TIME counts to milliseconds.
+ */
+static uint32_t counts_to_ms(uint64_t counts);
+
+/**
+ * @brief Format the record as a line of CSV into s_line and return its length.
+ */
+static size_t format_record(const session_log_record_t *record);
+
+// *****************************************************************************
+// Private (static) storage
+
+static session_log_ctx_t s_session_log_ctx;
+
+static char s_pending[SESSION_LOG_BUFFER_SIZE];
+
+static char s_line[MAX_LINE_LENGTH];
+
+// *****************************************************************************
+// Public code
+
+void session_log_start(session_log_record_t *record,
+                       const char *operation,
+                       const char *image) {
+  memset(record, 0, sizeof(*record));
+  record->operation = operation;
+  record->image = image;
+  record->start_count = SYS_TIME_Counter64Get();
+}
+
+uint32_t session_log_timer_start(void) { return SYS_TIME_CounterGet(); }
+
+void session_log_time(session_log_record_t *record,
+                      session_log_timer_t timer,
+                      uint32_t start) {
+  record->timer_counts[timer] += SYS_TIME_CounterGet() - start;
+}
+
+void session_log_add(session_log_record_t *record, bool ok) {
+  size_t len;
+
+  record->ok = ok;
+  record->total_counts = SYS_TIME_Counter64Get() - record->start_count;
+  s_session_log_ctx.n_sessions += 1;
+  len = format_record(record);
+  if (s_session_log_ctx.n_pending + len > sizeof(s_pending)) {
+    s_session_log_ctx.n_dropped += 1;
+    return;
+  }
+  memcpy(&s_pending[s_session_log_ctx.n_pending], s_line, len);
+  s_session_log_ctx.n_pending += len;
+}
+
+bool session_log_flush(void) {
+  SYS_FS_HANDLE handle;
+  size_t n_pending = s_session_log_ctx.n_pending;
+  bool ok = true;
+
+  if (n_pending == 0) {
+    return true;
+  }
+  handle = SYS_FS_FileOpen(SESSION_LOG_FILENAME, SYS_FS_FILE_OPEN_APPEND);
+  if (handle == SYS_FS_HANDLE_INVALID) {
+    SYS_DEBUG_PRINT(
+        SYS_ERROR_WARNING, "\nCould not open %s", SESSION_LOG_FILENAME);
+    return false;
+  }
+  if (SYS_FS_FileSize(handle) == 0) {
+    // a new file: name the columns first.
+    ok = SYS_FS_FileWrite(handle, CSV_HEADER, sizeof(CSV_HEADER) - 1) ==
+         sizeof(CSV_HEADER) - 1;
+  }
+  ok = ok && (SYS_FS_FileWrite(handle, s_pending, n_pending) == n_pending);
+  if (SYS_FS_FileClose(handle) != SYS_FS_RES_SUCCESS) {
+    ok = false;
+  }
+  if (!ok) {
+    SYS_DEBUG_PRINT(
+        SYS_ERROR_WARNING, "\nFailed to write %s", SESSION_LOG_FILENAME);
+    return false;
+  }
+  s_session_log_ctx.n_pending = 0;
+  return true;
+}
+
+uint32_t session_log_dropped_count(void) {
+  return s_session_log_ctx.n_dropped;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static uint32_t counts_to_ms(uint64_t counts) {
+  return (uint32_t)(counts * 1000 / SYS_TIME_FrequencyGet());
+}
+
+static size_t format_record(const session_log_record_t *record) {
+  char digest[MAX_FIELD_LENGTH] = "";
+  char mac[MAX_FIELD_LENGTH] = "";
+  char freq_offset[MAX_FIELD_LENGTH] = "";
+  char pa_gain_corr[MAX_FIELD_LENGTH] = "";
+  char image[MAX_LINE_LENGTH / 4];
+  uint32_t card_serial = 0;
+  uint32_t card_sectors = 0;
+  uint32_t free_sectors;
+  char label[MAX_FIELD_LENGTH];
+  const EFUSEProdStruct *efuse = &record->efuse;
+  size_t j = 0;
+  int len;
+
+  if (record->has_digest) {
+    snprintf(digest, sizeof(digest), "%08lx", record->digest);
+  }
+  if (record->has_efuse && efuse->MAC_addr_used) {
+    snprintf(mac,
+             sizeof(mac),
+             "%02x:%02x:%02x:%02x:%02x:%02x",
+             efuse->MAC_addr[0],
+             efuse->MAC_addr[1],
+             efuse->MAC_addr[2],
+             efuse->MAC_addr[3],
+             efuse->MAC_addr[4],
+             efuse->MAC_addr[5]);
+  }
+  if (record->has_efuse && efuse->FreqOffset_used) {
+    snprintf(freq_offset, sizeof(freq_offset), "%04x", efuse->FreqOffset);
+  }
+  if (record->has_efuse && efuse->PATxGainCorr_used) {
+    snprintf(pa_gain_corr, sizeof(pa_gain_corr), "%02x", efuse->PATxGainCorr);
+  }
+  // quote the image name, doubling any quotes in it, as CSV requires.
+  image[j++] = '"';
+  for (const char *p = record->image; *p && j < sizeof(image) - 3; p++) {
+    if (*p == '"') {
+      image[j++] = '"';
+    }
+    image[j++] = *p;
+  }
+  image[j++] = '"';
+  image[j] = '\0';
+  SYS_FS_DriveLabelGet(SD_MOUNT_NAME, label, &card_serial);
+  SYS_FS_DriveSectorGet(SD_MOUNT_NAME, &card_sectors, &free_sectors);
+
+  len = snprintf(
+      s_line,
+      sizeof(s_line),
+      "%lu,%s,%s,%s,%s,%s,%s,%s,%08lx,%lu,%08lx,%lu,%lu,%lu,%lu,%lu,%lu,%lu,"
+      "%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+      s_session_log_ctx.n_sessions,
+      record->operation,
+      record->ok ? "ok" : "failed",
+      image,
+      digest,
+      mac,
+      freq_offset,
+      pa_gain_corr,
+      record->flash_id,
+      record->flash_mbit,
+      card_serial,
+      card_sectors / (1024 * 1024 / CARD_SECTOR_SZ),
+      record->n_sectors,
+      record->n_equal,
+      record->n_changed,
+      record->n_skipped,
+      record->n_erases,
+      record->n_page_programs,
+      record->sd_bytes_read,
+      record->sd_bytes_written,
+      record->winc_bytes_read,
+      record->winc_bytes_written,
+      counts_to_ms(record->timer_counts[SESSION_LOG_TIMER_SD_READ]),
+      counts_to_ms(record->timer_counts[SESSION_LOG_TIMER_SD_WRITE]),
+      counts_to_ms(record->timer_counts[SESSION_LOG_TIMER_WINC_READ]),
+      counts_to_ms(record->timer_counts[SESSION_LOG_TIMER_ERASE]),
+      counts_to_ms(record->timer_counts[SESSION_LOG_TIMER_PROGRAM]),
+      counts_to_ms(record->timer_counts[SESSION_LOG_TIMER_COMPARE]),
+      counts_to_ms(record->total_counts));
+  if (len < 0) {
+    return 0;
+  }
+  return ((size_t)len < sizeof(s_line)) ? (size_t)len : sizeof(s_line) - 1;
+}
+
+// *****************************************************************************
+// End of file
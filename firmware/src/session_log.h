@@ -0,0 +1,179 @@
+/**
+ * @file session_log.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief session_log appends a line of statistics to a CSV file on the SD card
+ * for every extract, update and compare.
+ *
+ * winc_cloner fills in a session_log_record_t while an operation runs: a few
+ * counters and SYS_TIME readings per sector.  When the operation is over and
+ * its file is closed, session_log_add() formats the record as a line of text
+ * and session_log_flush() appends the pending lines to SESSION_LOG_FILENAME.
+ * Lines that could not be written stay pending, and go out with the next
+ * flush, until SESSION_LOG_BUFFER_SIZE bytes of them are waiting; after that,
+ * new lines are dropped and counted.
+ *
+ * The first line of the file names the columns:
+ *
+ *   seq             sessions since startup, from 1
+ *   operation       extract, update or compare
+ *   result          ok or failed
+ *   image           file name, or the label of a streamed image
+ *   image_crc32     CRC-32 of the image file, computed from the bytes the
+ *                   operation wrote or read; taken from the image catalog if
+ *                   the operation stopped partway (blank if the image has not
+ *                   been scanned, and for streamed images)
+ *   mac             WINC MAC address from its efuse (blank if not set)
+ *   freq_offset     efuse frequency offset (blank if not set)
+ *   pa_gain_corr    efuse PA gain correction (blank if not set)
+ *   flash_id        JEDEC ID of the WINC's serial flash
+ *   flash_mbit      size of the WINC's serial flash
+ *   card_serial     volume serial number of the SD card
+ *   card_mb         size of the SD card volume
+ *   sectors         sectors processed
+ *   equal           sectors that already matched the image
+ *   changed         sectors that differed (programmed, for an update)
+ *   skipped         sectors left alone (the PLL and gain tables)
+ *   erases          sector erases
+ *   page_programs   flash page programs
+ *   sd_read_bytes, sd_write_bytes, winc_read_bytes, winc_write_bytes
+ *   sd_read_ms, sd_write_ms, winc_read_ms, erase_ms, program_ms, compare_ms
+ *                   time spent in each part of the work
+ *   total_ms        duration of the whole operation
+ */
+
+#ifndef _SESSION_LOG_H_
+#define _SESSION_LOG_H_
+
+// *****************************************************************************
+// Includes
+
+#include "efuse.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#define SESSION_LOG_FILENAME "winc_sessions.csv"
+#define SESSION_LOG_BUFFER_SIZE 2048 // lines waiting to be written
+
+/**
+ * @brief The parts of an operation that are timed separately.
+ */
+typedef enum {
+  SESSION_LOG_TIMER_SD_READ,
+  SESSION_LOG_TIMER_SD_WRITE,
+  SESSION_LOG_TIMER_WINC_READ,
+  SESSION_LOG_TIMER_ERASE,
+  SESSION_LOG_TIMER_PROGRAM,
+  SESSION_LOG_TIMER_COMPARE,
+  SESSION_LOG_TIMER_COUNT
+} session_log_timer_t;
+
+typedef struct {
+  const char *operation; // "extract", "update" or "compare"
+  const char *image;     // file name or source label
+  bool ok;               // the operation succeeded
+  bool has_digest;       // digest is valid
+  uint32_t digest;       // CRC-32 of the image
+  bool has_efuse;        // efuse is valid
+  EFUSEProdStruct efuse; // the WINC's efuse values
+  uint32_t flash_id;
+  uint32_t flash_mbit;
+  uint32_t n_sectors;
+  uint32_t n_equal;
+  uint32_t n_changed;
+  uint32_t n_skipped;
+  uint32_t n_erases;
+  uint32_t n_page_programs;
+  uint32_t sd_bytes_read;
+  uint32_t sd_bytes_written;
+  uint32_t winc_bytes_read;
+  uint32_t winc_bytes_written;
+  uint64_t start_count;                          // SYS_TIME counter at start
+  uint64_t timer_counts[SESSION_LOG_TIMER_COUNT]; // SYS_TIME counts
+  uint64_t total_counts;                          // SYS_TIME counts
+} session_log_record_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Clear the record and note the start of an operation.
+ */
+void session_log_start(session_log_record_t *record,
+                       const char *operation,
+                       const char *image);
+
+/**
+ * @brief Return the SYS_TIME counter, to pass to session_log_time() at the end
+ * of the timed work.
+ */
+uint32_t session_log_timer_start(void);
+
+/**
+ * @brief Add the time since start (from session_log_timer_start()) to timer.
+ */
+void session_log_time(session_log_record_t *record,
+                      session_log_timer_t timer,
+                      uint32_t start);
+
+/**
+ * @brief Note the result and end time of the operation, then queue the record
+ * as a line of the log.
+ */
+void session_log_add(session_log_record_t *record, bool ok);
+
+/**
+ * @brief Append the queued lines to SESSION_LOG_FILENAME.  Call when no other
+ * file is open.
+ *
+ * @return true if all queued lines were written.
+ */
+bool session_log_flush(void);
+
+/**
+ * @brief Return the number of lines dropped since startup because the queue
+ * was full.
+ */
+uint32_t session_log_dropped_count(void);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SESSION_LOG_H_ */
@@ -0,0 +1,167 @@
+/**
+ * @file spi_trace.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "spi_trace.h"
+
+#if SPI_TRACE_ENABLED
+
+#include "definitions.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define RECORD_INDEX(_i) ((_i) & (SPI_TRACE_RECORDS - 1))
+
+typedef struct {
+  uint32_t n_written; // records started since startup
+  uint32_t n_failed;  // failed commands since the latest phase mark
+  uint8_t phase;      // spi_trace_phase_t of the latest phase mark
+} spi_trace_ctx_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+/**
+ * @brief Write n records starting at s_records[index] to the file.
+ */
+static bool write_records(SYS_FS_HANDLE handle, uint32_t index, uint32_t n);
+
+// *****************************************************************************
+// Private (static) storage
+
+static spi_trace_ctx_t s_spi_trace_ctx;
+
+static spi_trace_record_t s_records[SPI_TRACE_RECORDS];
+
+// *****************************************************************************
+// Public code
+
+void spi_trace_begin(uint8_t command,
+                     uint32_t address,
+                     uint32_t size,
+                     bool crc) {
+  spi_trace_record_t *record =
+      &s_records[RECORD_INDEX(s_spi_trace_ctx.n_written++)];
+
+  record->timestamp = SYS_TIME_CounterGet();
+  record->duration = 0;
+  record->address = address;
+  record->size = (uint16_t)size;
+  record->command = command;
+  record->status = (s_spi_trace_ctx.phase << SPI_TRACE_STATUS_PHASE_SHIFT) |
+                   (crc ? SPI_TRACE_STATUS_CRC : 0);
+}
+
+void spi_trace_end(bool ok) {
+  spi_trace_record_t *record;
+
+  if (s_spi_trace_ctx.n_written == 0) {
+    return;
+  }
+  record = &s_records[RECORD_INDEX(s_spi_trace_ctx.n_written - 1)];
+  if (record->status & (SPI_TRACE_STATUS_DONE | SPI_TRACE_STATUS_FAILED)) {
+    return;
+  }
+  record->duration = SYS_TIME_CounterGet() - record->timestamp;
+  if (ok) {
+    record->status |= SPI_TRACE_STATUS_DONE;
+  } else {
+    record->status |= SPI_TRACE_STATUS_FAILED;
+    s_spi_trace_ctx.n_failed += 1;
+  }
+}
+
+void spi_trace_mark(spi_trace_phase_t phase) {
+  s_spi_trace_ctx.phase = phase;
+  s_spi_trace_ctx.n_failed = 0;
+  spi_trace_begin(SPI_TRACE_COMMAND_MARK, phase, 0, false);
+  s_records[RECORD_INDEX(s_spi_trace_ctx.n_written - 1)].status |=
+      SPI_TRACE_STATUS_DONE;
+}
+
+uint32_t spi_trace_failed_count(void) { return s_spi_trace_ctx.n_failed; }
+
+bool spi_trace_dump(const char *filename) {
+  uint32_t n_written = s_spi_trace_ctx.n_written;
+  uint32_t n_records =
+      (n_written < SPI_TRACE_RECORDS) ? n_written : SPI_TRACE_RECORDS;
+  uint32_t first = RECORD_INDEX(n_written - n_records);
+  uint32_t n_to_end = SPI_TRACE_RECORDS - first;
+  spi_trace_header_t header;
+  SYS_FS_HANDLE handle;
+  bool ok;
+
+  memcpy(header.magic, SPI_TRACE_MAGIC, sizeof(header.magic));
+  header.version = SPI_TRACE_VERSION;
+  header.record_size = sizeof(spi_trace_record_t);
+  header.tick_hz = SYS_TIME_FrequencyGet();
+  header.n_records = n_records;
+  header.n_lost = n_written - n_records;
+
+  handle = SYS_FS_FileOpen(filename, SYS_FS_FILE_OPEN_WRITE);
+  if (handle == SYS_FS_HANDLE_INVALID) {
+    SYS_DEBUG_PRINT(SYS_ERROR_ERROR, "\nCould not open file %s", filename);
+    return false;
+  }
+  ok = SYS_FS_FileWrite(handle, &header, sizeof(header)) == sizeof(header);
+  // the ring may wrap: write up to its end, then from its start.
+  if (n_records <= n_to_end) {
+    ok = ok && write_records(handle, first, n_records);
+  } else {
+    ok = ok && write_records(handle, first, n_to_end) &&
+         write_records(handle, 0, n_records - n_to_end);
+  }
+  if (SYS_FS_FileClose(handle) != SYS_FS_RES_SUCCESS) {
+    ok = false;
+  }
+  if (!ok) {
+    SYS_DEBUG_PRINT(SYS_ERROR_ERROR, "\nFailed to write %s", filename);
+    return false;
+  }
+  SYS_CONSOLE_PRINT("\nWrote %ld SPI trace records to %s", n_records, filename);
+  return true;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool write_records(SYS_FS_HANDLE handle, uint32_t index, uint32_t n) {
+  size_t n_bytes = n * sizeof(spi_trace_record_t);
+
+  return SYS_FS_FileWrite(handle, &s_records[index], n_bytes) == n_bytes;
+}
+
+#endif // #if SPI_TRACE_ENABLED
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,193 @@
+/**
+ * @file spi_trace.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief spi_trace keeps a record of the latest commands on the WINC's SPI bus.
+ *
+ * nmspi.c records each command it sends to the WINC. The record holds the
+ * opcode, address, size, result, whether CRC was on, a SYS_TIME timestamp and
+ * how long the attempt took. Records go in a RAM ring buffer of
+ * SPI_TRACE_RECORDS entries, which always holds the most recent ones.
+ * winc_cloner marks the start of each operation (extract, update...) in the
+ * trace.
+ *
+ * spi_trace_dump() writes the ring to a file, oldest record first.  The
+ * cmd_task 't' command does so on demand.  winc_cloner does so by itself when
+ * an operation fails after bus commands have failed.  host/spi_trace_decode.py
+ * renders the file as a timeline and summarizes each operation's throughput,
+ * retries and longest gap.
+ *
+ * Recording costs two timestamps and a few stores per command.  Define
+ * SPI_TRACE_ENABLED as 0 to build without it.
+ */
+
+#ifndef _SPI_TRACE_H_
+#define _SPI_TRACE_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#ifndef SPI_TRACE_ENABLED
+#define SPI_TRACE_ENABLED 1
+#endif
+
+#define SPI_TRACE_RECORDS 1024 // ring buffer size, must be a power of two
+#define SPI_TRACE_FILENAME "spi_trace.bin"
+
+// File layout, little-endian: an spi_trace_header_t, then n_records
+// spi_trace_record_t, oldest first.
+#define SPI_TRACE_MAGIC "WSPT"
+#define SPI_TRACE_VERSION 1
+
+// The command of a phase mark.  Otherwise, command is the WINC SPI opcode.
+#define SPI_TRACE_COMMAND_MARK 0x00
+
+// spi_trace_record_t.status bits.  A command with neither DONE nor FAILED set
+// got no result: a reset, or an attempt interrupted by the dump.
+#define SPI_TRACE_STATUS_DONE 0x01
+#define SPI_TRACE_STATUS_FAILED 0x02
+#define SPI_TRACE_STATUS_CRC 0x04 // CRC protection was on
+// The phase the command belongs to, in case its mark was overwritten.
+#define SPI_TRACE_STATUS_PHASE_SHIFT 4
+#define SPI_TRACE_STATUS_PHASE_MASK 0x70
+
+typedef enum {
+  SPI_TRACE_PHASE_IDLE,
+  SPI_TRACE_PHASE_EXTRACT,
+  SPI_TRACE_PHASE_UPDATE,
+  SPI_TRACE_PHASE_COMPARE,
+  SPI_TRACE_PHASE_REBUILD_PLL,
+  SPI_TRACE_PHASE_IDENTIFY,
+  SPI_TRACE_PHASE_PROBE,
+} spi_trace_phase_t;
+
+typedef struct {
+  char magic[4];        // SPI_TRACE_MAGIC, not NUL-terminated
+  uint16_t version;     // SPI_TRACE_VERSION
+  uint16_t record_size; // sizeof(spi_trace_record_t)
+  uint32_t tick_hz;     // SYS_TIME counter rate
+  uint32_t n_records;   // records in the file
+  uint32_t n_lost;      // older records overwritten before the dump
+} spi_trace_header_t;
+
+typedef struct {
+  uint32_t timestamp; // SYS_TIME counter when the command started
+  uint32_t duration;  // SYS_TIME counts until its result was known
+  uint32_t address;   // WINC address, or spi_trace_phase_t of a mark
+  uint16_t size;      // bytes of data
+  uint8_t command;    // WINC SPI opcode, or SPI_TRACE_COMMAND_MARK
+  uint8_t status;     // SPI_TRACE_STATUS_xxx bits
+} spi_trace_record_t;
+
+#if SPI_TRACE_ENABLED
+
+/**
+ * @brief Record the start of a command.  Called from nmspi.c.
+ */
+#define SPI_TRACE_BEGIN(_command, _address, _size, _crc)                       \
+  spi_trace_begin((_command), (_address), (_size), (_crc))
+
+/**
+ * @brief Record the result of the latest command.  Called from nmspi.c.
+ */
+#define SPI_TRACE_END(_ok) spi_trace_end(_ok)
+
+/**
+ * @brief Record the start of a phase.
+ */
+#define SPI_TRACE_MARK(_phase) spi_trace_mark(_phase)
+
+#else
+
+#define SPI_TRACE_BEGIN(_command, _address, _size, _crc) ((void)0)
+
+#define SPI_TRACE_END(_ok) ((void)0)
+
+#define SPI_TRACE_MARK(_phase) ((void)0)
+
+#endif
+
+// *****************************************************************************
+// Public declarations
+
+#if SPI_TRACE_ENABLED
+
+/**
+ * @brief Start a record for a command.  Overwrites the oldest record once the
+ * ring is full.
+ */
+void spi_trace_begin(uint8_t command,
+                     uint32_t address,
+                     uint32_t size,
+                     bool crc);
+
+/**
+ * @brief Complete the latest record with its result and duration.  Does
+ * nothing if that record already has a result.
+ */
+void spi_trace_end(bool ok);
+
+/**
+ * @brief Record the start of a phase.  Called through SPI_TRACE_MARK().
+ */
+void spi_trace_mark(spi_trace_phase_t phase);
+
+/**
+ * @brief Return the number of failed commands recorded since the latest
+ * phase mark.
+ */
+uint32_t spi_trace_failed_count(void);
+
+/**
+ * @brief Write the records in the ring to the named file, replacing it.
+ *
+ * @return true on success
+ */
+bool spi_trace_dump(const char *filename);
+
+#endif
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _SPI_TRACE_H_ */
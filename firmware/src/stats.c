@@ -0,0 +1,130 @@
+/**
+ * @file stats.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "stats.h"
+
+#if STATS_ENABLED
+
+#include "definitions.h"
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+// WINC SPI command opcodes: see nmspi.c.
+#define SPI_CMD_INTERNAL_WRITE 0xc3
+#define SPI_CMD_INTERNAL_READ 0xc4
+#define SPI_CMD_DMA_EXT_WRITE 0xc7
+#define SPI_CMD_DMA_EXT_READ 0xc8
+#define SPI_CMD_SINGLE_WRITE 0xc9
+#define SPI_CMD_SINGLE_READ 0xca
+#define SPI_CMD_RESET 0xcf
+
+typedef struct {
+  uint32_t counts[STATS_COUNTER_COUNT];
+  uint64_t start_count; // SYS_TIME counter at the last reset
+  uint32_t start_drops; // console bytes dropped before the last reset
+} stats_ctx_t;
+
+// *****************************************************************************
+// Private (static) storage
+
+#define STATS_EXPAND_COUNTER_NAMES(_name) #_name,
+static const char *s_counter_names[] = {
+    STATS_COUNTERS(STATS_EXPAND_COUNTER_NAMES)};
+
+static stats_ctx_t s_stats_ctx;
+
+// *****************************************************************************
+// Public code
+
+void stats_add(stats_counter_t counter, uint32_t n) {
+  s_stats_ctx.counts[counter] += n;
+}
+
+void stats_spi_command(uint8_t command) {
+  stats_counter_t counter;
+
+  switch (command) {
+  case SPI_CMD_INTERNAL_WRITE:
+    counter = STATS_SPI_CMD_INTERNAL_WRITE;
+    break;
+  case SPI_CMD_INTERNAL_READ:
+    counter = STATS_SPI_CMD_INTERNAL_READ;
+    break;
+  case SPI_CMD_DMA_EXT_WRITE:
+    counter = STATS_SPI_CMD_DMA_EXT_WRITE;
+    break;
+  case SPI_CMD_DMA_EXT_READ:
+    counter = STATS_SPI_CMD_DMA_EXT_READ;
+    break;
+  case SPI_CMD_SINGLE_WRITE:
+    counter = STATS_SPI_CMD_SINGLE_WRITE;
+    break;
+  case SPI_CMD_SINGLE_READ:
+    counter = STATS_SPI_CMD_SINGLE_READ;
+    break;
+  case SPI_CMD_RESET:
+    counter = STATS_SPI_CMD_RESET;
+    break;
+  default:
+    counter = STATS_SPI_CMD_OTHER;
+    break;
+  }
+  s_stats_ctx.counts[counter] += 1;
+}
+
+void stats_reset(void) {
+  memset(s_stats_ctx.counts, 0, sizeof(s_stats_ctx.counts));
+  s_stats_ctx.start_count = SYS_TIME_Counter64Get();
+  s_stats_ctx.start_drops = SERCOM2_USART_WriteDropCountGet();
+}
+
+void stats_print(void) {
+  uint64_t elapsed = SYS_TIME_Counter64Get() - s_stats_ctx.start_count;
+
+  SYS_CONSOLE_PRINT("\ncounters for the last %lu ms",
+                    (uint32_t)(elapsed * 1000 / SYS_TIME_FrequencyGet()));
+  for (int i = 0; i < STATS_COUNTER_COUNT; i++) {
+    // skip the "STATS_" prefix
+    SYS_CONSOLE_PRINT("\n%-24s %10lu",
+                      s_counter_names[i] + sizeof("STATS_") - 1,
+                      s_stats_ctx.counts[i]);
+  }
+  SYS_CONSOLE_PRINT(
+      "\n%-24s %10lu",
+      "CONSOLE_BYTES_DROPPED",
+      SERCOM2_USART_WriteDropCountGet() - s_stats_ctx.start_drops);
+}
+
+#endif // #if STATS_ENABLED
+
+// *****************************************************************************
+// End of file
@@ -0,0 +1,147 @@
+/**
+ * @file stats.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief stats keeps running counts of the traffic on the WINC's SPI bus, the
+ * work done on its serial flash and the blocks moved to and from the SD card.
+ *
+ * Drivers count events as they happen:
+ *
+ *     STATS_INC(STATS_FLASH_ERASES);
+ *     STATS_ADD(STATS_SPI_BYTES_OUT, txSize);
+ *
+ * Each is one addition to a RAM counter, so the counts are kept at all times,
+ * from startup on.
+ * The console's 'k' command prints them, along with the console bytes dropped
+ * since the last reset, and then resets them.  Counting must not be done in
+ * interrupt handlers.
+ *
+ * Define STATS_ENABLED as 0 (in the project's preprocessor macros) to build
+ * the firmware without the counters.
+ */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+#ifndef STATS_ENABLED
+#define STATS_ENABLED 1
+#endif
+
+// The counters, in the order stats_print() lists them.
+#define STATS_COUNTERS(M)                                                      \
+  M(STATS_SPI_CMD_INTERNAL_WRITE)                                              \
+  M(STATS_SPI_CMD_INTERNAL_READ)                                               \
+  M(STATS_SPI_CMD_DMA_EXT_WRITE)                                               \
+  M(STATS_SPI_CMD_DMA_EXT_READ)                                                \
+  M(STATS_SPI_CMD_SINGLE_WRITE)                                                \
+  M(STATS_SPI_CMD_SINGLE_READ)                                                 \
+  M(STATS_SPI_CMD_RESET)                                                       \
+  M(STATS_SPI_CMD_OTHER)                                                       \
+  M(STATS_SPI_BYTES_OUT)                                                       \
+  M(STATS_SPI_BYTES_IN)                                                        \
+  M(STATS_SPI_DMA_TRANSFERS)                                                   \
+  M(STATS_SPI_SEM_WAITS)                                                       \
+  M(STATS_FLASH_ERASES)                                                        \
+  M(STATS_FLASH_PAGE_PROGRAMS)                                                 \
+  M(STATS_FLASH_STATUS_POLLS)                                                  \
+  M(STATS_SD_BLOCKS_READ)                                                      \
+  M(STATS_SD_BLOCKS_WRITTEN)
+
+#define STATS_EXPAND_COUNTER_IDS(_name) _name,
+typedef enum {
+  STATS_COUNTERS(STATS_EXPAND_COUNTER_IDS) STATS_COUNTER_COUNT
+} stats_counter_t;
+
+#if STATS_ENABLED
+
+#define STATS_ADD(_counter, _n) stats_add((_counter), (_n))
+
+#define STATS_INC(_counter) stats_add((_counter), 1)
+
+#define STATS_SPI_COMMAND(_command) stats_spi_command(_command)
+
+#else
+
+#define STATS_ADD(_counter, _n) ((void)0)
+
+#define STATS_INC(_counter) ((void)0)
+
+#define STATS_SPI_COMMAND(_command) ((void)0)
+
+#endif
+
+// *****************************************************************************
+// Public declarations
+
+#if STATS_ENABLED
+
+/**
+ * @brief Add n to counter.  Called through STATS_ADD() and STATS_INC().
+ */
+void stats_add(stats_counter_t counter, uint32_t n);
+
+/**
+ * @brief Count a command sent to the WINC over SPI under its type.  Called
+ * through STATS_SPI_COMMAND().
+ */
+void stats_spi_command(uint8_t command);
+
+/**
+ * @brief Clear the counters and start a new period.
+ */
+void stats_reset(void);
+
+/**
+ * @brief Print the counters on the console, with the length of the period
+ * they cover and the console bytes dropped during it.
+ */
+void stats_print(void);
+
+#endif
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _STATS_H_ */
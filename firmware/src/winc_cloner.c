@@ -98,11 +98,19 @@ int main() {
 
 #include "winc_cloner.h"
 
+#include "binlog.h"
+#include "crc32.h"
 #include "definitions.h"
+#include "dir_reader.h"
 #include "efuse.h"
+#include "progress.h"
 #include "m2m_wifi.h"
+#include "prof.h"
+#include "session_log.h"
 #include "spi_flash.h"
 #include "spi_flash_map.h"
+#include "spi_trace.h"
+#include "winc_image.h"
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -116,6 +124,21 @@ int main() {
 #define NUM_CHANNELS 14
 #define NUM_FREQS 84
 
+// Cluster link map for fast seeks within an image file: two entries per
+// fragment plus two.  A 1 MB image on a card with 4 KB clusters that is split
+// into more than 31 fragments falls back to ordinary (chain walking) seeks.
+#define LINK_MAP_LEN 64
+
+// Sectors of the largest WINC flash, for winc_cloner_identify().
+#define MAX_WINC_SECTORS (FLASH_8M_TOTAL_SZ / FLASH_SECTOR_SZ)
+
+// An image of the catalog and the number of its sectors that match the WINC.
+typedef struct {
+  bool is_valid;
+  uint16_t idx;
+  uint32_t n_matches;
+} identify_match_t;
+
 typedef struct {
   uint32_t u32PllInternal1;
   uint32_t u32PllInternal4;
@@ -159,6 +182,81 @@ static sector_result_t winc_sector_read(uint8_t *dst, uint32_t src_addr);
  */
 static sector_result_t winc_sector_write(uint8_t *src, uint32_t dst_addr);
 
+/**
+ * @brief Erase one sector of WINC flash memory and write it from src.
+ *
+ * NOTE: addr must fall on a FLASH_SECTOR_SZ boundary.
+ * NOTE: src must be at least FLASH_SECTOR_SZ bytes big.
+ */
+static sector_result_t winc_sector_program(uint8_t *src, uint32_t dst_addr);
+
+static bool update_from_source(const char *label,
+                               uint32_t n_bytes,
+                               winc_cloner_source_fn source);
+
+static bool rebuild_pll(void);
+
+static bool identify(void);
+
+static bool probe(void);
+
+/**
+ * @brief Read the control sector, or its backup if the control sector is not
+ * valid.  Return false if neither is.
+ */
+static bool probe_control_sector(tstrOtaControlSec *control);
+
+/**
+ * @brief Find the firmware's version record in the OTA image at image_addr.
+ * Return false if the image doesn't hold one.
+ */
+static bool probe_image(uint32_t image_addr, winc_image_rev_t *rev);
+
+/**
+ * @brief Return the number of sectors in which the manifest of an image
+ * matches the fingerprints of s_winc_crcs.
+ */
+static uint32_t count_matches(const uint16_t *manifest,
+                              uint16_t n_manifest,
+                              uint32_t n_sectors);
+
+/**
+ * @brief Read the idx'th image from the SD card and set *n_matches to the
+ * number of sectors whose CRC-32 matches s_winc_crcs, marking the others in
+ * s_differs.  Return false if the file could not be read or a key was pressed.
+ */
+static bool read_matches(uint16_t idx,
+                         uint32_t n_sectors,
+                         uint32_t *n_matches);
+
+/**
+ * @brief Read the idx'th image with read_matches(), print how many of its
+ * sectors match and make it the best match if it beats *best.  Return false if
+ * identify() should stop.
+ */
+static bool read_and_rank(uint16_t idx,
+                          uint32_t n_sectors,
+                          uint32_t n_compared,
+                          identify_match_t *best);
+
+/**
+ * @brief Print how many sectors of the idx'th image match the WINC.
+ */
+static void print_matches(uint16_t idx,
+                          uint32_t n_matches,
+                          uint32_t n_compared,
+                          bool was_read);
+
+/**
+ * @brief Print the runs of sectors marked in s_best_differs.
+ */
+static void print_differences(uint32_t n_sectors);
+
+/**
+ * @brief Return true if a key has been pressed to stop an operation.
+ */
+static bool key_was_pressed(void);
+
 static bool cloner_aux(const char *filename,
                        SYS_FS_FILE_OPEN_ATTRIBUTES file_mode,
                        bool (*inner_loop)(SYS_FS_HANDLE file_handle,
@@ -167,15 +265,46 @@ static bool cloner_aux(const char *filename,
 static bool extract_loop(SYS_FS_HANDLE file_handle, size_t n_bytes);
 static bool update_loop(SYS_FS_HANDLE file_handle, size_t n_bytes);
 static bool compare_loop(SYS_FS_HANDLE file_handle, size_t n_bytes);
+static bool source_loop(winc_cloner_source_fn source, uint32_t n_bytes);
+
+/**
+ * @brief Read the next to_xfer bytes of the image file into s_xfer_buf.
+ */
+static bool file_read(SYS_FS_HANDLE file_handle, size_t to_xfer);
+
+static bool is_pll_sector(uint32_t addr);
 
 static bool buffers_are_equal(uint8_t *buf_a, uint8_t *buf_b, size_t n_bytes);
 
+/**
+ * @brief Count a sector processed in the session record.
+ */
+static void count_sector(sector_result_t res);
+
+/**
+ * @brief If the operation stopped before it read the whole image file, take
+ * the image's digest from the catalog instead, if the file has been scanned.
+ */
+static void digest_from_catalog(const char *filename);
+
 static int32_t winc3400_pll_table_build(uint8_t *pBuffer, uint32_t freqOffset);
 
 static bool open_winc(void);
 
 static void dump_pll_data(uint8_t *buf, const char *msg);
 
+/**
+ * @brief Mark the end of an operation in the SPI trace.  If the operation
+ * failed after bus commands failed, save the trace to SPI_TRACE_FILENAME.
+ */
+static void trace_finish(bool ok);
+
+/**
+ * @brief Fill in the WINC's identity and queue the session record.  The caller
+ * writes it out with session_log_flush() once the image file is closed.
+ */
+static void session_finish(bool ok);
+
 // *****************************************************************************
 // Private (static) storage
 
@@ -187,6 +316,16 @@ uint8_t pllFlashSector[M2M_PLL_FLASH_SZ] = {0};
 
 static bool s_winc_is_opened;
 
+static uint32_t s_link_map[LINK_MAP_LEN];
+
+static session_log_record_t s_session;
+
+// identify(): the CRC-32 of each WINC sector, then one bit per sector for
+// those that differ in the image read last and in the best match so far.
+static uint32_t s_winc_crcs[MAX_WINC_SECTORS];
+static uint8_t s_differs[MAX_WINC_SECTORS / 8];
+static uint8_t s_best_differs[MAX_WINC_SECTORS / 8];
+
 // *****************************************************************************
 // Public code
 
@@ -195,7 +334,11 @@ void winc_cloner_init(void) {
 }
 
 bool winc_cloner_extract(const char *filename) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_EXTRACT);
+  session_log_start(&s_session, "extract", filename);
   bool ret = cloner_aux(filename, SYS_FS_FILE_OPEN_WRITE, extract_loop);
+  session_finish(ret);
+  trace_finish(ret);
   if (ret) {
     SYS_DEBUG_PRINT(SYS_ERROR_INFO,
                     "\nSuccessfully extracted WINC contents into %s",
@@ -205,7 +348,12 @@ bool winc_cloner_extract(const char *filename) {
 }
 
 bool winc_cloner_update(const char *filename) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_UPDATE);
+  session_log_start(&s_session, "update", filename);
   bool ret = cloner_aux(filename, SYS_FS_FILE_OPEN_READ, update_loop);
+  digest_from_catalog(filename);
+  session_finish(ret);
+  trace_finish(ret);
   if (ret) {
     SYS_DEBUG_PRINT(SYS_ERROR_INFO,
                     "\nSuccessfully updated WINC contents from %s",
@@ -214,8 +362,24 @@ bool winc_cloner_update(const char *filename) {
   return ret;
 }
 
+bool winc_cloner_update_from_source(const char *label,
+                                    uint32_t n_bytes,
+                                    winc_cloner_source_fn source) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_UPDATE);
+  session_log_start(&s_session, "update", label);
+  bool ret = update_from_source(label, n_bytes, source);
+  session_finish(ret);
+  trace_finish(ret);
+  return ret;
+}
+
 bool winc_cloner_compare(const char *filename) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_COMPARE);
+  session_log_start(&s_session, "compare", filename);
   bool ret = cloner_aux(filename, SYS_FS_FILE_OPEN_READ, compare_loop);
+  digest_from_catalog(filename);
+  session_finish(ret);
+  trace_finish(ret);
   if (ret) {
     SYS_DEBUG_PRINT(SYS_ERROR_INFO,
                     "\nSuccessfully compared WINC contents to %s",
@@ -225,12 +389,66 @@ bool winc_cloner_compare(const char *filename) {
 }
 
 bool winc_cloner_rebuild_pll(void) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_REBUILD_PLL);
+  bool ret = rebuild_pll();
+  trace_finish(ret);
+  return ret;
+}
+
+bool winc_cloner_probe(void) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_PROBE);
+  bool ret = probe();
+  trace_finish(ret);
+  return ret;
+}
+
+bool winc_cloner_identify(void) {
+  SPI_TRACE_MARK(SPI_TRACE_PHASE_IDENTIFY);
+  bool ret = identify();
+  trace_finish(ret);
+  return ret;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+static bool update_from_source(const char *label,
+                               uint32_t n_bytes,
+                               winc_cloner_source_fn source) {
+  uint32_t flash_bytes;
+  bool ret;
 
   if (!open_winc()) {
     SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "\nCould not open WINC");
     return false;
   }
 
+  flash_bytes = spi_flash_get_size() << 17; // convert megabits to bytes
+  if ((n_bytes == 0) || (n_bytes > flash_bytes) ||
+      ((n_bytes % FLASH_SECTOR_SZ) != 0)) {
+    SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
+                    "\n%ld byte image from %s does not fit %ld byte WINC",
+                    n_bytes,
+                    label,
+                    flash_bytes);
+    return false;
+  }
+  SYS_CONSOLE_MESSAGE("\n");
+  ret = source_loop(source, n_bytes);
+  progress_finish(ret);
+  if (ret) {
+    SYS_DEBUG_PRINT(
+        SYS_ERROR_INFO, "\nSuccessfully updated WINC contents from %s", label);
+  }
+  return ret;
+}
+
+static bool rebuild_pll(void) {
+  if (!open_winc()) {
+    SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "\nCould not open WINC");
+    return false;
+  }
+
   // fetch a copy of the PLL / GAIN tables
   if (winc_sector_read(s_xfer_buf, M2M_PLL_FLASH_OFFSET) != SECTOR_OKAY) {
     SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
@@ -278,8 +496,318 @@ bool winc_cloner_rebuild_pll(void) {
   return true;
 }
 
-// *****************************************************************************
-// Private (static) code
+static bool identify(void) {
+  uint32_t n_sectors;
+  uint32_t n_compared = 0;
+  uint16_t n_manifest;
+  const uint16_t *manifest;
+  identify_match_t best = {0};
+  identify_match_t candidate = {0};
+
+  if (!open_winc()) {
+    SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "\nCould not open WINC");
+    return false;
+  }
+  n_sectors = (spi_flash_get_size() << 17) / FLASH_SECTOR_SZ;
+  if ((n_sectors == 0) || (n_sectors > MAX_WINC_SECTORS)) {
+    SYS_DEBUG_PRINT(
+        SYS_ERROR_ERROR, "\nUnexpected WINC flash of %ld sectors", n_sectors);
+    return false;
+  }
+
+  // one pass over the WINC, keeping only the CRC-32 of each sector.
+  SYS_CONSOLE_MESSAGE("\n");
+  progress_start("Identifying", NULL, n_sectors, FLASH_SECTOR_SZ);
+  for (uint32_t i = 0; i < n_sectors; i++) {
+    if (key_was_pressed()) {
+      progress_finish(false);
+      SYS_CONSOLE_MESSAGE("\nStopped by a key press");
+      return false;
+    }
+    if (winc_sector_read(s_xfer_buf, i * FLASH_SECTOR_SZ) != SECTOR_OKAY) {
+      progress_finish(false);
+      return false;
+    }
+    s_winc_crcs[i] = crc32_update(0, s_xfer_buf, FLASH_SECTOR_SZ);
+    if (!is_pll_sector(i * FLASH_SECTOR_SZ)) {
+      // WINC sectors past the end of an image count as differing.
+      n_compared += 1;
+    }
+    progress_update(i + 1, 0);
+  }
+  progress_finish(true);
+
+  // Manifests rank the scanned images without opening them.  An image the
+  // background scan has not reached, or that found the manifest pool full, is
+  // read now.
+  for (uint16_t idx = 0; idx < dir_reader_filename_count(); idx++) {
+    uint32_t n_matches;
+
+    if (dir_reader_image_ref(idx)->flags & DIR_READER_IMAGE_SKIPPED) {
+      continue; // empty, too large or unreadable.
+    }
+    manifest = dir_reader_manifest_ref(idx, &n_manifest);
+    if (manifest == NULL) {
+      if (!read_and_rank(idx, n_sectors, n_compared, &best)) {
+        return false;
+      }
+      continue;
+    }
+    n_matches = count_matches(manifest, n_manifest, n_sectors);
+    print_matches(idx, n_matches, n_compared, false);
+    if (!candidate.is_valid || (n_matches > candidate.n_matches)) {
+      candidate.is_valid = true;
+      candidate.idx = idx;
+      candidate.n_matches = n_matches;
+    }
+  }
+
+  // A 16-bit fingerprint matches by chance one time in 65536, so a manifest
+  // only gives an upper bound.  Read back the image with the most matching
+  // fingerprints, then any other that still promises more than the best image
+  // read so far.
+  if (candidate.is_valid &&
+      (!best.is_valid || (candidate.n_matches > best.n_matches))) {
+    if (!read_and_rank(candidate.idx, n_sectors, n_compared, &best)) {
+      return false;
+    }
+    for (uint16_t idx = 0; idx < dir_reader_filename_count(); idx++) {
+      manifest = dir_reader_manifest_ref(idx, &n_manifest);
+      if ((idx == candidate.idx) || (manifest == NULL) ||
+          (dir_reader_image_ref(idx)->flags & DIR_READER_IMAGE_SKIPPED) ||
+          (count_matches(manifest, n_manifest, n_sectors) <= best.n_matches)) {
+        continue;
+      }
+      if (!read_and_rank(idx, n_sectors, n_compared, &best)) {
+        return false;
+      }
+    }
+  }
+
+  if (!best.is_valid) {
+    SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "\nNo image to identify against");
+    return false;
+  }
+  SYS_CONSOLE_PRINT("\nBest match: %s, %ld%% of sectors identical",
+                    dir_reader_filename_ref(best.idx),
+                    (best.n_matches * 100) / n_compared);
+  if (best.n_matches < n_compared) {
+    print_differences(n_sectors);
+  }
+  return true;
+}
+
+static bool probe(void) {
+  static const uint32_t image_addrs[] = {M2M_OTA_IMAGE1_OFFSET,
+                                         M2M_OTA_IMAGE2_OFFSET};
+  uint64_t start = SYS_TIME_Counter64Get();
+  tstrOtaControlSec control;
+  bool has_control;
+  uint32_t flash_sz;
+
+  if (!open_winc()) {
+    SYS_DEBUG_MESSAGE(SYS_ERROR_ERROR, "\nCould not open WINC");
+    return false;
+  }
+  flash_sz = spi_flash_get_size() << 17;
+  has_control = probe_control_sector(&control);
+  if (has_control) {
+    SYS_CONSOLE_PRINT("\nControl sector: sequence %ld, format 0x%lx",
+                      control.u32OtaSequenceNumber,
+                      control.u32OtaFormatVersion);
+  } else {
+    SYS_CONSOLE_MESSAGE("\nNo valid control sector: active image unknown");
+  }
+
+  for (size_t i = 0; i < sizeof(image_addrs) / sizeof(image_addrs[0]); i++) {
+    uint32_t addr = image_addrs[i];
+    const char *role = "";
+    winc_image_rev_t rev;
+
+    if (addr + OTA_IMAGE_SIZE > flash_sz) {
+      continue; // no room for this image on a small flash.
+    }
+    if (has_control && (addr == control.u32OtaCurrentWorkingImagOffset)) {
+      role = " (active)";
+    } else if (has_control && (addr == control.u32OtaRollbackImageOffset)) {
+      role = (control.u32OtaRollbackImageValidStatus == OTA_STATUS_VALID)
+                 ? " (rollback)"
+                 : " (rollback, invalid)";
+    }
+    SYS_CONSOLE_PRINT("\nImage %d at 0x%06lx%s: ", i + 1, addr, role);
+    if (!probe_image(addr, &rev)) {
+      SYS_CONSOLE_MESSAGE("no version record");
+      continue;
+    }
+    SYS_CONSOLE_PRINT("v%d.%d.%d, driver >= v%d.%d.%d, built %.12s %.9s",
+                      M2M_GET_MAJOR(rev.fw_version),
+                      M2M_GET_MINOR(rev.fw_version),
+                      M2M_GET_PATCH(rev.fw_version),
+                      M2M_GET_MAJOR(rev.drv_version),
+                      M2M_GET_MINOR(rev.drv_version),
+                      M2M_GET_PATCH(rev.drv_version),
+                      rev.build_date,
+                      rev.build_time);
+  }
+  SYS_CONSOLE_PRINT(
+      "\nProbed in %ld ms",
+      (uint32_t)((SYS_TIME_Counter64Get() - start) * 1000 /
+                 SYS_TIME_FrequencyGet()));
+  return true;
+}
+
+static bool probe_control_sector(tstrOtaControlSec *control) {
+  static const uint32_t addrs[] = {M2M_CONTROL_FLASH_OFFSET,
+                                   M2M_CONTROL_FLASH_BKP_OFFSET};
+
+  for (size_t i = 0; i < sizeof(addrs) / sizeof(addrs[0]); i++) {
+    if ((spi_flash_read((uint8_t *)control, addrs[i], sizeof(*control)) ==
+         M2M_SUCCESS) &&
+        (control->u32OtaMagicValue == OTA_MAGIC_VALUE)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool probe_image(uint32_t image_addr, winc_image_rev_t *rev) {
+  uint8_t header[WINC_IMAGE_BOOT_HEADER_SZ];
+  uint8_t window[WINC_IMAGE_REV_WINDOW_SZ];
+  uint32_t window_offset;
+
+  if (spi_flash_read(header, image_addr, sizeof(header)) != M2M_SUCCESS) {
+    return false;
+  }
+  window_offset = winc_image_rev_window(header);
+  if ((window_offset == 0) ||
+      (spi_flash_read(window, image_addr + window_offset, sizeof(window)) !=
+       M2M_SUCCESS)) {
+    return false;
+  }
+  return winc_image_find_rev(window, rev);
+}
+
+static uint32_t count_matches(const uint16_t *manifest,
+                              uint16_t n_manifest,
+                              uint32_t n_sectors) {
+  uint32_t n_matches = 0;
+
+  for (uint32_t i = 0; (i < n_sectors) && (i < n_manifest); i++) {
+    if (!is_pll_sector(i * FLASH_SECTOR_SZ) &&
+        (manifest[i] == DIR_READER_FINGERPRINT(s_winc_crcs[i]))) {
+      n_matches += 1;
+    }
+  }
+  return n_matches;
+}
+
+static bool read_matches(uint16_t idx,
+                         uint32_t n_sectors,
+                         uint32_t *n_matches) {
+  const char *filename = dir_reader_filename_ref(idx);
+  SYS_FS_HANDLE file_handle;
+  bool stopped = false;
+  bool ok = true;
+
+  file_handle = SYS_FS_FileOpen(filename, SYS_FS_FILE_OPEN_READ);
+  if (file_handle == SYS_FS_HANDLE_INVALID) {
+    SYS_DEBUG_PRINT(SYS_ERROR_ERROR, "\nCould not open file %s", filename);
+    return false;
+  }
+  memset(s_differs, 0, sizeof(s_differs));
+  *n_matches = 0;
+  SYS_CONSOLE_MESSAGE("\n");
+  progress_start(filename, NULL, n_sectors, FLASH_SECTOR_SZ);
+  for (uint32_t i = 0; i < n_sectors; i++) {
+    int32_t n_read = SYS_FS_FileRead(file_handle, s_xfer_buf, FLASH_SECTOR_SZ);
+
+    if (n_read < 0) {
+      SYS_DEBUG_PRINT(
+          SYS_ERROR_ERROR, "\nFailed to read sector %ld of %s", i, filename);
+      ok = false;
+      break;
+    }
+    if (key_was_pressed()) {
+      stopped = true;
+      break;
+    }
+    if (is_pll_sector(i * FLASH_SECTOR_SZ)) {
+      // not compared.
+    } else if ((n_read == FLASH_SECTOR_SZ) &&
+               (crc32_update(0, s_xfer_buf, FLASH_SECTOR_SZ) ==
+                s_winc_crcs[i])) {
+      *n_matches += 1;
+    } else {
+      // differs, or lies past the end of the image.
+      s_differs[i / 8] |= 1 << (i % 8);
+    }
+    progress_update(i + 1, 0);
+  }
+  progress_finish(ok && !stopped);
+  SYS_FS_FileClose(file_handle);
+  if (stopped) {
+    SYS_CONSOLE_MESSAGE("\nStopped by a key press");
+  }
+  return ok && !stopped;
+}
+
+static bool read_and_rank(uint16_t idx,
+                          uint32_t n_sectors,
+                          uint32_t n_compared,
+                          identify_match_t *best) {
+  uint32_t n_matches;
+
+  if (!read_matches(idx, n_sectors, &n_matches)) {
+    return false;
+  }
+  print_matches(idx, n_matches, n_compared, true);
+  if (!best->is_valid || (n_matches > best->n_matches)) {
+    best->is_valid = true;
+    best->idx = idx;
+    best->n_matches = n_matches;
+    memcpy(s_best_differs, s_differs, sizeof(s_best_differs));
+  }
+  return true;
+}
+
+static void print_matches(uint16_t idx,
+                          uint32_t n_matches,
+                          uint32_t n_compared,
+                          bool was_read) {
+  SYS_CONSOLE_PRINT("\n%3ld%% %4ld of %4ld sectors identical: %s%s",
+                    (n_matches * 100) / n_compared,
+                    n_matches,
+                    n_compared,
+                    dir_reader_filename_ref(idx),
+                    was_read ? " (read)" : "");
+}
+
+static void print_differences(uint32_t n_sectors) {
+  uint32_t run_start = 0;
+  bool in_run = false;
+
+  for (uint32_t i = 0; i <= n_sectors; i++) {
+    bool differs =
+        (i < n_sectors) && ((s_best_differs[i / 8] >> (i % 8)) & 1) != 0;
+
+    if (differs && !in_run) {
+      run_start = i;
+      in_run = true;
+    } else if (!differs && in_run) {
+      SYS_CONSOLE_PRINT("\n  0x%06lx - 0x%06lx differ (%ld sectors)",
+                        run_start * FLASH_SECTOR_SZ,
+                        i * FLASH_SECTOR_SZ - 1,
+                        i - run_start);
+      in_run = false;
+    }
+  }
+}
+
+static bool key_was_pressed(void) {
+  char ch;
+
+  return SYS_CONSOLE_Read(SYS_CONSOLE_DEFAULT_INSTANCE, &ch, sizeof(ch)) > 0;
+}
 
 static sector_result_t winc_sector_read(uint8_t *dst, uint32_t src_addr) {
   if ((src_addr % FLASH_SECTOR_SZ) != 0) {
@@ -288,7 +816,9 @@ static sector_result_t winc_sector_read(uint8_t *dst, uint32_t src_addr) {
                     src_addr);
     return SECTOR_ERROR;
   }
+  uint32_t start = session_log_timer_start();
   uint8_t ret = spi_flash_read(dst, src_addr, FLASH_SECTOR_SZ);
+  session_log_time(&s_session, SESSION_LOG_TIMER_WINC_READ, start);
   if (ret != M2M_SUCCESS) {
     // WINC read failed.
     SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
@@ -297,6 +827,7 @@ static sector_result_t winc_sector_read(uint8_t *dst, uint32_t src_addr) {
                     src_addr);
     return SECTOR_ERROR;
   }
+  s_session.winc_bytes_read += FLASH_SECTOR_SZ;
   return SECTOR_OKAY;
 }
 
@@ -310,7 +841,9 @@ static sector_result_t winc_sector_write(uint8_t *src, uint32_t dst_addr) {
     return SECTOR_ERROR;
   }
 
+  uint32_t start = session_log_timer_start();
   uint8_t ret = spi_flash_read(buf2, dst_addr, FLASH_SECTOR_SZ);
+  session_log_time(&s_session, SESSION_LOG_TIMER_WINC_READ, start);
   if (ret != M2M_SUCCESS) {
     SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
                     "\nFailed to read %ld WINC bytes at 0x%lx",
@@ -318,6 +851,7 @@ static sector_result_t winc_sector_write(uint8_t *src, uint32_t dst_addr) {
                     dst_addr);
     return SECTOR_ERROR;
   }
+  s_session.winc_bytes_read += FLASH_SECTOR_SZ;
 
   if (buffers_are_equal(src, buf2, FLASH_SECTOR_SZ)) {
     // buffers are equal: return immediately
@@ -325,7 +859,20 @@ static sector_result_t winc_sector_write(uint8_t *src, uint32_t dst_addr) {
   }
 
   // buffer differ: erase the sector and write from src
-  if (spi_flash_erase(dst_addr, FLASH_SECTOR_SZ) != M2M_SUCCESS) {
+  if (winc_sector_program(src, dst_addr) != SECTOR_OKAY) {
+    return SECTOR_ERROR;
+  }
+  return SECTOR_DIFFER;
+}
+
+static sector_result_t winc_sector_program(uint8_t *src, uint32_t dst_addr) {
+  PROF_BEGIN(PROF_ZONE_CLONER_PROGRAM_SECTOR);
+  uint32_t start = session_log_timer_start();
+  int8_t ret = spi_flash_erase(dst_addr, FLASH_SECTOR_SZ);
+
+  session_log_time(&s_session, SESSION_LOG_TIMER_ERASE, start);
+  s_session.n_erases += 1;
+  if (ret != M2M_SUCCESS) {
     // winc erase failed
     SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
                     "\nFailed to erase %ld WINC bytes at 0x%lx",
@@ -335,7 +882,11 @@ static sector_result_t winc_sector_write(uint8_t *src, uint32_t dst_addr) {
   }
 
   // Sector has been erased.  Now write the data.
-  if (spi_flash_write(src, dst_addr, FLASH_SECTOR_SZ) != M2M_SUCCESS) {
+  start = session_log_timer_start();
+  ret = spi_flash_write(src, dst_addr, FLASH_SECTOR_SZ);
+  session_log_time(&s_session, SESSION_LOG_TIMER_PROGRAM, start);
+  s_session.n_page_programs += FLASH_SECTOR_SZ / FLASH_PAGE_SZ;
+  if (ret != M2M_SUCCESS) {
     // winc write failed
     SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
                     "\nFailed to write %ld WINC bytes at 0x%lx",
@@ -343,7 +894,10 @@ static sector_result_t winc_sector_write(uint8_t *src, uint32_t dst_addr) {
                     dst_addr);
     return SECTOR_ERROR;
   }
-  return SECTOR_DIFFER;
+  s_session.winc_bytes_written += FLASH_SECTOR_SZ;
+  PROF_END(PROF_ZONE_CLONER_PROGRAM_SECTOR);
+  BINLOG("\nSector 0x%lx programmed", dst_addr);
+  return SECTOR_OKAY;
 }
 
 static bool cloner_aux(const char *filename,
@@ -367,65 +921,141 @@ static bool cloner_aux(const char *filename,
     SYS_DEBUG_PRINT(SYS_ERROR_ERROR, "\nCould not open file %s", filename);
     return false;
   }
+  if (file_mode == SYS_FS_FILE_OPEN_READ) {
+    // Map the image's cluster chain once so reads find clusters without FAT
+    // lookups.
+    if (SYS_FS_FileFastSeekEnable(file_handle, s_link_map, LINK_MAP_LEN) !=
+        SYS_FS_RES_SUCCESS) {
+      SYS_DEBUG_PRINT(SYS_ERROR_DEBUG,
+                      "\n%s too fragmented for fast seek (needs %ld entries)",
+                      filename,
+                      s_link_map[0]);
+    }
+  } else {
+    // Let the card write one sector while the WINC is read for the next.
+    if (SYS_FS_FileWriteBehindEnable(file_handle, true) != SYS_FS_RES_SUCCESS) {
+      SYS_DEBUG_PRINT(SYS_ERROR_DEBUG, "\nWrite-behind unavailable for %s",
+                      filename);
+    }
+  }
   SYS_CONSOLE_MESSAGE("\n");
   ret = inner_loop(file_handle, n_bytes);
-  SYS_FS_FileClose(file_handle); // assure that the file is closed
+  progress_finish(ret);
+  // Closing waits for buffered writes: a write that failed late shows up here.
+  if ((SYS_FS_FileClose(file_handle) != SYS_FS_RES_SUCCESS) && ret) {
+    SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
+                    "\nFailed to close %s, error %d",
+                    filename,
+                    SYS_FS_Error());
+    ret = false;
+  }
 
   return ret;
 }
 
 static bool extract_loop(SYS_FS_HANDLE file_handle, size_t n_bytes) {
   uint32_t src_addr = 0;
+  uint32_t n_sectors = 0;
+
+  progress_start(
+      "Extracting", NULL, n_bytes / FLASH_SECTOR_SZ, FLASH_SECTOR_SZ);
+
+  // The image size is known up front: allocate a contiguous cluster run so the
+  // writes below stream linearly without growing the FAT chain as they go.
+  // A card with no free run that long (SYS_FS_ERROR_DENIED) still takes the
+  // image with ordinary appending writes, only more slowly.
+  if (SYS_FS_FileExpand(file_handle, n_bytes) != SYS_FS_RES_SUCCESS) {
+    SYS_FS_ERROR error = SYS_FS_FileError(file_handle);
+
+    if ((error == SYS_FS_ERROR_DISK_ERR) || (error == SYS_FS_ERROR_INT_ERR) ||
+        (error == SYS_FS_ERROR_NOT_READY)) {
+      SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
+                      "\nCould not allocate %ld bytes, error %d",
+                      n_bytes,
+                      error);
+      return false;
+    }
+    SYS_DEBUG_PRINT(SYS_ERROR_WARNING,
+                    "\nNo contiguous %ld bytes free (error %d), appending\n",
+                    n_bytes,
+                    error);
+  }
 
   while (n_bytes > 0) {
+    PROF_BEGIN(PROF_ZONE_CLONER_EXTRACT_SECTOR);
     size_t to_xfer = n_bytes;
     if (to_xfer > FLASH_SECTOR_SZ) {
       to_xfer = FLASH_SECTOR_SZ;
     }
-    if (winc_sector_read(s_xfer_buf, src_addr) != SECTOR_OKAY) {
+    uint32_t start = session_log_timer_start();
+    int8_t read_ret = spi_flash_read(s_xfer_buf, src_addr, to_xfer);
+    session_log_time(&s_session, SESSION_LOG_TIMER_WINC_READ, start);
+    if (read_ret != M2M_SUCCESS) {
       SYS_DEBUG_PRINT(SYS_ERROR_ERROR,
                       "\nFailed to read %ld bytes at 0x%ld from WINC",
                       to_xfer,
                       src_addr);
       return false;
     }
-    if (SYS_FS_FileWrite(file_handle, s_xfer_buf, to_xfer) < 0) {
+    s_session.winc_bytes_read += to_xfer;
+    // Advance the card through the writes buffered so far.
+    start = session_log_timer_start();
+    SYS_FS_RESULT fs_ret = SYS_FS_FileWriteBehindTasks(file_handle);
+    session_log_time(&s_session, SESSION_LOG_TIMER_SD_WRITE, start);
+    if (fs_ret != SYS_FS_RES_SUCCESS) {
+      SYS_DEBUG_PRINT(
+          SYS_ERROR_ERROR, "\nBuffered write before 0x%lx failed", src_addr);
+      return false;
+    }
+    // The image's digest costs a pass over the data it already has in RAM.
+    s_session.digest = crc32_update(s_session.digest, s_xfer_buf, to_xfer);
+    start = session_log_timer_start();
+    int32_t written = SYS_FS_FileWrite(file_handle, s_xfer_buf, to_xfer);
+    session_log_time(&s_session, SESSION_LOG_TIMER_SD_WRITE, start);
+    if (written < 0) {
       // file write failed
       SYS_DEBUG_PRINT(
           SYS_ERROR_ERROR, "\nFailed to write %ld bytes to file", to_xfer);
       return false;
     }
+    s_session.sd_bytes_written += to_xfer;
+    count_sector(SECTOR_OKAY);
     n_bytes -= to_xfer;
     src_addr += to_xfer;
-    SYS_DEBUG_PRINT(SYS_ERROR_INFO, ".");
+    PROF_END(PROF_ZONE_CLONER_EXTRACT_SECTOR);
+    progress_update(++n_sectors, 0);
   }
+  s_session.has_digest = true;
   // success
   return true;
 }
 
 static bool update_loop(SYS_FS_HANDLE file_handle, size_t n_bytes) {
   uint32_t dst_addr = 0;
+  uint32_t n_sectors = 0;
+  uint32_t n_changed = 0;
   sector_result_t res;
 
+  progress_start(
+      "Updating", "changed", n_bytes / FLASH_SECTOR_SZ, FLASH_SECTOR_SZ);
+
   while (n_bytes > 0) {
+    PROF_BEGIN(PROF_ZONE_CLONER_UPDATE_SECTOR);
     size_t to_xfer = n_bytes;
     if (to_xfer > FLASH_SECTOR_SZ) {
       to_xfer = FLASH_SECTOR_SZ;
     }
-    // Read a sector of data from the file and from the WINC.  If they differ,
-    // erase the sector and write the file data to the WINC.
-    if (SYS_FS_FileRead(file_handle, s_xfer_buf, to_xfer) < 0) {
-      // file read failed.
-      SYS_DEBUG_PRINT(
-          SYS_ERROR_ERROR, "\nFailed to read %ld bytes from file", to_xfer);
+    if (!file_read(file_handle, to_xfer)) {
       return false;
-    }
 
-    if ((dst_addr >= M2M_PLL_FLASH_OFFSET) &&
-        (dst_addr < M2M_PLL_FLASH_OFFSET + M2M_CONFIG_SECT_TOTAL_SZ)) {
-      // do not overwrite PLL and GAIN settings: see spi_flash_map.h
+    } else if (is_pll_sector(dst_addr)) {
+      // do not overwrite PLL and GAIN settings: see spi_flash_map.h.  The
+      // sector is still read, for the image's digest.
       res = SECTOR_SKIPPED;
+
     } else {
+      // Read a sector of data from the file and from the WINC.  If they
+      // differ, erase the sector and write the file data to the WINC.
       res = winc_sector_write(s_xfer_buf, dst_addr);
     }
 
@@ -436,38 +1066,40 @@ static bool update_loop(SYS_FS_HANDLE file_handle, size_t n_bytes) {
                       dst_addr);
       return false;
 
-    } else if (res == SECTOR_EQUAL) {
-      SYS_CONSOLE_MESSAGE("=");
-
     } else if (res == SECTOR_DIFFER) {
-      SYS_CONSOLE_MESSAGE("!");
-
-    } else if (res == SECTOR_SKIPPED) {
-      SYS_CONSOLE_MESSAGE("x");
+      n_changed += 1;
     }
+    count_sector(res);
 
     // advance to next sector
     n_bytes -= to_xfer;
     dst_addr += to_xfer;
+    PROF_END(PROF_ZONE_CLONER_UPDATE_SECTOR);
+    progress_update(++n_sectors, n_changed);
   }
+  s_session.has_digest =
+      s_session.sd_bytes_read == SYS_FS_FileSize(file_handle);
   // success
   return true;
 }
 
 static bool compare_loop(SYS_FS_HANDLE file_handle, size_t n_bytes) {
   uint32_t dst_addr = 0;
+  uint32_t n_sectors = 0;
+  uint32_t n_differ = 0;
+
+  progress_start(
+      "Comparing", "differ", n_bytes / FLASH_SECTOR_SZ, FLASH_SECTOR_SZ);
 
   while (n_bytes > 0) {
+    PROF_BEGIN(PROF_ZONE_CLONER_COMPARE_SECTOR);
     size_t to_xfer = n_bytes;
     if (to_xfer > FLASH_SECTOR_SZ) {
       to_xfer = FLASH_SECTOR_SZ;
     }
 
     // Read a sector of data from the file and from the WINC and compare them.
-    if (SYS_FS_FileRead(file_handle, s_xfer_buf, to_xfer) < 0) {
-      // file read failed.
-      SYS_DEBUG_PRINT(
-          SYS_ERROR_ERROR, "\nFailed to read %ld bytes from file", to_xfer);
+    if (!file_read(file_handle, to_xfer)) {
       return false;
     }
     if (winc_sector_read(s_xfer_buf2, dst_addr) != SECTOR_OKAY) {
@@ -477,30 +1109,132 @@ static bool compare_loop(SYS_FS_HANDLE file_handle, size_t n_bytes) {
                       dst_addr);
       return false;
     }
-    if (buffers_are_equal(s_xfer_buf, s_xfer_buf2, to_xfer)) {
-      // buffers are identical
-      SYS_CONSOLE_MESSAGE("=");
-    } else {
+    if (!buffers_are_equal(s_xfer_buf, s_xfer_buf2, to_xfer)) {
       // buffers differ
-      SYS_CONSOLE_MESSAGE("!");
+      BINLOG("\nSector 0x%lx differs", dst_addr);
+      n_differ += 1;
+      count_sector(SECTOR_DIFFER);
+    } else {
+      count_sector(SECTOR_EQUAL);
     }
     // advance to next sector
     n_bytes -= to_xfer;
     dst_addr += to_xfer;
+    PROF_END(PROF_ZONE_CLONER_COMPARE_SECTOR);
+    progress_update(++n_sectors, n_differ);
   }
+  s_session.has_digest =
+      s_session.sd_bytes_read == SYS_FS_FileSize(file_handle);
   // success
   return true;
 }
 
-static bool buffers_are_equal(uint8_t *buf_a, uint8_t *buf_b, size_t n_bytes) {
-  for (size_t i = 0; i < n_bytes; i++) {
-    if (buf_a[i] != buf_b[i]) {
+static bool source_loop(winc_cloner_source_fn source, uint32_t n_bytes) {
+  uint32_t n_sectors = 0;
+  uint32_t n_changed = 0;
+
+  progress_start(
+      "Updating", "changed", n_bytes / FLASH_SECTOR_SZ, FLASH_SECTOR_SZ);
+
+  for (uint32_t dst_addr = 0; dst_addr < n_bytes; dst_addr += FLASH_SECTOR_SZ) {
+    if (is_pll_sector(dst_addr)) {
+      // do not overwrite PLL and GAIN settings: see spi_flash_map.h.
+      count_sector(SECTOR_SKIPPED);
+      progress_update(++n_sectors, n_changed);
+      continue;
+    }
+    // Hand the source the current contents so it can skip sending a sector
+    // that already matches.  Nothing else touches the WINC meanwhile.
+    if (winc_sector_read(s_xfer_buf2, dst_addr) != SECTOR_OKAY) {
+      return false;
+    }
+    switch (source(dst_addr, s_xfer_buf2, s_xfer_buf)) {
+    case WINC_CLONER_SOURCE_SAME:
+      count_sector(SECTOR_EQUAL);
+      break;
+    case WINC_CLONER_SOURCE_DATA:
+      if (!buffers_are_equal(s_xfer_buf, s_xfer_buf2, FLASH_SECTOR_SZ)) {
+        if (winc_sector_program(s_xfer_buf, dst_addr) != SECTOR_OKAY) {
+          return false;
+        }
+        n_changed += 1;
+        count_sector(SECTOR_DIFFER);
+      } else {
+        count_sector(SECTOR_EQUAL);
+      }
+      break;
+    case WINC_CLONER_SOURCE_ERROR:
+    default:
+      SYS_DEBUG_PRINT(
+          SYS_ERROR_ERROR, "\nNo image data for sector 0x%lx", dst_addr);
       return false;
     }
+    progress_update(++n_sectors, n_changed);
   }
+  // success
   return true;
 }
 
+static bool file_read(SYS_FS_HANDLE file_handle, size_t to_xfer) {
+  uint32_t start = session_log_timer_start();
+  int32_t n_read = SYS_FS_FileRead(file_handle, s_xfer_buf, to_xfer);
+
+  session_log_time(&s_session, SESSION_LOG_TIMER_SD_READ, start);
+  if (n_read < 0) {
+    // file read failed.
+    SYS_DEBUG_PRINT(
+        SYS_ERROR_ERROR, "\nFailed to read %ld bytes from file", to_xfer);
+    return false;
+  }
+  // The image's digest costs a pass over the data it already has in RAM.
+  s_session.digest = crc32_update(s_session.digest, s_xfer_buf, n_read);
+  s_session.sd_bytes_read += n_read;
+  return true;
+}
+
+static bool is_pll_sector(uint32_t addr) {
+  return (addr >= M2M_PLL_FLASH_OFFSET) &&
+         (addr < M2M_PLL_FLASH_OFFSET + M2M_CONFIG_SECT_TOTAL_SZ);
+}
+
+static bool buffers_are_equal(uint8_t *buf_a, uint8_t *buf_b, size_t n_bytes) {
+  PROF_BEGIN(PROF_ZONE_CLONER_BUFFER_COMPARE);
+  uint32_t start = session_log_timer_start();
+  size_t i = 0;
+
+  while ((i < n_bytes) && (buf_a[i] == buf_b[i])) {
+    i++;
+  }
+  session_log_time(&s_session, SESSION_LOG_TIMER_COMPARE, start);
+  PROF_END(PROF_ZONE_CLONER_BUFFER_COMPARE);
+  return i == n_bytes;
+}
+
+static void count_sector(sector_result_t res) {
+  s_session.n_sectors += 1;
+  if (res == SECTOR_EQUAL) {
+    s_session.n_equal += 1;
+  } else if (res == SECTOR_DIFFER) {
+    s_session.n_changed += 1;
+  } else if (res == SECTOR_SKIPPED) {
+    s_session.n_skipped += 1;
+  }
+}
+
+static void digest_from_catalog(const char *filename) {
+  const dir_reader_image_t *image;
+  uint16_t idx;
+
+  if (s_session.has_digest || !dir_reader_find(filename, &idx)) {
+    return;
+  }
+  image = dir_reader_image_ref(idx);
+  if (image->flags & DIR_READER_IMAGE_SCANNED) {
+    s_session.digest = image->digest;
+    s_session.has_digest = true;
+  }
+}
+
 static int32_t winc3400_pll_table_build(uint8_t *pBuffer, uint32_t freqOffset) {
   uint32_t val32;
   uint32_t magic[2];
@@ -631,5 +1365,29 @@ static void dump_pll_data(uint8_t *buf, const char *msg) {
   SYS_CONSOLE_MESSAGE("\n");
 }
 
+static void trace_finish(bool ok) {
+#if SPI_TRACE_ENABLED
+  bool bus_failed = spi_trace_failed_count() > 0;
+
+  spi_trace_mark(SPI_TRACE_PHASE_IDLE);
+  if (!ok && bus_failed) {
+    // keep what the bus was doing when it failed, for spi_trace_decode.py.
+    spi_trace_dump(SPI_TRACE_FILENAME);
+  }
+#else
+  (void)ok;
+#endif
+}
+
+static void session_finish(bool ok) {
+  if (s_winc_is_opened) {
+    s_session.has_efuse =
+        read_efuse_struct(&s_session.efuse, 0) == EFUSE_SUCCESS;
+    s_session.flash_id = spi_flash_get_id();
+    s_session.flash_mbit = spi_flash_get_size();
+  }
+  session_log_add(&s_session, ok);
+}
+
 // *****************************************************************************
 // End of file
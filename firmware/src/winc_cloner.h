@@ -35,6 +35,7 @@
 // Includes
 
 #include <stdbool.h>
+#include <stdint.h>
 
 // *****************************************************************************
 // C++ compatibility
@@ -46,6 +47,25 @@ extern "C" {
 // *****************************************************************************
 // Public types and definitions
 
+typedef enum {
+  WINC_CLONER_SOURCE_DATA,  // dst holds the image data for the sector
+  WINC_CLONER_SOURCE_SAME,  // the WINC already holds the image data
+  WINC_CLONER_SOURCE_ERROR, // no data: abandon the update
+} winc_cloner_source_result_t;
+
+/**
+ * @brief Supplies image data to winc_cloner_update_from_source(), one WINC
+ * flash sector (FLASH_SECTOR_SZ bytes) at a time.
+ *
+ * Called in address order with the current WINC contents of the sector at addr
+ * in winc_data.  The source either fills dst with the image data or reports
+ * that winc_data already matches it.  The WINC is idle while the source runs.
+ */
+typedef winc_cloner_source_result_t (*winc_cloner_source_fn)(
+    uint32_t addr,
+    const uint8_t *winc_data,
+    uint8_t *dst);
+
 // *****************************************************************************
 // Public declarations
 
@@ -70,6 +90,22 @@ bool winc_cloner_extract(const char *filename);
  */
 bool winc_cloner_update(const char *filename);
 
+/**
+ * @brief Update the WINC firmware image from a sector source rather than a
+ * file, programming only the sectors that differ.
+ *
+ * Note: like winc_cloner_update(), this does not touch the PLL and GAIN
+ * tables: the source is not asked for those sectors.
+ *
+ * @param label Names the source in messages.
+ * @param n_bytes Size of the image: a whole number of sectors, no bigger than
+ *        the WINC flash.
+ * @return true on success
+ */
+bool winc_cloner_update_from_source(const char *label,
+                                    uint32_t n_bytes,
+                                    winc_cloner_source_fn source);
+
 /**
  * @brief Compare the entire contents of the WINC firmware image with a file.
  *
@@ -85,6 +121,34 @@ bool winc_cloner_compare(const char *filename);
  */
 bool winc_cloner_rebuild_pll(void);
 
+/**
+ * @brief Print the firmware versions in both OTA images of the WINC.
+ *
+ * Reads only the control sector and the version records at the start of
+ * each OTA image, in download mode, so it takes a fraction of a second and
+ * never runs the WINC firmware.  Prints each image's firmware version, the
+ * oldest driver it supports, its build date, and which image is active.
+ *
+ * @return true if the WINC could be opened.
+ */
+bool winc_cloner_probe(void);
+
+/**
+ * @brief Read the WINC once and find the cataloged image it matches best.
+ *
+ * The CRC-32 of each WINC sector is checked against the manifest of every
+ * scanned image (see dir_reader_manifest_ref()), and against the image file
+ * itself for an image that has no manifest yet.  Since a manifest's 16-bit
+ * fingerprints can match by chance, the images that rank best by their
+ * manifest are read back to confirm their count.  Prints the share of
+ * identical sectors for each image, then the regions in which the best match
+ * differs.  The PLL / GAIN sector is left out, since it differs from one
+ * module to the next.  Any key press stops the search.
+ *
+ * @return true if the WINC was read and compared with at least one image.
+ */
+bool winc_cloner_identify(void);
+
 // *****************************************************************************
 // End of file
 
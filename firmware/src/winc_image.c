@@ -0,0 +1,94 @@
+/**
+ * @file winc_image.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// *****************************************************************************
+// Includes
+
+#include "winc_image.h"
+
+#include "spi_flash_map.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// *****************************************************************************
+// Private types and definitions
+
+#define BOOT_MAGIC 0x53494d4e // "NMIS", little endian
+#define REV_MAGIC 0xdadbabba
+
+typedef struct {
+  uint32_t magic;    // BOOT_MAGIC
+  uint32_t n_bytes;  // bytes in the section, after this header
+  uint32_t load_addr;
+  uint32_t code_sz;  // version records follow code_sz bytes of code
+} boot_header_t;
+
+// *****************************************************************************
+// Private (static, forward) declarations
+
+// *****************************************************************************
+// Private (static) storage
+
+// *****************************************************************************
+// Public code
+
+uint32_t winc_image_rev_window(const uint8_t *header) {
+  boot_header_t boot;
+
+  memcpy(&boot, header, sizeof(boot));
+  if ((boot.magic != BOOT_MAGIC) ||
+      (boot.code_sz >
+       OTA_IMAGE_SIZE - sizeof(boot) - WINC_IMAGE_REV_WINDOW_SZ)) {
+    return 0;
+  }
+  return sizeof(boot) + boot.code_sz;
+}
+
+bool winc_image_find_rev(const uint8_t *window, winc_image_rev_t *rev) {
+  bool found = false;
+
+  // the boot section's own record comes first: keep the last one, which
+  // describes the firmware.
+  for (size_t i = 0; i + sizeof(*rev) <= WINC_IMAGE_REV_WINDOW_SZ;
+       i += sizeof(uint32_t)) {
+    uint32_t magic;
+
+    memcpy(&magic, &window[i], sizeof(magic));
+    if (magic == REV_MAGIC) {
+      memcpy(rev, &window[i], sizeof(*rev));
+      found = true;
+    }
+  }
+  return found;
+}
+
+// *****************************************************************************
+// Private (static) code
+
+// *****************************************************************************
+// End of file
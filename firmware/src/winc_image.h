@@ -0,0 +1,101 @@
+/**
+ * @file winc_image.h
+ *
+ * MIT License
+ *
+ * Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief winc_image knows where a WINC image keeps its firmware versions.
+ *
+ * Each OTA image starts with the boot section that the WINC's ROM loads,
+ * followed by the image's version records.  The last record describes the
+ * firmware: the running firmware reports it through
+ * nm_get_firmware_full_info(), which only works once the firmware runs.  The
+ * catalog scan (dir_reader) and winc_cloner_probe() read the records straight
+ * from an image file or the WINC's flash, so they report the same version.
+ */
+
+#ifndef _WINC_IMAGE_H_
+#define _WINC_IMAGE_H_
+
+// *****************************************************************************
+// Includes
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// *****************************************************************************
+// C++ compatibility
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// *****************************************************************************
+// Public types and definitions
+
+// Bytes at the start of an OTA image that winc_image_rev_window() parses.
+#define WINC_IMAGE_BOOT_HEADER_SZ 16
+
+// Bytes after the boot section that winc_image_find_rev() searches.
+#define WINC_IMAGE_REV_WINDOW_SZ 128
+
+/**
+ * @brief A version record, as stored in an OTA image (36 bytes).
+ */
+typedef struct {
+  uint32_t magic; // private
+  uint32_t chip_id;
+  uint16_t fw_version;  // see M2M_GET_MAJOR() et al
+  uint16_t drv_version; // oldest driver the firmware supports
+  char build_date[12];  // __DATE__
+  char build_time[9];   // __TIME__
+  uint8_t pad;
+  uint16_t svn_rev;
+} winc_image_rev_t;
+
+// *****************************************************************************
+// Public declarations
+
+/**
+ * @brief Given the first WINC_IMAGE_BOOT_HEADER_SZ bytes of an OTA image,
+ * return the offset from the start of the image of the
+ * WINC_IMAGE_REV_WINDOW_SZ bytes that hold its version records.  Return 0 if
+ * header is not a boot section header.
+ */
+uint32_t winc_image_rev_window(const uint8_t *header);
+
+/**
+ * @brief Copy the firmware's version record from the WINC_IMAGE_REV_WINDOW_SZ
+ * bytes of window into rev.  Return false if window holds no record.
+ */
+bool winc_image_find_rev(const uint8_t *window, winc_image_rev_t *rev);
+
+// *****************************************************************************
+// End of file
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _WINC_IMAGE_H_ */
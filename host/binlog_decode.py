@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+Decode the binary log records in winc-cloner console output.
+
+MIT License
+
+Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+
+Debug messages recorded with BINLOG() (see firmware/src/binlog.h) reach the
+console as lines of hex words:
+
+    #BL <format address> <timestamp> <argument>...
+
+This program reads console output, replaces each such record with the message
+it encodes and passes all other text through unchanged.  The format strings,
+and any strings passed for %s, are looked up in the firmware's ELF file, which
+must be the one running on the target.  Like the client, it needs nothing
+beyond the Python 3 standard library.
+
+Usage:
+
+    binlog_decode.py firmware.elf console.log
+    binlog_decode.py firmware.elf < console.log
+
+Each message is prefixed with its time in seconds since the first record.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FORMAT_SECTION = ".binlog_fmt"
+DEFAULT_TICK_HZ = 60000000  # SYS_TIME counter rate (TC0_TimerFrequencyGet)
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+RECORD_RE = re.compile(r"#BL((?: [0-9a-f]{8}){2,})")
+CONVERSION_RE = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\*|\d+)?(?:\.(?P<precision>\*|\d*))?"
+    r"(?P<length>hh|h|ll|l|j|z|t|L)?(?P<conversion>[diouxXcsp%])")
+
+
+class ElfImage:
+    """The loadable sections of a little-endian ELF file, by address."""
+
+    def __init__(self, data):
+        if data[:4] != b"\x7fELF" or data[5] != 1:
+            raise ValueError("not a little-endian ELF file")
+        if data[4] == 1:
+            shoff, = struct.unpack_from("<I", data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2e)
+            header = "<IIIIIIIIII"
+        elif data[4] == 2:
+            shoff, = struct.unpack_from("<Q", data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3a)
+            header = "<IIQQQQIIQQ"
+        else:
+            raise ValueError("unknown ELF class %d" % data[4])
+        headers = [struct.unpack_from(header, data, shoff + i * shentsize)
+                   for i in range(shnum)]
+        names_offset = headers[shstrndx][4]
+
+        # (name, address, bytes) for every section that occupies memory.
+        self.sections = []
+        for name, sh_type, flags, addr, offset, size, *_ in headers:
+            if (flags & SHF_ALLOC) and sh_type != SHT_NOBITS and size > 0:
+                end = data.index(b"\0", names_offset + name)
+                self.sections.append((data[names_offset + name:end].decode(),
+                                      addr, data[offset:offset + size]))
+
+    @classmethod
+    def load(cls, path):
+        with open(path, "rb") as f:
+            return cls(f.read())
+
+    def string_at(self, addr, section=None):
+        """Return the NUL-terminated string at addr, or None if addr is not in
+        the image (or not in the named section)."""
+        for name, start, contents in self.sections:
+            if section not in (None, name):
+                continue
+            if start <= addr < start + len(contents):
+                offset = addr - start
+                end = contents.find(b"\0", offset)
+                if end < 0:
+                    end = len(contents)
+                return contents[offset:end].decode("latin-1")
+        return None
+
+
+def format_message(fmt, args, elf):
+    """printf() fmt with the 32-bit words args, as the target would have."""
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else None
+
+    def convert(match):
+        spec = match.groupdict()
+        conversion = spec["conversion"]
+        if conversion == "%":
+            return "%"
+        width = spec["width"] or ""
+        if width == "*":
+            width = str(next_arg() or 0)
+        precision = spec["precision"]
+        if precision == "*":
+            precision = str(next_arg() or 0)
+        value = next_arg()
+        if value is None:
+            return "<missing>"
+        if conversion in "di":
+            conversion = "d"
+            value = value - (1 << 32) if value & 0x80000000 else value
+        elif conversion == "u":
+            conversion = "d"
+        elif conversion == "c":
+            value = chr(value & 0xff)
+        elif conversion == "s":
+            string = elf.string_at(value)
+            value = string if string is not None else "<string@%08x>" % value
+        elif conversion == "p":
+            conversion, value = "s", "0x%x" % value
+        python_spec = "%" + spec["flags"] + width
+        if precision is not None:
+            python_spec += "." + precision
+        return (python_spec + conversion) % value
+
+    return CONVERSION_RE.sub(convert, fmt)
+
+
+class Decoder:
+    """Turns #BL records back into text, one line of console output at a time."""
+
+    def __init__(self, elf, tick_hz=DEFAULT_TICK_HZ):
+        self.elf = elf
+        self.tick_hz = tick_hz
+        self.last_ticks = None
+        self.elapsed_ticks = 0
+
+    def decode_line(self, line):
+        return RECORD_RE.sub(self._decode_record, line)
+
+    def _decode_record(self, match):
+        words = [int(word, 16) for word in match.group(1).split()]
+        fmt_addr, ticks, args = words[0], words[1], words[2:]
+
+        # the counter is 32 bits wide: accumulate differences to survive wrap.
+        if self.last_ticks is not None:
+            self.elapsed_ticks += (ticks - self.last_ticks) & 0xffffffff
+        self.last_ticks = ticks
+        stamp = "[%10.6f]" % (self.elapsed_ticks / self.tick_hz)
+
+        fmt = self.elf.string_at(fmt_addr, FORMAT_SECTION)
+        if fmt is None:
+            # not this firmware's format table: show the record as it came.
+            return "%s #BL%s (unknown format)" % (stamp, match.group(1))
+        return "%s %s" % (stamp, format_message(fmt, args, self.elf).strip())
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("elf", help="ELF file of the firmware that ran")
+    parser.add_argument("log", nargs="?", help="console output (default: stdin)")
+    parser.add_argument("--tick-hz", type=int, default=DEFAULT_TICK_HZ,
+                        help="SYS_TIME counter rate (default %(default)d)")
+    args = parser.parse_args(argv)
+
+    decoder = Decoder(ElfImage.load(args.elf), args.tick_hz)
+    log = open(args.log, errors="replace") if args.log else sys.stdin
+    with log:
+        for line in log:
+            sys.stdout.write(decoder.decode_line(line))
+            sys.stdout.flush()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""
+Render a winc-cloner SPI trace as a timeline.
+
+MIT License
+
+Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+
+The firmware records the latest commands it sent to the WINC over SPI (see
+firmware/src/spi_trace.h) and writes them to spi_trace.bin on the SD card,
+either on the console's 't' command or by itself after an operation fails on
+bus errors.  This program lists the commands with their timing, flags the
+failures, retries and gaps between commands, and summarizes each phase
+(extract, update...): its duration, data throughput and errors.  Like the
+client, it needs nothing beyond the Python 3 standard library.
+
+Usage:
+
+    spi_trace_decode.py spi_trace.bin
+    spi_trace_decode.py --summary spi_trace.bin
+    spi_trace_decode.py --gap-us 200 spi_trace.bin
+
+Times are in seconds since the first record in the file.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"WSPT"
+VERSION = 1
+HEADER = struct.Struct("<4sHHIII")
+RECORD = struct.Struct("<IIIHBB")
+
+STATUS_DONE = 0x01
+STATUS_FAILED = 0x02
+STATUS_CRC = 0x04
+STATUS_PHASE_SHIFT = 4
+STATUS_PHASE_MASK = 0x70
+
+COMMAND_MARK = 0x00
+COMMAND_RESET = 0xcf
+COMMAND_NAMES = {
+    0xc3: "INTERNAL_WRITE",
+    0xc4: "INTERNAL_READ",
+    0xc7: "DMA_EXT_WRITE",
+    0xc8: "DMA_EXT_READ",
+    0xc9: "SINGLE_WRITE",
+    0xca: "SINGLE_READ",
+    COMMAND_RESET: "RESET",
+}
+PHASE_NAMES = ["idle", "extract", "update", "compare", "rebuild_pll",
+               "identify", "probe"]
+
+DEFAULT_GAP_US = 1000
+
+
+class Record:
+    """One command (or phase mark), with times in seconds."""
+
+    def __init__(self, start, duration, address, size, command, status):
+        self.start = start
+        self.duration = duration
+        self.address = address
+        self.size = size
+        self.command = command
+        self.status = status
+        self.retry = 0  # how many failed attempts at this command came before
+
+    @property
+    def end(self):
+        return self.start + self.duration
+
+    @property
+    def is_mark(self):
+        return self.command == COMMAND_MARK
+
+    @property
+    def failed(self):
+        return bool(self.status & STATUS_FAILED)
+
+    @property
+    def done(self):
+        return bool(self.status & STATUS_DONE)
+
+    @property
+    def phase(self):
+        return (self.status & STATUS_PHASE_MASK) >> STATUS_PHASE_SHIFT
+
+    def name(self):
+        if self.is_mark:
+            return phase_name(self.address)
+        return COMMAND_NAMES.get(self.command, "CMD_%02X" % self.command)
+
+
+def phase_name(phase):
+    if phase < len(PHASE_NAMES):
+        return PHASE_NAMES[phase]
+    return "phase %d" % phase
+
+
+class Trace:
+    """The records of a trace file, oldest first."""
+
+    def __init__(self, data):
+        if len(data) < HEADER.size:
+            raise ValueError("file too short for a trace header")
+        magic, version, record_size, tick_hz, n_records, n_lost = \
+            HEADER.unpack_from(data)
+        if magic != MAGIC:
+            raise ValueError("not an SPI trace file")
+        if version != VERSION or record_size != RECORD.size:
+            raise ValueError("unknown trace version %d (record size %d)"
+                             % (version, record_size))
+        if len(data) < HEADER.size + n_records * RECORD.size:
+            raise ValueError("trace truncated: %d records expected"
+                             % n_records)
+        self.tick_hz = tick_hz
+        self.n_lost = n_lost
+        self.records = []
+
+        # timestamps come from a 32-bit counter: accumulate differences.
+        last_ticks = None
+        elapsed = 0
+        for i in range(n_records):
+            ticks, duration, address, size, command, status = \
+                RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+            if last_ticks is not None:
+                elapsed += (ticks - last_ticks) & 0xffffffff
+            last_ticks = ticks
+            self.records.append(Record(elapsed / tick_hz, duration / tick_hz,
+                                       address, size, command, status))
+        self._count_retries()
+
+    @classmethod
+    def load(cls, path):
+        with open(path, "rb") as f:
+            return cls(f.read())
+
+    def _count_retries(self):
+        # nmspi resends a failed command after a reset, up to SPI_RETRY_COUNT
+        # times: number the attempts that follow a failure.
+        failed = None
+        for record in self.records:
+            if record.is_mark:
+                failed = None
+            elif record.command == COMMAND_RESET:
+                continue
+            elif failed is not None and \
+                    (record.command, record.address, record.size) == \
+                    (failed.command, failed.address, failed.size):
+                record.retry = failed.retry + 1
+                failed = record if record.failed else None
+            else:
+                failed = record if record.failed else None
+
+    def phases(self):
+        """Split the records at the phase marks: a list of (mark, records),
+        where mark is None for records before the first mark (whose mark was
+        overwritten, if the ring filled up)."""
+        phases = [(None, [])]
+        for record in self.records:
+            if record.is_mark:
+                phases.append((record, []))
+            else:
+                phases[-1][1].append(record)
+        if not phases[0][1]:
+            phases.pop(0)
+        return phases
+
+
+class PhaseSummary:
+    """Totals for the commands of one phase."""
+
+    def __init__(self, mark, records, end):
+        if mark:
+            self.name = mark.name()
+        else:
+            self.name = phase_name(records[0].phase) + "*" if records else "-"
+        self.start = mark.start if mark else \
+            (records[0].start if records else 0.0)
+        self.seconds = max(end - self.start, 0.0)
+        self.n_commands = 0
+        self.n_bytes = 0
+        self.n_failed = 0
+        self.n_retries = 0
+        self.n_resets = 0
+        self.longest_gap = 0.0
+        previous_end = self.start
+        for record in records:
+            self.longest_gap = max(self.longest_gap,
+                                   record.start - previous_end)
+            previous_end = max(previous_end, record.end)
+            if record.command == COMMAND_RESET:
+                self.n_resets += 1
+                continue
+            self.n_commands += 1
+            if record.failed:
+                self.n_failed += 1
+            elif record.done:
+                self.n_bytes += record.size
+            if record.retry:
+                self.n_retries += 1
+
+    @property
+    def kb_per_s(self):
+        return self.n_bytes / 1024 / self.seconds if self.seconds else 0.0
+
+
+def summarize(trace):
+    """A PhaseSummary for each phase in the trace."""
+    phases = trace.phases()
+    summaries = []
+    for i, (mark, records) in enumerate(phases):
+        if i + 1 < len(phases):
+            end = phases[i + 1][0].start
+        elif records:
+            end = max(record.end for record in records)
+        else:
+            end = mark.start
+        summaries.append(PhaseSummary(mark, records, end))
+    return summaries
+
+
+def format_record(record):
+    stamp = "[%10.6f]" % record.start
+    if record.is_mark:
+        return "%s === %s ===" % (stamp, record.name())
+    if record.command == COMMAND_RESET:
+        return "%s %-14s" % (stamp, record.name())
+    if record.failed:
+        result = "FAILED"
+    elif record.done:
+        result = "ok"
+    else:
+        result = "(no result)"
+    if record.retry:
+        result += " (retry %d)" % record.retry
+    if record.status & STATUS_CRC:
+        result += " crc"
+    return "%s %-14s %08x %5d %10.1f us  %s" % (
+        stamp, record.name(), record.address, record.size,
+        record.duration * 1e6, result)
+
+
+def timeline(trace, gap):
+    """Yield the lines of the timeline, noting gaps longer than gap seconds."""
+    previous_end = None
+    for record in trace.records:
+        if previous_end is not None and record.start - previous_end > gap:
+            yield "%s     ... %.3f ms gap" % (
+                " " * 12, (record.start - previous_end) * 1e3)
+        yield format_record(record)
+        previous_end = record.start if record.is_mark else record.end
+
+
+def summary_lines(trace):
+    yield "%-12s %10s %10s %9s %9s %9s %7s %8s %7s %11s" % (
+        "phase", "start s", "seconds", "commands", "bytes", "KB/s",
+        "failed", "retries", "resets", "max gap ms")
+    for phase in summarize(trace):
+        yield "%-12s %10.6f %10.6f %9d %9d %9.1f %7d %8d %7d %11.3f" % (
+            phase.name, phase.start, phase.seconds, phase.n_commands,
+            phase.n_bytes, phase.kb_per_s, phase.n_failed, phase.n_retries,
+            phase.n_resets, phase.longest_gap * 1e3)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("trace", help="trace file written by the firmware")
+    parser.add_argument("--gap-us", type=float, default=DEFAULT_GAP_US,
+                        help="flag gaps between commands longer than this "
+                        "(default %(default)d)")
+    parser.add_argument("--summary", action="store_true",
+                        help="print only the summary of each phase")
+    args = parser.parse_args(argv)
+
+    try:
+        trace = Trace.load(args.trace)
+    except (OSError, ValueError) as err:
+        print("%s: %s" % (args.trace, err), file=sys.stderr)
+        return 1
+
+    print("%d records, %d older ones lost, %d Hz timestamps"
+          % (len(trace.records), trace.n_lost, trace.tick_hz))
+    if not args.summary:
+        for line in timeline(trace, args.gap_us / 1e6):
+            print(line)
+        print()
+    for line in summary_lines(trace):
+        print(line)
+    if trace.records and not trace.records[0].is_mark:
+        print("* phase started before the first record in the file")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Tests binlog_decode against a small ELF32 image built in memory.
+
+MIT License
+
+Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+
+The image mimics the firmware's: format strings in section .binlog_fmt and
+other constant strings in .rodata, both in flash.
+
+Run with:  python3 -m unittest -v test_binlog_decode
+"""
+
+import struct
+import unittest
+
+import binlog_decode as bld
+
+FMT_ADDR = 0x8000
+RODATA_ADDR = 0x9000
+FORMATS = [b"\r\n>Start erasing...\r\n", b"\nSector 0x%lx differs",
+           b"%d %u %5s|%-3c|%s", b"mac %02x:%02x:%02x:%02x:%02x:%02x", b"%d%%"]
+RODATA = [b"partial", b"full"]
+
+
+def table(strings, base):
+    """Concatenate NUL-terminated strings, returning (bytes, addresses)."""
+    data, addrs = b"", []
+    for string in strings:
+        addrs.append(base + len(data))
+        data += string + b"\0"
+    return data, addrs
+
+
+FMT_DATA, FMT = table(FORMATS, FMT_ADDR)
+RODATA_DATA, STR = table(RODATA, RODATA_ADDR)
+
+
+def build_elf():
+    """An ELF32 file with sections NULL, .binlog_fmt, .rodata, .shstrtab."""
+    names = b"\0.binlog_fmt\0.rodata\0.shstrtab\0"
+    contents = [(1, FMT_ADDR, FMT_DATA), (13, RODATA_ADDR, RODATA_DATA),
+                (21, 0, names)]
+    body, headers = b"", [struct.pack("<10I", *([0] * 10))]
+    offset = 52
+    for name, addr, data in contents:
+        flags = bld.SHF_ALLOC if addr else 0
+        headers.append(struct.pack("<10I", name, 1, flags, addr,
+                                   offset + len(body), len(data), 0, 0, 1, 0))
+        body += data
+    shoff = offset + len(body)
+    ident = b"\x7fELF\x01\x01\x01" + b"\0" * 9
+    elf_header = ident + struct.pack("<HHIIIIIHHHHHH", 2, 40, 1, 0, 0, shoff,
+                                     0, 52, 0, 0, 40, len(headers), 3)
+    return elf_header + body + b"".join(headers)
+
+
+def record(fmt, ticks, *args):
+    return "\n#BL" + "".join(" %08x" % word for word in (fmt, ticks) + args)
+
+
+class BinlogDecodeTest(unittest.TestCase):
+    def setUp(self):
+        self.decoder = bld.Decoder(bld.ElfImage(build_elf()), tick_hz=1000)
+
+    def decode(self, text):
+        return "".join(self.decoder.decode_line(line)
+                       for line in text.splitlines(True))
+
+    def test_string_lookup(self):
+        elf = bld.ElfImage(build_elf())
+        self.assertEqual(elf.string_at(STR[1]), "full")
+        self.assertEqual(elf.string_at(FMT[1], bld.FORMAT_SECTION),
+                         "\nSector 0x%lx differs")
+        self.assertIsNone(elf.string_at(STR[1], bld.FORMAT_SECTION))
+        self.assertIsNone(elf.string_at(0x20000000))
+
+    def test_plain_text_passes_through(self):
+        text = "\nUpdating WINC firmware from a.wimg\r 3 of 4 sectors\n"
+        self.assertEqual(self.decode(text), text)
+
+    def test_records(self):
+        text = (record(FMT[0], 0) + record(FMT[1], 1500, 0x1000) +
+                record(FMT[3], 2000, 0, 0x1a, 2, 0xb3, 4, 5) + "\n")
+        self.assertEqual(self.decode(text),
+                         "\n[  0.000000] >Start erasing..."
+                         "\n[  1.500000] Sector 0x1000 differs"
+                         "\n[  2.000000] mac 00:1a:02:b3:04:05\n")
+
+    def test_conversions(self):
+        text = record(FMT[2], 0, 0xfffffffb, 7, STR[1], ord("z"), 0x20001000)
+        self.assertEqual(self.decode(text),
+                         "\n[  0.000000] -5 7  full|z  |<string@20001000>")
+        self.assertEqual(self.decode(record(FMT[4], 0, 50)),
+                         "\n[  0.000000] 50%")
+
+    def test_timestamps_survive_counter_wrap(self):
+        text = record(FMT[0], 0xfffffc18) + record(FMT[0], 0x3e8) + "\n"
+        self.assertEqual(self.decode(text),
+                         "\n[  0.000000] >Start erasing..."
+                         "\n[  2.000000] >Start erasing...\n")
+
+    def test_unknown_format_and_missing_arguments(self):
+        self.assertEqual(self.decode(record(STR[0], 0)),
+                         "\n[  0.000000] #BL %08x 00000000 (unknown format)"
+                         % STR[0])
+        self.assertEqual(self.decode(record(FMT[1], 0)),
+                         "\n[  0.000000] Sector 0x<missing> differs")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+Tests spi_trace_decode against small trace files built in memory.
+
+MIT License
+
+Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+
+The files follow firmware/src/spi_trace.h: a header, then 16-byte records,
+oldest first, with timestamps from a 32-bit counter.
+
+Run with:  python3 -m unittest -v test_spi_trace_decode
+"""
+
+import struct
+import unittest
+
+import spi_trace_decode as std
+
+TICK_HZ = 1000000  # one tick per microsecond keeps the numbers readable
+PHASE_UPDATE = 2
+IN_UPDATE = PHASE_UPDATE << std.STATUS_PHASE_SHIFT
+OK = std.STATUS_DONE | IN_UPDATE
+FAILED = std.STATUS_FAILED | IN_UPDATE
+READ_BLOCK = 0xc8
+READ_REG = 0xca
+
+
+def trace_file(records, n_lost=0, tick_hz=TICK_HZ):
+    """records: (timestamp, duration, address, size, command, status)."""
+    header = struct.pack("<4sHHIII", b"WSPT", 1, 16, tick_hz, len(records),
+                         n_lost)
+    return header + b"".join(struct.pack("<IIIHBB", *r) for r in records)
+
+
+def mark(ticks, phase):
+    return (ticks, 0, phase, 0, std.COMMAND_MARK, std.STATUS_DONE)
+
+
+# An update: a register read, a block read that fails twice before going
+# through, then a 5 ms stall before the last read.
+UPDATE = [
+    mark(100, PHASE_UPDATE),
+    (110, 10, 0x1000, 4, READ_REG, OK),
+    (130, 100, 0x2000, 1024, READ_BLOCK, FAILED),
+    (240, 0, 0, 0, std.COMMAND_RESET, IN_UPDATE),
+    (260, 100, 0x2000, 1024, READ_BLOCK, FAILED),
+    (370, 0, 0, 0, std.COMMAND_RESET, IN_UPDATE),
+    (390, 100, 0x2000, 1024, READ_BLOCK, OK),
+    (5490, 10, 0x1000, 4, READ_REG, OK),
+    mark(5600, 0),
+]
+
+
+class SpiTraceDecodeTest(unittest.TestCase):
+    def test_header_checks(self):
+        data = trace_file(UPDATE)
+        with self.assertRaises(ValueError):
+            std.Trace(b"XXXX" + data[4:])
+        with self.assertRaises(ValueError):
+            std.Trace(data[:-1])
+        trace = std.Trace(trace_file(UPDATE, n_lost=7))
+        self.assertEqual(len(trace.records), len(UPDATE))
+        self.assertEqual(trace.n_lost, 7)
+
+    def test_retries(self):
+        trace = std.Trace(trace_file(UPDATE))
+        retries = [r.retry for r in trace.records if r.command == READ_BLOCK]
+        self.assertEqual(retries, [0, 1, 2])
+
+    def test_timeline(self):
+        lines = list(std.timeline(std.Trace(trace_file(UPDATE)), gap=0.001))
+        self.assertEqual(lines[0], "[  0.000000] === update ===")
+        self.assertEqual(lines[2], "[  0.000030] DMA_EXT_READ   00002000  "
+                         "1024      100.0 us  FAILED")
+        self.assertEqual(lines[3], "[  0.000140] RESET         ")
+        self.assertTrue(lines[6].endswith("ok (retry 2)"))
+        self.assertEqual(lines[7].strip(), "... 5.000 ms gap")
+        self.assertEqual(lines[-1], "[  0.005500] === idle ===")
+
+    def test_summary(self):
+        update, idle = std.summarize(std.Trace(trace_file(UPDATE)))
+        self.assertEqual(update.name, "update")
+        self.assertAlmostEqual(update.seconds, 0.0055)
+        self.assertEqual(update.n_commands, 5)
+        self.assertEqual(update.n_bytes, 1032)
+        self.assertEqual(update.n_failed, 2)
+        self.assertEqual(update.n_retries, 2)
+        self.assertEqual(update.n_resets, 2)
+        self.assertAlmostEqual(update.longest_gap, 0.005)
+        self.assertEqual(idle.name, "idle")
+        self.assertEqual(idle.n_commands, 0)
+
+    def test_timestamps_survive_counter_wrap(self):
+        records = [mark(0xffffff00, PHASE_UPDATE),
+                   (0x00000100, 10, 0x1000, 4, READ_REG, OK)]
+        trace = std.Trace(trace_file(records))
+        self.assertAlmostEqual(trace.records[1].start, 0x200 / TICK_HZ)
+
+    def test_commands_before_first_mark(self):
+        # the ring overwrote the mark: the phase comes from the status bits.
+        records = [(0, 10, 0x1000, 4, READ_REG, OK),
+                   (20, 10, 0x1000, 4, 0xc9, OK | std.STATUS_CRC)]
+        trace = std.Trace(trace_file(records, n_lost=1000))
+        phase, = std.summarize(trace)
+        self.assertEqual(phase.name, "update*")
+        self.assertEqual(phase.n_bytes, 8)
+        self.assertTrue(std.format_record(trace.records[1])
+                        .endswith("SINGLE_WRITE   00001000     4       "
+                                  "10.0 us  ok crc"))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,377 @@
+#!/usr/bin/env python3
+"""
+Tests winc_cloner_client against a simulated target on a pseudo-terminal.
+
+MIT License
+
+Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+
+The simulated target follows firmware/src/host_proto.c: it ACKs each request
+as soon as it arrives, queues up to QUEUE_LEN of them, runs them one at a time
+while emitting PROGRESS frames, and mixes console text in with the frames.
+It also holds a small simulated WINC flash for STREAM_UPDATE.
+
+Run with:  python3 -m unittest -v test_winc_cloner_client
+"""
+
+import os
+import pty
+import select
+import struct
+import threading
+import time
+import tty
+import unittest
+import zlib
+
+import winc_cloner_client as wcc
+
+N_SECTORS = 16
+STREAM_TIMEOUT = 0.5  # HOST_PROTO_STREAM_TIMEOUT_MS
+STREAM_TRIES = 8
+
+
+class SimulatedTarget(threading.Thread):
+    def __init__(self, master_fd, queue_len=wcc.QUEUE_LEN, sector_time=0.002):
+        super().__init__(daemon=True)
+        self.fd = master_fd
+        self.queue_len = queue_len
+        self.sector_time = sector_time
+        self.decoder = wcc.FrameDecoder()
+        self.queue = []
+        self.executed = []  # (type, name) of each request run
+        self.max_queued = 0
+        self.drop_next = 0  # number of incoming frames to ignore
+        self.corrupt_next = 0  # number of outgoing frames to corrupt
+        self.last = None
+        # fw_version is packed as by M2M_GET_FW_VER(): major.minor.patch
+        # in 8.4.4 bits.
+        self.images = [("m2m_aio_3a0_v19_5_4.wimg", 0x1354),
+                       ("prodB/m2m_aio_3a0_v19_7_7.wimg", 0x1377)]
+        self.flash = bytearray(b"\xff" * (N_SECTORS * wcc.SECTOR_SZ))
+        self.stream = None  # sector being streamed in
+        self.stream_round = 0
+        self.queries = 0  # SECTOR frames sent
+        self.data_received = 0  # bytes of STREAM_DATA accepted
+        self.drop_data = 0  # drop the n'th STREAM_DATA frame received
+        self.n_data_frames = 0
+        self.running = True
+        self.active = False
+
+    def stop(self):
+        self.running = False
+        self.join(2)
+
+    # -- output
+
+    def send(self, frame_type, seq, payload=b""):
+        frame = bytearray(wcc.encode_frame(frame_type, seq, payload))
+        if self.corrupt_next:
+            self.corrupt_next -= 1
+            frame[-1] ^= 0xFF
+        os.write(self.fd, bytes(frame))
+
+    def text(self, message):
+        os.write(self.fd, message.encode("ascii"))
+
+    # -- input
+
+    def poll(self, timeout=0.0):
+        ready, _, _ = select.select([self.fd], [], [], timeout)
+        if not ready:
+            return
+        try:
+            data = os.read(self.fd, 4096)
+        except OSError:
+            self.running = False
+            return
+        for frame_type, seq, payload in self.decoder.feed(data):
+            if self.drop_next:
+                self.drop_next -= 1
+                continue
+            if frame_type == wcc.CMD_STREAM_DATA:
+                self.n_data_frames += 1
+                if self.n_data_frames == self.drop_data:
+                    continue
+            self.receive(frame_type, seq, payload)
+
+    def receive(self, frame_type, seq, payload):
+        if not self.active:
+            self.active = True
+        if frame_type in (wcc.CMD_STREAM_DATA, wcc.CMD_STREAM_SKIP):
+            self.receive_stream(frame_type, seq, payload)
+            return
+        if frame_type in (wcc.CMD_PING, wcc.CMD_LIST, wcc.CMD_REBUILD_PLL,
+                          wcc.CMD_EXIT):
+            status = wcc.ACK_QUEUED if not payload else wcc.ACK_INVALID
+        elif frame_type in (wcc.CMD_EXTRACT, wcc.CMD_UPDATE, wcc.CMD_COMPARE):
+            status = (wcc.ACK_QUEUED if 0 < len(payload) <= wcc.MAX_NAME
+                      else wcc.ACK_INVALID)
+        elif frame_type == wcc.CMD_STREAM_UPDATE:
+            status = (wcc.ACK_QUEUED if len(payload) == 4 and payload != bytes(4)
+                      else wcc.ACK_INVALID)
+        else:
+            status = wcc.ACK_UNKNOWN
+        if status == wcc.ACK_QUEUED and self.last == (seq, frame_type):
+            self.send(wcc.RSP_ACK, seq, bytes([status, len(self.queue)]))
+            return
+        if status == wcc.ACK_QUEUED and len(self.queue) >= self.queue_len:
+            status = wcc.ACK_BUSY
+        if status == wcc.ACK_QUEUED:
+            self.queue.append((frame_type, seq, payload))
+            self.last = (seq, frame_type)
+            self.max_queued = max(self.max_queued, len(self.queue))
+        self.send(wcc.RSP_ACK, seq, bytes([status, len(self.queue)]))
+
+    def receive_stream(self, frame_type, round_, payload):
+        stream = self.stream
+        if stream is None or round_ != self.stream_round or len(payload) < 4:
+            return
+        (addr,) = struct.unpack_from("<I", payload)
+        if frame_type == wcc.CMD_STREAM_SKIP:
+            stream["skip"] = addr == stream["addr"]
+            return
+        data = payload[4:]
+        received = len(stream["data"])
+        if (addr != stream["addr"] + received
+                or received + len(data) > wcc.SECTOR_SZ):
+            stream["gap"] = True
+            return
+        stream["data"] += data
+        self.data_received += len(data)
+
+    # -- execution
+
+    def run(self):
+        while self.running:
+            self.poll(0.01)
+            if self.queue:
+                self.execute(*self.queue[0])
+                self.queue.pop(0)
+
+    def result(self, seq, status, value, text=b""):
+        self.send(wcc.RSP_RESULT, seq, struct.pack("<BI", status, value) + text)
+
+    def execute(self, frame_type, seq, payload):
+        if frame_type == wcc.CMD_STREAM_UPDATE:
+            self.executed.append((frame_type, ""))
+            self.stream_update(seq, struct.unpack("<I", payload)[0])
+            return
+        name = payload.decode()
+        self.executed.append((frame_type, name))
+        if frame_type == wcc.CMD_PING:
+            self.result(seq, wcc.RESULT_OK, 0, b"winc-cloner v0.0.7")
+        elif frame_type == wcc.CMD_LIST:
+            for idx, (image, version) in enumerate(self.images):
+                payload = struct.pack("<HIIHB", idx, 0x100000, 0xDEADBEEF + idx,
+                                      version,
+                                      wcc.IMAGE_SCANNED | wcc.IMAGE_HAS_VERSION)
+                self.send(wcc.RSP_ENTRY, seq, payload + image.encode())
+            self.result(seq, wcc.RESULT_OK, len(self.images))
+        elif frame_type == wcc.CMD_EXIT:
+            self.active = False  # before replying: the client may check
+            self.result(seq, wcc.RESULT_OK, 0)
+        else:
+            # cloner operations print text, like the firmware's error and info
+            # messages, which the client must skip.
+            self.text("\nOpening %s\n" % name)
+            changed = 0
+            for sector in range(1, N_SECTORS + 1):
+                time.sleep(self.sector_time)
+                self.poll()  # the firmware polls for requests between sectors
+                if frame_type == wcc.CMD_UPDATE and sector % 4 == 0:
+                    changed += 1
+                self.send(wcc.RSP_PROGRESS, seq,
+                          struct.pack("<III", sector, N_SECTORS, changed))
+            ok = name != "missing.wimg"
+            self.result(seq, wcc.RESULT_OK if ok else wcc.RESULT_FAILED,
+                        changed)
+
+    def stream_update(self, seq, size):
+        changed = 0
+        n_sectors = size // wcc.SECTOR_SZ
+        for sector in range(n_sectors):
+            addr = sector * wcc.SECTOR_SZ
+            current = bytes(self.flash[addr : addr + wcc.SECTOR_SZ])
+            data = self.stream_source(seq, addr, current)
+            if data is None:
+                self.result(seq, wcc.RESULT_FAILED, changed)
+                return
+            if data != current:
+                self.flash[addr : addr + wcc.SECTOR_SZ] = data
+                changed += 1
+            self.send(wcc.RSP_PROGRESS, seq,
+                      struct.pack("<III", sector + 1, n_sectors, changed))
+        self.result(seq, wcc.RESULT_OK, changed)
+
+    def stream_source(self, seq, addr, current):
+        """Fetch one sector from the host: None if it stops answering."""
+        self.stream = {"addr": addr, "data": b""}
+        tries = 0
+        while tries < STREAM_TRIES:
+            received = len(self.stream["data"])
+            self.stream.update(skip=False, gap=False)
+            self.stream_round = (self.stream_round + 1) & 0xFF
+            self.queries += 1
+            self.send(wcc.RSP_SECTOR, seq,
+                      struct.pack("<BIII", self.stream_round, addr, received,
+                                  zlib.crc32(current)))
+            tries += 1
+            deadline = time.monotonic() + STREAM_TIMEOUT
+            while time.monotonic() < deadline:
+                self.poll(0.01)
+                if self.stream["skip"]:
+                    self.stream = None
+                    return current
+                if len(self.stream["data"]) == wcc.SECTOR_SZ:
+                    data, self.stream = self.stream["data"], None
+                    return data
+                if self.stream["gap"]:
+                    break
+                if len(self.stream["data"]) != received:
+                    received = len(self.stream["data"])
+                    deadline = time.monotonic() + STREAM_TIMEOUT
+                    tries = 0
+        self.stream = None
+        return None
+
+
+class ClientTest(unittest.TestCase):
+    def setUp(self):
+        self.master, slave = pty.openpty()
+        tty.setraw(self.master)
+        self.target = SimulatedTarget(self.master)
+        self.target.start()
+        self.client = wcc.Client.open(os.ttyname(slave), ack_timeout=0.2)
+        os.close(slave)
+
+    def tearDown(self):
+        self.client.close()
+        self.target.stop()
+        os.close(self.master)
+
+    def test_crc16(self):
+        # CRC-16/CCITT-FALSE check value
+        self.assertEqual(wcc.crc16(b"123456789"), 0x29B1)
+
+    def test_decoder_skips_text_and_bad_frames(self):
+        good = wcc.encode_frame(wcc.RSP_ACK, 7, b"\x00\x01")
+        bad = bytearray(good)
+        bad[-2] ^= 1
+        decoder = wcc.FrameDecoder()
+        stream = b"hello\xa5" + bytes(bad) + b"\n" + good + b"tail"
+        # feed one byte at a time to exercise partial frames
+        frames = []
+        for i in range(len(stream)):
+            frames += decoder.feed(stream[i : i + 1])
+        self.assertEqual(frames, [(wcc.RSP_ACK, 7, b"\x00\x01")])
+        self.assertEqual(decoder.crc_errors, 1)
+
+    def test_ping(self):
+        self.assertEqual(self.client.ping(), "winc-cloner v0.0.7")
+
+    def test_list(self):
+        entries = self.client.list_images()
+        self.assertEqual([e["name"] for e in entries],
+                         ["m2m_aio_3a0_v19_5_4.wimg",
+                          "prodB/m2m_aio_3a0_v19_7_7.wimg"])
+        self.assertEqual(entries[1]["version"], "19.7.7")
+        self.assertEqual(entries[0]["digest"], "deadbeef")
+
+    def test_update_reports_progress(self):
+        progress = []
+        status, changed = self.client.run(
+            wcc.CMD_UPDATE, "a.wimg",
+            on_progress=lambda *p: progress.append(p))
+        self.assertEqual(status, wcc.RESULT_OK)
+        self.assertEqual(changed, N_SECTORS // 4)
+        self.assertEqual(progress[-1], (N_SECTORS, N_SECTORS, N_SECTORS // 4))
+
+    def test_failure_is_reported(self):
+        status, _ = self.client.run(wcc.CMD_COMPARE, "missing.wimg")
+        self.assertEqual(status, wcc.RESULT_FAILED)
+
+    def test_pipelined_commands_run_in_order(self):
+        self.target.sector_time = 0.01
+        seqs = [self.client.submit(wcc.CMD_UPDATE, b"a.wimg"),
+                self.client.submit(wcc.CMD_COMPARE, b"a.wimg"),
+                self.client.submit(wcc.CMD_PING)]
+        # all three were queued while the first was still running.
+        self.assertGreaterEqual(self.target.max_queued, 2)
+        results = [self.client.wait_result(seq) for seq in seqs]
+        self.assertEqual([r[0] for r in results], [wcc.RESULT_OK] * 3)
+        self.assertEqual([t for t, _ in self.target.executed],
+                         [wcc.CMD_UPDATE, wcc.CMD_COMPARE, wcc.CMD_PING])
+
+    def test_busy_target_is_retried(self):
+        self.target.queue_len = 1
+        self.target.sector_time = 0.005
+        first = self.client.submit(wcc.CMD_UPDATE, b"a.wimg")
+        second = self.client.submit(wcc.CMD_UPDATE, b"b.wimg")
+        self.assertEqual(self.client.wait_result(first)[0], wcc.RESULT_OK)
+        self.assertEqual(self.client.wait_result(second)[0], wcc.RESULT_OK)
+
+    def test_lost_request_is_resent(self):
+        self.target.drop_next = 1
+        self.assertEqual(self.client.ping(), "winc-cloner v0.0.7")
+
+    def test_lost_ack_does_not_run_twice(self):
+        self.target.corrupt_next = 1  # the first ACK arrives garbled
+        self.assertEqual(self.client.ping(), "winc-cloner v0.0.7")
+        self.assertEqual(self.target.executed, [(wcc.CMD_PING, "")])
+
+    def test_invalid_request_is_rejected(self):
+        with self.assertRaises(wcc.ProtocolError):
+            self.client.submit(wcc.CMD_UPDATE, b"")
+
+    def make_image(self, dirty):
+        image = bytearray(self.target.flash)
+        for sector in dirty:
+            start = sector * wcc.SECTOR_SZ
+            image[start : start + wcc.SECTOR_SZ] = os.urandom(wcc.SECTOR_SZ)
+        return bytes(image)
+
+    def test_stream_sends_only_dirty_sectors(self):
+        image = self.make_image([1, 7, 15])
+        progress = []
+        status, changed = self.client.stream_update(
+            image, on_progress=lambda *p: progress.append(p))
+        self.assertEqual((status, changed), (wcc.RESULT_OK, 3))
+        self.assertEqual(bytes(self.target.flash), image)
+        self.assertEqual(self.target.data_received, 3 * wcc.SECTOR_SZ)
+        self.assertEqual(progress[-1], (N_SECTORS, N_SECTORS, 3))
+        # an unchanged image costs one SECTOR/SKIP exchange per sector.
+        status, changed = self.client.stream_update(image)
+        self.assertEqual((status, changed), (wcc.RESULT_OK, 0))
+        self.assertEqual(self.target.data_received, 3 * wcc.SECTOR_SZ)
+
+    def test_stream_recovers_lost_data(self):
+        image = self.make_image([2])
+        self.target.drop_data = 5  # lose a chunk from the middle of sector 2
+        status, changed = self.client.stream_update(image)
+        self.assertEqual((status, changed), (wcc.RESULT_OK, 1))
+        self.assertEqual(bytes(self.target.flash), image)
+        # the gap was filled by asking again from the missing offset.
+        self.assertEqual(self.target.queries, N_SECTORS + 1)
+
+    def test_stream_then_pipelined_ping(self):
+        image = self.make_image([0])
+        seq = self.client.submit(wcc.CMD_STREAM_UPDATE,
+                                 struct.pack("<I", len(image)))
+        ping = self.client.submit(wcc.CMD_PING)
+        self.assertEqual(self.client.wait_result(seq, image=image)[:2],
+                         (wcc.RESULT_OK, 1))
+        self.assertEqual(self.client.wait_result(ping)[2], "winc-cloner v0.0.7")
+
+    def test_stream_rejects_partial_sector(self):
+        with self.assertRaises(ValueError):
+            self.client.stream_update(b"\0" * 100)
+
+    def test_close_exits_protocol(self):
+        self.client.ping()
+        self.client.close()
+        self.assertFalse(self.target.active)
+
+
+if __name__ == "__main__":
+    unittest.main()
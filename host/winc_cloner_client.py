@@ -0,0 +1,425 @@
+#!/usr/bin/env python3
+"""
+Reference client for the winc-cloner binary host protocol.
+
+MIT License
+
+Copyright (c) 2022 R. D. Poor (https://github.com/rdpoor)
+
+See firmware/src/host_proto.h for the frame format and the list of requests.
+This module has no dependencies beyond the Python 3 standard library, and runs
+on Linux (or anything else with termios).
+
+Usage as a program:
+
+    winc_cloner_client.py --port /dev/ttyACM0 ping
+    winc_cloner_client.py --port /dev/ttyACM0 list
+    winc_cloner_client.py --port /dev/ttyACM0 update m2m_aio_3a0.wimg compare m2m_aio_3a0.wimg
+    winc_cloner_client.py --port /dev/ttyACM0 stream images/m2m_aio_3a0_v19_7_7.img
+
+"stream" updates the WINC from a file on the host, sending only the sectors
+whose CRC-32 differs from what the WINC already holds; no SD card is needed.
+
+Several commands given on one command line are pipelined: each is sent as
+soon as the target has room to queue it.
+
+Usage as a module:
+
+    with Client.open("/dev/ttyACM0") as client:
+        print(client.ping())
+        seq = client.submit(CMD_UPDATE, b"m2m_aio_3a0_v19_7_7.wimg")
+        result = client.wait_result(seq, on_progress=print)
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import zlib
+
+SOF = b"\xa5\x5a"
+HEADER_SZ = 6
+MAX_PAYLOAD = 128
+MAX_NAME = 80
+QUEUE_LEN = 4
+SECTOR_SZ = 4096  # FLASH_SECTOR_SZ
+STREAM_CHUNK = MAX_PAYLOAD - 4  # data bytes per STREAM_DATA frame
+
+CMD_PING = 0x01
+CMD_LIST = 0x02
+CMD_EXTRACT = 0x10
+CMD_UPDATE = 0x11
+CMD_COMPARE = 0x12
+CMD_REBUILD_PLL = 0x13
+CMD_STREAM_UPDATE = 0x14
+CMD_EXIT = 0x1F
+CMD_STREAM_DATA = 0x20
+CMD_STREAM_SKIP = 0x21
+
+RSP_ACK = 0x80
+RSP_PROGRESS = 0x81
+RSP_ENTRY = 0x82
+RSP_RESULT = 0x83
+RSP_SECTOR = 0x84
+
+ACK_QUEUED = 0x00
+ACK_BUSY = 0x01
+ACK_UNKNOWN = 0x02
+ACK_INVALID = 0x03
+
+RESULT_OK = 0x00
+RESULT_FAILED = 0x01
+
+IMAGE_SCANNED = 0x01
+IMAGE_HAS_VERSION = 0x02
+IMAGE_SKIPPED = 0x04
+
+DEFAULT_BAUD = 921600  # the firmware's console rate
+
+# Not every platform defines the higher rates.
+BAUD_RATES = {
+    rate: getattr(termios, "B%d" % rate)
+    for rate in (9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600)
+    if hasattr(termios, "B%d" % rate)
+}
+
+
+class ProtocolError(Exception):
+    """The target rejected a request or stopped answering."""
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as computed by the firmware."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(frame_type, seq, payload=b""):
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError("payload too long")
+    body = struct.pack("<BBH", frame_type, seq, len(payload)) + payload
+    return SOF + body + struct.pack("<H", crc16(body))
+
+
+class FrameDecoder:
+    """Extracts valid frames from a byte stream, skipping anything else."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        """Add bytes; return a list of (type, seq, payload) tuples."""
+        self.buf += data
+        frames = []
+        while True:
+            start = self.buf.find(SOF)
+            if start < 0:
+                # keep a trailing 0xa5: it may start the next frame.
+                del self.buf[: max(0, len(self.buf) - 1)]
+                return frames
+            del self.buf[:start]
+            if len(self.buf) < HEADER_SZ:
+                return frames
+            frame_type, seq, length = struct.unpack_from("<BBH", self.buf, 2)
+            if length > MAX_PAYLOAD:
+                del self.buf[:1]  # not a frame after all: resynchronize.
+                continue
+            end = HEADER_SZ + length + 2
+            if len(self.buf) < end:
+                return frames
+            body = bytes(self.buf[2 : HEADER_SZ + length])
+            (crc,) = struct.unpack_from("<H", self.buf, HEADER_SZ + length)
+            if crc != crc16(body):
+                self.crc_errors += 1
+                del self.buf[:1]
+                continue
+            frames.append((frame_type, seq, bytes(self.buf[HEADER_SZ : end - 2])))
+            del self.buf[:end]
+
+
+class Client:
+    """Talks to one target over a serial port (or any file descriptor)."""
+
+    def __init__(self, fd, ack_timeout=1.0, retries=5, result_timeout=300.0):
+        self.fd = fd
+        self.ack_timeout = ack_timeout
+        self.retries = retries
+        self.result_timeout = result_timeout
+        self.decoder = FrameDecoder()
+        self.seq = 0
+        self.pending = []  # frames read but not yet consumed
+        self.in_protocol = False
+
+    @classmethod
+    def open(cls, path, baud=DEFAULT_BAUD, **kwargs):
+        fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attrs = termios.tcgetattr(fd)
+        # raw 8n1, no flow control
+        attrs[0] = 0
+        attrs[1] = 0
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0
+        attrs[4] = attrs[5] = BAUD_RATES[baud]
+        attrs[6][termios.VMIN] = 0
+        attrs[6][termios.VTIME] = 0
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        termios.tcflush(fd, termios.TCIOFLUSH)
+        return cls(fd, **kwargs)
+
+    def close(self):
+        if self.fd is not None:
+            if self.in_protocol:
+                try:
+                    self.wait_result(self.submit(CMD_EXIT))
+                except ProtocolError:
+                    pass
+            os.close(self.fd)
+            self.fd = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    # --------------------------------------------------------------------------
+    # requests
+
+    def submit(self, frame_type, payload=b""):
+        """Send a request and wait until the target has queued it.
+
+        Returns the request's seq, to be passed to wait_result().
+        """
+        self.seq = (self.seq + 1) & 0xFF
+        seq = self.seq
+        frame = encode_frame(frame_type, seq, payload)
+        attempts = 0
+        deadline = None
+        while True:
+            if deadline is None or time.monotonic() >= deadline:
+                if attempts > self.retries:
+                    raise ProtocolError("no ACK for request %d" % seq)
+                attempts += 1
+                self._write(frame)
+                deadline = time.monotonic() + self.ack_timeout
+            ack = self._take(lambda f: f[0] == RSP_ACK and f[1] == seq, deadline)
+            if ack is None:
+                continue  # timed out: resend
+            status = ack[2][0]
+            if status == ACK_QUEUED:
+                self.in_protocol = True
+                return seq
+            if status == ACK_BUSY:
+                # the queue is full: resend once something has finished.
+                self._take(lambda f: f[0] == RSP_RESULT, time.monotonic() + 0.2,
+                           consume=False)
+                deadline = None
+                attempts = 0
+                continue
+            raise ProtocolError("request %d rejected, status %d" % (seq, status))
+
+    def wait_result(self, seq, on_progress=None, on_entry=None, image=None):
+        """Wait for the RESULT of request seq: return (status, value, text).
+
+        on_progress(done, total, changed) and on_entry(dict) are called for the
+        PROGRESS and ENTRY frames the request produces on the way.  image holds
+        the bytes to answer SECTOR frames with, for CMD_STREAM_UPDATE.
+        """
+        deadline = time.monotonic() + self.result_timeout
+        while True:
+            frame = self._take(lambda f: f[1] == seq and f[0] != RSP_ACK, deadline)
+            if frame is None:
+                raise ProtocolError("no RESULT for request %d" % seq)
+            frame_type, _, payload = frame
+            if frame_type == RSP_PROGRESS and on_progress is not None:
+                on_progress(*struct.unpack("<III", payload))
+            elif frame_type == RSP_ENTRY and on_entry is not None:
+                on_entry(decode_entry(payload))
+            elif frame_type == RSP_SECTOR and image is not None:
+                self._send_sector(image, payload)
+            elif frame_type == RSP_RESULT:
+                status, value = struct.unpack_from("<BI", payload)
+                return status, value, payload[5:].decode("ascii", "replace")
+
+    def ping(self):
+        status, _, text = self.wait_result(self.submit(CMD_PING))
+        return text
+
+    def list_images(self):
+        entries = []
+        status, _, _ = self.wait_result(self.submit(CMD_LIST),
+                                        on_entry=entries.append)
+        if status != RESULT_OK:
+            raise ProtocolError("LIST failed")
+        return entries
+
+    def run(self, frame_type, filename=None, on_progress=None):
+        """Run one cloner command to completion: return (status, value)."""
+        payload = b"" if filename is None else encode_name(filename)
+        status, value, _ = self.wait_result(self.submit(frame_type, payload),
+                                            on_progress=on_progress)
+        return status, value
+
+    def stream_update(self, image, on_progress=None):
+        """Update the WINC from image (bytes): return (status, n_changed)."""
+        if not image or len(image) % SECTOR_SZ:
+            raise ValueError("image must be a whole number of %d byte sectors"
+                             % SECTOR_SZ)
+        seq = self.submit(CMD_STREAM_UPDATE, struct.pack("<I", len(image)))
+        status, value, _ = self.wait_result(seq, on_progress=on_progress,
+                                            image=image)
+        return status, value
+
+    def _send_sector(self, image, query):
+        round_, addr, offset, winc_crc = struct.unpack_from("<BIII", query)
+        sector = image[addr : addr + SECTOR_SZ]
+        if offset == 0 and zlib.crc32(sector) == winc_crc:
+            self._write(encode_frame(CMD_STREAM_SKIP, round_,
+                                     struct.pack("<I", addr)))
+            return
+        frames = []
+        for start in range(offset, SECTOR_SZ, STREAM_CHUNK):
+            chunk = sector[start : start + STREAM_CHUNK]
+            frames.append(encode_frame(CMD_STREAM_DATA, round_,
+                                       struct.pack("<I", addr + start) + chunk))
+        self._write(b"".join(frames))
+
+    def _write(self, data):
+        while data:
+            data = data[os.write(self.fd, data) :]
+
+    # --------------------------------------------------------------------------
+    # frame input
+
+    def _take(self, match, deadline, consume=True):
+        """Return the first frame satisfying match, reading until deadline."""
+        while True:
+            for i, frame in enumerate(self.pending):
+                if match(frame):
+                    return self.pending.pop(i) if consume else frame
+            timeout = deadline - time.monotonic()
+            if timeout <= 0:
+                return None
+            ready, _, _ = select.select([self.fd], [], [], timeout)
+            if ready:
+                try:
+                    data = os.read(self.fd, 4096)
+                except OSError:
+                    data = b""
+                self.pending += self.decoder.feed(data)
+
+
+def encode_name(filename):
+    name = filename.encode("utf-8")
+    if not 0 < len(name) <= MAX_NAME:
+        raise ValueError("filename must be 1 to %d bytes" % MAX_NAME)
+    return name
+
+
+def decode_entry(payload):
+    index, size, digest, fw_version, flags = struct.unpack_from("<HIIHB", payload)
+    entry = {
+        "index": index,
+        "name": payload[13:].decode("utf-8", "replace"),
+        "size": size,
+        "flags": flags,
+    }
+    if flags & IMAGE_HAS_VERSION:
+        entry["version"] = "%d.%d.%d" % (
+            fw_version >> 8,
+            (fw_version >> 4) & 0x0F,
+            fw_version & 0x0F,
+        )
+    if flags & IMAGE_SCANNED:
+        entry["digest"] = "%08x" % digest
+    return entry
+
+
+COMMANDS = {
+    "extract": CMD_EXTRACT,
+    "update": CMD_UPDATE,
+    "compare": CMD_COMPARE,
+}
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--port", required=True, help="e.g. /dev/ttyACM0")
+    parser.add_argument("--baud", type=int, default=DEFAULT_BAUD,
+                        choices=sorted(BAUD_RATES))
+    parser.add_argument("commands", nargs="+",
+                        help="ping | list | rebuild-pll | "
+                             "{extract,update,compare} FILENAME | "
+                             "stream LOCAL_FILE ...")
+    args = parser.parse_args(argv)
+
+    # parse the command line into requests first, so typos fail early.
+    requests = []
+    words = list(args.commands)
+    while words:
+        word = words.pop(0)
+        if word in COMMANDS:
+            if not words:
+                parser.error("%s needs a filename" % word)
+            requests.append((word, COMMANDS[word], encode_name(words.pop(0)),
+                             None))
+        elif word == "stream":
+            if not words:
+                parser.error("stream needs a local file")
+            with open(words.pop(0), "rb") as f:
+                image = f.read()
+            if not image or len(image) % SECTOR_SZ:
+                parser.error("stream: image is not a whole number of sectors")
+            requests.append((word, CMD_STREAM_UPDATE,
+                             struct.pack("<I", len(image)), image))
+        elif word == "rebuild-pll":
+            requests.append((word, CMD_REBUILD_PLL, b"", None))
+        elif word in ("ping", "list"):
+            requests.append((word, CMD_PING if word == "ping" else CMD_LIST, b"",
+                             None))
+        else:
+            parser.error("unknown command %r" % word)
+
+    failed = False
+    with Client.open(args.port, args.baud) as client:
+        # keep up to QUEUE_LEN requests in flight.
+        in_flight = []
+        while requests or in_flight:
+            while requests and len(in_flight) < QUEUE_LEN:
+                word, frame_type, payload, image = requests.pop(0)
+                in_flight.append((word, client.submit(frame_type, payload),
+                                  image))
+            word, seq, image = in_flight.pop(0)
+
+            def show_progress(done, total, changed, word=word):
+                sys.stderr.write("\r%s %d/%d, %d changed " % (word, done, total,
+                                                              changed))
+
+            def show_entry(entry):
+                print("%3d %-32s %8d %-8s %s" % (
+                    entry["index"], entry["name"], entry["size"],
+                    entry.get("version", "-"), entry.get("digest", "-")))
+
+            status, value, text = client.wait_result(
+                seq, on_progress=show_progress, on_entry=show_entry,
+                image=image)
+            sys.stderr.write("\n")
+            if word == "ping":
+                print(text)
+            elif word != "list":
+                print("%s: %s (%d)" % (word, "ok" if status == RESULT_OK
+                                       else "FAILED", value))
+            failed = failed or status != RESULT_OK
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())